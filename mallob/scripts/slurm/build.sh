@@ -25,6 +25,7 @@ CC=$(which mpicc) CXX=$(which mpicxx) cmake .. \
 `# (relative) path to sub-executables` -DMALLOB_SUBPROC_DISPATCH_PATH=\"$build/\" \
 `# include SAT (+preprocess) as application` -DMALLOB_APP_SAT=1 -DMALLOB_APP_SATWITHPRE=1 \
 `# include MaxSAT as application` -DMALLOB_APP_MAXSAT=1 -DMALLOB_USE_MAXPRE=0 \
+`# include k-means clustering as application` -DMALLOB_APP_KMEANS=1 \
 `# max. number of solver threads in a process` -DMALLOB_MAX_N_APPTHREADS_PER_PROCESS=64
 
 VERBOSE=1 make -j 8
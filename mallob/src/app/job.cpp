@@ -56,6 +56,10 @@ void Job::pushRevision(const std::shared_ptr<std::vector<uint8_t>>& data) {
 
     const int prevGroupId = _description.getGroupId();
     _description.deserialize(data);
+    if (!_has_description) {
+        _time_of_first_description = Timer::elapsedSeconds();
+        _time_since_submission_at_first_description = _description.getTimeSinceSubmission();
+    }
     _priority = _description.getPriority();
     if (_description.getMaxDemand() > 0) {
         // Set max. demand to more restrictive number
@@ -172,6 +172,8 @@ private:
     float _time_of_increment_activation = 0;
     float _time_of_first_volume_update = -1;
     float _time_of_abort = 0;
+    float _time_of_first_description = 0;
+    float _time_since_submission_at_first_description = -1;
     
     float _time_of_last_comm = 0;
     float _time_of_last_limit_check = 0;
@@ -312,6 +314,13 @@ public:
     // Elapsed seconds since termination of the job.
     float getAgeSinceAbort() const {return Timer::elapsedSeconds() - _time_of_abort;}
     float getLatencyOfFirstVolumeUpdate() const {return _time_of_first_volume_update < 0 ? -1 : _time_of_first_volume_update - _time_of_activation;}
+    // Seconds from the job's submission at the client until this node first started the job,
+    // or -1 if unknown. Since clocks are not synchronized across processes, the transfer
+    // of the description from the client to this process is not included.
+    float getSubmissionLatency() const {
+        if (_time_since_submission_at_first_description < 0 || _time_of_activation <= 0) return -1;
+        return _time_since_submission_at_first_description + (_time_of_activation - _time_of_first_description);
+    }
     float getUsedCpuSeconds() const {return _used_cpu_seconds;}
     int getNumThreads() const {return _threads_per_job;}
     void setNumThreads(int nbThreads) {_threads_per_job = nbThreads;} 
@@ -0,0 +1,226 @@
+#include "kmeans_assignment.hpp"
+
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+
+#include "util/assert.hpp"
+#include "util/sys/thread_pool.hpp"
+
+namespace {
+
+constexpr int TILE = KMeansAssignmentKernel::TILE_SIZE;
+// Number of points processed at once by the tile kernels
+constexpr int POINT_BLOCK = 4;
+// Number of points claimed at once by a thread in assignParallel
+constexpr int CHUNK_SIZE = 1024;
+
+// Each kernel writes the squared distances of P points to the TILE centers
+// of the given tile into out[p*TILE + j].
+typedef void (*TileKernel)(const float* const* points, const float* tile, int dim, float* out);
+
+template <int P>
+void tileDistancesScalar(const float* const* points, const float* tile, int dim, float* out) {
+    float acc[P][TILE] = {};
+    for (int d = 0; d < dim; ++d) {
+        const float* row = tile + d * TILE;
+        for (int p = 0; p < P; ++p) {
+            const float x = points[p][d];
+            for (int j = 0; j < TILE; ++j) {
+                const float diff = x - row[j];
+                acc[p][j] += diff * diff;
+            }
+        }
+    }
+    for (int p = 0; p < P; ++p)
+        for (int j = 0; j < TILE; ++j) out[p * TILE + j] = acc[p][j];
+}
+
+template <int P>
+__attribute__((target("avx2,fma")))
+void tileDistancesAvx2(const float* const* points, const float* tile, int dim, float* out) {
+    __m256 acc[P][2];
+    for (int p = 0; p < P; ++p) acc[p][0] = acc[p][1] = _mm256_setzero_ps();
+    for (int d = 0; d < dim; ++d) {
+        const __m256 c0 = _mm256_loadu_ps(tile + d * TILE);
+        const __m256 c1 = _mm256_loadu_ps(tile + d * TILE + 8);
+        for (int p = 0; p < P; ++p) {
+            const __m256 x = _mm256_set1_ps(points[p][d]);
+            const __m256 diff0 = _mm256_sub_ps(x, c0);
+            const __m256 diff1 = _mm256_sub_ps(x, c1);
+            acc[p][0] = _mm256_fmadd_ps(diff0, diff0, acc[p][0]);
+            acc[p][1] = _mm256_fmadd_ps(diff1, diff1, acc[p][1]);
+        }
+    }
+    for (int p = 0; p < P; ++p) {
+        _mm256_storeu_ps(out + p * TILE, acc[p][0]);
+        _mm256_storeu_ps(out + p * TILE + 8, acc[p][1]);
+    }
+}
+
+template <int P>
+__attribute__((target("avx512f")))
+void tileDistancesAvx512(const float* const* points, const float* tile, int dim, float* out) {
+    __m512 acc[P];
+    for (int p = 0; p < P; ++p) acc[p] = _mm512_setzero_ps();
+    for (int d = 0; d < dim; ++d) {
+        const __m512 c = _mm512_loadu_ps(tile + d * TILE);
+        for (int p = 0; p < P; ++p) {
+            const __m512 diff = _mm512_sub_ps(_mm512_set1_ps(points[p][d]), c);
+            acc[p] = _mm512_fmadd_ps(diff, diff, acc[p]);
+        }
+    }
+    for (int p = 0; p < P; ++p) _mm512_storeu_ps(out + p * TILE, acc[p]);
+}
+
+std::pair<TileKernel, TileKernel> getKernels(KMeansAssignmentKernel::Isa isa) {
+    switch (isa) {
+    case KMeansAssignmentKernel::AVX512:
+        return {&tileDistancesAvx512<POINT_BLOCK>, &tileDistancesAvx512<1>};
+    case KMeansAssignmentKernel::AVX2:
+        return {&tileDistancesAvx2<POINT_BLOCK>, &tileDistancesAvx2<1>};
+    default:
+        return {&tileDistancesScalar<POINT_BLOCK>, &tileDistancesScalar<1>};
+    }
+}
+
+}  // namespace
+
+KMeansAssignmentKernel::KMeansAssignmentKernel(Isa isa) : _isa(isSupported(isa) ? isa : SCALAR) {}
+
+void KMeansAssignmentKernel::setCenters(const std::vector<std::vector<float>>& centers, int dimension) {
+    _dimension = dimension;
+    _nb_centers = centers.size();
+    _nb_tiles = (_nb_centers + TILE - 1) / TILE;
+    // Padding slots of the last tile are zero; their distances are never considered.
+    _tiles.assign((size_t) _nb_tiles * _dimension * TILE, 0.0f);
+    for (int k = 0; k < _nb_centers; ++k) {
+        assert(centers[k].size() >= (size_t) _dimension);
+        float* tile = _tiles.data() + (size_t) (k / TILE) * _dimension * TILE;
+        for (int d = 0; d < _dimension; ++d) tile[d * TILE + k % TILE] = centers[k][d];
+    }
+}
+
+void KMeansAssignmentKernel::assign(const float* points, int begin, int end, int* membership) const {
+    assignPoints(points, end - begin, [&](int i) {return begin + i;}, membership, nullptr, nullptr);
+}
+
+void KMeansAssignmentKernel::assignSelected(const float* points, const int* pointIds, int nbPoints,
+        int* membership, float* nearestSqDist, float* secondSqDist) const {
+    assignPoints(points, nbPoints, [&](int i) {return pointIds[i];}, membership, nearestSqDist, secondSqDist);
+}
+
+template <typename GetPointId>
+void KMeansAssignmentKernel::assignPoints(const float* points, int nbPoints, GetPointId getPointId,
+        int* membership, float* nearestSqDist, float* secondSqDist) const {
+
+    auto [blockKernel, singleKernel] = getKernels(_isa);
+    const float* blockPoints[POINT_BLOCK];
+    int blockIds[POINT_BLOCK];
+    float distances[POINT_BLOCK * TILE];
+    float bestDistance[POINT_BLOCK];
+    float secondDistance[POINT_BLOCK];
+    int bestCenter[POINT_BLOCK];
+
+    for (int i = 0; i < nbPoints; i += POINT_BLOCK) {
+        const int nbBlockPoints = std::min(POINT_BLOCK, nbPoints - i);
+        for (int p = 0; p < nbBlockPoints; ++p) {
+            blockIds[p] = getPointId(i + p);
+            blockPoints[p] = points + (size_t) blockIds[p] * _dimension;
+            bestDistance[p] = std::numeric_limits<float>::infinity();
+            secondDistance[p] = std::numeric_limits<float>::infinity();
+            bestCenter[p] = -1;
+        }
+        for (int t = 0; t < _nb_tiles; ++t) {
+            const float* tile = _tiles.data() + (size_t) t * _dimension * TILE;
+            if (nbBlockPoints == POINT_BLOCK) {
+                blockKernel(blockPoints, tile, _dimension, distances);
+            } else {
+                for (int p = 0; p < nbBlockPoints; ++p)
+                    singleKernel(blockPoints + p, tile, _dimension, distances + p * TILE);
+            }
+            // Scan in ascending center order so that the first minimum wins
+            const int nbCentersInTile = std::min(TILE, _nb_centers - t * TILE);
+            for (int p = 0; p < nbBlockPoints; ++p) {
+                for (int j = 0; j < nbCentersInTile; ++j) {
+                    const float dist = distances[p * TILE + j];
+                    if (dist < bestDistance[p]) {
+                        secondDistance[p] = bestDistance[p];
+                        bestDistance[p] = dist;
+                        bestCenter[p] = t * TILE + j;
+                    } else if (dist < secondDistance[p]) {
+                        secondDistance[p] = dist;
+                    }
+                }
+            }
+        }
+        for (int p = 0; p < nbBlockPoints; ++p) {
+            membership[blockIds[p]] = bestCenter[p];
+            if (nearestSqDist) nearestSqDist[blockIds[p]] = bestDistance[p];
+            if (secondSqDist) secondSqDist[blockIds[p]] = secondDistance[p];
+        }
+    }
+}
+
+bool KMeansAssignmentKernel::assignParallel(const float* points, int begin, int end, int* membership,
+        int nbThreads, const std::function<bool(int)>& interrupt) const {
+    return forEachChunk(begin, end, nbThreads, interrupt, [&](int chunkBegin, int chunkEnd) {
+        assign(points, chunkBegin, chunkEnd, membership);
+    });
+}
+
+bool KMeansAssignmentKernel::forEachChunk(int begin, int end, int nbThreads,
+        const std::function<bool(int)>& interrupt, const std::function<void(int, int)>& work) {
+
+    std::atomic_int nextChunkBegin {begin};
+    std::atomic_bool interrupted {false};
+    auto run = [&]() {
+        while (!interrupted.load(std::memory_order_relaxed)) {
+            const int chunkBegin = nextChunkBegin.fetch_add(CHUNK_SIZE, std::memory_order_relaxed);
+            if (chunkBegin >= end) break;
+            if (interrupt(chunkBegin)) {
+                interrupted.store(true, std::memory_order_relaxed);
+                break;
+            }
+            work(chunkBegin, std::min(end, chunkBegin + CHUNK_SIZE));
+        }
+    };
+
+    // Do not spawn more tasks than there are chunks
+    const int nbChunks = (std::max(0, end - begin) + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    const int nbTasks = std::max(0, std::min(nbThreads, nbChunks) - 1);
+    std::vector<std::future<void>> futures;
+    futures.reserve(nbTasks);
+    for (int i = 0; i < nbTasks; ++i) futures.push_back(ProcessWideThreadPool::get().addTask(run));
+    run();
+    for (auto& future : futures) future.get();
+    return !interrupted.load(std::memory_order_relaxed);
+}
+
+KMeansAssignmentKernel::Isa KMeansAssignmentKernel::getBestIsa() {
+    if (isSupported(AVX512)) return AVX512;
+    if (isSupported(AVX2)) return AVX2;
+    return SCALAR;
+}
+
+bool KMeansAssignmentKernel::isSupported(Isa isa) {
+    switch (isa) {
+    case AVX512:
+        return __builtin_cpu_supports("avx512f");
+    case AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    default:
+        return true;
+    }
+}
+
+const char* KMeansAssignmentKernel::getIsaName(Isa isa) {
+    switch (isa) {
+    case AVX512: return "avx512";
+    case AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
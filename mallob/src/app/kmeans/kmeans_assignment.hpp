@@ -0,0 +1,65 @@
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+// Assigns points to their nearest cluster center (squared Euclidean distance).
+// The centers are transposed into tiles of TILE_SIZE centers each, stored as
+// [dimension][TILE_SIZE] ("structure of arrays"), so that the distances from
+// a point to all centers of a tile are computed with a few vector FMAs per
+// coordinate. Several points are processed at once to reuse each loaded tile
+// row. The instruction set (AVX-512, AVX2+FMA, or plain C++) is chosen at runtime.
+class KMeansAssignmentKernel {
+
+public:
+    static constexpr int TILE_SIZE = 16;
+    enum Isa {SCALAR, AVX2, AVX512};
+
+private:
+    Isa _isa;
+    int _dimension {0};
+    int _nb_centers {0};
+    int _nb_tiles {0};
+    std::vector<float> _tiles;
+
+    template <typename GetPointId>
+    void assignPoints(const float* points, int nbPoints, GetPointId getPointId,
+        int* membership, float* nearestSqDist, float* secondSqDist) const;
+
+public:
+    KMeansAssignmentKernel(Isa isa = getBestIsa());
+
+    void setCenters(const std::vector<std::vector<float>>& centers, int dimension);
+
+    // Writes the index of the nearest center of each point in [begin, end)
+    // to membership[pointIdx]. The points are stored consecutively with
+    // the dimension given to setCenters. On ties, the smallest index wins.
+    void assign(const float* points, int begin, int end, int* membership) const;
+
+    // Like assign, but splits the points into chunks which are processed by the
+    // calling thread and (nbThreads-1) tasks of the process-wide thread pool.
+    // Before each chunk, interrupt(firstPointOfChunk) is called (possibly
+    // concurrently); if it returns true, no further chunks are started and
+    // false is returned.
+    bool assignParallel(const float* points, int begin, int end, int* membership,
+        int nbThreads, const std::function<bool(int)>& interrupt) const;
+
+    // Like assign, but for the points with the given IDs, and also writing the
+    // squared distances to the nearest and the second nearest center
+    // (infinity if there is none) to nearestSqDist[pointId] and secondSqDist[pointId].
+    void assignSelected(const float* points, const int* pointIds, int nbPoints,
+        int* membership, float* nearestSqDist, float* secondSqDist) const;
+
+    Isa getIsa() const {return _isa;}
+
+    // Splits [begin, end) into chunks and calls work(chunkBegin, chunkEnd) for each of
+    // them from the calling thread and (nbThreads-1) tasks of the process-wide thread
+    // pool. Chunks are interrupted as described for assignParallel.
+    static bool forEachChunk(int begin, int end, int nbThreads,
+        const std::function<bool(int)>& interrupt, const std::function<void(int, int)>& work);
+
+    static Isa getBestIsa();
+    static bool isSupported(Isa isa);
+    static const char* getIsaName(Isa isa);
+};
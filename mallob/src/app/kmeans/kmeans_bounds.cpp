@@ -0,0 +1,127 @@
+#include "kmeans_bounds.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+#include "util/assert.hpp"
+
+namespace {
+
+double distance(const float* p1, const float* p2, int dim) {
+    double sum = 0;
+    for (int d = 0; d < dim; ++d) {
+        const double diff = (double) p1[d] - p2[d];
+        sum += diff * diff;
+    }
+    return std::sqrt(sum);
+}
+
+}  // namespace
+
+KMeansBounds::KMeansBounds(int nbPoints) : _nb_points(nbPoints),
+    _upper(nbPoints), _lower(nbPoints), _assigned(nbPoints, -1), _epoch(nbPoints, 0) {}
+
+void KMeansBounds::setCenters(const std::vector<std::vector<float>>& centers, int dimension) {
+    const int nbCenters = centers.size();
+    if (_current_epoch > 0 && dimension == _dimension && centers == _centers) return;
+
+    if (_current_epoch > 0 && dimension == _dimension && nbCenters == (int) _centers.size()) {
+        // Bounds of the previous epoch can be updated with the centers' movement
+        _drift.resize(nbCenters);
+        _max_drift_center = -1;
+        _max_drift = _second_max_drift = 0;
+        for (int k = 0; k < nbCenters; ++k) {
+            _drift[k] = distance(centers[k].data(), _centers[k].data(), dimension);
+            if (_drift[k] > _max_drift) {
+                _second_max_drift = _max_drift;
+                _max_drift = _drift[k];
+                _max_drift_center = k;
+            } else if (_drift[k] > _second_max_drift) {
+                _second_max_drift = _drift[k];
+            }
+        }
+        _current_epoch++;
+    } else {
+        // Invalidate all bounds
+        _current_epoch += 2;
+    }
+    _centers = centers;
+    _dimension = dimension;
+    // Relative error of the computed distances (see KMeansAssignmentKernel) and of the bounds
+    _slack = 1e-4f + 4 * dimension * FLT_EPSILON;
+
+    _half_min_center_dist.assign(nbCenters, std::numeric_limits<float>::infinity());
+    for (int k1 = 0; k1 < nbCenters; ++k1) {
+        for (int k2 = k1+1; k2 < nbCenters; ++k2) {
+            const float half = 0.5 * distance(centers[k1].data(), centers[k2].data(), dimension);
+            _half_min_center_dist[k1] = std::min(_half_min_center_dist[k1], half);
+            _half_min_center_dist[k2] = std::min(_half_min_center_dist[k2], half);
+        }
+    }
+}
+
+bool KMeansBounds::assignParallel(const KMeansAssignmentKernel& kernel, const float* points, int begin, int end,
+        int* membership, int nbThreads, const std::function<bool(int)>& interrupt) {
+    assert(end <= _nb_points);
+    return KMeansAssignmentKernel::forEachChunk(begin, end, nbThreads, interrupt, [&](int chunkBegin, int chunkEnd) {
+        assignChunk(kernel, points, chunkBegin, chunkEnd, membership);
+    });
+}
+
+void KMeansBounds::assignChunk(const KMeansAssignmentKernel& kernel, const float* points, int begin, int end, int* membership) {
+    static thread_local std::vector<int> exactPoints;
+    exactPoints.clear();
+    const int nbCenters = _centers.size();
+    uint64_t nbComputed = 0, nbSkipped = 0;
+
+    for (int p = begin; p < end; ++p) {
+        if (_epoch[p] + 1 == _current_epoch) {
+            // Loosen the bounds by the movement of the centers
+            const int a = _assigned[p];
+            _upper[p] += _drift[a];
+            _lower[p] = std::max(0.0f, _lower[p] - (a == _max_drift_center ? _second_max_drift : _max_drift));
+            _epoch[p] = _current_epoch;
+        } else if (_epoch[p] != _current_epoch) {
+            // No valid bounds
+            exactPoints.push_back(p);
+            continue;
+        }
+        const int a = _assigned[p];
+        const float bound = std::max(_half_min_center_dist[a], _lower[p]);
+        if (canSkip(_upper[p], bound)) {
+            membership[p] = a;
+            nbSkipped += nbCenters;
+            continue;
+        }
+        // Tighten the upper bound
+        _upper[p] = distance(points + (size_t) p * _dimension, _centers[a].data(), _dimension);
+        nbComputed++;
+        if (canSkip(_upper[p], bound)) {
+            membership[p] = a;
+            nbSkipped += nbCenters - 1;
+            continue;
+        }
+        exactPoints.push_back(p);
+    }
+
+    // Exact assignment of all remaining points, which also yields their new bounds
+    kernel.assignSelected(points, exactPoints.data(), exactPoints.size(),
+        _assigned.data(), _upper.data(), _lower.data());
+    for (int p : exactPoints) {
+        _upper[p] = std::sqrt(_upper[p]);
+        _lower[p] = std::sqrt(_lower[p]);
+        // No center at a finite distance: no valid bounds
+        _epoch[p] = _assigned[p] >= 0 ? _current_epoch : 0;
+        membership[p] = _assigned[p];
+    }
+    nbComputed += exactPoints.size() * nbCenters;
+
+    _nb_computed.fetch_add(nbComputed, std::memory_order_relaxed);
+    _nb_skipped.fetch_add(nbSkipped, std::memory_order_relaxed);
+}
+
+std::pair<uint64_t, uint64_t> KMeansBounds::extractDistanceCounts() {
+    return {_nb_computed.exchange(0, std::memory_order_relaxed), _nb_skipped.exchange(0, std::memory_order_relaxed)};
+}
@@ -0,0 +1,72 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "kmeans_assignment.hpp"
+
+// Accelerated assignment of points to their nearest center following Hamerly's
+// algorithm. For each point, we keep its assigned center, an upper bound on the
+// distance to this center, and a lower bound on the distance to any other center.
+// When the centers move, the bounds are loosened by the distance each center moved.
+// A point keeps its center without computing any distances if its upper bound is
+// smaller than its lower bound and than half the distance from its center to the
+// next center. Otherwise the upper bound is tightened and, if still necessary,
+// the point is assigned by the exact kernel.
+// The tests include a safety margin for floating-point rounding, so a point is
+// only skipped if its center is strictly the nearest one: the result is exactly
+// that of KMeansAssignmentKernel.
+// Bounds are valid only for the points that were assigned with the last or
+// second-to-last set of centers. All other points (e.g., those which became part
+// of this worker's interval since the job tree changed) are assigned exactly.
+class KMeansBounds {
+
+private:
+    const int _nb_points;
+    int _dimension {0};
+    float _slack {0};
+
+    std::vector<float> _upper;
+    std::vector<float> _lower;
+    std::vector<int> _assigned;
+    // The epoch of the centers each point's bounds refer to (0: none)
+    std::vector<uint32_t> _epoch;
+    uint32_t _current_epoch {0};
+
+    std::vector<std::vector<float>> _centers;
+    // Distance which each center moved since the previous epoch
+    std::vector<float> _drift;
+    int _max_drift_center {-1};
+    float _max_drift {0};
+    float _second_max_drift {0};
+    // Half the distance from each center to its nearest other center
+    std::vector<float> _half_min_center_dist;
+
+    std::atomic<uint64_t> _nb_computed {0};
+    std::atomic<uint64_t> _nb_skipped {0};
+
+public:
+    KMeansBounds(int nbPoints);
+
+    // Begins a new epoch if the centers differ from the ones of the current epoch.
+    void setCenters(const std::vector<std::vector<float>>& centers, int dimension);
+
+    // Assigns each point in [begin, end) to its nearest center, using the given
+    // kernel (which must hold the same centers) for exact assignments.
+    // The work is split like in KMeansAssignmentKernel::assignParallel.
+    bool assignParallel(const KMeansAssignmentKernel& kernel, const float* points, int begin, int end,
+        int* membership, int nbThreads, const std::function<bool(int)>& interrupt);
+
+    // Returns the numbers of computed and of skipped point-center distances
+    // since the last call.
+    std::pair<uint64_t, uint64_t> extractDistanceCounts();
+
+private:
+    void assignChunk(const KMeansAssignmentKernel& kernel, const float* points, int begin, int end, int* membership);
+    inline bool canSkip(float upper, float bound) const {
+        return upper * (1 + _slack) < bound * (1 - _slack);
+    }
+};
@@ -0,0 +1,35 @@
+
+#include <string>
+
+#include "kmeans_reader.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+
+// Converts a k-means instance from the plain text format
+// into the binary point file format (see KMeansPointFile).
+int main(int argc, char** argv) {
+
+    Timer::init();
+    Logger::LoggerConfig logConfig;
+    logConfig.rank = 0;
+    logConfig.verbosity = V2_INFO;
+    Logger::init(logConfig);
+
+    if (argc != 3) {
+        LOG(V0_CRIT, "Usage: %s <input-text-file> <output-point-file>\n", argv[0]);
+        return 1;
+    }
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+
+    float time = Timer::elapsedSeconds();
+    int nbPoints, dimension;
+    if (!KMeansReader::convertToPointFile(input, output, nbPoints, dimension)) {
+        LOG(V0_CRIT, "[ERROR] Conversion of %s failed\n", input.c_str());
+        return 1;
+    }
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "Converted %i points of dimension %i from %s to %s in %.3fs\n",
+        nbPoints, dimension, input.c_str(), output.c_str(), time);
+    return 0;
+}
@@ -6,7 +6,7 @@
 
 #include "app/job.hpp"
 #include "app/job_tree.hpp"
-#include "comm/job_tree_all_reduction.hpp"
+#include "comm/job_tree_pipelined_all_reduction.hpp"
 #include "comm/msgtags.h"
 #include "comm/mympi.hpp"
 #include "kmeans_utils.hpp"
@@ -43,6 +43,7 @@ void KMeansJob::appl_start() {
 
     loadInstance();
     _cluster_membership.assign(_num_points, -1);
+    if (_params.kmeansBounds()) _bounds.reset(new KMeansBounds(_num_points));
 
     _local_cluster_centers.resize(_num_clusters);
     _cluster_centers.resize(_num_clusters);
@@ -56,7 +57,7 @@ void KMeansJob::appl_start() {
         doInitWork();
     }
 }
-void KMeansJob::initReducer(JobMessage& msg) {
+void KMeansJob::initReducer() {
     JobTree& tempJobTree = getJobTree();
 
     int lIndex = _my_index * 2 + 1;
@@ -91,35 +92,29 @@ void KMeansJob::initReducer(JobMessage& msg) {
             }
         }
     }
-    // msg.payload = clusterCentersToBroadcast(clusterCenters);
-    // msg.payload.push_back(countCurrentWorkers);
-
-    _reducer.reset(new JobTreeAllReduction(tempJobTree,
+    _reducer.reset(new JobTreePipelinedAllReduction(tempJobTree.getSnapshot(),
                                           JobMessage(getId(), getContextId(),
                                                      getRevision(),
                                                      1,
                                                      MSG_ALLREDUCE_CLAUSES),
-                                          std::vector<int>(_all_red_elem_size, 0),
-                                          folder));
+                                          std::vector<float>(_all_red_elem_size, 0),
+                                          _reduce_segment_size,
+                                          [&](float* acc, const float* other, size_t offset, size_t size) {
+                                              aggregateSegment(acc, other, offset, size);
+                                          }));
 
     _reducer->setTransformationOfElementAtRoot(rootTransform);
     _reducer->disableBroadcast();
-    LOG(V5_DEBG, "KMDBG myIndex: %i advanceCollective\n", _my_index);
-    advanceCollective(msg, tempJobTree);
+    // Children outside of the current workers do not contribute
     if (tempJobTree.hasLeftChild() && !(lIndex < _num_curr_workers)) {
         _left_done = true;
-        _base_msg.tag = MSG_ALLREDUCE_CLAUSES;
-        _base_msg.payload = std::vector<int>(_all_red_elem_size, 0);
-
-        LOG(V5_DEBG, "KMDBG myIndex: %i send fill left\n", _my_index);
-        _reducer->receive(tempJobTree.getLeftChildNodeRank(), MSG_JOB_TREE_REDUCTION, _base_msg);
+        LOG(V5_DEBG, "KMDBG myIndex: %i prune left\n", _my_index);
+        _reducer->pruneChild(tempJobTree.getLeftChildNodeRank());
     }
     if (tempJobTree.hasRightChild() && !(rIndex < _num_curr_workers)) {
         _right_done = true;
-        _base_msg.tag = MSG_ALLREDUCE_CLAUSES;
-        _base_msg.payload = std::vector<int>(_all_red_elem_size, 0);
-        LOG(V5_DEBG, "KMDBG myIndex: %i send fill right\n", _my_index);
-        _reducer->receive(tempJobTree.getRightChildNodeRank(), MSG_JOB_TREE_REDUCTION, _base_msg);
+        LOG(V5_DEBG, "KMDBG myIndex: %i prune right\n", _my_index);
+        _reducer->pruneChild(tempJobTree.getRightChildNodeRank());
     }
 
     _has_reducer = true;
@@ -127,11 +122,58 @@ void KMeansJob::initReducer(JobMessage& msg) {
 
 void KMeansJob::sendRootNotification() {
     _init_send = false;
-    _base_msg.tag = MSG_BROADCAST_DATA;
-    _base_msg.payload = clusterCentersToBroadcast(_cluster_centers);
-    _base_msg.payload.push_back(_num_curr_workers);
     LOG(V5_DEBG, "KMDBG myIndex: %i sendRootNotification0\n", _my_index);
-    getJobTree().sendToRoot(_base_msg);
+    broadcastClusterCenters(_num_curr_workers);
+}
+
+void KMeansJob::broadcastClusterCenters(int numWorkers) {
+    _time_iteration_start = Timer::elapsedSeconds();
+    std::vector<float> centers;
+    centers.reserve(_num_clusters * _dimension);
+    for (auto& center : _cluster_centers) centers.insert(centers.end(), center.begin(), center.begin() + _dimension);
+
+    // The segments travel down the job tree independently (see receiveClusterCenterSegment)
+    const size_t segmentSize = _params.kmeansSegmentSize();
+    const int nbSegments = std::max(1UL, (centers.size() + segmentSize - 1) / segmentSize);
+    _base_msg.tag = MSG_BROADCAST_DATA;
+    for (int s = 0; s < nbSegments; ++s) {
+        const size_t begin = std::min(centers.size(), s * segmentSize);
+        const size_t end = std::min(centers.size(), begin + segmentSize);
+        JobTreePipelinedAllReduction::writeFloats(_base_msg.payload, {numWorkers, s, nbSegments},
+            centers.data() + begin, end - begin);
+        getJobTree().sendToRoot(_base_msg);
+    }
+}
+
+bool KMeansJob::receiveClusterCenterSegment(JobMessage& msg) {
+    const int numWorkers = msg.payload[0];
+    const int segmentIdx = msg.payload[1];
+    const int nbSegments = msg.payload[2];
+    const size_t segmentSize = _params.kmeansSegmentSize();
+
+    // Forward right away: each level of the tree receives the next segment
+    // while its children receive this one
+    forwardToChildren(msg, numWorkers);
+
+    if (_nb_received_center_segments == 0) {
+        _time_first_center_segment = Timer::elapsedSeconds();
+        _received_centers.resize(_num_clusters * _dimension);
+    }
+    const size_t begin = std::min(_received_centers.size(), segmentIdx * segmentSize);
+    const size_t end = std::min(_received_centers.size(), begin + segmentSize);
+    assert(msg.payload.size() == 3 + end - begin);
+    JobTreePipelinedAllReduction::readFloats(msg.payload, 3, _received_centers.data() + begin, end - begin);
+    if (++_nb_received_center_segments < nbSegments) return false;
+
+    // All segments present
+    _nb_received_center_segments = 0;
+    for (int k = 0; k < _num_clusters; ++k) {
+        _cluster_centers[k].assign(_received_centers.data() + k * _dimension, _received_centers.data() + (k+1) * _dimension);
+    }
+    _num_curr_workers = numWorkers;
+    LOG(V5_DEBG, "KMDBG myIndex: %i countCurrentWorkers: %i, centers received in %.4fs (%i segments)\n",
+        _my_index, _num_curr_workers, Timer::elapsedSeconds() - _time_first_center_segment, nbSegments);
+    return true;
 }
 void KMeansJob::doInitWork() {
     _init_msg_task = ProcessWideThreadPool::get().addTask([&]() {
@@ -183,6 +225,8 @@ void KMeansJob::reset() {
     _my_index = -2;
     _work.clear();
     _work_done.clear();
+    _nb_received_center_segments = 0;
+    _deferred_returns.clear();
     _terminate = true;
     if (_init_msg_task.valid()) _init_msg_task.get();
     if (_calculating_task.valid()) _calculating_task.get();
@@ -228,7 +272,7 @@ void KMeansJob::appl_communicate() {
                 if (!_right_done) _right_done = (currentIndex == (_my_index * 2 + 2));
                 LOG(V5_DEBG, "KMDBG myIndex: %i Start Calc\n", _my_index);
                 if (!_skip_current_iter) {
-                    calcNearestCenter(metric, cI);
+                    calcNearestCenter(cI);
                 }
                 LOG(V5_DEBG, "KMDBG myIndex: %i End Calc childs\n", _my_index);
 
@@ -252,10 +296,9 @@ void KMeansJob::appl_communicate() {
                 calcCurrentClusterCenters();
 
                 // LOG(V5_DEBG, "clusterCenters: \n%s\n", dataToString(localClusterCenters).c_str());
-                return clusterCentersToReduce(_local_sum_members, _local_cluster_centers);
+                return clusterCentersToReduce();
             };
             (_reducer)->produce(producer);
-            (_reducer)->advance();
         }
         _calculating_finished = false;
         LOG(V5_DEBG, "KMDBG myIndex: %i all work Finished END!!!\n", _my_index);
@@ -264,22 +307,16 @@ void KMeansJob::appl_communicate() {
         if (!_skip_current_iter) {
             if (_is_root && (_reducer)->hasResult()) {
                 LOG(V5_DEBG, "KMDBG myIndex: %i received Result from Transform\n", _my_index);
-                setClusterCenters((_reducer)->extractResult());
+                // The new centers were already set by rootTransform
+                (_reducer)->extractResult();
                 _cluster_membership.assign(_num_points, -1);
 
-                _base_msg.tag = MSG_BROADCAST_DATA;
-                _base_msg.payload = clusterCentersToBroadcast(_cluster_centers);
-                _base_msg.payload.push_back(_num_curr_workers);
                 LOG(V5_DEBG, "KMDBG myIndex: %i sendRootNotification1\n", _my_index);
-                getJobTree().sendToRoot(_base_msg);
-                // only root...?
-
-                // continue broadcasting
+                broadcastClusterCenters(this->getVolume());
 
                 // LOG(V5_DEBG, "KMDBG myIndex: %i clusterCenters: \n%s\n", getJobTree().getIndex(),
                 //     dataToString(clusterCenters).c_str());
             }
-            (_reducer)->advance();
         } else {
             LOG(V5_DEBG, "KMDBG Skip Iter\n");
             _skip_current_iter = false;
@@ -288,11 +325,8 @@ void KMeansJob::appl_communicate() {
             _right_done = false;
             _reducer.reset();
             _cluster_membership.assign(_num_points, -1);
-            _base_msg.tag = MSG_BROADCAST_DATA;
-            _base_msg.payload = clusterCentersToBroadcast(_cluster_centers);
-            _base_msg.payload.push_back(this->getVolume());
             LOG(V5_DEBG, "KMDBG myIndex: %i sendRootNotification2\n", _my_index);
-            getJobTree().sendToRoot(_base_msg);
+            broadcastClusterCenters(this->getVolume());
         }
     }
 }
@@ -323,6 +357,8 @@ void KMeansJob::appl_communicate(int source, int mpiTag, JobMessage& msg) {
     LOG(V5_DEBG, "KMDBG myIndex: %i source: %i mpiTag: %i payloadSize: %lu\n", _my_index, sourceIndex, mpiTag, msg.payload.size());
     if (!_loaded) {
         LOG(V5_DEBG, "KMDBG myIndex: %i not Ready: %i mpiTag: %i\n", _my_index, sourceIndex, mpiTag);
+        // Return the centers only once, i.e., their first segment
+        if (msg.tag == MSG_BROADCAST_DATA && !msg.returnedToSender && msg.payload.size() >= 3 && msg.payload[1] != 0) return;
         if (_my_index < 0) {
             _my_index = getJobTree().getIndex();
         }
@@ -331,33 +367,13 @@ void KMeansJob::appl_communicate(int source, int mpiTag, JobMessage& msg) {
         return;
     }
     if (msg.returnedToSender) {
-        // I will do it
-        std::vector<int> missingChilds;
-        LOG(V5_DEBG, "KMDBG myIndex: %i returnFrom: %i mpiTag: %i\n", _my_index, sourceIndex, mpiTag);
-        LOG(V5_DEBG, "KMDBG !leftDone %i !getJobTree().hasLeftChild() %i getJobTree().getLeftChildIndex() < countCurrentWorkers %i\n", !_left_done, !getJobTree().hasLeftChild(), getJobTree().getLeftChildIndex() < _num_curr_workers);
-        LOG(V5_DEBG, "KMDBG !leftDone %i\n", msg.payload[0]);
-        if (!_left_done && (msg.payload[0] == getJobTree().getLeftChildIndex() || !getJobTree().hasLeftChild()) && getJobTree().getLeftChildIndex() < _num_curr_workers) {
-            // missing left child
-            _left_done = true;
-            missingChilds.push_back(getJobTree().getLeftChildIndex());
-            LOG(V5_DEBG, "KMDBG myIndex: %i LsourceIndex: %i\n", _my_index, sourceIndex);
-        }
-        if (!_right_done && (msg.payload[0] == getJobTree().getRightChildIndex() || !getJobTree().hasRightChild()) && getJobTree().getRightChildIndex() < _num_curr_workers) {
-            // missing right child
-            _right_done = true;
-            missingChilds.push_back(getJobTree().getRightChildIndex());
-            LOG(V5_DEBG, "KMDBG myIndex: %i RsourceIndex: %i\n", _my_index, sourceIndex);
-        }
-        for (auto child : missingChilds) {
-            auto grandChilds = KMeansUtils::childIndexesOf(child, _num_curr_workers);
-            msg.payload = std::vector<int>(_all_red_elem_size, 0);
-            msg.tag = MSG_ALLREDUCE_CLAUSES;
-            (_reducer)->receive(source, MSG_JOB_TREE_REDUCTION, msg);
-            _work.push_back(child);
-            for (auto child : grandChilds) {
-                _work.push_back(child);
-            }
+        if (msg.tag == MSG_BROADCAST_DATA && _nb_received_center_segments > 0) {
+            // The centers were forwarded before all of them arrived here:
+            // wait for the reducer of the new iteration
+            _deferred_returns.emplace_back(source, std::move(msg));
+            return;
         }
+        handleReturnedMessage(source, msg);
         return;
     }
 
@@ -376,25 +392,30 @@ void KMeansJob::appl_communicate(int source, int mpiTag, JobMessage& msg) {
     }
 
     if (msg.tag == MSG_BROADCAST_DATA) {
-        LOG(V5_DEBG, "KMDBG myIndex: %i MSG_BROADCAST_DATA \n", _my_index);
-        LOG(V5_DEBG, "KMDBG myIndex: %i Workers: %i!\n", _my_index, _num_curr_workers);
-        setClusterCenters(msg.payload);
-        if (_my_index < _num_curr_workers) {
-            initReducer(msg);
+        // Payload: #workers, segment index, #segments, segment of the cluster centers
+        const int numWorkers = msg.payload[0];
+        LOG(V5_DEBG, "KMDBG myIndex: %i MSG_BROADCAST_DATA segment %i/%i\n", _my_index, msg.payload[1], msg.payload[2]);
+        LOG(V5_DEBG, "KMDBG myIndex: %i Workers: %i!\n", _my_index, numWorkers);
+        if (_my_index < numWorkers) {
+            if (!receiveClusterCenterSegment(msg)) return;
+            initReducer();
             _cluster_membership.assign(_num_points, -1);
 
-            // continue broadcasting
-
             // LOG(V5_DEBG, "KMDBG myIndex: %i clusterCenters: \n%s\n", getJobTree().getIndex(),
             //     dataToString(clusterCenters).c_str());
             _calculating_task = ProcessWideThreadPool::get().addTask([&]() {
                 LOG(V5_DEBG, "KMDBG myIndex: %i Start Calc\n", _my_index);
-                calcNearestCenter(metric, _my_index);
+                calcNearestCenter(_my_index);
                 LOG(V5_DEBG, "KMDBG myIndex: %i End Calc basic\n", _my_index);
                 _calculating_finished = true;
             });
+            for (auto& [returnSource, returnedMsg] : _deferred_returns) handleReturnedMessage(returnSource, returnedMsg);
+            _deferred_returns.clear();
         } else {
             LOG(V5_DEBG, "KMDBG myIndex: %i not in range\n", _my_index);
+            // Return the centers only once, i.e., their first segment
+            if (msg.payload[1] != 0) return;
+            _num_curr_workers = numWorkers;
             msg.payload.assign(1, _my_index);
             if (_my_index < 0) {
                 _my_index = getJobTree().getIndex();
@@ -404,14 +425,41 @@ void KMeansJob::appl_communicate(int source, int mpiTag, JobMessage& msg) {
         }
     }
 }
-void KMeansJob::advanceCollective(JobMessage& msg, JobTree& jobTree) {
-    // Broadcast to children
-
-    if (jobTree.hasLeftChild() && jobTree.getLeftChildIndex() < _num_curr_workers) {
+void KMeansJob::handleReturnedMessage(int source, JobMessage& msg) {
+    // I will do it
+    std::vector<int> missingChilds;
+    int sourceIndex = getIndex(source);
+    LOG(V5_DEBG, "KMDBG myIndex: %i returnFrom: %i tag: %i\n", _my_index, sourceIndex, msg.tag);
+    LOG(V5_DEBG, "KMDBG !leftDone %i !getJobTree().hasLeftChild() %i getJobTree().getLeftChildIndex() < countCurrentWorkers %i\n", !_left_done, !getJobTree().hasLeftChild(), getJobTree().getLeftChildIndex() < _num_curr_workers);
+    LOG(V5_DEBG, "KMDBG !leftDone %i\n", msg.payload[0]);
+    if (!_left_done && (msg.payload[0] == getJobTree().getLeftChildIndex() || !getJobTree().hasLeftChild()) && getJobTree().getLeftChildIndex() < _num_curr_workers) {
+        // missing left child
+        _left_done = true;
+        missingChilds.push_back(getJobTree().getLeftChildIndex());
+        LOG(V5_DEBG, "KMDBG myIndex: %i LsourceIndex: %i\n", _my_index, sourceIndex);
+    }
+    if (!_right_done && (msg.payload[0] == getJobTree().getRightChildIndex() || !getJobTree().hasRightChild()) && getJobTree().getRightChildIndex() < _num_curr_workers) {
+        // missing right child
+        _right_done = true;
+        missingChilds.push_back(getJobTree().getRightChildIndex());
+        LOG(V5_DEBG, "KMDBG myIndex: %i RsourceIndex: %i\n", _my_index, sourceIndex);
+    }
+    for (auto child : missingChilds) {
+        auto grandChilds = KMeansUtils::childIndexesOf(child, _num_curr_workers);
+        if (_reducer) _reducer->pruneChildByIndex(child);
+        _work.push_back(child);
+        for (auto child : grandChilds) {
+            _work.push_back(child);
+        }
+    }
+}
+void KMeansJob::forwardToChildren(JobMessage& msg, int numWorkers) {
+    JobTree& jobTree = getJobTree();
+    if (jobTree.hasLeftChild() && jobTree.getLeftChildIndex() < numWorkers) {
         LOG(V5_DEBG, "KMDBG myIndex: %i sendTo %i type: %i\n", _my_index, jobTree.getLeftChildIndex(), MSG_SEND_APPLICATION_MESSAGE);
         getJobTree().sendToLeftChild(msg);
     }
-    if (jobTree.hasRightChild() && jobTree.getRightChildIndex() < _num_curr_workers) {
+    if (jobTree.hasRightChild() && jobTree.getRightChildIndex() < numWorkers) {
         LOG(V5_DEBG, "KMDBG myIndex: %i sendTo %i type: %i\n", _my_index, jobTree.getRightChildIndex(), MSG_SEND_APPLICATION_MESSAGE);
         getJobTree().sendToRightChild(msg);
     }
@@ -425,6 +473,8 @@ void KMeansJob::loadInstance() {
     _num_points = metadata[2];
     LOG(V5_DEBG, "                          countClusters: %i dimension %i pointsCount: %i\n", _num_clusters, _dimension, _num_points);
     _all_red_elem_size = (_dimension + 1) * _num_clusters;
+    // Reduction segments consist of whole rows [count, center coordinates]
+    _reduce_segment_size = std::max(1, _params.kmeansSegmentSize() / (_dimension + 1)) * (_dimension + 1);
     setMaxDemand();
 }
 
@@ -452,16 +502,15 @@ void KMeansJob::setRandomStartCenters() {  // use RNG with seed
     }
 }
 
-void KMeansJob::calcNearestCenter(std::function<float(const float* p1, const float* p2, const size_t dim)> metric, int intervalId) {
-    int currentCluster;
-    float currentDistance;
-    float distanceToCluster;
+void KMeansJob::calcNearestCenter(int intervalId) {
     // while own or child slices todo
     int startIndex = static_cast<int>(static_cast<float>(_num_points) * (static_cast<float>(intervalId) / static_cast<float>(_num_curr_workers)));
     int endIndex = static_cast<int>(static_cast<float>(_num_points) * (static_cast<float>(intervalId + 1) / static_cast<float>(_num_curr_workers)));
     LOG(V5_DEBG, "KMDBG MI: %i intervalId: %i PC: %i cW: %i start:%i end:%i!!      iter:%i k:%i \n", _my_index, intervalId, _num_points, _num_curr_workers, startIndex, endIndex, _iterations_done, _num_clusters);
-    for (int pointID = startIndex; pointID < endIndex; ++pointID) {
-        if (_terminate) return;
+    const float time = Timer::elapsedSeconds();
+    std::atomic_bool skipIter {false};
+    auto interrupt = [&](int pointID) {
+        if (_terminate) return true;
         // LOG(V1_WARN, "(pointID / endIndex) < 0.25: %i iAmRoot: %i countCurrentWorkers == 1: %i std::find(work.begin(), work.end(), 1) != work.end() && std::find(work.begin(), work.end(), 2) != work.end()): %i leftDone && rightDone:%i this->getVolume() > 1:%i\n", (pointID / endIndex) < 0.25, iAmRoot, countCurrentWorkers == 1, std::find(work.begin(), work.end(), 1) != work.end() && std::find(work.begin(), work.end(), 2) != work.end(), leftDone && rightDone,  this->getVolume() > 1);
 
         if (((float)pointID / endIndex) < 0.25 &&
@@ -470,25 +519,34 @@ void KMeansJob::calcNearestCenter(std::function<float(const float* p1, const flo
              (std::find(_work.begin(), _work.end(), 1) != _work.end() && std::find(_work.begin(), _work.end(), 2) != _work.end())) &&
             (_left_done && _right_done) &&
             this->getVolume() > 1) {
+            skipIter = true;
+            return true;
+        }
+        return false;
+    };
+    // The points of the interval are distributed over all threads of this process
+    _assignment_kernel.setCenters(_cluster_centers, _dimension);
+    bool completed;
+    if (_bounds) {
+        _bounds->setCenters(_cluster_centers, _dimension);
+        completed = _bounds->assignParallel(_assignment_kernel, _points_start, startIndex, endIndex,
+            _cluster_membership.data(), _params.numThreadsPerProcess(), interrupt);
+    } else {
+        completed = _assignment_kernel.assignParallel(_points_start, startIndex, endIndex,
+            _cluster_membership.data(), _params.numThreadsPerProcess(), interrupt);
+    }
+    if (!completed) {
+        if (skipIter) {
             LOG(V3_VERB, "%s : will skip Iter\n", toStr());
             _skip_current_iter = true;
             _work.clear();
             _work_done.clear();
-            return;
         }
-        currentCluster = -1;
-        currentDistance = std::numeric_limits<float>::infinity();
-        for (int clusterID = 0; clusterID < _num_clusters; ++clusterID) {
-            distanceToCluster = metric(getKMeansData(pointID), _cluster_centers[clusterID].data(), _dimension);
-            if (distanceToCluster < currentDistance) {
-                currentCluster = clusterID;
-                currentDistance = distanceToCluster;
-            }
-        }
-
-        _cluster_membership[pointID] = currentCluster;
+        return;
     }
-    LOG(V5_DEBG, "KMDBG MI: %i intervalId: %i PC: %i cW: %i start:%i end:%i COMPLETED iter:%i \n", _my_index, intervalId, _num_points, _num_curr_workers, startIndex, endIndex, _iterations_done);
+    const float elapsed = Timer::elapsedSeconds() - time;
+    LOG(V5_DEBG, "KMDBG MI: %i intervalId: %i PC: %i cW: %i start:%i end:%i COMPLETED iter:%i time:%.4f (%.1f points/s, %s)\n", _my_index, intervalId, _num_points, _num_curr_workers, startIndex, endIndex, _iterations_done,
+        elapsed, (endIndex - startIndex) / std::max(elapsed, 1e-6f), KMeansAssignmentKernel::getIsaName(_assignment_kernel.getIsa()));
 }
 
 void KMeansJob::calcCurrentClusterCenters() {
@@ -517,6 +575,11 @@ void KMeansJob::calcCurrentClusterCenters() {
             }
         }
     }
+    if (_bounds) {
+        auto [nbComputed, nbSkipped] = _bounds->extractDistanceCounts();
+        LOG(V3_VERB, "%s : Iteration %i - skipped %lu/%lu distances (%.3f)\n", toStr(), _iterations_done,
+            nbSkipped, nbComputed + nbSkipped, nbSkipped / (double) std::max(1UL, nbComputed + nbSkipped));
+    }
     ++_iterations_done;
 }
 
@@ -598,140 +661,43 @@ std::vector<float> KMeansJob::clusterCentersToSolution() {
     return result;
 }
 
-std::vector<int> KMeansJob::clusterCentersToBroadcast(const std::vector<Point>& reduceClusterCenters) {
-    std::vector<int> result;
-    result.resize(reduceClusterCenters.size() * _dimension);
-    int i = 0;
-    for (auto point : reduceClusterCenters) {
-        auto centerData = point.data();
-        for (int entry = 0; entry < _dimension; ++entry) {
-            result[i++] = (*((int*)(centerData + entry)));
-        }
-    }
-    // LOG(V5_DEBG, "KMDBG reduce in clusterCentersToBroadcast: \n%s\n",
-    //     dataToString(result).c_str());
-    return result;
-}
-
-std::vector<KMeansJob::Point> KMeansJob::broadcastToClusterCenters(const std::vector<int>& reduce) {
-    std::vector<Point> localClusterCentersResult;
-    const int elementsCount = _all_red_elem_size - _num_clusters;
-    const int* reduceData = reduce.data();
-
-    reduceData += _num_clusters;
-
-    localClusterCentersResult.resize(_num_clusters);
+std::vector<float> KMeansJob::clusterCentersToReduce() {
+    // One row [count, center coordinates] per cluster. The counts are only used as weights,
+    // so their representation as floats (exact up to 2^24) is of no concern.
+    std::vector<float> result;
+    result.reserve(_all_red_elem_size);
     for (int k = 0; k < _num_clusters; ++k) {
-        localClusterCentersResult[k].resize(_dimension);
-        auto currentCenter = localClusterCentersResult[k].data();
-        auto receivedCenter = reduceData + k * _dimension;
-        for (int d = 0; d < _dimension; ++d) {
-            currentCenter[d] = *((float*)(receivedCenter + d));
-        }
+        result.push_back(_local_sum_members[k]);
+        result.insert(result.end(), _local_cluster_centers[k].begin(), _local_cluster_centers[k].begin() + _dimension);
     }
-
-    return localClusterCentersResult;
-}
-void KMeansJob::setClusterCenters(const std::vector<int>& reduce) {
-    const int elementsCount = _all_red_elem_size - _num_clusters;
-    for (int k = 0; k < _num_clusters; ++k) {
-        assert(k < _cluster_centers.size());
-        auto& currentCenter = _cluster_centers[k];
-        for (int d = 0; d < _dimension; ++d) {
-            assert(k*_dimension + d < reduce.size());
-            int val = reduce[k*_dimension + d];
-            currentCenter[d] = *((float*)(&val));
-        }
-    }
-    _num_curr_workers = reduce[elementsCount];
-    LOG(V5_DEBG, "KMDBG myIndex: %i countCurrentWorkers: %i\n", _my_index, _num_curr_workers);
-}
-
-std::vector<int> KMeansJob::clusterCentersToReduce(const std::vector<int>& reduceSumMembers, const std::vector<Point>& reduceClusterCenters) {
-    std::vector<int> result;
-    int i = 0;
-    std::vector<int> tempCenters = clusterCentersToBroadcast(reduceClusterCenters);
-
-    result.resize(reduceSumMembers.size());
-
-    for (auto entry : reduceSumMembers) {
-        result[i++] = entry;
-    }
-    result.insert(result.end(), tempCenters.begin(), tempCenters.end());
-
     return result;
 }
 
-std::pair<std::vector<std::vector<float>>, std::vector<int>>
-KMeansJob::reduceToclusterCenters(const std::vector<int>& reduce) {
-    // auto [centers, counts] = reduceToclusterCenters(); //call example
-    std::vector<int> localSumMembersResult;
-    const int elementsCount = _all_red_elem_size - _num_clusters;
-
-    const int* reduceData = reduce.data();
-
-    localSumMembersResult.assign(_num_clusters, 0);
-    for (int i = 0; i < _num_clusters; ++i) {
-        // LOG(V5_DEBG, "i: %d\n", i);
-        localSumMembersResult[i] = reduceData[i];
+void KMeansJob::setReducedClusterCenters(const std::vector<float>& reduced) {
+    for (int k = 0; k < _num_clusters; ++k) {
+        const float* row = reduced.data() + k * (_dimension + 1);
+        _cluster_centers[k].assign(row + 1, row + 1 + _dimension);
     }
-
-    return std::pair(std::move(broadcastToClusterCenters(reduce)), std::move(localSumMembersResult));
 }
 
-std::vector<int> KMeansJob::aggregate(const std::list<std::vector<int>>& messages) {
-    std::vector<std::vector<KMeansJob::Point>> centers;
-    std::vector<int> counts;
-    std::vector<int> tempSumMembers;
-    std::vector<Point> tempClusterCenters;
-    const int countMessages = messages.size();
-    centers.resize(countMessages);
-    counts.reserve(countMessages * _num_clusters);
-    auto message = messages.begin();
-    // LOG(V5_DEBG, "                         myIndex: %i countMessages: %d\n", myIndex, countMessages);
-    for (int i = 0; i < countMessages; ++i) {
-        auto data = reduceToclusterCenters(*message);
-        ++message;
-        centers[i] = std::move(data.first);
-        counts.insert(counts.end(), data.second.begin(), data.second.end());
-
-        // LOG(V5_DEBG, "                         myIndex: %i counts[%d] : \n%s\n", myIndex, i, dataToString(counts[i]).c_str());
-        //  LOG(V5_DEBG, "clusterCentersI: \n%s\n", dataToString(centers[i]).c_str());
-    }
-
-    tempSumMembers.resize(_num_clusters);
-    for (int i = 0; i < countMessages; ++i) {
-        for (int j = 0; j < _num_clusters; ++j) {
-            tempSumMembers[j] = tempSumMembers[j] + counts[i * _num_clusters + j];
-
-            // LOG(V5_DEBG, "tempSumMembers[%d] + counts[%d][%d] : \n%d\n",j,i,j, tempSumMembers[j] + counts[i][j]);
-            // LOG(V5_DEBG, "tempSumMembers[%d] : \n%d\n",j, tempSumMembers[j]);
-            // LOG(V5_DEBG, "KRITcounts[%d] : \n%s\n",i, dataToString(tempSumMembers).c_str());
+void KMeansJob::aggregateSegment(float* acc, const float* other, size_t offset, size_t size) {
+    // Count-weighted mean of each cluster center
+    const size_t rowSize = _dimension + 1;
+    assert(offset % rowSize == 0 && size % rowSize == 0);
+    for (size_t row = 0; row < size; row += rowSize) {
+        const float accCount = acc[row];
+        const float otherCount = other[row];
+        if (otherCount == 0) continue;
+        if (accCount == 0) {
+            std::copy(other + row, other + row + rowSize, acc + row);
+            continue;
         }
-    }
-    tempClusterCenters.resize(_num_clusters);
-    for (int i = 0; i < _num_clusters; ++i) {
-        tempClusterCenters[i].assign(_dimension, 0);
-    }
-
-    float ratio;
-    float currentSum;
-
-    for (int i = 0; i < countMessages; ++i) {
-        std::vector<KMeansJob::Point>& currentMsg = centers[i];
-        for (int j = 0; j < _num_clusters; ++j) {
-            currentSum = static_cast<float>(tempSumMembers[j]);
-            if (currentSum != 0) {
-                KMeansJob::Point& currentCenter = tempClusterCenters[j];
-                KMeansJob::Point& currentMsgCenter = currentMsg[j];
-                ratio = static_cast<float>(counts[i * _num_clusters + j]) /
-                        currentSum;
-                for (int k = 0; k < _dimension; ++k) {
-                    currentCenter[k] += currentMsgCenter[k] * ratio;
-                }
-            }
+        const float total = accCount + otherCount;
+        const float accRatio = accCount / total;
+        const float otherRatio = otherCount / total;
+        for (size_t d = 1; d < rowSize; ++d) {
+            acc[row + d] = acc[row + d] * accRatio + other[row + d] * otherRatio;
         }
+        acc[row] = total;
     }
-
-    return clusterCentersToReduce(tempSumMembers, tempClusterCenters);  // localSumMembers, tempClusterCenters
-}
\ No newline at end of file
+}
@@ -9,7 +9,9 @@
 
 #include "app/job.hpp"
 #include "app/sat/job/sat_constants.h"
-#include "comm/job_tree_all_reduction.hpp"
+#include "comm/job_tree_pipelined_all_reduction.hpp"
+#include "kmeans_assignment.hpp"
+#include "kmeans_bounds.hpp"
 #include "kmeans_utils.hpp"
 #include "util/params.hpp"
 
@@ -53,36 +55,29 @@ class KMeansJob : public Job {
     int _num_curr_workers;
     JobMessage _base_msg;
     JobResult _internal_result;
-    std::unique_ptr<JobTreeAllReduction> _reducer;
-
-    const std::function<float(const float* p1, const float* p2, const size_t dim)> metric =
-        [&](const float* p1, const float* p2, const size_t dim) {
-            return KMeansUtils::eukild(p1, p2, dim);
-        };
-    const std::function<std::vector<int>(std::list<std::vector<int>>&)> folder =
-        [&](std::list<std::vector<int>>& elems) {
-            return aggregate(elems);
-        };
-    const std::function<std::vector<int>(const std::vector<int>&)> rootTransform =
-        [&](const std::vector<int>& payload) {
+    // Reduction of [count, center coordinates] per cluster, in segments of whole rows
+    std::unique_ptr<JobTreePipelinedAllReduction> _reducer;
+    size_t _reduce_segment_size;
+    // Cluster centers arriving in segments of the broadcast
+    std::vector<float> _received_centers;
+    int _nb_received_center_segments = 0;
+    float _time_first_center_segment = 0;
+    float _time_iteration_start = 0;
+    // Messages returned by children while the centers were still arriving
+    std::vector<std::pair<int, JobMessage>> _deferred_returns;
+    KMeansAssignmentKernel _assignment_kernel;
+    std::unique_ptr<KMeansBounds> _bounds;
+
+    const std::function<std::vector<float>(const std::vector<float>&)> rootTransform =
+        [&](const std::vector<float>& reduced) {
             LOG(V5_DEBG, "KMDBG myIndex: %i start Roottransform\n", _my_index);
-            auto data = reduceToclusterCenters(payload);
-            const int* sumMembers;
-
-            _cluster_centers = data.first;
-            sumMembers = data.second.data();
-            int sum = 0;
-            for (int i = 0; i < _num_clusters; ++i) {
-                sum += sumMembers[i];
-            }
-            
-            auto transformed = clusterCentersToBroadcast(_cluster_centers);
-            transformed.push_back(this->getVolume());  // will be countCurrentWorkers
+            setReducedClusterCenters(reduced);
             LOG(V5_DEBG, "KMDBG COMMSIZE: %i myIndex: %i \n",
                 this->getVolume(), _my_index);
             LOG(V5_DEBG, "KMDBG Children: %i\n",
                 this->getJobTree().getNumChildren());
 
+            const float reductionTime = Timer::elapsedSeconds() - _reducer->getTimeOfFirstContribution();
             if (!centersChanged(0.001f)) {
                 LOG(V2_INFO, "%s : finished after %i iterations\n", toStr(), _iterations_done);
                 _internal_result.result = RESULT_SAT;
@@ -95,15 +90,17 @@ class KMeansJob : public Job {
                 _internal_result.setSolutionToSerialize((int*)(solution.data()), solution.size());
                 _finished_job = true;
                 LOG(V5_DEBG, "%s : solution cluster centers: \n%s\n", toStr(), dataToString(_cluster_centers).c_str());
-                return std::move(std::vector<int>(_all_red_elem_size, 0));
+                return reduced;
 
             } else {
                 if (_is_root && _iterations_done == 1) {
                     LOG(V5_DEBG, "KMDBG first iteration finished\n");
                 }
-                LOG(V3_VERB, "%s : Iteration %i - k:%i w:%i\n", toStr(), _iterations_done, _num_clusters, this->getVolume());
+                LOG(V3_VERB, "%s : Iteration %i - k:%i w:%i time:%.4f collective:%.4f segments:%i\n", toStr(), _iterations_done,
+                    _num_clusters, this->getVolume(), Timer::elapsedSeconds() - _time_iteration_start,
+                    reductionTime, _reducer->getNbSegments());
                 //LOG(V2_INFO, "KMDBG Another iter %i    k:%i    w:%i   dem:%i\n", iterationsDone, countClusters, this->getVolume(), this->getDemand());
-                return transformed;
+                return reduced;
             }
         };
 
@@ -167,7 +164,7 @@ class KMeansJob : public Job {
     void doInitWork();
     void sendRootNotification();
     void setRandomStartCenters();
-    void calcNearestCenter(std::function<float(const float* p1, const float* p2, const size_t dim)> metric, int intervalId);
+    void calcNearestCenter(int intervalId);
     void calcCurrentClusterCenters();
     std::string dataToString(std::vector<Point> data);
     std::string dataToString(std::vector<int> data);
@@ -176,14 +173,14 @@ class KMeansJob : public Job {
     bool centersChanged();
     bool centersChanged(float factor);
     std::vector<float> clusterCentersToSolution();
-    std::vector<int> clusterCentersToBroadcast(const std::vector<Point>&);
-    std::vector<Point> broadcastToClusterCenters(const std::vector<int>&);
-    void setClusterCenters(const std::vector<int>&);
-    std::vector<int> clusterCentersToReduce(const std::vector<int>&, const std::vector<Point>&);
-    std::pair<std::vector<std::vector<float>>, std::vector<int>> reduceToclusterCenters(const std::vector<int>&);
-    std::vector<int> aggregate(const std::list<std::vector<int>>&);
-    void advanceCollective(JobMessage& msg, JobTree& jobTree);
-    void initReducer(JobMessage& msg);
+    std::vector<float> clusterCentersToReduce();
+    void setReducedClusterCenters(const std::vector<float>& reduced);
+    void aggregateSegment(float* acc, const float* other, size_t offset, size_t size);
+    void broadcastClusterCenters(int numWorkers);
+    bool receiveClusterCenterSegment(JobMessage& msg);
+    void forwardToChildren(JobMessage& msg, int numWorkers);
+    void initReducer();
+    void handleReturnedMessage(int source, JobMessage& msg);
     int getIndex(int rank);
     const float* getKMeansData(int point) {
         return (_points_start + _dimension * point);
@@ -0,0 +1,46 @@
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Binary point-matrix format of the k-means application. A fixed-size header
+// is followed by all points in row-major order as 32-bit floats (exactly
+// dimension values per point). This is how the points are laid out in a
+// serialized job description, so a memory-mapped point file can be ingested
+// with a single copy and without any parsing.
+// Use mallob_kmeans_convert to convert a file from the plain text format.
+struct KMeansPointFile {
+
+    static constexpr uint64_t MAGIC = 0x31534e4d4b424c4dULL; // "MLBKMNS1" (little endian)
+
+    struct Header {
+        uint64_t magic;
+        int32_t nbClusters;
+        int32_t dimension;
+        uint64_t nbPoints;
+    };
+
+    // Whether the provided data of the given size is a well-formed point file
+    // (with a number of points which fits into an int).
+    static bool isPointFile(const void* data, size_t size) {
+        if (size < sizeof(Header)) return false;
+        Header header = readHeader(data);
+        if (header.magic != MAGIC || header.dimension <= 0 || header.nbPoints > INT32_MAX) return false;
+        // Compare the number of points by division, since the header's
+        // nbPoints * dimension * sizeof(float) may overflow
+        const size_t pointSize = header.dimension * sizeof(float);
+        const size_t payloadSize = size - sizeof(Header);
+        return payloadSize % pointSize == 0 && payloadSize / pointSize == header.nbPoints;
+    }
+
+    static Header readHeader(const void* data) {
+        Header header;
+        memcpy(&header, data, sizeof(Header));
+        return header;
+    }
+
+    static const float* getPoints(const void* data) {
+        return (const float*) (((const uint8_t*) data) + sizeof(Header));
+    }
+};
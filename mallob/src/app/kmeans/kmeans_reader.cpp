@@ -1,12 +1,58 @@
 #include "kmeans_reader.hpp"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdio.h>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
+#include "kmeans_point_file.hpp"
+#include "util/logger.hpp"
 #include "util/sys/terminator.hpp"
-bool KMeansReader::read(const std::string &filename, JobDescription &desc) {
+#include "util/sys/timer.hpp"
+
+namespace KMeansReader {
+
+// Ingests a binary point file via mmap. Sets isPointFile to whether the file
+// begins like a point file; returns false if it could not be ingested.
+bool readPointFile(const std::string& filename, JobDescription& desc, bool& isPointFile) {
+    isPointFile = false;
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    uint64_t magic = 0;
+    struct stat st;
+    isPointFile = fstat(fd, &st) == 0
+        && pread(fd, &magic, sizeof(magic), 0) == sizeof(magic)
+        && magic == KMeansPointFile::MAGIC;
+    const size_t size = isPointFile ? st.st_size : 0;
+    void* mmapped = isPointFile ? mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mmapped == MAP_FAILED) return false;
+
+    bool ok = KMeansPointFile::isPointFile(mmapped, size);
+    auto header = KMeansPointFile::readHeader(mmapped);
+    if (ok) {
+        madvise(mmapped, size, MADV_SEQUENTIAL);
+        desc.reserveSize(size);
+        desc.addPermanentData(header.nbClusters);
+        desc.addPermanentData(header.dimension);
+        desc.addPermanentData((int) header.nbPoints);
+        desc.addPermanentData(KMeansPointFile::getPoints(mmapped), header.nbPoints * header.dimension);
+    } else {
+        LOG(V1_WARN, "[WARN] Malformed k-means point file %s\n", filename.c_str());
+    }
+    munmap(mmapped, size);
+    return ok;
+}
+
+bool readText(const std::string& filename, const std::function<bool(int, int, int)>& onHeader,
+        const std::function<bool(const float*)>& onPoint) {
     /*
     files have to be in format:
     k = k of kmeans
@@ -20,10 +66,6 @@ bool KMeansReader::read(const std::string &filename, JobDescription &desc) {
     one point per row
     */
 
-    // allocate necessary structs for the revision to read
-
-    desc.beginInitialization(0);
-
     std::ifstream ifile(filename.c_str(), std::ios::in);
 
     // check to see that the file was opened correctly:
@@ -44,31 +86,86 @@ bool KMeansReader::read(const std::string &filename, JobDescription &desc) {
 
     int skipCols = columnsInFile - dimension;  // dont read the last few columns
 
-    desc.addPermanentData(countClusters);
-    desc.addPermanentData(dimension);
-    desc.addPermanentData(pointsCount);
-    //LOG(V5_DEBG, "                          countClusters: %i dimension %i pointsCount: %i columnsInFile: %i skipCols:%i\n", countClusters, dimension, pointsCount, columnsInFile, skipCols);
+    if (!onHeader(countClusters, dimension, pointsCount)) return false;
+    std::vector<float> point(dimension);
     float num = 0.0;
-    for (int point = 0; point < pointsCount; ++point) {
+    for (int i = 0; i < pointsCount; ++i) {
         for (int entry = 0; entry < dimension; ++entry) {
-            ifile >> num;
-            desc.addPermanentData(num);
-            //if (point < 10) {
-            //    LOG(V5_DEBG, "                          num: %f\n", num);
-            //}
+            ifile >> point[entry];
         }
-        if (Terminator::isTerminating()) return false;
         for (int skip = 0; skip < skipCols; ++skip) {
             ifile >> num;  // dont read the last few columns of each row
-            // num wont be read until reset
-            //if (point < 10) {
-            //    LOG(V5_DEBG, "                          skip num: %f\n", num);
-            //}
         }
+        if (!onPoint(point.data())) return false;
     }
 
     ifile.close();
+    // success
+    return true;
+}
+
+bool convertToPointFile(const std::string& textFile, const std::string& pointFile, int& outNbPoints, int& outDimension) {
+    // Write to a temporary file first, so that no partial output remains on failure
+    const std::string tmpFile = pointFile + ".tmp." + std::to_string(getpid());
+    FILE* f = fopen(tmpFile.c_str(), "w");
+    if (f == nullptr) return false;
+
+    int dimension = 0;
+    int nbPoints = 0;
+    int nbWritten = 0;
+    bool ok = readText(textFile, [&](int nbClusters, int dim, int count) {
+        dimension = dim;
+        nbPoints = count;
+        KMeansPointFile::Header header {KMeansPointFile::MAGIC, nbClusters, dimension, (uint64_t) nbPoints};
+        return dimension > 0 && nbPoints >= 0 && fwrite(&header, sizeof(header), 1, f) == 1;
+    }, [&](const float* point) {
+        nbWritten++;
+        return fwrite(point, sizeof(float), dimension, f) == (size_t) dimension;
+    });
+    ok = (fclose(f) == 0) && ok && nbWritten == nbPoints;
+    if (ok) ok = rename(tmpFile.c_str(), pointFile.c_str()) == 0;
+    if (!ok) remove(tmpFile.c_str());
+    outNbPoints = nbPoints;
+    outDimension = dimension;
+    return ok;
+}
+
+bool read(const std::string& filename, JobDescription& desc) {
+
+    // allocate necessary structs for the revision to read
+
+    desc.beginInitialization(0);
+    float time = Timer::elapsedSeconds();
+
+    // Binary point file?
+    bool isPointFile;
+    bool ok = readPointFile(filename, desc, isPointFile);
+    if (isPointFile) {
+        if (!ok) return false;
+        desc.endInitialization();
+        time = Timer::elapsedSeconds() - time;
+        LOG(V3_VERB, "read k-means point file %s in %.3fs\n", filename.c_str(), time);
+        return true;
+    }
+
+    int dimension = 0;
+    ok = readText(filename, [&](int countClusters, int dim, int pointsCount) {
+        dimension = dim;
+        desc.addPermanentData(countClusters);
+        desc.addPermanentData(dimension);
+        desc.addPermanentData(pointsCount);
+        return true;
+    }, [&](const float* point) {
+        desc.addPermanentData(point, dimension);
+        return !Terminator::isTerminating();
+    });
+    if (!ok) return false;
+
     desc.endInitialization();
+    time = Timer::elapsedSeconds() - time;
+    LOG(V3_VERB, "read k-means text file %s in %.3fs\n", filename.c_str(), time);
     // success
     return true;
 }
+
+}  // namespace KMeansReader
@@ -2,12 +2,22 @@
 #ifndef DOMPASCH_MALLOB_KMEANS_READER_HPP
 #define DOMPASCH_MALLOB_KMEANS_READER_HPP
 
+#include <functional>
 #include <string>
 
 #include "data/job_description.hpp"
 
 namespace KMeansReader {
+// Reads a k-means instance in the plain text format or in the binary
+// point file format (see KMeansPointFile), which is detected by its header.
 bool read(const std::string& filename, JobDescription& desc);
+// Parses a file in the plain text format. onHeader(k, dim, count) is called
+// once, then onPoint(values) for each point with dim values. Parsing stops
+// (and false is returned) as soon as a callback returns false.
+bool readText(const std::string& filename, const std::function<bool(int, int, int)>& onHeader,
+    const std::function<bool(const float*)>& onPoint);
+// Converts a file in the plain text format into a binary point file.
+bool convertToPointFile(const std::string& textFile, const std::string& pointFile, int& outNbPoints, int& outDimension);
 };
 
 #endif
@@ -3,7 +3,11 @@
 
 #include "optionslist.hpp"
 
-// Add your application-specific options here
-
-// OPTION_GROUP(grpAppYourapp, "app/yourappkey", "Options for application XXX")
-// OPT_* ...
+// Application-specific program options for k-means clustering.
+// memberName                               short option name, long option name          default   min  max
+
+OPTION_GROUP(grpAppKMeans, "app/kmeans", "K-means clustering options")
+ OPT_BOOL(kmeansBounds,                     "kmb", "kmeans-bounds",                      true,
+    "Skip distance computations via triangle-inequality bounds (Hamerly) - yields the same clustering")
+ OPT_INT(kmeansSegmentSize,                 "kmss", "kmeans-segment-size",               4096, 1,   LARGE_INT,
+    "Number of floats per segment in the pipelined reduction and broadcast of cluster centers")
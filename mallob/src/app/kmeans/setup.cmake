@@ -1,10 +1,19 @@
 
-# Add compilation units of the application
-set(KMEANS_SOURCES src/app/kmeans/kmeans_job.cpp src/app/kmeans/kmeans_reader.cpp src/app/kmeans/kmeans_utils.cpp)
+# Add k-means-specific sources to main Mallob executable
+set(KMEANS_MALLOB_SOURCES src/app/kmeans/kmeans_assignment.cpp src/app/kmeans/kmeans_bounds.cpp src/app/kmeans/kmeans_job.cpp src/app/kmeans/kmeans_reader.cpp src/app/kmeans/kmeans_utils.cpp)
+set(MALLOB_COREPLUSCOMM_SOURCES ${MALLOB_COREPLUSCOMM_SOURCES} ${KMEANS_MALLOB_SOURCES} CACHE INTERNAL "")
 
-# Add these sources to Mallob's base sources
-set(BASE_SOURCES ${BASE_SOURCES} ${KMEANS_SOURCES} CACHE INTERNAL "")
+#message("commons+KMEANS sources: ${MALLOB_COREPLUSCOMM_SOURCES}") # Use to debug
 
-#message("commons+DUMMY sources: ${BASE_SOURCES}") # Use to debug
+# Converter from the text format to the binary point file format
+add_executable(mallob_kmeans_convert src/app/kmeans/kmeans_convert.cpp)
+target_include_directories(mallob_kmeans_convert PRIVATE ${BASE_INCLUDES})
+target_compile_options(mallob_kmeans_convert PRIVATE ${BASE_COMPILEFLAGS})
+target_link_libraries(mallob_kmeans_convert mallob_corepluscomm)
 
 # Done!
+
+# Tests
+new_test(kmeans_assignment "${BASE_INCLUDES}" mallob_corepluscomm)
+new_test(kmeans_bounds "${BASE_INCLUDES}" mallob_corepluscomm)
+new_test(kmeans_reader "${BASE_INCLUDES}" mallob_corepluscomm)
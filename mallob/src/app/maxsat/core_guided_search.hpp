@@ -0,0 +1,209 @@
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "app/maxsat/encoding/cardinality_encoding.hpp"
+#include "app/maxsat/encoding/generalized_totalizer.hpp"
+#include "app/maxsat/maxsat_instance.hpp"
+#include "robin_map.h"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+
+// Core-guided MaxSAT search in the style of OLL, with stratification by weight.
+// The objective function is maintained as a reformulation, i.e., a set of weighted
+// soft literals which are all imposed as assumptions of a SAT call. An unsatisfiable core
+// (a subset of these assumptions) increases the lower bound by the core's minimum weight.
+// The core is then relaxed with a totalizer over its violated literals, and the totalizer's
+// outputs ("at most k of the core are violated") become new soft literals.
+// This class only maintains the reformulation; the SAT calls are made by the caller.
+class CoreGuidedSearch {
+
+private:
+    struct Soft {
+        size_t weight {0};
+        int totalizer {-1}; // -1 for a literal of the original objective
+        size_t bound {0}; // the literal means "at most <bound> inputs of the totalizer are true"
+    };
+    // soft literals by their assumption literal, which is true iff the soft literal is satisfied
+    tsl::robin_map<int, Soft> _softs;
+
+    struct Totalizer {
+        std::unique_ptr<CardinalityEncoding> enc;
+        size_t nbInputs;
+    };
+    std::vector<Totalizer> _totalizers;
+    // totalizer outputs which still need to be encoded and added as soft literals
+    struct PendingOutput {
+        int totalizer;
+        size_t bound;
+        size_t weight;
+    };
+    std::vector<PendingOutput> _pending_outputs;
+
+    unsigned int _nb_vars;
+    std::function<void(int)> _clause_collector;
+
+    size_t _lower_bound {0};
+    size_t _stratum {ULONG_MAX}; // only soft literals of at least this weight are assumed
+
+    std::vector<int> _call_assumptions;
+    bool _call_prepared {false};
+
+public:
+    // New variables are introduced from nbVars+1 on. All clauses of the reformulation
+    // (totalizers and hardened soft literals) are reported via clauseCollector.
+    CoreGuidedSearch(const std::vector<MaxSatInstance::ObjectiveTerm>& objective, unsigned int nbVars,
+            std::function<void(int)> clauseCollector) : _nb_vars(nbVars), _clause_collector(clauseCollector) {
+        // A term is incurred if its literal is true, so its negation is the assumption.
+        for (auto& term : objective) _softs[-term.lit].weight += term.factor;
+    }
+
+    // Encodes all new totalizer outputs, hardens soft literals which cannot be violated
+    // by any solution better than bestCost, and writes the assumptions for the next SAT call.
+    void prepareCall(size_t bestCost, std::vector<int>& assumptions) {
+        for (auto& out : _pending_outputs) encodeOutput(out);
+        _pending_outputs.clear();
+        harden(bestCost);
+        // Do not make a call without any soft literals of the current stratum
+        const size_t maxWeight = getNextStratum(ULONG_MAX);
+        if (maxWeight != ULONG_MAX && maxWeight < _stratum) _stratum = maxWeight;
+
+        _call_assumptions.clear();
+        for (auto& [lit, soft] : _softs) {
+            if (soft.weight >= _stratum) _call_assumptions.push_back(lit);
+        }
+        assumptions.insert(assumptions.end(), _call_assumptions.begin(), _call_assumptions.end());
+        _call_prepared = true;
+        LOG(V4_VVER, "MAXSAT CORE lb=%lu stratum=%lu softs=%lu assumed=%lu totalizers=%lu\n",
+            _lower_bound, _stratum, _softs.size(), _call_assumptions.size(), _totalizers.size());
+    }
+    bool isCallPrepared() const {
+        return _call_prepared;
+    }
+    // The assumptions of the last prepared call, which form a (trivial) core if the call was UNSAT.
+    const std::vector<int>& getCallAssumptions() const {
+        return _call_assumptions;
+    }
+
+    // Relaxes a core of the last prepared call. Returns false if the core is empty,
+    // i.e., the hard clauses are unsatisfiable on their own.
+    bool handleCore(const std::vector<int>& core) {
+        assert(_call_prepared);
+        _call_prepared = false;
+
+        size_t minWeight = ULONG_MAX;
+        std::vector<int> coreLits;
+        for (int lit : core) {
+            auto it = _softs.find(lit);
+            if (it == _softs.end()) continue; // not one of our soft literals
+            coreLits.push_back(lit);
+            minWeight = std::min(minWeight, it->second.weight);
+        }
+        if (coreLits.empty()) return false;
+
+        _lower_bound += minWeight;
+        for (int lit : coreLits) {
+            auto it = _softs.find(lit);
+            Soft soft = it->second;
+            // OLL: the next output of a relaxed totalizer becomes soft with the core's weight
+            if (soft.totalizer >= 0 && soft.bound+1 < _totalizers[soft.totalizer].nbInputs)
+                _pending_outputs.push_back({soft.totalizer, soft.bound+1, minWeight});
+            if (soft.weight == minWeight) _softs.erase(it);
+            else it.value().weight -= minWeight;
+        }
+        if (coreLits.size() == 1) {
+            // The literal is violated in every solution
+            addClause({-coreLits.front()});
+        } else {
+            // At least one of the core's literals is violated: relax the core with a totalizer
+            // whose output "at most one violation" becomes soft.
+            std::vector<MaxSatInstance::ObjectiveTerm> inputs;
+            for (int lit : coreLits) inputs.push_back({1, -lit});
+            _totalizers.push_back({std::unique_ptr<CardinalityEncoding>(
+                new GeneralizedTotalizer(_nb_vars, inputs)), coreLits.size()});
+            _pending_outputs.push_back({(int) _totalizers.size()-1, 1, minWeight});
+        }
+        LOG(V4_VVER, "MAXSAT CORE size=%lu weight=%lu lb=%lu\n", coreLits.size(), minWeight, _lower_bound);
+        return true;
+    }
+
+    // Handles a satisfying assignment of the last prepared call. Returns true if the assignment is
+    // proven optimal, i.e., all soft literals were assumed. Otherwise, the next stratum is assumed next.
+    bool handleSat() {
+        assert(_call_prepared);
+        _call_prepared = false;
+        const size_t next = getNextStratum(_stratum);
+        if (next == ULONG_MAX) return true;
+        _stratum = next;
+        return false;
+    }
+
+    // The last prepared call returned neither SAT nor UNSAT, e.g., since it was interrupted.
+    void discardCall() {
+        _call_prepared = false;
+    }
+
+    size_t getLowerBound() const {
+        return _lower_bound;
+    }
+
+private:
+    // Returns the largest weight of a soft literal below the given weight, or ULONG_MAX if none exists.
+    size_t getNextStratum(size_t current) const {
+        size_t next = 0;
+        for (auto& [lit, soft] : _softs) {
+            if (soft.weight < current) next = std::max(next, soft.weight);
+        }
+        return next == 0 ? ULONG_MAX : next;
+    }
+
+    void encodeOutput(const PendingOutput& out) {
+        auto& enc = *_totalizers[out.totalizer].enc;
+        std::vector<int> outputLits;
+        enc.setClauseCollector(_clause_collector);
+        enc.setAssumptionCollector([&](int lit) {outputLits.push_back(lit);});
+        enc.setNbVars(_nb_vars);
+        enc.encode(out.bound, out.bound, _totalizers[out.totalizer].nbInputs);
+        enc.enforceBound(out.bound);
+        _nb_vars = enc.getNbVars();
+        if (outputLits.empty()) return; // bound is trivially satisfied
+
+        int softLit = outputLits.front();
+        if (outputLits.size() > 1) {
+            // Bundle all assumptions in one fresh literal which implies each of them
+            softLit = ++_nb_vars;
+            for (int lit : outputLits) addClause({-softLit, lit});
+        }
+        auto& soft = _softs[softLit];
+        soft.weight += out.weight;
+        soft.totalizer = out.totalizer;
+        soft.bound = out.bound;
+    }
+
+    // A soft literal whose violation alone exceeds the best known cost must be satisfied
+    // by any improving solution, so it can be added as a hard unit clause.
+    void harden(size_t bestCost) {
+        if (bestCost == ULONG_MAX || bestCost < _lower_bound) return;
+        const size_t gap = bestCost - _lower_bound;
+        std::vector<int> hardened;
+        for (auto& [lit, soft] : _softs) {
+            if (soft.weight > gap) hardened.push_back(lit);
+        }
+        for (int lit : hardened) {
+            _softs.erase(lit);
+            addClause({lit});
+        }
+        if (!hardened.empty())
+            LOG(V4_VVER, "MAXSAT CORE hardened %lu soft literals (gap %lu)\n", hardened.size(), gap);
+    }
+
+    void addClause(std::initializer_list<int> lits) {
+        for (int lit : lits) _clause_collector(lit);
+        _clause_collector(0);
+    }
+};
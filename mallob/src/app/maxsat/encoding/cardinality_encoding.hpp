@@ -27,6 +27,14 @@ public:
         doEnforce(bound);
         //addGuardClauseIfNeeded(guardVar);
     }
+    // If several encodings share a variable domain, the next free variable
+    // must be synchronized between them before and after each encode() call.
+    void setNbVars(unsigned int nbVars) {
+        _nb_vars = nbVars;
+    }
+    unsigned int getNbVars() const {
+        return _nb_vars;
+    }
     virtual ~CardinalityEncoding() {}
 protected:
     unsigned int _nb_vars;
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include "app/maxsat/core_guided_search.hpp"
 #include "app/maxsat/encoding/cardinality_encoding.hpp"
 #include "app/maxsat/encoding/generalized_totalizer.hpp"
 #include "app/maxsat/encoding/polynomial_watchdog.hpp"
@@ -8,13 +9,13 @@
 #include "app/maxsat/maxsat_instance.hpp"
 #include "app/maxsat/sat_job_stream.hpp"
 #include "app/maxsat/solution_writer.hpp"
-#include "app/sat/data/model_string_compressor.hpp"
 #include "app/sat/data/theories/integer_term.hpp"
 #include "app/sat/data/theories/theory_specification.hpp"
 #include "app/sat/job/sat_constants.h"
 #include "rustsat.h"
 #include "util/logger.hpp"
 #include "util/random.hpp"
+#include "util/data_statistics.hpp"
 #include "util/string_utils.hpp"
 #include "util/sys/background_worker.hpp"
 #include "util/sys/terminator.hpp"
@@ -45,7 +46,11 @@ public:
         // Forbid the last found solution to be found again, in some way that only
         // worse solutions than the best known solution are being prohibited.
         // Many SAT calls followed by a concluding UNSAT call (if you're lucky).
-        NAIVE_REFINEMENT
+        NAIVE_REFINEMENT,
+        // Impose all (stratified) objective terms as assumptions and relax the unsatisfiable
+        // cores found (OLL). Many UNSAT calls, each improving the lower bound, followed by
+        // a concluding SAT call.
+        CORE_GUIDED
     };
 
     enum EncodingStrategy {
@@ -93,6 +98,9 @@ private:
     std::vector<int> _last_found_solution;
     std::vector<MaxSatInstance::ObjectiveTerm> _shuffled_objective;
 
+    // only for CORE_GUIDED strategy
+    std::unique_ptr<CoreGuidedSearch> _core_search;
+
     std::string _desc_label_next_call;
 
     bool _yield_searcher {false};
@@ -100,6 +108,11 @@ private:
 
     std::shared_ptr<SolutionWriter> _sol_writer;
 
+    // Per-call latencies: time spent in submitting a call, and the time from a call's submission
+    // until its result minus the time the job was actually processed within Mallob
+    std::vector<float> _submission_latencies;
+    std::vector<float> _response_overheads;
+
 public:
     MaxSatSearchProcedure(const Parameters& params, APIConnector& api, JobDescription& desc,
             MaxSatInstance& instance, EncodingStrategy encStrat, SearchStrategy searchStrat, const std::string& label) :
@@ -111,8 +124,12 @@ public:
 
         _nb_orig_vars = _instance.nbVars; // before cardinality constraint encodings!
 
-        _shared_encoder = _params.maxSatSharedEncoder();
-        if (!_shared_encoder) {
+        _shared_encoder = _params.maxSatSharedEncoder() && searchStrat != CORE_GUIDED;
+        if (searchStrat == CORE_GUIDED) {
+            // The totalizers of the relaxed cores are the only encodings we need
+            _core_search.reset(new CoreGuidedSearch(_instance.objective, _instance.nbVars,
+                [&](int lit) {appendLiteral(lit);}));
+        } else if (!_shared_encoder) {
             if (encStrat == WARNERS_ADDER)
                 _enc.reset(new WarnersAdder(_instance.nbVars, _instance.objective));
             if (encStrat == DYNAMIC_POLYNOMIAL_WATCHDOG)
@@ -175,6 +192,17 @@ public:
         } else {
             _current_bound = boundOverride;
         }
+        if (_search_strat == CORE_GUIDED) {
+            assert(boundOverride == -1UL);
+            // Encode the totalizers of new cores and set the assumptions of the current stratum
+            assert(!_future_encoder.valid());
+            _is_encoding = true;
+            _future_encoder = ProcessWideThreadPool::get().addTask([&, bestCost=_instance.bestCost]() {
+                _core_search->prepareCall(bestCost, _assumptions_to_set);
+                _is_done_encoding = true;
+            });
+            return true;
+        }
         if (_encoding_strat == NONE || _search_strat == NAIVE_REFINEMENT || _current_bound == ULONG_MAX)
             return true;
 
@@ -238,6 +266,8 @@ public:
             // as the most useful to give resources to.
             // 1.0f + 0.01f * (_current_bound - _instance.lowerBound) / (float) (_instance.upperBound - _instance.lowerBound));
             0, hash);
+        _submission_latencies.push_back(_job_stream.getLastSubmissionDuration());
+        LOG(V4_VVER, "MAXSAT %s Submitted SAT call in %.6fs\n", _label.c_str(), _submission_latencies.back());
         _lits_to_add.clear();
         _assumptions_to_set.clear();
         _desc_label_next_call = "";
@@ -251,13 +281,30 @@ public:
 
         // Job is done - retrieve the result.
         int resultCode;
-        nlohmann::json result;
+        SatJobStream::Result result;
         if (_job_stream.isRejected()) {
             LOG(V2_INFO, "MAXSAT %s Call rejected\n", _label.c_str());
             resultCode = 0; // UNKNOWN
         } else {
-            result = std::move(_job_stream.getResult());
-            resultCode = result["result"]["resultcode"];
+            result = _job_stream.getResult();
+            resultCode = result.resultCode;
+            _response_overheads.push_back(result.responseTime - result.processingTime);
+            LOG(V4_VVER, "MAXSAT %s Response after %.4fs, %.4fs of which processing\n",
+                _label.c_str(), result.responseTime, result.processingTime);
+        }
+        if (resultCode == RESULT_UNSAT && _search_strat == CORE_GUIDED && _core_search->isCallPrepared()) {
+            // The failed assumptions reported with the result form the core. An empty core means
+            // that the hard clauses alone are unsatisfiable. Only if the response does not report
+            // a core, fall back to all assumptions of the call, which form a core as well.
+            const auto& core = result.failedAssumptionsReported ?
+                result.failedAssumptions : _core_search->getCallAssumptions();
+            if (!_core_search->handleCore(core)) {
+                LOG(V2_INFO, "MAXSAT %s Hard clauses unsat\n", _label.c_str());
+                _yield_searcher = true;
+                return RESULT_UNSAT;
+            }
+            updateLowerBoundFromCores();
+            return RESULT_UNSAT;
         }
         if (resultCode == RESULT_UNSAT) {
             // UNSAT
@@ -284,6 +331,7 @@ public:
         if (resultCode != RESULT_SAT) {
             // UNKNOWN or something else - presumably because the job was interrupted
             LOG(V2_INFO, "MAXSAT %s Call returned UNKNOWN\n", _label.c_str(), _current_bound);
+            if (_core_search) _core_search->discardCall();
             if (_instance.intervalSearch)
                 _instance.intervalSearch->stopTestingWithoutUpdates(_current_bound);
             _current_bound = ULONG_MAX;
@@ -292,27 +340,22 @@ public:
         // Formula is SATisfiable.
 
         // Retrieve the initial model and compute its cost as a first upper bound.
-        std::vector<int> solution;
-        if (_params.compressModels()) {
-            solution = ModelStringCompressor::decompress(result["result"]["solution"].get<std::string>());
-        } else {
-            solution = result["result"]["solution"].get<std::vector<int>>();
-        }
+        std::vector<int> solution = std::move(result.solution);
         if (_search_strat == NAIVE_REFINEMENT) {
             // remember *any* found solution to forbid it in the next step
             _last_found_solution = solution;
         }
         const size_t cost = _instance.getCostOfModel(solution);
         if (cost > _current_bound) {
-            std::string reportFilename = _params.logDirectory() + "/erroneous-maxsat-model." + result["name"].get<std::string>();
+            std::string reportFilename = _params.logDirectory() + "/erroneous-maxsat-model." + result.jobName;
             {
                 std::ofstream ofs(reportFilename);
                 ofs << "MaxSAT searcher " << _label << std::endl;
-                ofs << "Internal job ID: #" << result["internal_id"].get<int>() << std::endl;
-                ofs << "Job literals: perhaps present at " << _params.logDirectory() + "/maxsat.joblits." + result["name"].get<std::string>() << std::endl;
-                ofs << "Job assumptions: perhaps present at " << _params.logDirectory() + "/maxsat.jobassumptions." + result["name"].get<std::string>() << std::endl;
-                ofs << "Found model: perhaps present at " << _params.solutionToFile() + "." + std::to_string(result["internal_id"].get<int>())
-                    + "." + std::to_string(result["internal_revision"].get<int>()) << std::endl;
+                ofs << "Internal job ID: #" << result.internalId << std::endl;
+                ofs << "Job literals: perhaps present at " << _params.logDirectory() + "/maxsat.joblits." + result.jobName << std::endl;
+                ofs << "Job assumptions: perhaps present at " << _params.logDirectory() + "/maxsat.jobassumptions." + result.jobName << std::endl;
+                ofs << "Found model: perhaps present at " << _params.solutionToFile() + "." + std::to_string(result.internalId)
+                    + "." + std::to_string(result.internalRevision) << std::endl;
                 ofs << "Enforced cost: " << _current_bound << " or lower" << std::endl;
                 ofs << "Cost obtained from model: " << cost << std::endl;
                 for (auto& term : _instance.objective) {
@@ -349,6 +392,14 @@ public:
             if (_instance.intervalSearch)
                 _instance.intervalSearch->stopTestingWithoutUpdates(_current_bound);
         }
+        if (_search_strat == CORE_GUIDED && _core_search->isCallPrepared() && _core_search->handleSat()) {
+            // All remaining objective terms could be satisfied: the found model is optimal.
+            if (cost != _core_search->getLowerBound())
+                LOG(V1_WARN, "[WARN] MAXSAT %s Final model has cost %lu, but cores imply %lu\n",
+                    _label.c_str(), cost, _core_search->getLowerBound());
+            updateLowerBoundFromCores();
+            _yield_searcher = true;
+        }
         _assumptions_to_persist_upon_sat.clear();
         _current_bound = ULONG_MAX;
         return RESULT_SAT;
@@ -364,7 +415,8 @@ public:
         assert(_solving);
         // With the "naive refinement" strategy, we don't encode bounds explicitly,
         // so this search does not become obsolete with improved bounds per se.
-        if (_search_strat == NAIVE_REFINEMENT) return false;
+        // The same holds for core-guided search, which only improves the lower bound.
+        if (_search_strat == NAIVE_REFINEMENT || _search_strat == CORE_GUIDED) return false;
         // We are solving for (cost <= _current_bound).
         // Case 1: We already know that this cost is impossible to achieve. 
         if (_current_bound < _instance.lowerBound) return true;
@@ -398,6 +450,9 @@ public:
     size_t getCurrentBound() const {
         return _current_bound;
     }
+    bool isCoreGuided() const {
+        return _search_strat == CORE_GUIDED;
+    }
 
     bool canBeFinalized() {
         return !isEncoding() || isDoneEncoding();
@@ -411,10 +466,26 @@ public:
     ~MaxSatSearchProcedure() {
         while (!canBeFinalized()) {usleep(1000);}
         finalize();
+        reportLatencies();
     }
 
 private:
 
+    void reportLatencies() {
+        if (!_submission_latencies.empty()) {
+            DataStatistics stats(std::move(_submission_latencies));
+            stats.computeStats();
+            LOG(V3_VERB, "MAXSAT %s STATS submission_latencies num:%ld min:%.6f max:%.6f med:%.6f mean:%.6f\n", 
+                _label.c_str(), stats.num(), stats.min(), stats.max(), stats.median(), stats.mean());
+        }
+        if (!_response_overheads.empty()) {
+            DataStatistics stats(std::move(_response_overheads));
+            stats.computeStats();
+            LOG(V3_VERB, "MAXSAT %s STATS response_overheads num:%ld min:%.6f max:%.6f med:%.6f mean:%.6f\n", 
+                _label.c_str(), stats.num(), stats.min(), stats.max(), stats.median(), stats.mean());
+        }
+    }
+
     bool findNextBound() {
         if (_yield_searcher) return false;
 
@@ -422,6 +493,9 @@ private:
         const size_t globalUpperBound = _instance.upperBound;
         if (globalUpperBound <= globalLowerBound) return false;
 
+        // Core-guided search is independent of the tested bounds
+        if (_search_strat == CORE_GUIDED) return true;
+
         if (_instance.intervalSearch) {
             if (!_instance.intervalSearch->getNextBound(_current_bound)) return false;
         } else {
@@ -449,6 +523,20 @@ private:
         return true;
     }
 
+    // Share the lower bound implied by the cores found so far with all other searches.
+    void updateLowerBoundFromCores() {
+        const size_t lb = _core_search->getLowerBound();
+        if (lb > _instance.lowerBound) {
+            _instance.lowerBound = lb;
+            if (_instance.intervalSearch)
+                _instance.intervalSearch->stopTestingAndUpdateLower(lb-1);
+            LOG(V2_INFO, "MAXSAT %s Cores imply cost %lu - new bounds: (%lu,%lu)\n",
+                _label.c_str(), lb, _instance.lowerBound, _instance.upperBound);
+        } else {
+            LOG(V3_VERB, "MAXSAT %s Cores imply cost %lu - bounds unchanged\n", _label.c_str(), lb);
+        }
+    }
+
     // We use the best solution and now forbid the solver to select 
     // some (sufficient) subset of the "true" objective literals.
     // Note that this does *not* necessarily result in a monotonic
@@ -148,6 +148,8 @@ public:
         // Parse the user-provided sequence of search strategies.
         size_t nbSearchers = std::min((size_t)_params.maxSatNumSearchers(), (_instance->upperBound - _instance->lowerBound) + 1);
         std::string searchStrats = std::string(nbSearchers, 'd');
+        // Core-guided search runs alongside the solution improving searches, sharing bounds with them
+        if (_params.maxSatCoreGuided() && !_instance->objective.empty()) searchStrats += 'c';
         const int nbWorkers = _params.numWorkers() == -1 ? MyMpi::size(MPI_COMM_WORLD) : _params.numWorkers();
         // Loop over each specified search strategy
         for (int i = 0; i < searchStrats.size(); i++) {
@@ -164,7 +166,8 @@ public:
 
             // If everybody uses their own encoder, we can still put all of them in the same cross-sharing group
             // due to the consistent naming of variables across all encoders.
-            if (!_shared_encoder) {
+            // (Core-guided search introduces its own variables and is excluded.)
+            if (!_shared_encoder && !searches.back()->isCoreGuided()) {
                 searches.back()->setGroupId("consistent-logic-" + std::to_string(updateLayer)/*, 1, _instance->nbVars*/);
             }
 
@@ -242,6 +245,7 @@ public:
 
             // Add the encoder and its encoding to each search
             for (auto& search : searches) {
+                if (search->isCoreGuided()) continue;
                 search->setSharedEncoder(encoder);
                 search->setDescriptionLabelForNextCall("initial-bounds-" + std::to_string(updateLayer));
                 search->setGroupId("common-logic-" + std::to_string(updateLayer)); // enable cross job clause sharing
@@ -314,7 +318,7 @@ public:
                     // cancel the searcher at the lowest bound
                     MaxSatSearchProcedure* lowest {nullptr};
                     for (auto& search : searches) {
-                        if (search->isNonblockingSolvePending() &&
+                        if (search->isNonblockingSolvePending() && !search->isCoreGuided() &&
                             (!lowest || search->getCurrentBound() < lowest->getCurrentBound())) {
                             lowest = search.get();
                         }
@@ -402,14 +406,21 @@ public:
                 // Make one more SAT call to find such a solution.
                 LOG(V2_INFO, "MAXSAT final SAT call to find solution of optimal cost %lu ...\n", _instance->upperBound);
                 assert(!searches.empty());
-                auto& search = searches.front();
-                bool ok = search->enforceNextBound(_instance->upperBound);
-                assert(ok);
-                while (!search->isDoneEncoding()) usleep(1000);
-                int resultCode = search->solveBlocking(); // could still be cancelled
-                if (resultCode == SAT) {
-                    assert(_instance->bestCost == _instance->upperBound);
-                    r.result = RESULT_OPTIMUM_FOUND;
+                auto it = std::find_if(searches.begin(), searches.end(), [](auto& search) {return !search->isCoreGuided();});
+                if (it == searches.end()) it = searches.begin();
+                auto& search = *it;
+                if (search->isCoreGuided()) {
+                    // Core-guided search cannot enforce a bound, but its final call yields an optimal model
+                    LOG(V2_INFO, "MAXSAT [WARN] no search left to enforce bound %lu\n", _instance->upperBound);
+                } else {
+                    bool ok = search->enforceNextBound(_instance->upperBound);
+                    assert(ok);
+                    while (!search->isDoneEncoding()) usleep(1000);
+                    int resultCode = search->solveBlocking(); // could still be cancelled
+                    if (resultCode == SAT) {
+                        assert(_instance->bestCost == _instance->upperBound);
+                        r.result = RESULT_OPTIMUM_FOUND;
+                    }
                 }
                 LOG(V4_VVER, "MAXSAT once again trying to stop all searches ...\n");
                 tryStopAllSearches(searches);
@@ -641,6 +652,10 @@ private:
             searchStrat = MaxSatSearchProcedure::NAIVE_REFINEMENT;
             label += "NRE";
             break;
+        case 'c':
+            searchStrat = MaxSatSearchProcedure::CORE_GUIDED;
+            label += "CORE";
+            break;
         }
         // Initialize search procedure
         auto p = new MaxSatSearchProcedure(_params, _api, _desc,
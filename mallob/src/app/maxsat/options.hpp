@@ -16,7 +16,9 @@ OPT_INT(maxSatFocusMin, "maxsat-focus-min", "", 1, 1, LARGE_INT, "Minimum number
 OPT_INT(maxSatNumSearchers, "maxsat-searchers", "", 1, 1, LARGE_INT, "Number of searchers to run in parallel")
 OPT_FLOAT(maxSatIntervalSkew, "maxsat-interval-skew", "", 0.5, 0, 1, "Skew to cut search intervals with")
 OPT_STRING(maxSatSolutionFile, "maxsat-sol-file", "", "", "Path to file to write intermediate solutions to")
+OPT_BOOL(maxSatCoreGuided, "maxsat-core-guided", "", false, "Run a core-guided search (OLL with stratification) alongside the solution improving searches")
 OPT_BOOL(maxSatWriteJobLiterals, "maxsat-write-job-lits", "", false, "Output all submitted jobs' literals into files for debugging")
+OPT_BOOL(maxSatBinarySubmission, "maxsat-binary-submission", "", false, "Submit incremental SAT calls without JSON: write new clauses and assumptions directly into the job description and receive binary results")
 
 #if MALLOB_USE_MAXPRE == 1
 OPT_BOOL(maxPre, "maxpre", "", true, "true: use MaxPRE2 preprocessor library to preprocess instance; false: assume appropriately preprocessed file")
@@ -1,18 +1,37 @@
 
 #pragma once
 
+#include "app/app_registry.hpp"
 #include "app/maxsat/maxsat_instance.hpp"
+#include "app/sat/data/model_string_compressor.hpp"
+#include "app/sat/job/sat_constants.h"
 #include "data/checksum.hpp"
 #include "data/job_description.hpp"
 #include "interface/api/api_connector.hpp"
 #include "interface/json_interface.hpp"
+#include "interface/result_record.hpp"
 #include "util/json.hpp"
 #include "util/logger.hpp"
 #include "util/static_store.hpp"
 #include "util/params.hpp"
+#include "util/sys/timer.hpp"
 
 class SatJobStream {
 
+public:
+    // The outcome of a single SAT call.
+    struct Result {
+        int resultCode {RESULT_UNKNOWN};
+        std::vector<int> solution;
+        std::vector<int> failedAssumptions; // only for UNSAT
+        bool failedAssumptionsReported {false}; // false for responses without failed assumptions
+        std::string jobName; // without user prefix
+        int internalId {-1};
+        int internalRevision {-1};
+        float responseTime {0}; // from submission until the result was reported
+        float processingTime {0}; // within Mallob, from the job's start until the result was found
+    };
+
 private:
     const Parameters& _params;
     APIConnector& _api;
@@ -26,14 +45,20 @@ private:
     bool _pending {false};
     bool _interrupt_set {false};
     nlohmann::json _json_result;
+    // Binary fast path: jobs are submitted without any JSON, results arrive as ResultRecords
+    const bool _binary;
+    ResultRecord _binary_result;
     bool _rejected {false};
     std::string _expected_result_job_name;
+    std::string _precursor_name;
+    float _last_submission_duration {0};
 
 public:
     SatJobStream(const Parameters& params, APIConnector& api, JobDescription& desc,
             int streamId, bool incremental) :
         _params(params), _api(api), _desc(desc), _incremental(incremental), 
-        _username("maxsat#" + std::to_string(_desc.getId())) {
+        _username("maxsat#" + std::to_string(_desc.getId())),
+        _binary(incremental && params.maxSatBinarySubmission()) {
 
         _base_job_name = "satjob-" + std::to_string(streamId) + "-rev-";
         _json_base = nlohmann::json {
@@ -69,6 +94,7 @@ public:
 
         if (_incremental && _json_base.contains("name")) {
             _json_base["precursor"] = _username + std::string(".") + _json_base["name"].get<std::string>();
+            _precursor_name = _json_base["name"].get<std::string>();
         }
         _json_base["priority"] = priority > 0 ? priority : 1;
         const int subjob = _subjob_counter++;
@@ -84,30 +110,17 @@ public:
                 ofs << lit << " 0" << std::endl;
             }
         }
-        nlohmann::json copy(_json_base);
-        StaticStore<std::vector<int>>::insert(_json_base["name"].get<std::string>(), std::move(newLiterals));
-        copy["internalliterals"] = _json_base["name"].get<std::string>();
-        copy["assumptions"] = assumptions;
-        if (!descriptionLabel.empty()) {
-            copy["description-id"] = descriptionLabel;
-        }
-        _expected_result_job_name = copy["name"].get<std::string>();
+        const float time = Timer::elapsedSeconds();
         _pending = true;
         _rejected = false;
         _interrupt_set = false;
-        auto response = _api.submit(copy, [&](nlohmann::json& result) {
-            if (result["name"].get<std::string>() != _expected_result_job_name) {
-                LOG(V0_CRIT, "[ERROR] MAXSAT Result for unexpected job \"%s\" (expected: %s)!\n",
-                    result["name"].get<std::string>().c_str(), _expected_result_job_name.c_str());
-                abort();
-            }
-            _json_result = std::move(result);
-            _pending = false;
-        });
+        auto response = _binary ? submitBinary(std::move(newLiterals), assumptions, descriptionLabel, chksum)
+            : submitJson(std::move(newLiterals), assumptions, descriptionLabel);
         if (response == JsonInterface::Result::DISCARD) {
             _rejected = true;
             _pending = false;
         }
+        _last_submission_duration = Timer::elapsedSeconds() - time;
     }
     bool interrupt() {
         if (!_pending || _interrupt_set) return false;
@@ -150,8 +163,96 @@ public:
     bool isRejected() const {
         return _rejected;
     }
-    nlohmann::json& getResult() {
+    Result getResult() {
         assert(!_pending);
-        return _json_result;
+        Result result;
+        if (_binary) {
+            result.resultCode = _binary_result.resultCode;
+            if (result.resultCode == RESULT_UNSAT) {
+                result.failedAssumptions = std::move(_binary_result.solution);
+                result.failedAssumptionsReported = true;
+            } else result.solution = std::move(_binary_result.solution);
+            result.jobName = _binary_result.jobName.substr(_username.size()+1);
+            result.internalId = _binary_result.id;
+            result.internalRevision = _binary_result.revision;
+            result.responseTime = _binary_result.responseTime;
+            result.processingTime = _binary_result.processingTime;
+            return result;
+        }
+        result.resultCode = _json_result["result"]["resultcode"];
+        if (result.resultCode == RESULT_SAT) {
+            if (_params.compressModels()) {
+                result.solution = ModelStringCompressor::decompress(_json_result["result"]["solution"].get<std::string>());
+            } else {
+                result.solution = _json_result["result"]["solution"].get<std::vector<int>>();
+            }
+        }
+        if (result.resultCode == RESULT_UNSAT && _json_result["result"].contains("solution")) {
+            result.failedAssumptions = _json_result["result"]["solution"].get<std::vector<int>>();
+            result.failedAssumptionsReported = true;
+        }
+        result.jobName = _json_result["name"].get<std::string>();
+        result.internalId = _json_result["internal_id"].get<int>();
+        result.internalRevision = _json_result["internal_revision"].get<int>();
+        result.responseTime = _json_result["stats"]["time"]["total"].get<float>();
+        result.processingTime = _json_result["stats"]["time"]["processing"].get<float>();
+        return result;
+    }
+    // Time spent within the last call to submitNext
+    float getLastSubmissionDuration() const {
+        return _last_submission_duration;
+    }
+
+private:
+    JsonInterface::Result submitJson(std::vector<int>&& newLiterals, const std::vector<int>& assumptions,
+            const std::string& descriptionLabel) {
+        nlohmann::json copy(_json_base);
+        StaticStore<std::vector<int>>::insert(_json_base["name"].get<std::string>(), std::move(newLiterals));
+        copy["internalliterals"] = _json_base["name"].get<std::string>();
+        copy["assumptions"] = assumptions;
+        if (!descriptionLabel.empty()) {
+            copy["description-id"] = descriptionLabel;
+        }
+        _expected_result_job_name = copy["name"].get<std::string>();
+        return _api.submit(copy, [&](nlohmann::json& result) {
+            if (result["name"].get<std::string>() != _expected_result_job_name) {
+                LOG(V0_CRIT, "[ERROR] MAXSAT Result for unexpected job \"%s\" (expected: %s)!\n",
+                    result["name"].get<std::string>().c_str(), _expected_result_job_name.c_str());
+                abort();
+            }
+            _json_result = std::move(result);
+            _pending = false;
+        });
+    }
+
+    JsonInterface::Result submitBinary(std::vector<int>&& newLiterals, const std::vector<int>& assumptions,
+            const std::string& descriptionLabel, const Checksum& chksum) {
+        JsonInterface::BinarySubmission sub;
+        sub.user = _username;
+        sub.name = _json_base["name"].get<std::string>();
+        sub.precursor = _precursor_name;
+        sub.incremental = true;
+        sub.priority = _json_base["priority"].get<float>();
+        sub.applicationId = app_registry::getAppId("SAT");
+        if (_json_base.contains("group-id")) sub.groupId = _json_base["group-id"].get<std::string>();
+        sub.descriptionId = descriptionLabel;
+        if (_params.useChecksums()) sub.checksum = chksum;
+        for (auto& [key, val] : _json_base["configuration"].items())
+            sub.configuration[key] = val.is_string() ? val.get<std::string>() : val.dump();
+        // Append the new clauses and the assumptions right into the new revision
+        sub.fillDescription = [&](JobDescription& desc) {
+            desc.addPermanentData(newLiterals.data(), newLiterals.size());
+            for (int lit : assumptions) desc.addTransientData(lit);
+        };
+        _expected_result_job_name = _username + "." + sub.name;
+        return _api.submitBinary(sub, [&](const std::vector<uint8_t>& record) {
+            if (!_binary_result.deserialize(record.data(), record.size())
+                    || _binary_result.jobName != _expected_result_job_name) {
+                LOG(V0_CRIT, "[ERROR] MAXSAT Malformed or unexpected result record (expected: %s)!\n",
+                    _expected_result_job_name.c_str());
+                abort();
+            }
+            _pending = false;
+        });
     }
 };
@@ -1,30 +1,66 @@
 
 #pragma once
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "app/sat/data/clause.hpp"
 using namespace Mallob;
 
+// Lexicographic three-way comparison of two literal arrays of equal size.
+// Literals are compared block-wise (8 or 4 at a time, depending on the
+// available instruction set) and only the first differing position is
+// then compared as a scalar.
+inline int compareLiteralBlocks(const int* left, const int* right, int size) {
+	int i = 0;
+#if defined(__AVX2__)
+	for (; i+8 <= size; i += 8) {
+		__m256i l = _mm256_loadu_si256((const __m256i*) (left+i));
+		__m256i r = _mm256_loadu_si256((const __m256i*) (right+i));
+		unsigned neq = ~(unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(l, r))) & 0xFFu;
+		if (neq != 0) {
+			const int j = i + __builtin_ctz(neq);
+			return left[j] < right[j] ? -1 : 1;
+		}
+	}
+#endif
+#if defined(__SSE2__)
+	for (; i+4 <= size; i += 4) {
+		__m128i l = _mm_loadu_si128((const __m128i*) (left+i));
+		__m128i r = _mm_loadu_si128((const __m128i*) (right+i));
+		unsigned neq = ~(unsigned) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(l, r))) & 0xFu;
+		if (neq != 0) {
+			const int j = i + __builtin_ctz(neq);
+			return left[j] < right[j] ? -1 : 1;
+		}
+	}
+#endif
+	for (; i < size; i++) {
+		if (left[i] != right[i])
+			return left[i] < right[i] ? -1 : 1;
+	}
+	return 0;
+}
+
 struct AbstractClauseThreewayComparator {
 	virtual ~AbstractClauseThreewayComparator() {}
 	virtual int compare(const Clause& left, const Clause& right) const = 0;
 };
 
-struct LexicographicClauseThreewayComparator : public AbstractClauseThreewayComparator {
+struct LexicographicClauseThreewayComparator final : public AbstractClauseThreewayComparator {
 	int compare(const Clause& left, const Clause& right) const {
 		// Shortest length first
 		if (left.size != right.size) return left.size < right.size ? -1 : 1;
 		// Shortest LBD first
 		if (left.lbd != right.lbd) return left.lbd < right.lbd ? -1 : 1;
 		// Lexicographic comparison of literals
-		for (size_t i = ClauseMetadata::numInts(); i < left.size; i++) {
-			if (left.begin[i] != right.begin[i]) 
-				return left.begin[i] < right.begin[i] ? -1 : 1;
-		}
-		return 0;
+		const int offset = ClauseMetadata::numInts();
+		return compareLiteralBlocks(left.begin+offset, right.begin+offset, left.size-offset);
 	}
 };
 
-struct LengthLbdSumClauseThreewayComparator : public AbstractClauseThreewayComparator {
+struct LengthLbdSumClauseThreewayComparator final : public AbstractClauseThreewayComparator {
 	int maxLengthLbdSum;
 	LengthLbdSumClauseThreewayComparator(int maxLengthLbdSum) : maxLengthLbdSum(maxLengthLbdSum) {}
 	int compare(const Clause& left, const Clause& right) const {
@@ -38,11 +74,8 @@ struct LengthLbdSumClauseThreewayComparator : public AbstractClauseThreewayCompa
 		// Shortest LBD first
 		if (left.lbd != right.lbd) return left.lbd < right.lbd ? -1 : 1;
 		// Lexicographic comparison of literals
-		for (size_t i = ClauseMetadata::numInts(); i < left.size; i++) {
-			if (left.begin[i] != right.begin[i]) 
-				return left.begin[i] < right.begin[i] ? -1 : 1;
-		}
-		return 0;
+		const int offset = ClauseMetadata::numInts();
+		return compareLiteralBlocks(left.begin+offset, right.begin+offset, left.size-offset);
 	}
 };
 
@@ -11,6 +11,9 @@ struct SharingStatistics {
 	unsigned long clausesDroppedAtExport = 0;
 	unsigned long clausesProcessFilteredAtExport = 0;
 	unsigned long clausesSolverFilteredAtExport = 0;
+	// Sampled filter look-ups of unregistered clauses and how many of them were spuriously filtered
+	unsigned long filterSampledQueries = 0;
+	unsigned long filterFalsePositives = 0;
 	ClauseHistogram* histProduced;
 	ClauseHistogram* histFailedFilter;
 	ClauseHistogram* histAdmittedToDb;
@@ -27,6 +30,7 @@ struct SharingStatistics {
 			+ " drp:" + std::to_string(clausesDroppedAtExport) 
 					+ "(" + std::to_string((float) (0.01 * (int)(droppedRatio*100))) + ")"
 			+ " pflt:" + std::to_string(clausesProcessFilteredAtExport)
-			+ " sflt:" + std::to_string(clausesSolverFilteredAtExport);
+			+ " sflt:" + std::to_string(clausesSolverFilteredAtExport)
+			+ " fpos:" + std::to_string(filterFalsePositives) + "/" + std::to_string(filterSampledQueries);
 	}
 };
@@ -18,6 +18,7 @@
 #include "util/logger.hpp"
 #include "util/params.hpp"
 #include "util/sys/shared_memory.hpp"
+#include "util/sys/shmem_cache.hpp"
 #include "util/sys/process.hpp"
 #include "util/sys/proc.hpp"
 #include "data/checksum.hpp"
@@ -382,11 +383,10 @@ private:
         }
 
         std::string formulaShmemId = _shmem_id + ".formulae." + std::to_string(revision);
-        int* descIdPtr = (int*) accessMemory(_shmem_id + ".descid." + std::to_string(revision),
-            sizeof(int), SharedMemory::ARBITRARY, false);
-        if (descIdPtr) {
-            const int descId = *descIdPtr;
-            formulaShmemId = "/edu.kit.iti.mallob.jobdesc." + std::to_string(descId);
+        auto* keyPtr = (SharedMemoryCache::Key*) accessMemory(_shmem_id + ".desckey." + std::to_string(revision),
+            sizeof(SharedMemoryCache::Key), SharedMemory::ARBITRARY, false);
+        if (keyPtr) {
+            formulaShmemId = SharedMemoryCache::getShmemId(*keyPtr);
         }
 
         const int* fPtr = (const int*) accessMemory(formulaShmemId,
@@ -369,6 +369,9 @@ void SolverThread::runOnce() {
     }
     LOGGER(_logger, V4_VVER, "ENDSOL\n");
 
+    if (res == UNSAT && !_solver.getOptimizer())
+        _failed_assumptions = extractFailedAssumptions(aSize, aLits, revision);
+
     // Report result, if present
     if (res == UNSAT && _solver.getOptimizer()) {
         res = UNKNOWN;
@@ -392,6 +395,38 @@ void SolverThread::waitUntil(std::function<bool()> predicate) {
     _state_cond.wait(_state_mutex, predicate);
 }
 
+std::vector<int> SolverThread::extractFailedAssumptions(size_t aSize, const int* aLits, int revision) {
+
+    // A non-incremental solver added all assumptions as unit clauses,
+    // so all of them need to be reported as failed.
+    if (!_solver.supportsIncrementalSat()) return std::vector<int>(aLits, aLits+aSize);
+
+    auto failed = _solver.getFailedAssumptions();
+    std::vector<int> core(failed.begin(), failed.end());
+
+    // Cheap minimization: solve again with only the failed assumptions
+    // as long as this shrinks the set of failed assumptions.
+    for (int round = 0; round < _params.coreTrimRounds() && core.size() > 1 && !_lrat; round++) {
+        {
+            auto lock = _state_mutex.getLock();
+            if (_terminated || revision != _latest_revision) break;
+            _in_solve_call = true;
+        }
+        auto res = _solver.solve(core.size(), core.data());
+        {
+            auto lock = _state_mutex.getLock();
+            _in_solve_call = false;
+            _solver.uninterrupt();
+        }
+        if (res != UNSAT) break; // interrupted
+        failed = _solver.getFailedAssumptions();
+        if (failed.size() >= core.size()) break;
+        LOGGER(_logger, V4_VVER, "trimmed failed assumptions from %lu to %lu\n", core.size(), failed.size());
+        core.assign(failed.begin(), failed.end());
+    }
+    return core;
+}
+
 void SolverThread::reportResult(int res, int revision) {
 
     if (res == 0 || _found_result) return;
@@ -432,10 +467,8 @@ void SolverThread::reportResult(int res, int revision) {
             _lrat->push({20});
             _lrat->waitForUnsatValidation();
         }
-        auto failed = _solver.getFailedAssumptions();
-        auto failedVec = std::vector<int>(failed.begin(), failed.end());
         _state_mutex.lock();
-        _result.setSolutionToSerialize(failedVec.data(), failedVec.size());
+        _result.setSolutionToSerialize(_failed_assumptions.data(), _failed_assumptions.size());
     }
     _result.result = SatResult(res);
     _result.revision = revision;
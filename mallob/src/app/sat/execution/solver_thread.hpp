@@ -41,6 +41,7 @@ private:
 
     std::vector<std::unique_ptr<SerializedFormulaParser>> _pending_formulae;
     std::vector<std::pair<size_t, const int*>> _pending_assumptions;
+    std::vector<int> _failed_assumptions; // of the last UNSAT result
 
     SplitMix64Rng _rng;
 
@@ -138,6 +139,7 @@ private:
     void waitWhileSolved();
     void waitUntil(std::function<bool()> predicate);
     
+    std::vector<int> extractFailedAssumptions(size_t aSize, const int* aLits, int revision);
     void reportResult(int res, int revision);
 
     const char* toStr();
@@ -55,7 +55,16 @@ AnytimeSatClauseCommunicator::AnytimeSatClauseCommunicator(const Parameters& par
     ),
     _cross_job_clause_sharer(_job->getDescription().getGroupId() > 0 && _job->getJobTree().isRoot() ?
         new InterJobClauseSharer(_params, job->getDescription().getGroupId(), job->getContextId(), job->toStr()) : nullptr),
-    _sent_cert_unsat_ready_msg(!params.proofOutputFile.isSet() && !params.deterministicSolving()) {
+    _sent_cert_unsat_ready_msg(!params.proofOutputFile.isSet() && !params.deterministicSolving()),
+    _compress_clause_buffers(params.compressClauseBuffers()) {
+
+    // The job's configuration may override the clause buffer wire format.
+    // All processes of the job see the same description and therefore agree on it.
+    const auto& config = _job->getDescription().getAppConfiguration().map;
+    if (config.count("compress-clause-buffers")) {
+        const auto& val = config.at("compress-clause-buffers");
+        _compress_clause_buffers = val == "1" || val == "true";
+    }
 
     _time_of_last_epoch_initiation = Timer::elapsedSecondsCached();
     if (_cross_job_clause_sharer) initCrossSharer();
@@ -326,7 +335,8 @@ void AnytimeSatClauseCommunicator::initiateClauseSharing(JobMessage& msg, int so
     assert(compensationFactor >= 0.1 && compensationFactor <= 10);
 
     _current_session.reset(
-        new ClauseSharingSession(_params, _job, snapshot, _cls_history.get(), _current_epoch, compensationFactor)
+        new ClauseSharingSession(_params, _job, snapshot, _cls_history.get(), _current_epoch, compensationFactor,
+            _compress_clause_buffers)
     );
 
     // register listener to grab final, filtered shared clauses and share them with other jobs
@@ -393,7 +403,8 @@ void AnytimeSatClauseCommunicator::initiateCrossSharing(JobMessage& msg, int sou
     LOG(V4_VVER, "XTCS init: %s\n", comm.toStr().c_str());
     _cross_job_clause_sharer->updateCommunicator(comm.getCommSize(), comm.getMyLocalRank());
     _cross_sharing_session.reset(
-        new ClauseSharingSession(_params, _cross_job_clause_sharer.get(), snapshot, nullptr, 0, 1)
+        new ClauseSharingSession(_params, _cross_job_clause_sharer.get(), snapshot, nullptr, 0, 1,
+            _params.compressClauseBuffers())
     );
     msg.contextIdOfSender = snapshot.contextId;
     msg.treeIndexOfSender = snapshot.index;
@@ -43,6 +43,7 @@ private:
     float _solving_time = 0;
 
     bool _sent_cert_unsat_ready_msg;
+    bool _compress_clause_buffers;
     int _num_ready_msgs_from_children = 0;
 
     JobMessage _msg_unsat_found;
@@ -5,6 +5,7 @@
 #include "app/sat/data/clause_metadata.hpp"
 #include "app/sat/job/clause_sharing_actor.hpp"
 #include "app/sat/sharing/buffer/buffer_reader.hpp"
+#include "app/sat/sharing/buffer/clause_buffer_codec.hpp"
 #include "app/sat/sharing/filter/clause_buffer_lbd_scrambler.hpp"
 #include "app/sat/sharing/filter/generic_clause_filter.hpp"
 #include "app/sat/sharing/store/static_clause_store.hpp"
@@ -38,6 +39,9 @@ private:
 
     std::vector<int> _excess_clauses_from_merge;
     std::vector<int> _broadcast_clause_buffer;
+    // Whether the broadcast clause buffer was kept after handing it to the job
+    // (only needed for the clause history and for a clause listener)
+    bool _keep_broadcast_clause_buffer {false};
     int _local_export_limit;
     int _num_broadcast_clauses;
     int _num_admitted_clauses;
@@ -56,7 +60,7 @@ private:
 
 public:
     ClauseSharingSession(const Parameters& params, ClauseSharingActor* actor, const JobTreeSnapshot& snapshot,
-            HistoricClauseStorage* clsHistory, int epoch, float compensationFactor) : 
+            HistoricClauseStorage* clsHistory, int epoch, float compensationFactor, bool compressClauseBuffers) : 
         _params(params), _job(actor), _cls_history(clsHistory), _epoch(epoch),
         _allreduce_clauses(
             snapshot,
@@ -70,7 +74,8 @@ public:
             }
         ), _rng(_params.seed()+69) {
 
-        if (_params.clauseFilterMode() == MALLOB_CLAUSE_FILTER_EXACT_DISTRIBUTED) {
+        if (_params.clauseFilterMode() == MALLOB_CLAUSE_FILTER_EXACT_DISTRIBUTED
+                || _params.clauseFilterMode() == MALLOB_CLAUSE_FILTER_FINGERPRINT_DISTRIBUTED) {
             _allreduce_filter.emplace(
                 snapshot, 
                 // Base message
@@ -84,6 +89,18 @@ public:
             );
         }
 
+        if (compressClauseBuffers) {
+            // Clause buffers travel through the job tree in compressed form
+            _allreduce_clauses.setWireCodec([&](const std::vector<int>& elem) {
+                auto encoded = ClauseBufferCodec::encode(elem);
+                LOG(V5_DEBG, "%s CS encoded %lu ints -> %lu bytes\n", _job->getLabel(),
+                    elem.size(), ClauseBufferCodec::getNbEncodedBytes(encoded));
+                return encoded;
+            }, [&](const std::vector<int>& elem) {
+                return ClauseBufferCodec::decode(elem);
+            });
+        }
+
         LOG(V5_DEBG, "%s CS OPEN e=%i\n", _job->getLabel(), _epoch);
         _local_export_limit = _job->setSharingCompensationFactorAndUpdateExportLimit(compensationFactor);
         if (!_job->hasPreparedSharing()) _job->prepareSharing();
@@ -156,12 +173,15 @@ public:
             if (_allreduce_filter) {
                 // Initiate production of local filter element for 2nd all-reduction 
                 LOG(V5_DEBG, "%s CS filter\n", _job->getLabel());
-                _job->filterSharing(_epoch, std::vector<int>(_broadcast_clause_buffer));
+                _keep_broadcast_clause_buffer = _cls_history || _has_clause_listener;
+                _job->filterSharing(_epoch, _keep_broadcast_clause_buffer ?
+                    std::vector<int>(_broadcast_clause_buffer) : std::move(_broadcast_clause_buffer));
                 _stage = PRODUCING_FILTER;
             } else {
                 // No distributed filtering: Sharing is done!
                 LOG(V5_DEBG, "%s CS digest w/o filter\n", _job->getLabel());
-                _job->digestSharingWithoutFilter(_epoch, std::vector<int>(_broadcast_clause_buffer), false);
+                _job->digestSharingWithoutFilter(_epoch, _cls_history ?
+                    std::vector<int>(_broadcast_clause_buffer) : std::move(_broadcast_clause_buffer), false);
                 if (_cls_history) {
                     InplaceClauseAggregation(_broadcast_clause_buffer).stripToRawBuffer();
                     _cls_history->importSharing(_epoch, std::move(_broadcast_clause_buffer));
@@ -186,15 +206,15 @@ public:
             // Extract and digest result
             auto filter = _allreduce_filter->extractResult();
             LOG(V5_DEBG, "%s CS digest w/ filter, size %i\n", _job->getLabel(), filter.size());
-            if (_cls_history || _has_clause_listener) {
+            // (a clause listener added after the buffer was handed to the job misses this epoch)
+            if (_keep_broadcast_clause_buffer) {
                 InplaceClauseAggregation(_broadcast_clause_buffer).stripToRawBuffer();
                 applyGlobalFilter(filter, _broadcast_clause_buffer);
+                if (_has_clause_listener) _clause_listener(_broadcast_clause_buffer);
                 if (_cls_history) {
                     // Add clause batch to history
-                    std::vector<int> copy(_broadcast_clause_buffer);
-                    _cls_history->importSharing(_epoch, std::move(copy));
+                    _cls_history->importSharing(_epoch, std::move(_broadcast_clause_buffer));
                 }
-                if (_has_clause_listener) _clause_listener(_broadcast_clause_buffer);
             }
             _job->applyFilter(_epoch, std::move(filter));
 
@@ -292,6 +312,7 @@ private:
             merged = merger.mergePriorityBased(_params, _excess_clauses_from_merge, _rng);
         } else {
             auto merger = BufferMerger(buflim, maxEffectiveClsLen, maxFreeEffectiveClsLen, false);
+            merger.setLoserTreeMerging(_params.loserTreeBufferMerging());
             for (auto& elem : elems) {
                 merger.add(_merge_store->getBufferReader(elem.data(), elem.size()));
             }
@@ -431,8 +431,7 @@ void ForkedSatJob::startDestructThreadIfNecessary() {
             // manually clean up formulas in shared memory which haven't been forwarded yet
             for (auto& obj : _formulas_in_shmem) {
                 if (!obj.data) continue;
-                int descriptionId = getDescription().getJobDescriptionId(obj.revision);
-                StaticSharedMemoryCache::get().drop(descriptionId, obj.userLabel, obj.size, obj.data);
+                StaticSharedMemoryCache::get().drop(obj.cacheKey, obj.userLabel, obj.size, obj.data);
                 obj.data = nullptr;
             }
             LOG(V4_VVER, "%s : FSJ mem freed\n", toStr());
@@ -456,11 +455,12 @@ bool ForkedSatJob::canHandleIncompleteRevision(int rev) {
         + std::to_string(getMyMpiRank()) + ".nopidyet"
         + std::string(toStr()) + "~" + std::to_string(_subproc_idx)
         + ".formulae." + std::to_string(rev);
+    SharedMemoryCache::Key key;
     void* shmem = StaticSharedMemoryCache::get().tryAccess(descriptionId,
-        userLabel, size, shmemId);
+        userLabel, size, shmemId, key);
     if (!shmem) return false;
     if (_formulas_in_shmem.size() <= rev) _formulas_in_shmem.resize(2*rev+1);
-    _formulas_in_shmem[rev] = {std::move(shmemId), shmem, size, true, rev, std::move(userLabel)};
+    _formulas_in_shmem[rev] = {std::move(shmemId), shmem, size, true, rev, std::move(userLabel), descriptionId, key};
     return true;
 }
 
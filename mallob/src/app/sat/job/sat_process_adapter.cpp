@@ -167,8 +167,8 @@ void SatProcessAdapter::appendRevisions(const std::vector<RevisionData>& revisio
 }
 
 void SatProcessAdapter::preregisterShmemObject(ShmemObject&& obj) {
-    std::string shmemId = obj.id;
-    _guard_prereg_shmem.lock().get()[shmemId] = std::move(obj);
+    std::string shmemSubId = "formulae." + std::to_string(obj.revision);
+    _guard_prereg_shmem.lock().get()[shmemSubId] = std::move(obj);
 }
 
 void SatProcessAdapter::setSolvingState(SolvingStates::SolvingState state) {
@@ -403,7 +403,7 @@ void* SatProcessAdapter::createSharedMemoryBlock(std::string shmemSubId, size_t
 
     void* shmem {nullptr};
 
-    if (!managedInCache || descId == 0) {
+    if (!managedInCache) {
         shmem = SharedMemory::create(qualifiedShmemId, size);
         assert(shmem);
         if (data) {
@@ -416,29 +416,39 @@ void* SatProcessAdapter::createSharedMemoryBlock(std::string shmemSubId, size_t
         return shmem;
     }
 
-    actualShmemId = SharedMemoryCache::getShmemId(descId);
+    // The formula may have been preregistered by the job (incomplete revision)
+    SharedMemoryCache::Key key {0};
     {
         ShmemObject obj;
         auto preregShmem = _guard_prereg_shmem.lock();
-        if (preregShmem->contains(actualShmemId)) {
-            obj = std::move(preregShmem.get()[actualShmemId]);
+        if (preregShmem->contains(shmemSubId)) {
+            obj = std::move(preregShmem.get()[shmemSubId]);
             shmem = obj.data;
-            preregShmem->erase(actualShmemId);
+            key = obj.cacheKey;
+            actualShmemId = obj.id;
+            preregShmem->erase(shmemSubId);
         }
         if (shmem)
             _shmem.insert(ShmemObject{actualShmemId, shmem, size,
-                true, rev, obj.userLabel, descId});
+                true, rev, obj.userLabel, descId, key});
     }
     if (!shmem) {
-        shmem = StaticSharedMemoryCache::get().createOrAccess(descId, qualifiedShmemId, size,
+        // Look up the formula by its content, so that identical formulae
+        // (across jobs and revisions) share a single segment on this machine
+        assert(data);
+        SharedMemoryCache::Fingerprint fingerprint;
+        key = SharedMemoryCache::computeKey(data, size, &fingerprint);
+        shmem = StaticSharedMemoryCache::get().createOrAccess(key, fingerprint, descId, qualifiedShmemId, size,
             data, actualShmemId);
+        // A different formula with the same key is cached: use a private segment instead
+        if (!shmem) return createSharedMemoryBlock(shmemSubId, size, data, rev, descId, false);
         _shmem.insert(ShmemObject{actualShmemId, shmem, size,
-            true, rev, qualifiedShmemId, descId});
+            true, rev, qualifiedShmemId, descId, key});
     }
 
     assert(shmem);
-    auto descIdShmemId = "descid." + std::to_string(rev);
-    createSharedMemoryBlock(descIdShmemId, sizeof(int), &descId);
+    auto keyShmemId = "desckey." + std::to_string(rev);
+    createSharedMemoryBlock(keyShmemId, sizeof(SharedMemoryCache::Key), &key);
 
     return shmem;
 }
@@ -481,10 +491,8 @@ void SatProcessAdapter::freeSharedMemory() {
     for (auto& shmemObj : _shmem) {
         //log(V4_VVER, "DBG deleting %s\n", shmemObj.id.c_str());
         if (shmemObj.managedInCache) {
-            const int descId = shmemObj.descId;
-            assert(descId > 0);
             assert(shmemObj.data);
-            StaticSharedMemoryCache::get().drop(descId, shmemObj.userLabel, shmemObj.size, shmemObj.data);
+            StaticSharedMemoryCache::get().drop(shmemObj.cacheKey, shmemObj.userLabel, shmemObj.size, shmemObj.data);
         } else {
             SharedMemory::free(shmemObj.id, (char*)shmemObj.data, shmemObj.size);
         }
@@ -51,8 +51,9 @@ public:
         int revision {0};
         std::string userLabel;
         int descId {0};
+        uint64_t cacheKey {0};
         bool operator==(const ShmemObject& other) const {
-            return id == other.id && size == other.size;
+            return id == other.id && size == other.size && revision == other.revision;
         }
     };
 
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdio.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "data/checksum.hpp"
+
+// Mallob's binary CNF format. A fixed-size header is followed by the formula's
+// literals as 32-bit integers, each clause terminated by a zero, and then by the
+// assumption literals. This is exactly how formulae are laid out in a serialized
+// job description, so a memory-mapped binary CNF can be ingested with a single
+// copy and without any parsing.
+struct BinaryCnf {
+
+    static constexpr uint64_t MAGIC = 0x31464e4342424c4dULL; // "MLBBCNF1" (little endian)
+
+    struct Header {
+        uint64_t magic;
+        int32_t nbVars;
+        int32_t nbClauses;
+        uint64_t nbLiterals;
+        uint64_t nbAssumptions;
+        // Checksum over the literals and the negated assumptions
+        // (as computed by JobDescription)
+        uint64_t checksumCount;
+        uint64_t checksumValue;
+    };
+
+    // Whether the provided data of the given size is a well-formed binary CNF.
+    static bool isBinaryCnf(const void* data, size_t size) {
+        if (size < sizeof(Header)) return false;
+        Header header;
+        memcpy(&header, data, sizeof(Header));
+        return header.magic == MAGIC
+            && size == sizeof(Header) + (header.nbLiterals + header.nbAssumptions) * sizeof(int);
+    }
+
+    static Header readHeader(const void* data) {
+        Header header;
+        memcpy(&header, data, sizeof(Header));
+        return header;
+    }
+
+    // Whether the checksum in the header matches the literals and assumptions.
+    // Call only if isBinaryCnf(data, size) holds.
+    static bool hasValidChecksum(const void* data) {
+        Header header = readHeader(data);
+        const int* lits = (const int*) ((const uint8_t*) data + sizeof(Header));
+        Checksum chk = computeChecksum(lits, header.nbLiterals, lits + header.nbLiterals, header.nbAssumptions);
+        return chk == Checksum(header.checksumCount, header.checksumValue);
+    }
+
+    static Checksum computeChecksum(const int* lits, size_t nbLits, const int* assumptions, size_t nbAssumptions) {
+        Checksum chk;
+        for (size_t i = 0; i < nbLits; i++) chk.combine(lits[i]);
+        for (size_t i = 0; i < nbAssumptions; i++) chk.combine(-assumptions[i]);
+        return chk;
+    }
+
+    // Write a binary CNF to the given path. The file is written to a temporary
+    // location first and then renamed, so concurrent readers never see a partial file.
+    static bool write(const std::string& path, int nbVars, int nbClauses,
+            const int* lits, size_t nbLits, const int* assumptions, size_t nbAssumptions) {
+
+        Checksum chk = computeChecksum(lits, nbLits, assumptions, nbAssumptions);
+        Header header {MAGIC, nbVars, nbClauses, nbLits, nbAssumptions, chk.count(), chk.get()};
+
+        std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+        FILE* f = fopen(tmpPath.c_str(), "w");
+        if (f == nullptr) return false;
+        bool ok = fwrite(&header, sizeof(Header), 1, f) == 1
+            && fwrite(lits, sizeof(int), nbLits, f) == nbLits
+            && fwrite(assumptions, sizeof(int), nbAssumptions, f) == nbAssumptions;
+        ok = (fclose(f) == 0) && ok;
+        if (ok) ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+        if (!ok) remove(tmpPath.c_str());
+        return ok;
+    }
+};
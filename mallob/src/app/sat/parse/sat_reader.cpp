@@ -8,6 +8,10 @@
 #include <assert.h>
 #include <fstream>
 #include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <list>
 #include <map>
 #include <memory>
 #include <utility>
@@ -16,9 +20,12 @@
 #include "app/sat/proof/trusted/trusted_utils.hpp"
 #include "app/sat/proof/trusted_parser_process_adapter.hpp"
 #include "sat_reader.hpp"
+#include "binary_cnf.hpp"
+#include "util/hashing.hpp"
 #include "util/logger.hpp"
 #include "util/params.hpp"
 #include "util/sys/terminator.hpp"
+#include "util/sys/thread_pool.hpp"
 #include "util/sys/timer.hpp"
 #include "util/sys/tmpdir.hpp"
 #include "data/app_configuration.hpp"
@@ -36,6 +43,210 @@ void handleUnsat(const Parameters& _params) {
 	}
 }
 
+// Maps the file at the provided path to memory and hands its content to the callback.
+bool processMmappedFile(const std::string& filename, const std::function<void(const char*, size_t)>& callback) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) return false;
+	struct stat s;
+	if (fstat(fd, &s) == -1) {
+		close(fd);
+		return false;
+	}
+	size_t size = s.st_size;
+	void* mmapped = size == 0 ? nullptr : mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mmapped == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+	callback((const char*) mmapped, size);
+	if (size > 0) munmap(mmapped, size);
+	close(fd);
+	return true;
+}
+
+// Location of the cached binary conversion of the provided file, keyed by the
+// file's absolute path, size, and modification time.
+std::string getCacheFilename(const std::string& filename, const std::string& cacheDir) {
+	struct stat s;
+	if (stat(filename.c_str(), &s) == -1) return "";
+	char* absPath = realpath(filename.c_str(), nullptr);
+	if (absPath == nullptr) return "";
+	size_t key = 1;
+	hash_combine(key, std::string(absPath));
+	free(absPath);
+	hash_combine(key, (size_t) s.st_size);
+	hash_combine(key, (size_t) s.st_mtim.tv_sec);
+	hash_combine(key, (size_t) s.st_mtim.tv_nsec);
+	return cacheDir + "/" + Logger::dataToHexStr((const uint8_t*) &key, sizeof(key)) + ".mcnf";
+}
+
+// Parses up to eight decimal digits at once (SWAR) and returns the number of
+// parsed digits. Eight bytes beginning at data must be readable.
+inline int parseDigitsSwar(const char* data, int& num) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t val;
+	memcpy(&val, data, sizeof(uint64_t));
+	// Subtracting '0' maps digits to 0..9; adding 0x76 then sets the high bit
+	// of each byte above 9. Borrows and carries only ever propagate to bytes
+	// *after* the first non-digit, which are ignored.
+	const uint64_t sub = val - 0x3030303030303030ULL;
+	const uint64_t nonDigits = (sub | (sub + 0x7676767676767676ULL)) & 0x8080808080808080ULL;
+	const int nbDigits = nonDigits == 0 ? 8 : __builtin_ctzll(nonDigits) / 8;
+	if (nbDigits == 0) return 0;
+	// Discard non-digits, pad with leading zeroes, combine pairwise
+	uint64_t digits = sub << (8 * (8 - nbDigits));
+	digits = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFULL;
+	digits = (digits * 100 + (digits >> 16)) & 0x0000FFFF0000FFFFULL;
+	digits = (digits * 10000 + (digits >> 32)) & 0x00000000FFFFFFFFULL;
+	num = (int) digits;
+	return nbDigits;
+#else
+	return 0;
+#endif
+}
+
+struct DimacsChunk {
+	const char* begin;
+	const char* end;
+	std::vector<int> lits;
+	std::vector<int> assumptions;
+	int maxVar {0};
+	int nbClauses {0};
+	bool containsEmptyClause {false};
+	bool invalid {false};
+};
+
+void parseDimacsChunk(DimacsChunk& chunk, const char* fileEnd) {
+	const char* p = chunk.begin;
+	const char* end = chunk.end;
+	chunk.lits.reserve((end - p) / 4);
+	bool assumption = false;
+	while (p < end) {
+		const char c = *p;
+		if (c == ' ' || c == '\t') {
+			p++;
+			continue;
+		}
+		if (c == '\n' || c == '\r') {
+			assumption = false;
+			p++;
+			continue;
+		}
+		if (c == 'c' || c == 'p') {
+			// skip comment or header line
+			const char* newline = (const char*) memchr(p, '\n', end - p);
+			p = newline == nullptr ? end : newline;
+			continue;
+		}
+		if (c == 'a') {
+			assumption = true;
+			p++;
+			continue;
+		}
+
+		// Parse a number
+		int sign = 1;
+		if (c == '-') {
+			sign = -1;
+			p++;
+		}
+		const char* numBegin = p;
+		int num = 0;
+		if (p + 8 <= fileEnd) p += parseDigitsSwar(p, num);
+		if (p - numBegin == 0 || p - numBegin == 8) {
+			// scalar parsing (of the remaining digits)
+			while (p < end && *p >= '0' && *p <= '9') num = num*10 + (*p++ - '0');
+		}
+		if (p == numBegin) {
+			chunk.invalid = true;
+			return;
+		}
+		// A number must be followed by whitespace. At a line's end, it must be zero.
+		if (p == end || *p == '\n' || *p == '\r') {
+			if (num != 0) {
+				chunk.invalid = true;
+				return;
+			}
+		} else if (*p != ' ' && *p != '\t') {
+			chunk.invalid = true;
+			return;
+		}
+
+		chunk.maxVar = std::max(chunk.maxVar, num);
+		if (!assumption) {
+			if (num == 0) {
+				// Empty clauses at the chunk's beginning are detected when chunks are concatenated
+				if (!chunk.lits.empty() && chunk.lits.back() == 0) chunk.containsEmptyClause = true;
+				chunk.nbClauses++;
+			}
+			chunk.lits.push_back(sign * num);
+		} else if (num != 0) {
+			chunk.assumptions.push_back(sign * num);
+		}
+	}
+}
+
+void SatReader::parseInParallel(const char* data, size_t size, JobDescription& desc) {
+
+	const size_t nbTasks = _params.parallelParsingTasks();
+	const size_t minChunkSize = 1<<20, maxChunkSize = 1<<26;
+	const size_t chunkSize = std::max(minChunkSize, std::min(maxChunkSize, size / nbTasks + 1));
+
+	// Split the file into chunks which each end after a newline (or at the file's end)
+	std::vector<DimacsChunk> chunks;
+	const char* fileEnd = data + size;
+	const char* pos = data;
+	while (pos < fileEnd) {
+		const char* chunkEnd = pos + std::min(chunkSize, (size_t) (fileEnd - pos));
+		if (chunkEnd < fileEnd) {
+			const char* newline = (const char*) memchr(chunkEnd, '\n', fileEnd - chunkEnd);
+			chunkEnd = newline == nullptr ? fileEnd : newline+1;
+		}
+		chunks.push_back({pos, chunkEnd});
+		pos = chunkEnd;
+	}
+
+	// Parse up to #tasks chunks at a time, append parsed chunks in order
+	std::vector<std::future<void>> futures(chunks.size());
+	auto launch = [&](size_t idx) {
+		if (idx >= chunks.size()) return;
+		futures[idx] = ProcessWideThreadPool::get().addTask([&, idx]() {
+			parseDimacsChunk(chunks[idx], fileEnd);
+		});
+	};
+	for (size_t i = 0; i < nbTasks; i++) launch(i);
+	std::vector<int> assumptions;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		futures[i].get();
+		auto& chunk = chunks[i];
+		launch(i + nbTasks);
+		if (chunk.invalid) _input_invalid = true;
+		if (!chunk.lits.empty()) {
+			if (chunk.lits.front() == 0 && _last_added_lit_was_zero) _contains_empty_clause = true;
+			_last_added_lit_was_zero = chunk.lits.back() == 0;
+		}
+		_contains_empty_clause |= chunk.containsEmptyClause;
+		_max_var = std::max(_max_var, chunk.maxVar);
+		_num_read_clauses += chunk.nbClauses;
+		desc.addPermanentData(chunk.lits.data(), chunk.lits.size());
+		assumptions.insert(assumptions.end(), chunk.assumptions.begin(), chunk.assumptions.end());
+		chunk.lits = std::vector<int>();
+		chunk.assumptions = std::vector<int>();
+	}
+	for (int a : assumptions) desc.addTransientData(a);
+	_input_finished = true;
+}
+
+void SatReader::ingestBinaryCnf(const char* data, size_t size, JobDescription& desc) {
+	auto header = BinaryCnf::readHeader(data);
+	const int* lits = (const int*) (data + sizeof(BinaryCnf::Header));
+	desc.addPermanentData(lits, header.nbLiterals);
+	for (size_t i = 0; i < header.nbAssumptions; i++) desc.addTransientData(lits[header.nbLiterals + i]);
+	_max_var = header.nbVars;
+	_num_read_clauses = header.nbClauses;
+	_input_finished = true;
+}
+
 bool SatReader::parseWithTrustedParser(JobDescription& desc) {
 	// Parse and sign in a separate subprocess
 	TrustedParserProcessAdapter tp(desc.getId());
@@ -74,6 +285,31 @@ bool SatReader::parseInternally(JobDescription& desc) {
 
 	if (_pipe == nullptr && _namedpipe == -1) {
 
+		if (!_raw_content_mode && _params.cnfCacheDirectory.isSet() && !_params.satPreprocessor.isSet()) {
+			// Try to ingest a binary conversion of this file from an earlier parse
+			_cache_file = getCacheFilename(_filename, _params.cnfCacheDirectory());
+			if (!_cache_file.empty()) {
+				bool hit = false;
+				float time = Timer::elapsedSeconds();
+				processMmappedFile(_cache_file, [&](const char* data, size_t size) {
+					if (!BinaryCnf::isBinaryCnf(data, size)) return;
+					if (!BinaryCnf::hasValidChecksum(data)) {
+						LOG(V1_WARN, "[WARN] Checksum mismatch in CNF cache file %s - ignoring it\n", _cache_file.c_str());
+						return;
+					}
+					desc.reserveSize(size);
+					ingestBinaryCnf(data, size, desc);
+					hit = true;
+				});
+				time = Timer::elapsedSeconds() - time;
+				if (hit) {
+					LOG(V3_VERB, "read %s from CNF cache %s in %.3fs\n", _filename.c_str(), _cache_file.c_str(), time);
+					return true;
+				}
+				_write_cache_file = true;
+			}
+		}
+
 		if (_params.satPreprocessor.isSet()) {
 
 			std::string newFilename = _params.logDirectory() + "/input_units_removed.cnf";
@@ -101,31 +337,36 @@ bool SatReader::parseInternally(JobDescription& desc) {
 		}
 
 		// Read file with mmap
-		int fd = open(_filename.c_str(), O_RDONLY);
-		if (fd == -1) return false;
-
-		off_t size;
-    	struct stat s;
-		int status = stat(_filename.c_str(), &s);
-		if (status == -1) return false;
-		size = s.st_size;
-		desc.reserveSize(size / sizeof(int));
-		void* mmapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
-
-		if (_raw_content_mode) {
-			int* f = (int*) mmapped;
-			for (long i = 0; i < size; i++) {
-				processInt(f[i], desc);
+		bool ok = processMmappedFile(_filename, [&](const char* data, size_t size) {
+			desc.reserveSize(size / sizeof(int));
+			bool binary = BinaryCnf::isBinaryCnf(data, size);
+			if (binary && !BinaryCnf::hasValidChecksum(data)) {
+				LOG(V1_WARN, "[WARN] Checksum mismatch in binary CNF %s - parsing it as DIMACS\n", _filename.c_str());
+				binary = false;
 			}
-		} else {
-			char* f = (char*) mmapped;
-			for (long i = 0; i < size; i++) {
-				process(f[i], desc);
+			if (binary) {
+				// Already in binary format: nothing to convert
+				ingestBinaryCnf(data, size, desc);
+				_write_cache_file = false;
+			} else if (_raw_content_mode) {
+				const int* f = (const int*) data;
+				for (size_t i = 0; i < size / sizeof(int); i++) {
+					processInt(f[i], desc);
+				}
+			} else if (_params.parallelParsingTasks() > 0) {
+				float time = Timer::elapsedSeconds();
+				parseInParallel(data, size, desc);
+				time = Timer::elapsedSeconds() - time;
+				LOG(V3_VERB, "parsed %.3f GB with %i tasks in %.3fs (%.3f GB/s)\n", size / 1e9,
+					_params.parallelParsingTasks(), time, size / 1e9 / time);
+			} else {
+				for (size_t i = 0; i < size; i++) {
+					process(data[i], desc);
+				}
+				process(EOF, desc);
 			}
-			process(EOF, desc);
-		}
-		munmap(mmapped, size);
-		close(fd);
+		});
+		if (!ok) return false;
 
 	} else if (_namedpipe != -1) {
 		// Read formula over named pipe
@@ -204,6 +445,16 @@ bool SatReader::read(JobDescription& desc) {
 		if (!parseInternally(desc)) return false;
 	}
 
+	if (_write_cache_file && isValidInput() && !_contains_empty_clause) {
+		// Store a binary conversion of the parsed formula for future submissions
+		const int* lits = desc.getFormulaPayload(desc.getRevision());
+		const size_t nbLits = desc.getNumFormulaLiterals();
+		bool ok = BinaryCnf::write(_cache_file, _max_var, _num_read_clauses,
+			lits, nbLits, lits + nbLits, desc.getNumAssumptionLiterals());
+		if (ok) LOG(V3_VERB, "wrote %s to CNF cache %s\n", _filename.c_str(), _cache_file.c_str());
+		else LOG(V1_WARN, "[WARN] could not write %s to CNF cache %s\n", _filename.c_str(), _cache_file.c_str());
+	}
+
 	// Store # variables and # clauses in app config
 	std::vector<std::pair<int, std::string>> fields {
 		{_num_read_clauses, "__NC"},
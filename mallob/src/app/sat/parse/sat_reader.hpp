@@ -40,12 +40,22 @@ private:
     bool _input_invalid {false};
     bool _input_finished {false};
 
+    // Cache of binary conversions of parsed DIMACS files
+    std::string _cache_file;
+    bool _write_cache_file {false};
+
 public:
     SatReader(const Parameters& params, const std::string& filename) : 
         _params(params), _filename(filename) {}
     bool read(JobDescription& desc);
     bool parseInternally(JobDescription& desc);
     bool parseWithTrustedParser(JobDescription& desc);
+    // Parse a memory-mapped plain DIMACS file which is split into chunks at line
+    // boundaries. The chunks are parsed by parallel tasks, each beginning with
+    // a fresh parsing state, and are appended to the description in order.
+    void parseInParallel(const char* data, size_t size, JobDescription& desc);
+    // Ingest a formula in binary CNF format (see binary_cnf.hpp) without parsing.
+    void ingestBinaryCnf(const char* data, size_t size, JobDescription& desc);
 
     inline void processInt(int x, JobDescription& desc) {
         
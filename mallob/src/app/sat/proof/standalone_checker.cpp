@@ -2,6 +2,8 @@
 #include <sys/prctl.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iosfwd>
 #include <string>
 #include <vector>
@@ -10,6 +12,7 @@
 #include "app/sat/proof/lrat_utils.hpp"
 #include "app/sat/proof/merging/lrat_compactifier.hpp"
 #include "app/sat/proof/serialized_lrat_line.hpp"
+#include "app/sat/proof/trusted/lrat_check_pipeline.hpp"
 #include "app/sat/proof/trusted/lrat_checker.hpp"
 #include "app/sat/proof/trusted/trusted_utils.hpp"
 #include "data/job_description.hpp"
@@ -47,6 +50,7 @@ int main(int argc, char** argv) {
     const char* proofInput = nullptr;
     enum ProofReadMode {NORMAL, REVERSED} proofReadMode = NORMAL;
     bool deduplicate {false};
+    int nbCheckThreads {0};
 
     for (int i = 1; i < argc; i++) {
         if (TrustedUtils::beginsWith(argv[i], "-reversed")
@@ -55,6 +59,9 @@ int main(int argc, char** argv) {
         else if (TrustedUtils::beginsWith(argv[i], "-deduplicate")
         || TrustedUtils::beginsWith(argv[i], "--deduplicate"))
             deduplicate = true;
+        else if (TrustedUtils::beginsWith(argv[i], "-threads=")
+        || TrustedUtils::beginsWith(argv[i], "--threads="))
+            nbCheckThreads = atoi(strchr(argv[i], '=')+1);
         else if (!cnfInput) cnfInput = argv[i];
         else if (!proofInput) proofInput = argv[i];
         else {
@@ -62,7 +69,7 @@ int main(int argc, char** argv) {
         }
     }
     if (!cnfInput || !proofInput) {
-        LOG(V0_CRIT, "Usage: %s <cnf-file> <proof-file> [--reversed] [--deduplicate]\n", argv[0]);
+        LOG(V0_CRIT, "Usage: %s <cnf-file> <proof-file> [--reversed] [--deduplicate] [--threads=<#check-threads>]\n", argv[0]);
         exitUnverified();
     }
 
@@ -116,9 +123,24 @@ int main(int argc, char** argv) {
     LratCompactifier compactifier(deduplicate ? liveClauses : 0, deduplicate);
     unsigned long duplicates {0};
     LratLine line;
+    // With check threads, derivations are checked asynchronously and errors are noticed with some delay.
+    std::atomic_bool pipelineError {false};
+    LratCheckPipeline* pipeline {nullptr};
+    if (nbCheckThreads > 0) {
+        pipeline = new LratCheckPipeline(chk, nbCheckThreads, [&](bool ok, const u8*) {
+            if (!ok) pipelineError = true;
+        });
+    }
+    auto exitOnPipelineError = [&]() {
+        pipeline->drain();
+        LOG(V0_CRIT, "[ERROR] problem while checking proof (around line %i).\n", nbLines);
+        LOG(V0_CRIT, "Checker message: %s\n", pipeline->getErrorMessage());
+        exitUnverified();
+    };
     time = Timer::elapsedSeconds();
     bool failureFlag {false};
     while (lrat_utils::readLine(readbuf, line, &failureFlag)) {
+        if (pipeline && MALLOB_UNLIKELY(pipelineError)) exitOnPipelineError();
         nbLines++;
         if (line.isDeletionStatement()) {
             int nbHints = line.hints.size();
@@ -129,7 +151,8 @@ int main(int argc, char** argv) {
             nbDeletions += nbHints;
             if (liveClauses > maxLiveClauses) maxLiveClauses = liveClauses;
             liveClauses -= nbHints;
-            ok = chk.deleteClause(line.hints.data(), line.hints.size());
+            if (pipeline) pipeline->submitDeletion(line.hints.data(), line.hints.size());
+            else ok = chk.deleteClause(line.hints.data(), line.hints.size());
             if (!ok) {
                 LOG(V0_CRIT, "[ERROR] Problem with clause deletion.\n");
                 LOG(V0_CRIT, "Offending line %i: %s", nbLines, line.toStr().c_str());
@@ -143,7 +166,9 @@ int main(int argc, char** argv) {
             }
             nbAdditions++;
             liveClauses++;
-            ok = chk.addClause(line.id, line.literals.data(), line.literals.size(), line.hints.data(), line.hints.size());
+            if (pipeline) pipeline->submitDerivation(line.id, line.literals.data(), line.literals.size(),
+                line.hints.data(), line.hints.size(), nullptr);
+            else ok = chk.addClause(line.id, line.literals.data(), line.literals.size(), line.hints.data(), line.hints.size());
             if (!ok) {
                 LOG(V0_CRIT, "[ERROR] problem while adding clause derivation.\n");
                 LOG(V0_CRIT, "Offending line %i: %s", nbLines, line.toStr().c_str());
@@ -153,14 +178,22 @@ int main(int argc, char** argv) {
         }
         if (nbLines % 1048576 == 0) {
             auto rss = Proc::getRecursiveProportionalSetSizeKbs(Proc::getPid());
-            LOG(V2_INFO, "%lu lines passed; RAM usage: %.1f MB\n", nbLines, rss/1024.0);
+            LOG(V2_INFO, "%lu lines passed; RAM usage: %.1f MB; checker: %.1f bytes/clause\n", nbLines, rss/1024.0,
+                chk.getMemoryFootprint() / (double) std::max(1UL, chk.getNbClauses()));
         }
     }
+    if (pipeline) {
+        pipeline->drain();
+        if (!pipeline->valid() || pipelineError) exitOnPipelineError();
+        delete pipeline;
+    }
     time = Timer::elapsedSeconds() - time;
 
     LOG(V2_INFO, "Done; %lu lines, %lu added cls, %lu deleted cls, %lu bottleneck cls, %lu duplicates; time %.3f (= %.1f lines/sec)\n",
         nbLines, nbAdditions, nbDeletions, maxLiveClauses, duplicates, time, nbLines/std::max(0.0001f, time));
-    LOG(V2_INFO, "%lu non-deleted clauses remaining\n", liveClauses);
+    LOG(V2_INFO, "%lu non-deleted clauses remaining; %.1f checks/sec; checker: %.1f bytes/clause, %lu compactions\n",
+        liveClauses, nbAdditions/std::max(0.0001f, time),
+        chk.getMemoryFootprint() / (double) std::max(1UL, chk.getNbClauses()), chk.getNbCompactions());
     if (failureFlag) {
         LOG(V0_CRIT, "[ERROR] parsing error in line %i\n", nbLines+1);
         exitUnverified();
@@ -0,0 +1,257 @@
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "lrat_checker.hpp"
+#include "trusted_utils.hpp"
+
+// Pipelined LRAT checking with several checker threads.
+// The calling thread submits all lines in proof order. For each derivation, it
+// resolves the hints and inserts the new clause right away, so that each line
+// sees exactly the clauses it would see in sequential checking. Since all
+// antecedents of a line are thus known at submission time, the unit propagation
+// of different derivations is independent and is performed by worker threads
+// in any order. (A derivation may use a clause whose own check is still pending;
+// if that check fails, the entire proof is rejected anyway.) A commit thread
+// reports the results in submission order. The storage of a deleted clause is
+// released only after all earlier lines have been committed.
+class LratCheckPipeline {
+
+public:
+    // Called by the commit thread for each line, in submission order.
+    typedef std::function<void(bool ok, const u8* sigOrNull)> CommitCallback;
+    // Called by the commit thread whenever no further line can be committed yet.
+    typedef std::function<void()> IdleCallback;
+
+private:
+    struct Line {
+        u64 id;
+        u32 offset;
+        int nbLits;
+        std::vector<u64> hints;
+        std::vector<u32> hintOffsets;
+        bool needsCheck;
+        bool affectsValidity;
+        bool result;
+        bool hasSig;
+        signature sig;
+        std::string errmsg;
+        std::atomic_bool done {false};
+    };
+
+    static constexpr u64 WINDOW_SIZE = 1<<14;
+    static constexpr u64 CLAIM_BATCH_SIZE = 16;
+
+    LratChecker& _chk;
+    CommitCallback _cb_commit;
+    IdleCallback _cb_idle;
+
+    std::vector<Line> _lines;
+    std::atomic<u64> _nb_submitted {0};
+    std::atomic<u64> _nb_claimed {0};
+    std::atomic<u64> _nb_committed {0};
+
+    std::vector<std::pair<u64, u32>> _deferred_releases;
+    size_t _deferred_releases_begin {0};
+    std::vector<u32> _unlinked;
+
+    // Written by the commit thread only
+    bool _valid {true};
+    // message of the first rejected line
+    std::string _errmsg;
+
+    std::atomic_bool _terminate {false};
+    std::vector<std::thread> _workers;
+    std::thread _committer;
+
+public:
+    // With nbWorkers=0 (or if the checker cannot guarantee stable clause addresses),
+    // derivations are checked by the submitting thread.
+    LratCheckPipeline(LratChecker& chk, int nbWorkers, CommitCallback cbCommit, IdleCallback cbIdle = [](){}) :
+            _chk(chk), _cb_commit(cbCommit), _cb_idle(cbIdle), _lines(WINDOW_SIZE) {
+        if (!_chk.hasStableClauseAddresses()) nbWorkers = 0;
+        for (int i = 0; i < nbWorkers; i++) _workers.emplace_back([&]() {runWorker();});
+        _committer = std::thread([&]() {runCommitter();});
+    }
+    ~LratCheckPipeline() {
+        drain();
+        _terminate = true;
+        for (auto& worker : _workers) worker.join();
+        _committer.join();
+    }
+
+    void submitDerivation(u64 id, const int* lits, int nbLits, const u64* hints, int nbHints, const u8* sigOrNull) {
+        Line& line = beginLine(true, sigOrNull);
+        line.id = id;
+        line.nbLits = nbLits;
+        line.hints.assign(hints, hints+nbHints);
+        line.hintOffsets.resize(nbHints);
+        line.needsCheck = _chk.resolveHints(id, hints, nbHints, line.hintOffsets.data())
+            && _chk.addAxiomaticClause(id, lits, nbLits, &line.offset);
+        if (!line.needsCheck) {
+            line.result = false;
+            line.errmsg = _chk.getErrorMessage();
+        } else if (_workers.empty()) {
+            check(line, _chk.getVarValues());
+        }
+        endLine();
+    }
+
+    void submitAxiom(u64 id, const int* lits, int nbLits) {
+        Line& line = beginLine(true, nullptr);
+        line.result = _chk.addAxiomaticClause(id, lits, nbLits);
+        if (!line.result) line.errmsg = _chk.getErrorMessage();
+        endLine();
+    }
+
+    void submitDeletion(const u64* ids, int nbIds) {
+        Line& line = beginLine(false, nullptr);
+        _unlinked.clear();
+        line.result = _chk.unlinkClauses(ids, nbIds, _unlinked);
+        if (!line.result) line.errmsg = _chk.getErrorMessage();
+        const u64 seq = _nb_submitted.load(std::memory_order_relaxed);
+        for (u32 offset : _unlinked) _deferred_releases.push_back({seq, offset});
+        endLine();
+    }
+
+    // A line whose result is already known, e.g., an import with an invalid signature.
+    void submitResult(bool ok, const char* errmsg) {
+        Line& line = beginLine(true, nullptr);
+        line.result = ok;
+        if (!ok) line.errmsg = errmsg;
+        endLine();
+    }
+
+    // A response of the calling thread which does not affect the proof's validity.
+    // It is reported in order with all other lines, so that all output is written by the commit thread.
+    void submitResponse(bool ok, const u8* sigOrNull) {
+        Line& line = beginLine(false, sigOrNull);
+        line.result = ok;
+        endLine();
+    }
+
+    // Wait until all submitted lines have been committed.
+    void drain() {
+        const u64 nbSubmitted = _nb_submitted.load(std::memory_order_relaxed);
+        int nbIdleCycles = 0;
+        while (_nb_committed.load(std::memory_order_acquire) < nbSubmitted) idle(nbIdleCycles);
+        releaseDeferred();
+    }
+
+    // Whether all committed derivations and imports were accepted.
+    // Call drain() first.
+    bool valid() const {return _valid;}
+    // The message of the first rejected line (if any). Call drain() first.
+    const char* getErrorMessage() const {return _errmsg.c_str();}
+
+private:
+    Line& beginLine(bool affectsValidity, const u8* sigOrNull) {
+        const u64 seq = _nb_submitted.load(std::memory_order_relaxed);
+        // Wait for a free slot
+        int nbIdleCycles = 0;
+        while (seq - _nb_committed.load(std::memory_order_acquire) >= WINDOW_SIZE) idle(nbIdleCycles);
+        releaseDeferred();
+        Line& line = _lines[seq % WINDOW_SIZE];
+        line.needsCheck = false;
+        line.affectsValidity = affectsValidity;
+        line.hasSig = sigOrNull != nullptr;
+        if (line.hasSig) TrustedUtils::copyBytes(line.sig, sigOrNull, SIG_SIZE_BYTES);
+        line.errmsg.clear();
+        return line;
+    }
+    void endLine() {
+        Line& line = _lines[_nb_submitted.load(std::memory_order_relaxed) % WINDOW_SIZE];
+        if (_workers.empty()) line.done.store(true, std::memory_order_release);
+        _nb_submitted.fetch_add(1, std::memory_order_release);
+    }
+
+    // Release the storage of deleted clauses which no pending check can access anymore.
+    void releaseDeferred() {
+        const u64 nbCommitted = _nb_committed.load(std::memory_order_acquire);
+        while (_deferred_releases_begin < _deferred_releases.size()
+                && _deferred_releases[_deferred_releases_begin].first < nbCommitted) {
+            _chk.releaseClause(_deferred_releases[_deferred_releases_begin].second);
+            _deferred_releases_begin++;
+        }
+        if (_deferred_releases_begin == _deferred_releases.size()) {
+            _deferred_releases.clear();
+            _deferred_releases_begin = 0;
+        }
+        if (MALLOB_UNLIKELY(_chk.needsCompaction())) {
+            // Clauses are moved: wait until no checks are pending
+            if (nbCommitted < _nb_submitted.load(std::memory_order_relaxed)) {
+                drain();
+                return;
+            }
+            _chk.compact();
+        }
+    }
+
+    void check(Line& line, int8_t* varValues) {
+        static thread_local char errmsg[512];
+        errmsg[0] = '\0';
+        line.result = _chk.checkResolved(line.id, _chk.getClauseLiterals(line.offset), line.nbLits,
+            line.hints.data(), line.hintOffsets.data(), line.hints.size(), varValues, errmsg);
+        if (!line.result) line.errmsg = errmsg;
+    }
+
+    void runWorker() {
+        std::vector<int8_t> varValues(_chk.getNbVars()+1, 0);
+        int nbIdleCycles = 0;
+        while (!_terminate) {
+            u64 begin = _nb_claimed.load(std::memory_order_relaxed);
+            const u64 nbSubmitted = _nb_submitted.load(std::memory_order_acquire);
+            if (begin >= nbSubmitted) {
+                idle(nbIdleCycles);
+                continue;
+            }
+            const u64 end = std::min(begin + CLAIM_BATCH_SIZE, nbSubmitted);
+            if (!_nb_claimed.compare_exchange_weak(begin, end, std::memory_order_relaxed)) continue;
+            nbIdleCycles = 0;
+            for (u64 seq = begin; seq < end; seq++) {
+                Line& line = _lines[seq % WINDOW_SIZE];
+                if (line.needsCheck) check(line, varValues.data());
+                line.done.store(true, std::memory_order_release);
+            }
+        }
+    }
+
+    void runCommitter() {
+        int nbIdleCycles = 0;
+        while (true) {
+            const u64 seq = _nb_committed.load(std::memory_order_relaxed);
+            const u64 nbSubmitted = _nb_submitted.load(std::memory_order_acquire);
+            if (seq == nbSubmitted && _terminate) {
+                _cb_idle();
+                break;
+            }
+            Line& line = _lines[seq % WINDOW_SIZE];
+            if (seq == nbSubmitted || !line.done.load(std::memory_order_acquire)) {
+                if (nbIdleCycles == 0) _cb_idle();
+                idle(nbIdleCycles);
+                continue;
+            }
+            nbIdleCycles = 0;
+            bool ok = line.result;
+            if (!ok && _errmsg.empty()) _errmsg = line.errmsg;
+            if (line.affectsValidity) {
+                _valid &= ok;
+                ok = _valid;
+            }
+            _cb_commit(ok, line.hasSig ? line.sig : nullptr);
+            line.done.store(false, std::memory_order_relaxed);
+            _nb_committed.store(seq+1, std::memory_order_release);
+        }
+    }
+
+    void idle(int& nbIdleCycles) {
+        if (nbIdleCycles++ < 64) std::this_thread::yield();
+        else usleep(50);
+    }
+};
@@ -3,43 +3,46 @@
 
 #include "siphash/siphash.hpp"
 #include "trusted_utils.hpp"
-#include "robin_map.h"
+#include "lrat_clause_arena.hpp"
+#include "robin_set.h"
 
 class LratChecker {
 
 private:
-    // We represent each clause as a raw, owned, zero-terminated pointer to the literals.
+    // All clauses reside in an arena. The hash table only holds the 32-bit
+    // offset of each clause; its ID is stored in the arena as well.
     // This minimizes the memory used by "empty" elements in the large hash table.
-    struct CompactClause {
-        int* data {nullptr};
-        CompactClause(const int* data, int nbLits) {
-            this->data = (int*) malloc((nbLits+1) * sizeof(int));
-            for (int i = 0; i < nbLits; i++) this->data[i] = data[i];
-            this->data[nbLits] = 0;
-        }
-        CompactClause(CompactClause&& moved) : data(moved.data) {
-            moved.data = nullptr;
-        }
-        CompactClause& operator=(CompactClause&& moved) {
-            data = moved.data;
-            moved.data = nullptr;
-            return *this;
-        }
-        ~CompactClause() {
-            if (data) free(data);
-        }
+    LratClauseArena _arena;
+
+    struct ClauseRef {
+        u32 offset;
     };
 
     // Simple and fast hash function for clause IDs.
     struct ClauseIdHasher {
+        const LratClauseArena* arena;
         std::size_t operator()(const u64& val) const {
             return (0xcbf29ce484222325UL ^ val) * 0x00000100000001B3UL;
         }
+        std::size_t operator()(const ClauseRef& ref) const {
+            return (*this)(arena->getId(ref.offset));
+        }
+    };
+    // Compares clause references by their IDs, also allowing lookups by ID.
+    struct ClauseIdEquals {
+        using is_transparent = void;
+        const LratClauseArena* arena;
+        bool operator()(const ClauseRef& ref, const u64& id) const {
+            return arena->getId(ref.offset) == id;
+        }
+        bool operator()(const ClauseRef& left, const ClauseRef& right) const {
+            return arena->getId(left.offset) == arena->getId(right.offset);
+        }
     };
 
     // The hash table where we keep all clauses and which uses most of our RAM.
     // We still use a power-of-two growth policy since this makes lookups faster.
-    tsl::robin_map<u64, CompactClause, ClauseIdHasher> _clauses;
+    tsl::robin_set<ClauseRef, ClauseIdHasher, ClauseIdEquals> _clauses;
 
     std::vector<int8_t> _var_values;
     char _errmsg[512] = {0};
@@ -53,7 +56,7 @@ private:
 
 public:
     LratChecker(int nbVars, const u8* sigKey128bit = nullptr) :
-        _clauses(1<<16),
+        _clauses(1<<16, ClauseIdHasher{&_arena}, ClauseIdEquals{&_arena}),
         _var_values(nbVars+1, 0), _siphash_builder(sigKey128bit) {}
 
     inline bool loadLiteral(int lit) {
@@ -98,9 +101,14 @@ public:
         return true;
     }
 
-    inline bool addAxiomaticClause(u64 id, const int* lits, int nbLits) {
-        auto [it, ok] = _clauses.insert({id, CompactClause{lits, nbLits}});
-        if (!ok) snprintf(_errmsg, 512, "Insertion of clause %lu unsuccessful - already present?", id);
+    inline bool addAxiomaticClause(u64 id, const int* lits, int nbLits, u32* outOffset = nullptr) {
+        u32 offset = _arena.allocate(id, lits, nbLits);
+        if (outOffset) *outOffset = offset;
+        auto [it, ok] = _clauses.insert(ClauseRef{offset});
+        if (!ok) {
+            _arena.release(offset);
+            snprintf(_errmsg, 512, "Insertion of clause %lu unsuccessful - already present?", id);
+        }
         else if (nbLits == 0) _unsat_proven = true; // added top-level empty clause!
         return ok;
     }
@@ -119,10 +127,25 @@ public:
                 snprintf(_errmsg, 512, "Clause deletion: ID %lu not found", id);
                 return false;
             }
+            const u32 offset = it->offset;
             _clauses.erase(it);
+            _arena.release(offset);
         }
+        if (MALLOB_UNLIKELY(needsCompaction())) compact();
         return true;
     }
+    u64 getNbClauses() const {
+        return _clauses.size();
+    }
+    // Approximate number of bytes allocated for the clauses and the hash table.
+    u64 getMemoryFootprint() const {
+        // Each bucket holds an offset, the distance to its ideal bucket and a flag
+        return _arena.getNbAllocatedBytes() + _clauses.bucket_count() * 2*sizeof(u32);
+    }
+    u64 getNbCompactions() const {
+        return _arena.getNbCompactions();
+    }
+
     const char* getErrorMessage() const {
         return _errmsg;
     }
@@ -139,8 +162,90 @@ public:
         return true;
     }
 
+    // Low-level interface for pipelined checking (see LratCheckPipeline).
+    // The checks of derivations can be performed concurrently (checkResolved) while
+    // a single thread adds and removes clauses, as long as the storage of each
+    // removed clause is only released after all checks which may use it are done.
+
+    // Look up the clauses for the given hints and write their offsets.
+    inline bool resolveHints(u64 baseId, const u64* hints, int nbHints, u32* outOffsets) {
+        for (int i = 0; i < nbHints; i++) {
+            auto it = _clauses.find(hints[i]);
+            if (MALLOB_UNLIKELY(it == _clauses.end())) {
+                snprintf(_errmsg, 512, "Derivation %lu: hint %lu not found", baseId, hints[i]);
+                return false;
+            }
+            outOffsets[i] = it->offset;
+        }
+        return true;
+    }
+    // Remove the clauses from the hash table, but keep their storage until
+    // releaseClause is called for each of the written offsets.
+    inline bool unlinkClauses(const u64* ids, int nbIds, std::vector<u32>& outOffsets) {
+        for (int i = 0; i < nbIds; i++) {
+            auto id = ids[i];
+            if (id == 0) continue;
+            auto it = _clauses.find(id);
+            if (it == _clauses.end()) {
+                snprintf(_errmsg, 512, "Clause deletion: ID %lu not found", id);
+                return false;
+            }
+            outOffsets.push_back(it->offset);
+            _clauses.erase(it);
+        }
+        return true;
+    }
+    inline void releaseClause(u32 offset) {
+        _arena.release(offset);
+    }
+    // Check a derivation whose hints have been resolved to clause offsets,
+    // using the provided variable assignment (all zero, nbVars+1 entries) and
+    // writing a message to errmsg (512 bytes) in case of failure.
+    inline bool checkResolved(u64 baseId, const int* lits, int nbLits, const u64* hints,
+            const u32* hintOffsets, int nbHints, int8_t* varValues, char* errmsg) const {
+        return propagate(baseId, lits, nbLits, hints, nbHints, [&](int i) {
+            return _arena.getLiterals(hintOffsets[i]);
+        }, varValues, errmsg);
+    }
+    inline const int* getClauseLiterals(u32 offset) const {
+        return _arena.getLiterals(offset);
+    }
+    // The variable assignment used for checks by the thread which adds clauses.
+    int8_t* getVarValues() {
+        return _var_values.data();
+    }
+    bool hasStableClauseAddresses() const {
+        return _arena.hasStableAddresses();
+    }
+    int getNbVars() const {
+        return _var_values.size()-1;
+    }
+    bool needsCompaction() const {
+        return _arena.needsCompaction();
+    }
+    // Reclaim the space of deleted clauses. All clauses are re-inserted into the
+    // hash table (which keeps its size) since their offsets change.
+    void compact() {
+        _clauses.clear();
+        _arena.compact([&](u32 offset) {
+            _clauses.insert(ClauseRef{offset});
+        });
+    }
+
 private:
     inline bool checkClause(u64 baseId, const int* lits, int nbLits, const u64* hints, int nbHints) {
+        return propagate(baseId, lits, nbLits, hints, nbHints, [&](int i) -> const int* {
+            auto hintClsIt = _clauses.find(hints[i]);
+            if (MALLOB_UNLIKELY(hintClsIt == _clauses.end())) return nullptr;
+            return _arena.getLiterals(hintClsIt->offset);
+        }, _var_values.data(), _errmsg);
+    }
+
+    // Traverse the hints (resolved to their literals by getHint) to derive
+    // a conflict from the negation of the clause via unit propagation.
+    template <typename GetHint>
+    static inline bool propagate(u64 baseId, const int* lits, int nbLits, const u64* hints, int nbHints,
+            GetHint getHint, int8_t* varValues, char* errmsg) {
         // Keep track of asserted unit clauses in a stack
         static thread_local std::vector<int> setUnits;
 
@@ -148,7 +253,7 @@ private:
         // Assume the negation of each literal in the new clause
         for (int i = 0; i < nbLits; i++) {
             int var = abs(lits[i]);
-            _var_values[var] = lits[i]>0 ? -1 : 1; // negated
+            varValues[var] = lits[i]>0 ? -1 : 1; // negated
             setUnits.push_back(var); // remember to reset later
         }
 
@@ -158,36 +263,34 @@ private:
 
             // Find the clause for this hint
             auto hintId = hints[i];
-            auto hintClsIt = _clauses.find(hintId);
-            if (MALLOB_UNLIKELY(hintClsIt == _clauses.end())) {
+            const int* hintCls = getHint(i);
+            if (MALLOB_UNLIKELY(!hintCls)) {
                 // ERROR - hint not found
-                snprintf(_errmsg, 512, "Derivation %lu: hint %lu not found", baseId, hintId);
+                snprintf(errmsg, 512, "Derivation %lu: hint %lu not found", baseId, hintId);
                 ok = false; break;
             }
 
             // Interpret hint clause (should derive a new unit clause)
-            const auto& hintCls = hintClsIt->second;
-            TrustedUtils::doAssert(hintCls.data);
             int newUnit = 0;
             for (int litIdx = 0; ; litIdx++) { // for each literal ...
-                int lit = hintCls.data[litIdx];
+                int lit = hintCls[litIdx];
                 if (lit == 0) break;           // ... until termination zero
                 int var = abs(lit);
-                if (_var_values[var] == 0) {
+                if (varValues[var] == 0) {
                     // Literal is unassigned
                     if (MALLOB_UNLIKELY(newUnit != 0)) {
                         // ERROR - multiple unassigned literals in hint clause!
-                        snprintf(_errmsg, 512, "Derivation %lu: multiple literals unassigned", baseId);
+                        snprintf(errmsg, 512, "Derivation %lu: multiple literals unassigned", baseId);
                         ok = false; break;
                     }
                     newUnit = lit;
                     continue;
                 }
                 // Literal is fixed
-                bool sign = _var_values[var]>0;
+                bool sign = varValues[var]>0;
                 if (MALLOB_UNLIKELY(sign == (lit>0))) {
                     // ERROR - clause is satisfied, so it is not a correct hint
-                    snprintf(_errmsg, 512, "Derivation %lu: dependency %lu is satisfied", baseId, hintId);
+                    snprintf(errmsg, 512, "Derivation %lu: dependency %lu is satisfied", baseId, hintId);
                     ok = false; break;
                 }
                 // All OK - literal is false, thus (virtually) removed from the clause
@@ -200,24 +303,24 @@ private:
                 // -> Empty clause derived.
                 if (MALLOB_UNLIKELY(i+1 < nbHints)) {
                     // ERROR - not at the final hint yet!
-                    snprintf(_errmsg, 512, "Derivation %lu: empty clause produced at non-final hint %lu", baseId, hintId);
+                    snprintf(errmsg, 512, "Derivation %lu: empty clause produced at non-final hint %lu", baseId, hintId);
                     ok = false; break;
                 }
                 // Final hint produced empty clause - everything OK!
-                for (int var : setUnits) _var_values[var] = 0; // reset variable values
+                for (int var : setUnits) varValues[var] = 0; // reset variable values
                 setUnits.clear();
                 return true;
             }
             // Insert the new derived unit clause
             int var = abs(newUnit);
-            _var_values[var] = newUnit>0 ? 1 : -1;
+            varValues[var] = newUnit>0 ? 1 : -1;
             setUnits.push_back(var); // remember to reset later
         }
 
         // ERROR - something went wrong
-        if (_errmsg[0] == '\0')
-            snprintf(_errmsg, 512, "Derivation %lu: no empty clause was produced", baseId);
-        for (int var : setUnits) _var_values[var] = 0; // reset variable values
+        if (errmsg[0] == '\0')
+            snprintf(errmsg, 512, "Derivation %lu: no empty clause was produced", baseId);
+        for (int var : setUnits) varValues[var] = 0; // reset variable values
         setUnits.clear();
         return false;
     }
@@ -0,0 +1,182 @@
+
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+#include <sys/mman.h>
+
+#include "trusted_utils.hpp"
+
+// Storage for the clauses of the LRAT checker within a single growing block of
+// memory. Each clause is a block [ID (two ints)] [literals] [0] which is
+// referenced by its 32-bit offset (in ints) into the arena. This avoids the
+// per-clause overhead and the fragmentation of individual heap allocations.
+// Released blocks of moderate size are kept in free lists per block size and
+// are reused for new clauses of the same size; all other released space is
+// reclaimed by compacting the arena.
+// If possible, the arena reserves the address space for its maximum size up
+// front (without committing memory), so that clauses never move while the
+// arena grows. This allows other threads to read clauses while new clauses
+// are added (see LratCheckPipeline).
+class LratClauseArena {
+
+public:
+    static constexpr u32 NONE = 0xffffffff;
+
+private:
+    // A released block is marked by setting the upper half of its ID to this value,
+    // which no clause ID (< 2^63) can have. The lower half then holds the offset
+    // of the next block in the free list. The literals remain in place, so the
+    // size of a released block can still be determined.
+    static constexpr u32 FREE_MARK = 0xffffffff;
+    static constexpr int NB_HEADER_INTS = 2;
+    static constexpr int MAX_POOLED_BLOCK_SIZE = 64;
+    static constexpr u64 MAX_NB_INTS = NONE;
+    static constexpr u64 MIN_NB_INTS_FOR_COMPACTION = 1<<20;
+
+    int* _data {nullptr};
+    bool _reserved {false};
+    u64 _capacity {0};
+    u64 _size {0};
+    u64 _nb_released_ints {0};
+    u64 _nb_compactions {0};
+    u32 _free_lists[MAX_POOLED_BLOCK_SIZE+1];
+
+public:
+    LratClauseArena(u64 initialCapacity = 1<<16) {
+        for (int i = 0; i <= MAX_POOLED_BLOCK_SIZE; i++) _free_lists[i] = NONE;
+        void* data = mmap(nullptr, MAX_NB_INTS * sizeof(int), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (data != MAP_FAILED) {
+            _data = (int*) data;
+            _reserved = true;
+        }
+        reserve(initialCapacity);
+    }
+    ~LratClauseArena() {
+        if (_reserved) munmap(_data, MAX_NB_INTS * sizeof(int));
+        else free(_data);
+    }
+
+    // Whether the addresses of clauses remain valid while new clauses are added.
+    bool hasStableAddresses() const {return _reserved;}
+
+    inline u32 allocate(u64 id, const int* lits, int nbLits) {
+        const u64 blockSize = NB_HEADER_INTS + nbLits + 1;
+        u32 offset;
+        if (blockSize <= MAX_POOLED_BLOCK_SIZE && _free_lists[blockSize] != NONE) {
+            // Reuse a released block of the same size
+            offset = _free_lists[blockSize];
+            _free_lists[blockSize] = (u32) _data[offset];
+            _nb_released_ints -= blockSize;
+        } else {
+            if (MALLOB_UNLIKELY(_size + blockSize > _capacity)) {
+                reserve(_size + blockSize);
+            }
+            offset = _size;
+            _size += blockSize;
+        }
+        memcpy(_data + offset, &id, sizeof(u64));
+        memcpy(_data + offset + NB_HEADER_INTS, lits, nbLits * sizeof(int));
+        _data[offset + NB_HEADER_INTS + nbLits] = 0;
+        return offset;
+    }
+
+    inline void release(u32 offset) {
+        const u64 blockSize = getBlockSize(offset);
+        _data[offset+1] = (int) FREE_MARK;
+        if (blockSize <= MAX_POOLED_BLOCK_SIZE) {
+            _data[offset] = (int) _free_lists[blockSize];
+            _free_lists[blockSize] = offset;
+        }
+        _nb_released_ints += blockSize;
+    }
+
+    inline u64 getId(u32 offset) const {
+        u64 id;
+        memcpy(&id, _data + offset, sizeof(u64));
+        return id;
+    }
+    // Zero-terminated literals of the clause at the given offset.
+    inline const int* getLiterals(u32 offset) const {
+        return _data + offset + NB_HEADER_INTS;
+    }
+
+    // Whether at least half of the arena consists of released blocks.
+    bool needsCompaction() const {
+        return _size >= MIN_NB_INTS_FOR_COMPACTION && 2*_nb_released_ints >= _size;
+    }
+
+    // Move all live blocks to the front of the arena, preserving their order,
+    // and call onMoved(newOffset) for each of them (in ascending order).
+    // All previous offsets become invalid.
+    template <typename F>
+    void compact(F onMoved) {
+        u64 readPos = 0, writePos = 0;
+        while (readPos < _size) {
+            const u64 blockSize = getBlockSize(readPos);
+            if (isFree(readPos)) {
+                readPos += blockSize;
+                continue;
+            }
+            if (writePos != readPos) memmove(_data + writePos, _data + readPos, blockSize * sizeof(int));
+            onMoved((u32) writePos);
+            writePos += blockSize;
+            readPos += blockSize;
+        }
+        _size = writePos;
+        _nb_released_ints = 0;
+        for (int i = 0; i <= MAX_POOLED_BLOCK_SIZE; i++) _free_lists[i] = NONE;
+        _nb_compactions++;
+        // Give back memory
+        shrink(_size + (_size >> 2));
+    }
+
+    u64 getNbAllocatedBytes() const {return _capacity * sizeof(int);}
+    u64 getNbUsedBytes() const {return (_size - _nb_released_ints) * sizeof(int);}
+    u64 getNbCompactions() const {return _nb_compactions;}
+
+private:
+    inline bool isFree(u64 offset) const {
+        return (u32) _data[offset+1] == FREE_MARK;
+    }
+    inline u64 getBlockSize(u64 offset) const {
+        const int* lits = _data + offset + NB_HEADER_INTS;
+        u64 nbLits = 0;
+        while (lits[nbLits] != 0) nbLits++;
+        return NB_HEADER_INTS + nbLits + 1;
+    }
+
+    void reserve(u64 minCapacity) {
+        if (minCapacity > MAX_NB_INTS) {
+            TrustedUtils::log("[ERROR] LRAT clause arena exhausted");
+            TrustedUtils::doAbort();
+        }
+        u64 capacity = _capacity + (_capacity >> 1);
+        if (capacity < minCapacity) capacity = minCapacity;
+        if (capacity > MAX_NB_INTS) capacity = MAX_NB_INTS;
+        resize(capacity);
+    }
+    void shrink(u64 capacity) {
+        if (capacity < (1<<16)) capacity = 1<<16;
+        if (capacity < _capacity) resize(capacity);
+    }
+    void resize(u64 capacity) {
+        if (_reserved) {
+            // Give back the memory of pages beyond the new capacity
+            const u64 pageInts = 4096 / sizeof(int);
+            u64 begin = (capacity + pageInts-1) / pageInts * pageInts;
+            if (begin < _capacity) madvise(_data + begin, (_capacity - begin) * sizeof(int), MADV_DONTNEED);
+            _capacity = capacity;
+            return;
+        }
+        int* data = (int*) realloc(_data, capacity * sizeof(int));
+        if (!data) {
+            TrustedUtils::log("[ERROR] LRAT clause arena: allocation failed");
+            TrustedUtils::doAbort();
+        }
+        _data = data;
+        _capacity = capacity;
+    }
+};
@@ -11,17 +11,21 @@ int main(int argc, char *argv[]) {
 
     const char optDirectives[] = "-fifo-directives=";
     const char optFeedback[] = "-fifo-feedback=";
+    const char optCheckThreads[] = "-check-threads=";
     const char* fifoDirectives;
     const char* fifoFeedback;
+    int nbCheckThreads = 0;
     for (int i = 0; i < argc; i++) {
         if (TrustedUtils::beginsWith(argv[i], optDirectives))
             fifoDirectives = argv[i] + (sizeof(optDirectives)-1);
         if (TrustedUtils::beginsWith(argv[i], optFeedback))
             fifoFeedback = argv[i] + (sizeof(optFeedback)-1);
+        if (TrustedUtils::beginsWith(argv[i], optCheckThreads))
+            nbCheckThreads = atoi(argv[i] + (sizeof(optCheckThreads)-1));
     }
     TrustedUtils::log("Using input path", fifoDirectives);
     TrustedUtils::log("Using output path", fifoFeedback);
-    TrustedCheckerProcess p(fifoDirectives, fifoFeedback);
+    TrustedCheckerProcess p(fifoDirectives, fifoFeedback, nbCheckThreads);
     int res = p.run();
     fflush(stdout);
     return res;
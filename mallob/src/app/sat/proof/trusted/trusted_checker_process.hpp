@@ -6,6 +6,7 @@
 #include <cstring>
 #include <ctime>
 
+#include "lrat_check_pipeline.hpp"
 #include "printer.hpp"
 #include "trusted_utils.hpp"
 #include "trusted_solving.hpp"
@@ -21,6 +22,9 @@ private:
     signature _formula_signature; // formula signature
 
     TrustedSolving* _ts;
+    // Pipelined checking of derivations with this many worker threads (if > 0)
+    int _nb_check_threads;
+    LratCheckPipeline* _pipeline {nullptr};
 
     bool _do_logging {true};
 
@@ -36,13 +40,15 @@ private:
     Printer _printer;
 
 public:
-    TrustedCheckerProcess(const char* fifoIn, const char* fifoOut) {
+    TrustedCheckerProcess(const char* fifoIn, const char* fifoOut, int nbCheckThreads = 0) :
+            _nb_check_threads(nbCheckThreads) {
         _input = fopen(fifoIn, "r");
         _output = fopen(fifoOut, "w");
         _buf_lits = (int*) malloc(_bufcap_lits * sizeof(int));
         _buf_hints = (u64*) malloc(_bufcap_hints * sizeof(u64));
     }
     ~TrustedCheckerProcess() {
+        if (_pipeline) delete _pipeline;
         free(_buf_hints);
         free(_buf_lits);
         fclose(_output);
@@ -61,6 +67,11 @@ public:
 
         while (true) {
             int c = TrustedUtils::readChar(_input);
+            if (_pipeline && c != TRUSTED_CHK_CLS_PRODUCE && c != TRUSTED_CHK_CLS_IMPORT && c != TRUSTED_CHK_CLS_DELETE) {
+                // Synchronize with the pipeline: all results are reported, so we can respond directly
+                _pipeline->drain();
+                if (!_pipeline->valid()) _ts->invalidate(_pipeline->getErrorMessage());
+            }
             if (c == TRUSTED_CHK_INIT) {
 
                 _nb_vars = TrustedUtils::readInt(_input);
@@ -81,7 +92,18 @@ public:
             } else if (c == TRUSTED_CHK_END_LOAD) {
 
                 _printer.printEndLoadingDirective();
-                sayWithFlush(_ts->endLoading());
+                bool res = _ts->endLoading();
+                if (res && _nb_check_threads > 0) {
+                    // From now on, all output is written (and flushed) by the pipeline's commit thread
+                    _pipeline = new LratCheckPipeline(_ts->getChecker(), _nb_check_threads,
+                        [&](bool ok, const u8* sig) {
+                            say(ok);
+                            if (ok && sig) TrustedUtils::writeSignature(sig, _output);
+                        }, [&]() {
+                            UNLOCKED_IO(fflush)(_output);
+                        });
+                }
+                respond(res, nullptr);
 
             } else if (c == TRUSTED_CHK_CLS_PRODUCE) {
 
@@ -94,12 +116,18 @@ public:
                 bool share = TrustedUtils::readChar(_input);
                 //TrustedUtils::doAssert(nbRemaining == 0);
                 _printer.printProduceDirective(id, _buf_lits, nbLits, _buf_hints, nbHints);
+                nbProduced++;
+                if (_pipeline) {
+                    // The signature does not depend on the check's result
+                    if (share) _ts->computeClauseSignature(id, _buf_lits, nbLits, _buf_sig);
+                    _pipeline->submitDerivation(id, _buf_lits, nbLits, _buf_hints, nbHints, share ? _buf_sig : nullptr);
+                    continue;
+                }
                 // forward to checker
                 bool res = _ts->produceClause(id, _buf_lits, nbLits, _buf_hints, nbHints, share ? _buf_sig : nullptr);
                 // respond
                 say(res);
-                if (share) TrustedUtils::writeSignature(_buf_sig, _output);
-                nbProduced++;
+                if (res && share) TrustedUtils::writeSignature(_buf_sig, _output);
 
             } else if (c == TRUSTED_CHK_CLS_IMPORT) {
 
@@ -109,11 +137,17 @@ public:
                 readLiterals(nbLits);
                 TrustedUtils::readSignature(_buf_sig, _input);
                 _printer.printImportDirective(id, _buf_lits, nbLits, _buf_sig);
+                nbImported++;
+                if (_pipeline) {
+                    if (_ts->verifyClauseSignature(id, _buf_lits, nbLits, _buf_sig))
+                        _pipeline->submitAxiom(id, _buf_lits, nbLits);
+                    else _pipeline->submitResult(false, _ts->getErrorMessage());
+                    continue;
+                }
                 // forward to checker
                 bool res = _ts->importClause(id, _buf_lits, nbLits, _buf_sig);
                 // respond
                 say(res);
-                nbImported++;
 
             } else if (c == TRUSTED_CHK_CLS_DELETE) {
                 
@@ -123,11 +157,15 @@ public:
                 //TrustedUtils::doAssert(nbRemaining == 0);
                 _printer.printDeleteDirective(_buf_hints, nbHints);
                 //printf("PROOF?? d %lu ... (%i)\n", hints[0], nbHints);
+                nbDeleted++;
+                if (_pipeline) {
+                    _pipeline->submitDeletion(_buf_hints, nbHints);
+                    continue;
+                }
                 // forward to checker
                 bool res = _ts->deleteClauses(_buf_hints, nbHints);
                 // respond
                 say(res);
-                nbDeleted++;
 
             } else if (c == TRUSTED_CHK_VALIDATE) {
 
@@ -136,14 +174,12 @@ public:
                 _printer.printValidateDirective();
                 bool res = _ts->validateUnsat(_buf_sig);
                 _do_logging = doLoggingPrev;
-                say(res);
-                TrustedUtils::writeSignature(_buf_sig, _output);
-                UNLOCKED_IO(fflush)(_output);
+                respond(res, _buf_sig);
 
             } else if (c == TRUSTED_CHK_TERMINATE) {
 
                 _printer.printTerminateDirective();
-                sayWithFlush(TRUSTED_CHK_RES_ACCEPT);
+                respond(true, nullptr);
                 break;
 
             } else {
@@ -163,8 +199,11 @@ public:
 
         float elapsed = (float) (clock() - start) / CLOCKS_PER_SEC;
 
-        char msg[128];
-        sprintf(msg, "cpu:%.3f prod:%lu imp:%lu del:%lu", elapsed, nbProduced, nbImported, nbDeleted);
+        char msg[256];
+        const LratChecker& chk = _ts->getChecker();
+        sprintf(msg, "cpu:%.3f prod:%lu imp:%lu del:%lu chk/s:%.1f cls:%lu B/cls:%.1f", elapsed, nbProduced, nbImported, nbDeleted,
+            nbProduced / (elapsed > 0 ? elapsed : 1), chk.getNbClauses(),
+            chk.getMemoryFootprint() / (double) (chk.getNbClauses() > 0 ? chk.getNbClauses() : 1));
         log(msg);
 
         return 0;
@@ -179,6 +218,17 @@ private:
         say(ok);
         UNLOCKED_IO(fflush)(_output);
     }
+    // Responds to a directive after the pipeline (if any) has been drained.
+    // With a pipeline, the response is written and flushed by the pipeline's commit thread.
+    inline void respond(bool ok, const u8* sigOrNull) {
+        if (_pipeline) {
+            _pipeline->submitResponse(ok, sigOrNull);
+            return;
+        }
+        say(ok);
+        if (ok && sigOrNull) TrustedUtils::writeSignature(sigOrNull, _output);
+        UNLOCKED_IO(fflush)(_output);
+    }
     inline void say(bool ok) {
         TrustedUtils::writeChar(ok ? TRUSTED_CHK_RES_ACCEPT : TRUSTED_CHK_RES_ERROR, _output);
     }
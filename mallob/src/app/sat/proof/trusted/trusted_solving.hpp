@@ -61,11 +61,8 @@ public:
         const u8* signatureData) {
         
         // verify signature
-        signature computedSignature;
-        computeClauseSignature(id, literals, nbLiterals, computedSignature);
-        if (!TrustedUtils::equalSignatures(signatureData, computedSignature)) {
+        if (!verifyClauseSignature(id, literals, nbLiterals, signatureData)) {
             _valid = false;
-            snprintf(_errmsg, 512, "Signature check of clause %lu failed", id);
             return false;
         }
 
@@ -98,6 +95,16 @@ public:
         TrustedUtils::copyBytes(out, hashOut, SIG_SIZE_BYTES);
     }
 
+    inline bool verifyClauseSignature(u64 id, const int* lits, int nbLits, const u8* signatureData) {
+        signature computedSignature;
+        computeClauseSignature(id, lits, nbLits, computedSignature);
+        if (!TrustedUtils::equalSignatures(signatureData, computedSignature)) {
+            snprintf(_errmsg, 512, "Signature check of clause %lu failed", id);
+            return false;
+        }
+        return true;
+    }
+
     inline void computeSignature(const u8* data, int size, u8* out) {
         u8* sipout = _siphash.reset()
             .update(data, size)
@@ -106,6 +113,12 @@ public:
     }
 
     inline bool valid() const {return _valid;}
+    // For pipelined checking (LratCheckPipeline), which operates on the checker directly
+    LratChecker& getChecker() {return _checker;}
+    void invalidate(const char* errmsg) {
+        _valid = false;
+        snprintf(_errmsg, 512, "%s", errmsg);
+    }
 
     const char* getErrorMessage() {
         if (_errmsg[0] != '\0') return _errmsg;
@@ -17,6 +17,7 @@
 //#define UNLOCKED_IO(fun) fun
 
 typedef unsigned long u64;
+typedef unsigned int u32;
 typedef unsigned char u8;
 
 static constexpr int SIG_SIZE_BYTES = 16;
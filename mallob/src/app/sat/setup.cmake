@@ -55,6 +55,9 @@ new_test(hashing "${BASE_INCLUDES}" mallob_sat_subproc)
 new_test(random "${BASE_INCLUDES}" mallob_sat_subproc)
 new_test(sat_reader "${BASE_INCLUDES}" mallob_corepluscomm)
 new_test(clause_database "${BASE_INCLUDES}" mallob_sat_subproc)
+new_test(buffer_merger "${BASE_INCLUDES}" mallob_sat_subproc)
+new_test(clause_filter "${BASE_INCLUDES}" mallob_sat_subproc)
+new_test(clause_buffer_codec "${BASE_INCLUDES}" mallob_sat_subproc)
 new_test(import_buffer "${BASE_INCLUDES}" mallob_sat_subproc)
 new_test(variable_translator "${BASE_INCLUDES}" mallob_sat_subproc)
 new_test(job_description "${BASE_INCLUDES}" mallob_corepluscomm)
@@ -15,6 +15,7 @@
 #include "util/random.hpp"
 #include "util/tsl/robin_set.h"
 #include "app/sat/sharing/buffer/buffer_iterator.hpp"
+#include "app/sat/sharing/buffer/clause_loser_tree.hpp"
 #include "app/sat/sharing/store/generic_clause_store.hpp"
 #include "robin_hash.h"
 
@@ -95,12 +96,125 @@ std::vector<int> BufferMerger::mergePriorityBased(const Parameters& params, std:
     return resultClauses;
 }
 
+// Output side of a merge: de-duplicates the incoming (sorted) stream of clauses
+// and distributes them over the main buffer and, if present, the excess buffer.
+struct BufferMerger::MergeOutput {
+
+    BufferBuilder mainBuilder;
+    BufferBuilder* excessBuilder {nullptr};
+    BufferBuilder* currentBuilder;
+    int excessFirstCounterPosition = -1;
+
+    // For checking duplicates
+    Clause lastSeenClause;
+    tsl::robin_set<Mallob::Clause, Mallob::NonCommutativeClauseHasher, Mallob::SortedClauseExactEquals> acceptedClausesSet;
+    int currentClauseLengthOfSet = 0;
+
+    MergeOutput(int sizeLimit, int maxEffClauseLength, int maxFreeEffClauseLength, bool slotsForSumOfLengthAndLbd, bool withExcess) :
+            mainBuilder(sizeLimit, maxEffClauseLength, slotsForSumOfLengthAndLbd) {
+        mainBuilder.setFreeClauseLengthLimit(maxFreeEffClauseLength - ClauseMetadata::numInts());
+        if (withExcess) {
+            excessBuilder = new BufferBuilder(sizeLimit, maxEffClauseLength, slotsForSumOfLengthAndLbd);
+            excessBuilder->setFreeClauseLengthLimit(maxFreeEffClauseLength - ClauseMetadata::numInts());
+        }
+        currentBuilder = &mainBuilder;
+    }
+    ~MergeOutput() {
+        if (excessBuilder) delete excessBuilder;
+    }
+
+    inline bool isDuplicate(const Clause& clause) const {
+        if (currentClauseLengthOfSet != clause.size) return false;
+        // Identical to the last accepted clause? (Most duplicates arrive right after each other.)
+        const int offset = ClauseMetadata::numInts();
+        if (lastSeenClause.size == clause.size && compareLiteralBlocks(
+                lastSeenClause.begin+offset, clause.begin+offset, clause.size-offset) == 0)
+            return true;
+        // Either lastSeenClause == clause or the clause was seen before with another LBD.
+        return acceptedClausesSet.contains(clause);
+    }
+
+    inline void accept(const Clause& clause) {
+        if (isDuplicate(clause)) return;
+
+        // -- not a duplicate
+        lastSeenClause = clause;
+        // insert to set which is needed for filtering out identical clauses with different LBDs 
+        if (currentClauseLengthOfSet < lastSeenClause.size) {
+            // new clause length reached: can safely discard smaller accepted clauses
+            acceptedClausesSet.clear();
+            currentClauseLengthOfSet = lastSeenClause.size;
+        }
+        acceptedClausesSet.insert(lastSeenClause);
+
+        // Try to append to current builder
+        bool success = currentBuilder->append(lastSeenClause);
+        if (!success && currentBuilder == &mainBuilder) {
+            // Switch from normal output to excess clauses output
+            assert(excessBuilder);
+            currentBuilder = excessBuilder;
+            success = currentBuilder->append(lastSeenClause);
+            if (success) excessFirstCounterPosition = currentBuilder->getCurrentCounterPosition();
+        }
+    }
+};
+
 std::vector<int> BufferMerger::merge(std::vector<int>* excessClauses, SplitMix64Rng* rng) {
+
+    // Setup builders for main buffer and excess clauses buffer
+    MergeOutput out(_size_limit, _max_eff_clause_length, _max_free_eff_clause_length,
+        _slots_for_sum_of_length_and_lbd, excessClauses != nullptr);
+
+    if (!_use_loser_tree) {
+        mergeWithSortedList(out);
+    } else if (_slots_for_sum_of_length_and_lbd) {
+        mergeWithLoserTree(LengthLbdSumClauseThreewayComparator(_max_eff_clause_length+2), out);
+    } else {
+        mergeWithLoserTree(LexicographicClauseThreewayComparator(), out);
+    }
+
+    auto resultClauses = out.mainBuilder.extractBuffer();
+
+    // Fill provided excess clauses buffer with result from according builder
+    if (excessClauses != nullptr) {
+        *excessClauses = out.excessBuilder->extractBuffer();
+
+        if (rng != nullptr && out.excessFirstCounterPosition != -1) {
+            // Do random tie breaking if necessary
+            auto failedInfo = out.mainBuilder.getFailedInsertionInfo();
+            if (failedInfo.failedBucket == failedInfo.lastBucket) {
+                // Both the main and the excess buffer feature a non-zero number
+                // of clauses from this length-LBD bucket: break ties randomly
+                redistributeBorderBucketClausesRandomly(resultClauses, *excessClauses, 
+                    *rng, failedInfo, out.excessFirstCounterPosition);
+            } // else: insertion failed on a bucket border: no tie breaking needed
+        }
+    }
+
+    return resultClauses;
+}
+
+template <typename Compare>
+void BufferMerger::mergeWithLoserTree(const Compare& compare, MergeOutput& out) {
+
+    // Fetch first clause of each reader
+    for (auto& reader : _readers) reader.getNextIncomingClause();
+
+    ClauseLoserTree<Compare> tree(_readers, compare);
+    while (!tree.empty()) {
+        // Fetch next best clause
+        out.accept(tree.topClause());
+        // Advance the winning reader and replay its path to the root
+        _readers[tree.top()].getNextIncomingClause();
+        tree.replayTop();
+    }
+}
+
+void BufferMerger::mergeWithSortedList(MergeOutput& out) {
     
     AbstractClauseThreewayComparator* threewayCompare = _slots_for_sum_of_length_and_lbd ?
         (AbstractClauseThreewayComparator*) new LengthLbdSumClauseThreewayComparator(_max_eff_clause_length+2) :
         (AbstractClauseThreewayComparator*) new LexicographicClauseThreewayComparator();
-    ClauseComparator compare(threewayCompare);
     InputClauseComparator inputCompare(threewayCompare);
 
     // Setup readers
@@ -125,51 +239,12 @@ std::vector<int> BufferMerger::merge(std::vector<int>* excessClauses, SplitMix64
         }
     }
 
-    // Setup builders for main buffer and excess clauses buffer
-    BufferBuilder mainBuilder(_size_limit, _max_eff_clause_length, _slots_for_sum_of_length_and_lbd);
-    mainBuilder.setFreeClauseLengthLimit(_max_free_eff_clause_length - ClauseMetadata::numInts());
-    BufferBuilder* excessBuilder {nullptr};
-    if (excessClauses != nullptr) {
-        excessBuilder = new BufferBuilder(_size_limit, _max_eff_clause_length, _slots_for_sum_of_length_and_lbd);
-    }
-    BufferBuilder* currentBuilder = &mainBuilder;
-    int excessFirstCounterPosition = -1;
-
-    // For checking duplicates
-    Clause lastSeenClause;
-    tsl::robin_set<Mallob::Clause, Mallob::NonCommutativeClauseHasher, Mallob::SortedClauseExactEquals> acceptedClausesSet;
-    int currentClauseLengthOfSet = 0;
-
     // Merge rounds
     while (!_merger.empty()) {
 
         // Fetch next best clause
         auto& [clause, readerId] = _merger.front();
-        
-        // Duplicate?
-        if (currentClauseLengthOfSet == clause->size && acceptedClausesSet.contains(*clause)) {
-            // Duplicate! Either lastSeenClause == clause or the clause was seen before with another LBD.
-        } else {
-            // -- not a duplicate
-            lastSeenClause = *clause;
-            // insert to set which is needed for filtering out identical clauses with different LBDs 
-            if (currentClauseLengthOfSet < lastSeenClause.size) {
-                // new clause length reached: can safely discard smaller accepted clauses
-                acceptedClausesSet.clear();
-                currentClauseLengthOfSet = lastSeenClause.size;
-            }
-            acceptedClausesSet.insert(lastSeenClause);
-
-            // Try to append to current builder
-            bool success = currentBuilder->append(lastSeenClause);
-            if (!success && currentBuilder == &mainBuilder) {
-                // Switch from normal output to excess clauses output
-                assert(excessBuilder);
-                currentBuilder = excessBuilder;
-                success = currentBuilder->append(lastSeenClause);
-                if (success) excessFirstCounterPosition = currentBuilder->getCurrentCounterPosition();
-            }
-        }
+        out.accept(*clause);
 
         // Refill merger
         _readers[readerId].getNextIncomingClause();
@@ -193,28 +268,7 @@ std::vector<int> BufferMerger::merge(std::vector<int>* excessClauses, SplitMix64
         }
     }
 
-    auto resultClauses = mainBuilder.extractBuffer();
-
-    // Fill provided excess clauses buffer with result from according builder
-    if (excessClauses != nullptr) {
-        *excessClauses = excessBuilder->extractBuffer();
-
-        if (rng != nullptr && excessFirstCounterPosition != -1) {
-            // Do random tie breaking if necessary
-            auto failedInfo = mainBuilder.getFailedInsertionInfo();
-            if (failedInfo.failedBucket == failedInfo.lastBucket) {
-                // Both the main and the excess buffer feature a non-zero number
-                // of clauses from this length-LBD bucket: break ties randomly
-                redistributeBorderBucketClausesRandomly(resultClauses, *excessClauses, 
-                    *rng, failedInfo, excessFirstCounterPosition);
-            } // else: insertion failed on a bucket border: no tie breaking needed
-        }
-
-        delete excessBuilder;
-    }
-
     delete threewayCompare;
-    return resultClauses;
 }
 
 std::string vecToStr(const std::vector<int>& vec) {
@@ -39,11 +39,17 @@ private:
     };
     std::forward_list<InputClause> _merger;
     StaticClauseStore<false>* _merge_store {nullptr};
+    bool _use_loser_tree {true};
+
+    struct MergeOutput;
 
 public:
     BufferMerger(int sizeLimit, int maxEffClauseLength, int maxFreeEffClauseLength, bool slotsForSumOfLengthAndLbd, bool useChecksum = false);
     BufferMerger(StaticClauseStore<false>* mergeStore, int sizeLimit, int maxEffClauseLength, bool slotsForSumOfLengthAndLbd, bool useChecksum = false);
     void add(BufferReader&& reader);
+    // Select between the loser tree merge engine (default) and the original
+    // sorted-list merge. Both produce identical output.
+    void setLoserTreeMerging(bool enabled) {_use_loser_tree = enabled;}
 
     std::vector<int> mergeDiscardingExcess();
     std::vector<int> mergePreservingExcess(std::vector<int>& excessOut);
@@ -53,6 +59,8 @@ public:
     
 private:
     std::vector<int> merge(std::vector<int>* excessClauses, SplitMix64Rng* rng);
+    void mergeWithSortedList(MergeOutput& out);
+    template <typename Compare> void mergeWithLoserTree(const Compare& compare, MergeOutput& out);
     void redistributeBorderBucketClausesRandomly(std::vector<int>& resultClauses, std::vector<int>& excessClauses, 
         SplitMix64Rng& rng, const BufferBuilder::FailedInsertion& failedInfo, int excess1stCounterPos);
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/compression.hpp"
+
+// Compact wire format for clause buffers (including any trailing aggregation
+// metadata). The buffer is read as a flat sequence of integers which is delta
+// coded by compressIntStream (util/compression.hpp): each integer is stored as
+// the zigzag varint of its difference to the preceding non-zero integer, and a
+// zero takes a single byte. Since the literals of each exported clause are sorted
+// (see SharingManager) and clauses are grouped into buckets of similar clauses,
+// most differences are small and need one or two bytes. This applies to every
+// integer of the buffer alike, i.e., the bucket headers (clause counts) and the
+// checksum are delta-coded as well.
+// The encoding is lossless for arbitrary integer vectors, so all buffer
+// operations (BufferMerger, BufferReducer, InPlaceClauseFiltering, ...) remain
+// unaffected as long as they are performed on decoded buffers.
+// Encoded layout: [#ints of decoded buffer] [#bytes] [bytes, padded to full ints]
+class ClauseBufferCodec {
+
+private:
+    static constexpr int NUM_HEADER_INTS = 2;
+    // Worst case of compressIntStream
+    static constexpr int MAX_BYTES_PER_INT = 5;
+
+public:
+    static std::vector<int> encode(const std::vector<int>& buffer) {
+        std::vector<int> out(NUM_HEADER_INTS + (buffer.size()*MAX_BYTES_PER_INT + sizeof(int)-1) / sizeof(int));
+        const size_t nbBytes = compressIntStream(buffer.data(), buffer.size(), (uint8_t*) (out.data() + NUM_HEADER_INTS));
+        out[0] = buffer.size();
+        out[1] = nbBytes;
+        out.resize(NUM_HEADER_INTS + (nbBytes + sizeof(int)-1) / sizeof(int));
+        return out;
+    }
+
+    static std::vector<int> decode(const std::vector<int>& encoded) {
+        assert(encoded.size() >= NUM_HEADER_INTS);
+        const size_t nbInts = encoded[0];
+        const size_t nbBytes = encoded[1];
+        assert(encoded.size() == NUM_HEADER_INTS + (nbBytes + sizeof(int)-1) / sizeof(int)
+            || log_return_false("[ERROR] Malformed encoded clause buffer of size %lu (%lu bytes announced)\n",
+            encoded.size(), nbBytes));
+        std::vector<int> out(nbInts);
+        bool success = decompressIntStream((const uint8_t*) (encoded.data() + NUM_HEADER_INTS), nbBytes,
+            out.data(), nbInts);
+        assert(success || log_return_false("[ERROR] Malformed encoded clause buffer of %lu bytes for %lu ints\n",
+            nbBytes, nbInts));
+        return out;
+    }
+
+    static size_t getNbEncodedBytes(const std::vector<int>& encoded) {
+        return encoded.size() >= NUM_HEADER_INTS ? encoded[1] : 0;
+    }
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "app/sat/data/clause.hpp"
+#include "buffer_reader.hpp"
+
+// Tournament tree of losers over a set of BufferReaders. The winner (tree node 0)
+// is the reader whose current clause is to be emitted next. After this reader
+// has been advanced, replayTop() restores the tree with log2(#readers) comparisons
+// along the leaf-to-root path of the winner.
+// The Compare type must provide a three-way compare(const Clause&, const Clause&).
+// Equal clauses are ordered by descending reader index, which is the order
+// in which BufferMerger's sorted-list merge emits them.
+template <typename Compare>
+class ClauseLoserTree {
+
+private:
+    std::vector<BufferReader>& _readers;
+    Compare _compare;
+    int _num_leaves;
+    std::vector<int> _tree;
+
+public:
+    ClauseLoserTree(std::vector<BufferReader>& readers, const Compare& compare) :
+            _readers(readers), _compare(compare) {
+        _num_leaves = 1;
+        while (_num_leaves < _readers.size()) _num_leaves *= 2;
+        _tree.resize(_num_leaves);
+        _tree[0] = play(1);
+    }
+
+    bool empty() const {
+        return exhausted(_tree[0]);
+    }
+    int top() const {
+        return _tree[0];
+    }
+    Mallob::Clause& topClause() {
+        return *_readers[_tree[0]].getCurrentClausePointer();
+    }
+
+    // Call after the current winner's reader has been advanced.
+    void replayTop() {
+        int winner = _tree[0];
+        for (int node = (winner + _num_leaves) / 2; node >= 1; node /= 2) {
+            if (before(_tree[node], winner)) std::swap(_tree[node], winner);
+        }
+        _tree[0] = winner;
+    }
+
+private:
+    inline bool exhausted(int readerIdx) const {
+        return readerIdx >= _readers.size() || _readers[readerIdx].getCurrentClausePointer()->begin == nullptr;
+    }
+
+    // Whether the current clause of reader a is to be emitted before the one of reader b
+    inline bool before(int a, int b) const {
+        if (exhausted(a)) return false;
+        if (exhausted(b)) return true;
+        int res = _compare.compare(*_readers[a].getCurrentClausePointer(), *_readers[b].getCurrentClausePointer());
+        if (res != 0) return res < 0;
+        return a > b;
+    }
+
+    // Initial tournament: returns the winner of the subtree rooted at node
+    // and stores the losers of all matches at the inner nodes.
+    int play(int node) {
+        if (node >= _num_leaves) return node - _num_leaves;
+        int left = play(2*node);
+        int right = play(2*node+1);
+        if (before(left, right)) {
+            _tree[node] = right;
+            return left;
+        }
+        _tree[node] = left;
+        return right;
+    }
+};
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "app/sat/data/clause.hpp"
+#include "app/sat/data/clause_metadata.hpp"
+#include "app/sat/data/produced_clause_candidate.hpp"
+#include "app/sat/sharing/store/generic_clause_store.hpp"
+#include "app/sat/sharing/filter/generic_clause_filter.hpp"
+#include "produced_clause_filter_commons.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+
+// Compact, concurrent variant of ExactClauseFilter. Instead of the clauses themselves,
+// a 64-bit fingerprint of each clause is stored together with its ClauseInfo in a
+// 16-byte entry of an open-addressing (linear probing) table. There is one table ("shard")
+// per clause length. Look-ups and insertions are lock-free: an empty slot is claimed
+// with a CAS on its fingerprint, and the meta data word is updated with a CAS loop.
+// Since entries are never removed concurrently, a claimed slot remains valid until
+// the next rebuild of the shard. Garbage collection rebuilds one shard at a time,
+// dropping all entries which expired w.r.t. the epoch horizon and resizing the table
+// as needed; only the shard being rebuilt is blocked for (i.e., refused to) inserting threads.
+// An inserting thread which finds its shard full grows the shard in the same manner.
+// Two distinct clauses of the same length may share a fingerprint, in which case
+// the second clause is spuriously filtered. For n entries in a shard, the probability
+// of this happening for a single look-up is at most n/2^64.
+class FingerprintClauseFilter : public GenericClauseFilter {
+
+private:
+    static constexpr uint64_t FP_EMPTY = 0;
+    static constexpr size_t MIN_CAPACITY = 1024;
+
+    struct Entry {
+        std::atomic<uint64_t> fingerprint {FP_EMPTY};
+        // Packed ClauseInfo (see encode / decode); zero represents a default ClauseInfo.
+        std::atomic<uint64_t> meta {0};
+    };
+    static_assert(sizeof(Entry) == 16);
+
+    struct Shard {
+        std::unique_ptr<Entry[]> entries;
+        size_t capacity {0};
+        size_t maxNbEntries {0};
+        std::atomic<size_t> nbEntries {0};
+        // Number of threads currently accessing the shard
+        std::atomic_int nbAccessors {0};
+        // Set while the shard is rebuilt or otherwise needs to be exclusively owned
+        std::atomic_bool blocked {false};
+
+        Shard() {
+            resize(MIN_CAPACITY);
+        }
+        void resize(size_t newCapacity) {
+            capacity = newCapacity;
+            maxNbEntries = (3 * capacity) / 4;
+            entries.reset(new Entry[capacity]);
+            nbEntries.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    const int _epoch_horizon;
+    std::vector<std::unique_ptr<Shard>> _shards;
+    int _last_gc_epoch {0};
+
+    // Number of admitted clauses which could not be registered because the respective shard was full
+    std::atomic<unsigned long> _nb_overflows {0};
+
+public:
+    FingerprintClauseFilter(GenericClauseStore& clauseStore, int epochHorizon, int maxEffClauseLength) :
+        GenericClauseFilter(clauseStore), _epoch_horizon(epochHorizon),
+        _shards(maxEffClauseLength) {
+
+        for (size_t i = 0; i < _shards.size(); i++) {
+            _shards[i].reset(new Shard());
+        }
+    }
+
+    ExportResult tryRegisterAndInsert(ProducedClauseCandidate&& c, GenericClauseStore* storeOrNullptr = nullptr) override {
+        auto& shard = getShard(c.size);
+        const uint64_t fp = fingerprint(c.begin, c.size);
+
+        Entry* entry = find(shard, fp);
+        if (entry) {
+            // entry existed before: check if the clause should be filtered.
+            ClauseInfo info = decode(entry->meta.load(std::memory_order_acquire));
+            if (!info.isAdmissibleForInsertion(c.epoch, _epoch_horizon)) {
+                // filtered! add new producer, return.
+                updateClauseInfo(*entry, c, false);
+                return FILTERED;
+            }
+        }
+
+        // Try to insert clause to clause store
+        Mallob::Clause cls;
+        cls.begin = c.begin; cls.size = c.size; cls.lbd = c.lbd;
+        auto clauseStore = storeOrNullptr ? storeOrNullptr : &_clause_store;
+        if (!clauseStore->addClause(cls)) {
+            // No space left in database: drop clause
+            if (entry) updateClauseInfo(*entry, c, false); // update if existent
+            return DROPPED;
+        }
+        // Success! Register the clause (create if nonexistent)
+        if (!entry) {
+            entry = findOrInsert(shard, fp);
+            // Shard is full: try to grow it right away
+            if (!entry && tryGrow(shard)) entry = findOrInsert(shard, fp);
+        }
+        if (entry) updateClauseInfo(*entry, c, true);
+        else _nb_overflows.fetch_add(1, std::memory_order_relaxed);
+        return ADMITTED;
+    }
+
+    bool collectGarbage(const Logger& logger) override {
+
+        int epoch = _epoch.load(std::memory_order_relaxed);
+        bool sweep = _epoch_horizon >= 0 && epoch - _last_gc_epoch >= _epoch_horizon;
+        if (sweep) _last_gc_epoch = epoch;
+
+        bool rebuiltAny = false;
+        size_t totalEntries = 0, totalCapacity = 0;
+        double maxFalsePositiveRate = 0;
+        for (size_t i = 0; i < _shards.size(); i++) {
+            auto& shard = *_shards.at(i);
+            size_t nbEntries = shard.nbEntries.load(std::memory_order_relaxed);
+            bool grow = 8 * nbEntries > 5 * shard.capacity; // load factor above 5/8
+            if (sweep || grow) {
+                auto time = Timer::elapsedSeconds();
+                block(shard);
+                size_t nbRemoved = rebuild(shard, epoch, sweep);
+                unblock(shard);
+                time = Timer::elapsedSeconds() - time;
+                LOGGER(logger, V5_DEBG, "filter-gc clslen=%i epoch=%i removed=%lu/%lu cap=%lu time=%.4f\n",
+                    i+1-ClauseMetadata::numInts(), epoch, nbRemoved, nbEntries, shard.capacity, time);
+                nbEntries = shard.nbEntries.load(std::memory_order_relaxed);
+                rebuiltAny = true;
+            }
+            totalEntries += nbEntries;
+            totalCapacity += shard.capacity;
+            maxFalsePositiveRate = std::max(maxFalsePositiveRate, nbEntries / 18446744073709551616.0);
+        }
+
+        if (rebuiltAny) {
+            LOGGER(logger, V4_VVER, "fpfilter entries=%lu cap=%lu mem=%lu B/entry=%.2f fprate<=%.3e overflows=%lu\n",
+                totalEntries, totalCapacity, totalCapacity * sizeof(Entry),
+                totalEntries == 0 ? 0.0 : (double) (totalCapacity * sizeof(Entry)) / totalEntries,
+                maxFalsePositiveRate, _nb_overflows.load(std::memory_order_relaxed));
+            LOGGER(logger, V4_VVER, "pcb size=%ld %s\n", _clause_store.getCurrentlyUsedLiterals(),
+                _clause_store.getCurrentlyUsedLiteralsReport().c_str());
+        }
+        return rebuiltAny;
+    }
+
+    cls_producers_bitset confirmSharingAndGetProducers(Mallob::Clause& c, int epoch) override {
+        Entry* entry = find(getShard(c.size), fingerprint(c.begin, c.size));
+        if (!entry) return 0;
+        cls_producers_bitset producers;
+        uint64_t meta = entry->meta.load(std::memory_order_acquire);
+        ClauseInfo info;
+        do {
+            info = decode(meta);
+            // return no producers if all registered producers are from a long time ago
+            producers = (_epoch_horizon >= 0 && epoch - info.lastProducedEpoch > _epoch_horizon) ?
+                0 : info.producers;
+            info.lastSharedEpoch = epoch;
+            info.producers = 0; // reset producers in any case
+        } while (!entry->meta.compare_exchange_weak(meta, encode(info), std::memory_order_acq_rel));
+        return producers;
+    }
+
+    bool admitSharing(Mallob::Clause& c, int epoch) override {
+        Entry* entry = find(getShard(c.size), fingerprint(c.begin, c.size));
+        if (!entry) return true;
+        // Do not reshare a clause which was shared at some recent point in time
+        return decode(entry->meta.load(std::memory_order_acquire)).isAdmissibleForSharing(epoch, _epoch_horizon);
+    }
+
+    size_t size(int clauseLength) const override {
+        if (clauseLength == 0) {
+            size_t totalSize = 0;
+            for (auto& shard : _shards) totalSize += shard->nbEntries.load(std::memory_order_relaxed);
+            return totalSize;
+        }
+        return getShard(clauseLength).nbEntries.load(std::memory_order_relaxed);
+    }
+
+    // The "locks" only exclude accesses to a shard which is being rebuilt
+    // or which is owned exclusively via acquireAllLocks().
+    bool tryAcquireLock(int clauseLength) override {
+        auto& shard = getShard(clauseLength);
+        shard.nbAccessors.fetch_add(1, std::memory_order_seq_cst);
+        if (shard.blocked.load(std::memory_order_seq_cst)) {
+            shard.nbAccessors.fetch_sub(1, std::memory_order_seq_cst);
+            return false;
+        }
+        return true;
+    }
+    void acquireLock(int clauseLength) override {
+        while (!tryAcquireLock(clauseLength)) std::this_thread::yield();
+    }
+    void releaseLock(int clauseLength) override {
+        getShard(clauseLength).nbAccessors.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void acquireAllLocks() override {
+        for (auto& shard : _shards) block(*shard);
+    }
+    void releaseAllLocks() override {
+        for (auto& shard : _shards) unblock(*shard);
+    }
+
+private:
+    Shard& getShard(int clauseLength) const {
+        assert((clauseLength-1 >= 0 && clauseLength-1 < _shards.size())
+            || log_return_false("[ERROR] Invalid clause length %i\n", clauseLength));
+        return *_shards.at(clauseLength-1);
+    }
+
+    void block(Shard& shard) {
+        bool expected = false;
+        while (!shard.blocked.compare_exchange_weak(expected, true, std::memory_order_seq_cst)) {
+            expected = false;
+            std::this_thread::yield();
+        }
+        while (shard.nbAccessors.load(std::memory_order_seq_cst) > 0) std::this_thread::yield();
+    }
+    void unblock(Shard& shard) {
+        shard.blocked.store(false, std::memory_order_seq_cst);
+    }
+
+    // xxHash64-style hashing of the literals (excluding clause metadata).
+    // Binary clauses are hashed in a normalized order.
+    static uint64_t fingerprint(const int* data, int size) {
+        constexpr uint64_t P1 = 11400714785074694791ULL, P2 = 14029467366897019727ULL,
+            P3 = 1609587929392839161ULL, P4 = 9650029242287828579ULL, P5 = 2870177450012600261ULL;
+        auto round = [&](uint64_t acc, uint64_t val) {
+            acc += val * P2;
+            acc = (acc << 31) | (acc >> 33);
+            return acc * P1;
+        };
+        const int* lits = data + ClauseMetadata::numInts();
+        const int nbLits = size - ClauseMetadata::numInts();
+        uint64_t h = P5 + nbLits;
+        if (nbLits == 2) {
+            h = round(h, (uint32_t) std::min(lits[0], lits[1]));
+            h = round(h, (uint32_t) std::max(lits[0], lits[1]));
+        } else {
+            int i = 0;
+            // Consume two literals at a time
+            for (; i+1 < nbLits; i += 2)
+                h = round(h, ((uint64_t) (uint32_t) lits[i] << 32) | (uint32_t) lits[i+1]);
+            if (i < nbLits) h = round(h, (uint32_t) lits[i]);
+        }
+        h ^= h >> 33; h *= P2;
+        h ^= h >> 29; h *= P3;
+        h ^= h >> 32;
+        h += P4 * (h == FP_EMPTY); // reserve the empty fingerprint
+        return h;
+    }
+
+    Entry* find(Shard& shard, uint64_t fp) const {
+        const size_t mask = shard.capacity - 1;
+        size_t idx = fp & mask;
+        for (size_t i = 0; i < shard.capacity; i++) {
+            uint64_t f = shard.entries[idx].fingerprint.load(std::memory_order_acquire);
+            if (f == fp) return &shard.entries[idx];
+            if (f == FP_EMPTY) return nullptr;
+            idx = (idx+1) & mask;
+        }
+        return nullptr;
+    }
+
+    // Returns nullptr if the shard is full.
+    Entry* findOrInsert(Shard& shard, uint64_t fp) {
+        const size_t mask = shard.capacity - 1;
+        size_t idx = fp & mask;
+        for (size_t i = 0; i < shard.capacity; i++) {
+            auto& entry = shard.entries[idx];
+            uint64_t f = entry.fingerprint.load(std::memory_order_acquire);
+            if (f == FP_EMPTY) {
+                if (shard.nbEntries.load(std::memory_order_relaxed) >= shard.maxNbEntries) return nullptr;
+                if (entry.fingerprint.compare_exchange_strong(f, fp, std::memory_order_acq_rel)) {
+                    shard.nbEntries.fetch_add(1, std::memory_order_relaxed);
+                    return &entry;
+                }
+                // Slot was claimed concurrently: f now holds its fingerprint
+            }
+            if (f == fp) return &entry;
+            idx = (idx+1) & mask;
+        }
+        return nullptr;
+    }
+
+    // Called by an inserting thread which holds access to the shard. Succeeds (and rebuilds
+    // the shard with a larger capacity) if no other thread is currently blocking the shard.
+    bool tryGrow(Shard& shard) {
+        bool expected = false;
+        if (!shard.blocked.compare_exchange_strong(expected, true, std::memory_order_seq_cst)) return false;
+        while (shard.nbAccessors.load(std::memory_order_seq_cst) > 1) std::this_thread::yield();
+        if (shard.nbEntries.load(std::memory_order_relaxed) >= shard.maxNbEntries)
+            rebuild(shard, _epoch.load(std::memory_order_relaxed), false);
+        unblock(shard);
+        return true;
+    }
+
+    // Requires exclusive access to the shard. Returns the number of removed entries.
+    size_t rebuild(Shard& shard, int epoch, bool dropExpired) {
+        std::unique_ptr<Entry[]> oldEntries = std::move(shard.entries);
+        const size_t oldCapacity = shard.capacity;
+
+        size_t nbKept = 0, nbRemoved = 0;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            auto& entry = oldEntries[i];
+            if (entry.fingerprint.load(std::memory_order_relaxed) == FP_EMPTY) continue;
+            ClauseInfo info = decode(entry.meta.load(std::memory_order_relaxed));
+            if (dropExpired && epoch - info.lastSharedEpoch > _epoch_horizon
+                    && epoch - info.lastProducedEpoch > _epoch_horizon) {
+                entry.fingerprint.store(FP_EMPTY, std::memory_order_relaxed);
+                nbRemoved++;
+            } else nbKept++;
+        }
+
+        // Target a load factor of at most 1/2 after the rebuild
+        size_t newCapacity = MIN_CAPACITY;
+        while (newCapacity < 2 * nbKept) newCapacity *= 2;
+        shard.resize(newCapacity);
+
+        const size_t mask = newCapacity - 1;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            auto& entry = oldEntries[i];
+            uint64_t fp = entry.fingerprint.load(std::memory_order_relaxed);
+            if (fp == FP_EMPTY) continue;
+            size_t idx = fp & mask;
+            while (shard.entries[idx].fingerprint.load(std::memory_order_relaxed) != FP_EMPTY)
+                idx = (idx+1) & mask;
+            shard.entries[idx].fingerprint.store(fp, std::memory_order_relaxed);
+            shard.entries[idx].meta.store(entry.meta.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        shard.nbEntries.store(nbKept, std::memory_order_relaxed);
+        return nbRemoved;
+    }
+
+    void updateClauseInfo(Entry& entry, const ProducedClauseCandidate& c, bool updateProducedEpoch) {
+        assert(c.producerId < MALLOB_MAX_N_APPTHREADS_PER_PROCESS);
+        uint64_t meta = entry.meta.load(std::memory_order_acquire);
+        ClauseInfo info;
+        do {
+            info = decode(meta);
+            // Update the epoch where it was last produced
+            if (updateProducedEpoch && c.epoch > info.lastProducedEpoch) info.lastProducedEpoch = c.epoch;
+            // Add producing solver as a producer
+            info.producers |= ((cls_producers_bitset) 1) << c.producerId;
+        } while (!entry.meta.compare_exchange_weak(meta, encode(info), std::memory_order_acq_rel));
+    }
+
+    // Meta data word: [0,16) last shared epoch XOR "never shared", [16,32) last produced epoch,
+    // [32,64) producers. With more than 32 producers per process, producer i is folded
+    // onto bit i%32 and therefore represents all producers j with j%32 = i%32
+    // (which may withhold a clause from a solver which did not produce it).
+    static uint64_t encode(const ClauseInfo& info) {
+        uint64_t producers = 0;
+        for (size_t i = 0; i < 8*sizeof(cls_producers_bitset); i += 32)
+            producers |= (uint32_t) (info.producers >> i);
+        return ((uint64_t) (info.lastSharedEpoch ^ MALLOB_EPOCH_NEVER_SHARED))
+            | (((uint64_t) info.lastProducedEpoch) << 16)
+            | (producers << 32);
+    }
+    static ClauseInfo decode(uint64_t meta) {
+        ClauseInfo info;
+        info.lastSharedEpoch = (meta & 0xffff) ^ MALLOB_EPOCH_NEVER_SHARED;
+        info.lastProducedEpoch = (meta >> 16) & 0xffff;
+        cls_producers_bitset producers = 0;
+        for (size_t i = 0; i < 8*sizeof(cls_producers_bitset); i += 32)
+            producers |= ((cls_producers_bitset) (meta >> 32)) << i;
+        info.producers = producers;
+        return info;
+    }
+};
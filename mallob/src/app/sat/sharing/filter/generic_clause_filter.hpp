@@ -8,11 +8,13 @@ class GenericClauseStore;
 class Logger;
 namespace Mallob { struct Clause; }
 struct ProducedClauseCandidate;
+struct SharingStatistics;
 
 #define MALLOB_CLAUSE_FILTER_NONE 0
 #define MALLOB_CLAUSE_FILTER_BLOOM 1
 #define MALLOB_CLAUSE_FILTER_EXACT 2
 #define MALLOB_CLAUSE_FILTER_EXACT_DISTRIBUTED 3
+#define MALLOB_CLAUSE_FILTER_FINGERPRINT_DISTRIBUTED 4
 
 class GenericClauseFilter {
 
@@ -31,6 +33,7 @@ public:
     virtual size_t size(int clauseLength = 0) const = 0;
 
     virtual bool collectGarbage(const Logger& logger) {return false;}
+    virtual void collectStatistics(SharingStatistics& stats) const {}
 
     void updateEpoch(int epoch) {
         _epoch.store(epoch, std::memory_order_relaxed);
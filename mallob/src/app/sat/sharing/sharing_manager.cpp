@@ -20,6 +20,7 @@
 #include "app/sat/sharing/filter/noop_clause_filter.hpp"
 #include "app/sat/sharing/filter/bloom_clause_filter.hpp"
 #include "app/sat/sharing/filter/exact_clause_filter.hpp"
+#include "app/sat/sharing/filter/fingerprint_clause_filter.hpp"
 #include "app/sat/sharing/simple_export_manager.hpp"
 #include "app/sat/sharing/backlog_export_manager.hpp"
 #include "app/sat/data/clause_metadata.hpp"
@@ -80,7 +81,9 @@ SharingManager::SharingManager(
 		case MALLOB_CLAUSE_FILTER_BLOOM:
 			return new BloomClauseFilter(*_clause_store, _solvers.size(),
 				_params.strictClauseLengthLimit()+ClauseMetadata::numInts(),
-				_params.backlogExportManager());
+				_params.backlogExportManager(), _params.clauseFilterClearInterval());
+		case MALLOB_CLAUSE_FILTER_FINGERPRINT_DISTRIBUTED:
+			return new FingerprintClauseFilter(*_clause_store, _params.clauseFilterClearInterval(), _params.strictClauseLengthLimit()+ClauseMetadata::numInts());
 		case MALLOB_CLAUSE_FILTER_EXACT:
 		case MALLOB_CLAUSE_FILTER_EXACT_DISTRIBUTED:
 		default:
@@ -557,6 +560,7 @@ SharingStatistics SharingManager::getStatistics() {
 		_observed_nonunit_lbd_of_two, 
 		_observed_nonunit_lbd_of_length_minus_one, 
 		_observed_nonunit_lbd_of_length);
+	_clause_filter->collectStatistics(_stats);
 	return _stats;
 }
 
@@ -47,13 +47,15 @@ struct BalancingEntry {
         // Copy base fields of this (dismissed) entry
         int tmpJobId = jobId;
         int tmpDemand = demand;
+        int tmpOriginalDemand = originalDemand;
         float tmpPriority = priority;
-        float tmpFairShare = fairShare;
+        double tmpFairShare = fairShare;
         int tmpVolume = volume;
 
         // Copy ALL fields of other (active) entry to this object
         jobId = other.jobId;
         demand = other.demand;
+        originalDemand = other.originalDemand;
         priority = other.priority;
         fairShare = other.fairShare;
         volume = other.volume;
@@ -63,6 +65,7 @@ struct BalancingEntry {
         // Copy base fields of dismissed entry to other object
         other.jobId = tmpJobId;
         other.demand = tmpDemand;
+        other.originalDemand = tmpOriginalDemand;
         other.priority = tmpPriority;
         other.fairShare = tmpFairShare;
         other.volume = tmpVolume;
@@ -8,7 +8,7 @@
 
 #include "event_driven_balancer.hpp"
 #include "app/job.hpp"
-#include "volume_calculator.hpp"
+#include "incremental_volume_calculator.hpp"
 #include "util/data_statistics.hpp"
 #include "app/job_tree.hpp"
 #include "balancing/balancing_entry.hpp"
@@ -21,7 +21,8 @@
 
 class Parameters;
 
-EventDrivenBalancer::EventDrivenBalancer(MPI_Comm& comm, Parameters& params) : _comm(comm), _params(params) {
+EventDrivenBalancer::EventDrivenBalancer(MPI_Comm& comm, Parameters& params) : _comm(comm), _params(params),
+        _volume_calculator(params, MyMpi::size(comm)) {
 
     int size = MyMpi::size(_comm);
     int myRank = MyMpi::rank(_comm);
@@ -221,6 +222,10 @@ void EventDrivenBalancer::digest(const EventMap& data) {
     LOG(V5_DEBG, "BLC DIGEST states_pre=%s\n", _states.toStr().c_str());
 
     _states.updateBy(data);
+    for (const auto& [jobId, ev] : data.getEntries()) {
+        auto it = _states.getEntries().find(jobId);
+        if (it != _states.getEntries().end()) _volume_calculator.update(it->second);
+    }
     _balancing_epoch = data.getGlobalEpoch();
 
     LOG(V5_DEBG, "BLC DIGEST states_post=%s\n", _states.toStr().c_str());
@@ -233,32 +238,45 @@ void EventDrivenBalancer::digest(const EventMap& data) {
 
     LOG(V5_DEBG, "BLC digest %i diffs, %i/%i local diffs remaining\n", 
             data.getEntries().size(), _diffs.getEntries().size(), diffSize);
-    _states.removeOldZeros();
+    for (int jobId : _states.removeOldZeros()) _volume_calculator.remove(jobId);
 }
 
 void EventDrivenBalancer::computeBalancingResult() {
 
     int rank = MyMpi::rank(_comm);
     //int verb = rank == 0 ? V4_VVER : V6_DEBGV;
-    _job_volumes.clear();
 
     if (_states.isEmpty()) return;
 
     if (rank == 0) LOG(V5_DEBG, "BLC: calc result\n");
 
-    VolumeCalculator calc(_states, _params, MyMpi::size(_comm), /*logging=*/rank == 0);
-    calc.calculateResult();
+    _volume_calculator.calculateResult(/*logging=*/rank == 0);
 
-    std::string msg = "";
-    for (const auto& entry : calc.getEntries()) {
-        if (rank == 0)
-            msg += std::to_string(entry.jobId) + ":" + std::to_string(entry.volume) + " ";
-        
-        _job_volumes[entry.jobId] = entry.volume;
+    if (rank == 0 && Logger::getMainInstance().getVerbosity() >= V5_DEBG) {
+        std::string msg = "";
+        _volume_calculator.forEachVolume([&](int jobId, int volume) {
+            msg += std::to_string(jobId) + ":" + std::to_string(volume) + " ";
+        });
+        LOG(V5_DEBG, "BLC RESULT %s\n", msg.c_str());
+    }
+
+    // Only local jobs are concerned by a balancing result
+    // (copied since a callback may modify the set of local jobs)
+    std::vector<int> localJobs(_local_jobs.begin(), _local_jobs.end());
+    for (int jobId : localJobs) {
+
+        // Job volume became zero?
+        if (!_volume_calculator.hasVolume(jobId)) {
+            if (_volume_calculator.getZeroEntries().count(jobId))
+                _volume_update_callback(jobId, 0, 0);
+            continue;
+        }
+
+        int volume = _volume_calculator.getVolume(jobId);
         float elapsed = 0;
 
         // My active job?
-        if (entry.jobId == _active_job_id) {
+        if (jobId == _active_job_id) {
             // Did I fire an event for this job which is not yet fulfilled?
             if (_pending_entries.count(_active_job_id)) {
                 auto it = _pending_entries.find(_active_job_id);
@@ -267,33 +285,25 @@ void EventDrivenBalancer::computeBalancingResult() {
                 if (epoch == _states.getEntries().at(_active_job_id).epoch) {
                     // -- Yes: Measure latency, remove pending event
                     elapsed = Timer::elapsedSeconds() - time;
-                    _balancing_latencies[entry.jobId].push_back(elapsed);
+                    _balancing_latencies[jobId].push_back(elapsed);
                     _pending_entries.erase(it);
                 }
             }
         }
         
-        // Trigger balancing callback?
-        if (_local_jobs.count(entry.jobId))
-            _volume_update_callback(entry.jobId, entry.volume, elapsed);
+        // Trigger balancing callback
+        _volume_update_callback(jobId, volume, elapsed);
     }
 
-    // also call callback for all jobs whose volume became zero
-    for (const auto& entry : calc.getZeroEntries()) {
-        if (_local_jobs.count(entry.jobId))
-            _volume_update_callback(entry.jobId, 0, 0);
-    }
-    
-    if (rank == 0) LOG(V5_DEBG, "BLC RESULT %s\n", msg.c_str());
     if (_balancing_done_callback) _balancing_done_callback();
 }
 
 bool EventDrivenBalancer::hasVolume(int jobId) const {
-    return _job_volumes.count(jobId);
+    return _volume_calculator.hasVolume(jobId);
 }
 
 int EventDrivenBalancer::getVolume(int jobId) const {
-    return _job_volumes.at(jobId);
+    return _volume_calculator.getVolume(jobId);
 }
 
 int EventDrivenBalancer::getRootRank() {
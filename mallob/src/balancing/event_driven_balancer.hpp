@@ -15,6 +15,7 @@
 #include "data/reduceable.hpp"
 #include "util/logger.hpp"
 #include "balancing/event_map.hpp"
+#include "balancing/incremental_volume_calculator.hpp"
 #include "util/periodic_event.hpp"
 #include "comm/mpi_base.hpp"
 #include "util/robin_hood.hpp"
@@ -60,7 +61,8 @@ private:
     int _active_job_id = -1;
     robin_hood::unordered_set<int> _local_jobs;
     robin_hood::unordered_map<int, int> _job_root_epochs;
-    robin_hood::unordered_map<int, int> _job_volumes;
+    // Job volumes as of the last balancing result, updated with each digested event
+    IncrementalVolumeCalculator _volume_calculator;
 
     robin_hood::unordered_map<int, std::vector<float>> _balancing_latencies;
     std::list<std::vector<float>> _past_balancing_latencies;
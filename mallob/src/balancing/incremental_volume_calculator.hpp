@@ -0,0 +1,390 @@
+
+#ifndef DOMPASCH_MALLOB_INCREMENTAL_VOLUME_CALCULATOR_HPP
+#define DOMPASCH_MALLOB_INCREMENTAL_VOLUME_CALCULATOR_HPP
+
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/params.hpp"
+#include "util/robin_hood.hpp"
+#include "balancing/event_map.hpp"
+#include "balancing/balancing_entry.hpp"
+
+/*
+Computes the same job volumes as the VolumeCalculator, but keeps its state across
+balancing rounds: each changed job is applied in O(log J) via update() / remove(),
+and no entries are rebuilt or sorted for a computation.
+All jobs with the same priority and demand behave identically during the search
+for the fair share multiplier, so the search is performed over these job classes
+(O(#classes) per probed multiplier) and replays each step of the VolumeCalculator,
+including the caching of volumes at the search bounds. Floating-point aggregates
+are maintained such that they are bitwise identical to those of the VolumeCalculator:
+the sum of priorities is updated incrementally only as long as this is provably
+exact and is re-summed in job ID order otherwise.
+*/
+class IncrementalVolumeCalculator {
+
+private:
+    struct JobClassKey {
+        float priority;
+        int demand; // original demand
+    };
+    struct JobClassKeyComparator {
+        // Same order as in VolumeCalculator: highest priority first, then highest demand first
+        bool operator()(const JobClassKey& first, const JobClassKey& second) const {
+            if (first.priority != second.priority) return first.priority > second.priority;
+            return first.demand > second.demand;
+        }
+    };
+    typedef std::pair<size_t, int> Member; // (hash of job ID, job ID)
+    struct JobClass {
+        // Members in the order used by VolumeCalculator to break ties
+        std::set<Member> members;
+        // Shared state of all members during a computation (capped demand, fair share, volumes)
+        BalancingEntry entry {0, 0, 0};
+        bool dismissed {false};
+        // The first nbIncremented members (up to lastIncremented) receive one extra worker
+        int nbIncremented {0};
+        Member lastIncremented;
+    };
+    struct JobState {
+        int demand;
+        float priority;
+    };
+
+    Parameters& _params;
+    int _num_workers;
+
+    robin_hood::unordered_map<int, JobState> _jobs;
+    std::map<JobClassKey, JobClass, JobClassKeyComparator> _classes;
+    // All classes in order (rebuilt after classes have been added or removed)
+    std::vector<JobClass*> _ordered_classes;
+    bool _classes_changed {false};
+    // Classes which have not been dismissed yet during the current search
+    std::vector<JobClass*> _active_classes;
+    std::set<int> _zero_jobs;
+    size_t _num_entries {0};
+
+    // Priorities of all jobs with non-zero demand, in job ID order
+    std::map<int, float> _priorities;
+    // Binary exponents of these priorities (to check whether their sum is exact)
+    std::map<int, int> _priority_exponents;
+    double _sum_of_priorities {0};
+    bool _sum_of_priorities_exact {true};
+
+    // Results of the last computation
+    int _available_volume {0};
+    bool _bailed_out {false};
+    bool _logging {false};
+
+    // Search state (see VolumeCalculator)
+    double _prev_lb;
+    double _prev_ub;
+    long long _base_utilization;
+    int _max_volume_diff_between_bounds;
+
+public:
+    IncrementalVolumeCalculator(Parameters& params, int numWorkers) :
+        _params(params), _num_workers(numWorkers) {}
+
+    // Apply the latest event of a job. An event with zero demand makes the job a zero entry.
+    void update(const Event& ev) {
+        assert(ev.demand >= 0);
+        auto it = _jobs.find(ev.jobId);
+        if (it != _jobs.end()) {
+            if (it->second.demand == ev.demand && it->second.priority == ev.priority) return;
+            remove(ev.jobId);
+        }
+        _jobs[ev.jobId] = JobState {ev.demand, ev.priority};
+        if (ev.demand == 0) {
+            _zero_jobs.insert(ev.jobId);
+            return;
+        }
+        assert((ev.priority > 0) || LOG_RETURN_FALSE("#%i has priority %.2f!\n", ev.jobId, ev.priority));
+        auto& members = _classes[JobClassKey {ev.priority, ev.demand}].members;
+        if (members.empty()) _classes_changed = true;
+        members.insert(getMember(ev.jobId));
+        _num_entries++;
+        _priorities[ev.jobId] = ev.priority;
+        _priority_exponents[getExponent(ev.priority)]++;
+        if (_sum_of_priorities_exact && isSumOfPrioritiesExact()) _sum_of_priorities += ev.priority;
+        else _sum_of_priorities_exact = false;
+    }
+
+    void remove(int jobId) {
+        auto it = _jobs.find(jobId);
+        if (it == _jobs.end()) return;
+        const auto [demand, priority] = it->second;
+        _jobs.erase(it);
+        if (demand == 0) {
+            _zero_jobs.erase(jobId);
+            return;
+        }
+        auto classIt = _classes.find(JobClassKey {priority, demand});
+        classIt->second.members.erase(getMember(jobId));
+        if (classIt->second.members.empty()) {
+            _classes.erase(classIt);
+            _classes_changed = true;
+        }
+        _num_entries--;
+        _priorities.erase(jobId);
+        auto expIt = _priority_exponents.find(getExponent(priority));
+        if (--expIt->second == 0) _priority_exponents.erase(expIt);
+        // Subtracting from an exact sum on the same grid of values is exact as well
+        if (_num_entries == 0) {
+            _sum_of_priorities = 0;
+            _sum_of_priorities_exact = true;
+        } else if (_sum_of_priorities_exact) _sum_of_priorities -= priority;
+    }
+
+    void calculateResult(bool logging) {
+
+        _logging = logging;
+        _available_volume = _num_workers * _params.loadFactor();
+
+        // Check if there are enough workers for the active jobs
+        if (_logging) LOG(V5_DEBG, "BLC #av=%i #j=%i\n", _available_volume, _num_entries);
+        _bailed_out = _available_volume <= _num_entries;
+        if (_bailed_out) {
+            // Every job keeps a volume of one
+            if (_logging) LOG(V5_DEBG, "BLC too many jobs, bailing out\n");
+            return;
+        }
+
+        if (_classes_changed) {
+            _ordered_classes.clear();
+            for (auto& [key, cls] : _classes) _ordered_classes.push_back(&cls);
+            _classes_changed = false;
+        }
+        for (auto& [key, cls] : _classes) {
+            cls.entry = BalancingEntry(0, key.demand, key.priority);
+            cls.dismissed = false;
+            cls.nbIncremented = 0;
+        }
+
+        if (!_sum_of_priorities_exact) {
+            // Sum up in the same order as VolumeCalculator
+            _sum_of_priorities = 0;
+            for (const auto& [jobId, priority] : _priorities) _sum_of_priorities += priority;
+            _sum_of_priorities_exact = isSumOfPrioritiesExact();
+        }
+
+        // Compute fair shares
+        const static double EPSILON = 1e-6;
+        double minMultiplier = INT32_MAX;
+        double maxMultiplier = 0;
+        unsigned long long sumOfDemands = 0;
+        for (auto cls : _ordered_classes) {
+            auto& job = cls->entry;
+            job.fairShare = job.priority / _sum_of_priorities * _available_volume;
+            job.demand = std::min(job.demand, (int) (_available_volume - _num_entries + 1)); // cap demand at max. reachable volume
+            assert(job.demand > 0);
+            minMultiplier = std::min(minMultiplier, job.getFairShareMultiplierLowerBound());
+            maxMultiplier = std::max(maxMultiplier, job.getFairShareMultiplierUpperBound());
+            sumOfDemands += cls->members.size() * (unsigned long long) job.demand;
+        }
+        maxMultiplier += EPSILON;
+
+        // Trivial case: every job receives its full demand
+        if (sumOfDemands <= _available_volume) {
+            for (auto cls : _ordered_classes) cls->entry.volume = cls->entry.demand;
+            return;
+        }
+
+        // Non-trivial case: some jobs do not receive their full demand.
+        // Do root search over possible multipliers for fair share
+        calculateFunctionOptimizationAssignments(minMultiplier, maxMultiplier);
+    }
+
+    // Volume of a job with non-zero demand as of the last computation.
+    bool hasVolume(int jobId) const {
+        auto it = _jobs.find(jobId);
+        return it != _jobs.end() && it->second.demand > 0;
+    }
+    int getVolume(int jobId) const {
+        const auto& state = _jobs.at(jobId);
+        return getVolume(_classes.at(JobClassKey {state.priority, state.demand}), getMember(jobId));
+    }
+    void forEachVolume(std::function<void(int, int)> callback) const {
+        for (const auto& [key, cls] : _classes) for (const auto& member : cls.members)
+            callback(member.second, getVolume(cls, member));
+    }
+
+    const std::set<int>& getZeroEntries() const {
+        return _zero_jobs;
+    }
+    size_t getNbEntries() const {
+        return _num_entries;
+    }
+    size_t getNbJobClasses() const {
+        return _classes.size();
+    }
+
+private:
+    static Member getMember(int jobId) {
+        return Member(robin_hood::hash_int(jobId), jobId);
+    }
+    static int getExponent(float priority) {
+        int exp;
+        std::frexp(priority, &exp);
+        return exp;
+    }
+
+    // All priorities are multiples of 2^(minExp-24) and below 2^maxExp. If their sum
+    // fits into a double's mantissa on this grid, every partial sum is exact,
+    // regardless of the order of summation.
+    bool isSumOfPrioritiesExact() const {
+        if (_priority_exponents.empty()) return true;
+        int minExp = _priority_exponents.begin()->first;
+        int maxExp = _priority_exponents.rbegin()->first;
+        int log2NumEntries = 0;
+        while ((1ULL << log2NumEntries) < _num_entries) log2NumEntries++;
+        return maxExp - minExp + 24 + log2NumEntries <= 53;
+    }
+
+    int getVolume(const JobClass& cls, const Member& member) const {
+        if (_bailed_out) return 1;
+        int volume = cls.entry.volume;
+        if (cls.nbIncremented > 0 && member <= cls.lastIncremented) volume++;
+        return volume;
+    }
+
+    double getCenterOfMassOfMultiplier() const {
+        // Summed up job by job in the same order as in VolumeCalculator
+        double centerOfMass = 0;
+        for (auto cls : _ordered_classes) {
+            const auto& job = cls->entry;
+            const double summand = (job.getFairShareMultiplierLowerBound() + job.getFairShareMultiplierUpperBound())/2;
+            for (size_t i = 0; i < cls->members.size(); i++) centerOfMass += summand;
+        }
+        return centerOfMass / _num_entries;
+    }
+
+    void calculateFunctionOptimizationAssignments(double minMultiplier, double maxMultiplier) {
+
+        _prev_lb = -1;
+        _prev_ub = -1;
+        _base_utilization = 0;
+        _max_volume_diff_between_bounds = 0;
+
+        double lower = minMultiplier;
+        double upper = maxMultiplier;
+        double mid = 1;
+        double best;
+        if (_logging) LOG(V5_DEBG, "BLC Finding opt. multiplier, starting range [%.4f, %.4f]\n", lower, upper);
+
+        long long bestExcess = -1;
+        long long excessAtLeft = _available_volume - _num_entries;
+        int numIterations = 0;
+        while (true) {
+
+            numIterations++;
+            long long excess = calculateExcessVolumeOrNegative(mid, lower, upper);
+
+            if (bestExcess == -1 || std::abs(excess) < std::abs(bestExcess)) {
+                best = mid;
+                bestExcess = excess;
+                if (bestExcess == 0) break;
+            }
+
+            // Base case: each remaining job's volume differs by at most one in between the bounds.
+            // At the lower bound, assign one additional worker to each job f.l.t.r.
+            if (_max_volume_diff_between_bounds <= 1) {
+
+                best = lower;
+                excess = excessAtLeft;
+                long long stillAvailable = excess;
+                assert(stillAvailable > 0);
+                if (_logging) LOG(V4_VVER, "BLC FINALIZE %.6f it=%i excess=%i\n", best, numIterations, (int) excess);
+
+                for (auto cls : _ordered_classes) {
+                    if (cls->dismissed) continue;
+                    cls->entry.volume = cls->entry.volumeLower;
+                    if (stillAvailable == 0) continue;
+                    cls->nbIncremented = std::min((long long) cls->members.size(), stillAvailable);
+                    stillAvailable -= cls->nbIncremented;
+                    cls->lastIncremented = *std::next(cls->members.begin(), cls->nbIncremented-1);
+                }
+                assert(stillAvailable == 0);
+                bestExcess = 0;
+                break;
+            }
+
+            if (excess > 0) {
+                lower = mid;
+                excessAtLeft = excess;
+            }
+            if (excess < 0) {
+                upper = mid;
+            }
+
+            // The center of mass is only needed (and computed) after the first iteration
+            const double centerOfMass = mid == 1 && excess != 0 ? getCenterOfMassOfMultiplier() : 0;
+            if (mid == 1 && excess > 0 && centerOfMass > mid) {
+                mid = centerOfMass;
+            } else if (mid == 1 && excess < 0 && centerOfMass < mid) {
+                mid = centerOfMass;
+            } else {
+                mid = (lower+upper)/2;
+            }
+        }
+
+        if (_logging) LOG(V4_VVER, "BLC FINALIZED alpha=%.6f excess=%i\n", best, (int) bestExcess);
+    }
+
+    long long calculateExcessVolumeOrNegative(double fairShareMultiplier, double left, double right) {
+
+        if (_prev_lb == -1) {
+            _active_classes = _ordered_classes;
+            for (auto cls : _active_classes) {
+                cls->entry.volumeLower = cls->entry.getVolume(left);
+                cls->entry.volumeUpper = cls->entry.getVolume(right);
+            }
+        }
+
+        // Re-use cached volumes at the bounds just like VolumeCalculator does
+        bool leftHalf = left == _prev_lb;
+        bool rightHalf = right == _prev_ub;
+
+        long long utilization = _base_utilization;
+        _max_volume_diff_between_bounds = 0;
+        size_t numRemainingJobs = 0;
+
+        for (size_t i = 0; i < _active_classes.size(); i++) {
+            auto cls = _active_classes[i];
+            auto& job = cls->entry;
+            if (leftHalf) job.volumeUpper = job.volume;
+            if (rightHalf) job.volumeLower = job.volume;
+
+            if (job.volumeLower == job.volumeUpper) {
+                // Same volume in the entire range to search: dismiss class
+                job.volume = job.volumeLower;
+                utilization += cls->members.size() * (long long) job.volumeLower;
+                _base_utilization += cls->members.size() * (long long) job.volumeLower;
+                cls->dismissed = true;
+                _active_classes[i--] = _active_classes.back();
+                _active_classes.pop_back();
+            } else {
+                job.volume = job.getVolume(fairShareMultiplier);
+                utilization += cls->members.size() * (long long) job.volume;
+                _max_volume_diff_between_bounds = std::max(_max_volume_diff_between_bounds, job.volumeUpper - job.volumeLower);
+                numRemainingJobs += cls->members.size();
+            }
+        }
+
+        if (_logging) LOG(V5_DEBG, "BLC util @ multiplier %.6f : %lld (%lu jobs left)\n", fairShareMultiplier,
+            utilization, numRemainingJobs);
+        _prev_lb = left;
+        _prev_ub = right;
+
+        return _available_volume - utilization;
+    }
+};
+
+#endif
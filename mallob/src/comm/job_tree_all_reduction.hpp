@@ -50,6 +50,10 @@ private:
     bool _has_transformation_at_root = false;
     std::function<AllReduceElement(const AllReduceElement&)> _transformation_at_root;
 
+    bool _has_wire_codec = false;
+    std::function<AllReduceElement(const AllReduceElement&)> _wire_encoder;
+    std::function<AllReduceElement(const AllReduceElement&)> _wire_decoder;
+
     bool _has_producer = false;
     bool _reduction_locally_done = false;
     bool _finished = false;
@@ -111,6 +115,18 @@ public:
         _has_transformation_at_root = true;
     }
 
+    // Set an encoding which is applied to each element before it is sent to another
+    // process and a corresponding decoding which is applied to each received element.
+    // The aggregator, the transformation at the root, and the final result only
+    // ever see decoded elements. All processes of the all-reduction must agree
+    // on whether a codec is used.
+    void setWireCodec(std::function<AllReduceElement(const AllReduceElement&)> encoder,
+            std::function<AllReduceElement(const AllReduceElement&)> decoder) {
+        _wire_encoder = encoder;
+        _wire_decoder = decoder;
+        _has_wire_codec = true;
+    }
+
     void enableBroadcast() {
         _broadcastEnabled = true;
     }
@@ -148,7 +164,7 @@ public:
             advance();
         }
         if (tag == MSG_JOB_TREE_BROADCAST && _broadcastEnabled) {
-            receiveAndForwardFinalElem(std::move(msg.payload));
+            receiveAndForwardFinalElem(std::move(msg.payload), _has_wire_codec);
         }
         return true;
     }
@@ -168,8 +184,15 @@ public:
             _aggregating = true;
             _future_aggregate = ProcessWideThreadPool::get().addTask([&]() {
                 std::list<AllReduceElement> elemsList;
-                for (auto& childElem : _child_elems) elemsList.push_back(std::move(childElem.elem));
+                for (auto& childElem : _child_elems) {
+                    // Elements from children (source >= 0) arrived in wire format
+                    if (_has_wire_codec && childElem.source >= 0)
+                        elemsList.push_back(_wire_decoder(childElem.elem));
+                    else elemsList.push_back(std::move(childElem.elem));
+                }
                 _aggregated_elem = _aggregator(elemsList);
+                if (_has_wire_codec && !_is_root)
+                    _aggregated_elem.emplace(_wire_encoder(_aggregated_elem.value()));
                 _aggregating = false;
             });
         }
@@ -210,7 +233,7 @@ public:
 
         if (!_reduction_locally_done) {
             // Aggregation upwards was not performed yet: Send neutral element upwards
-            _base_msg.payload = _neutral_elem;
+            _base_msg.payload = _has_wire_codec ? _wire_encoder(_neutral_elem) : _neutral_elem;
             _base_msg.treeIndexOfDestination = _parent_index;
             _base_msg.contextIdOfDestination = _parent_ctx_id;
             MyMpi::isend(_parent_rank, MSG_JOB_TREE_REDUCTION, _base_msg);
@@ -255,8 +278,21 @@ private:
         _base_msg.payload = std::move(elem);
     }
 
-    void receiveAndForwardFinalElem(AllReduceElement&& elem) {
-        receiveFinalElem(std::move(elem));
+    void receiveAndForwardFinalElem(AllReduceElement&& elem, bool wireEncoded = false) {
+        AllReduceElement decoded;
+        bool hasChildren = _expected_child_ranks.first >= 0 || _expected_child_ranks.second >= 0;
+        if (_has_wire_codec && (wireEncoded || hasChildren)) {
+            // Forward the element in wire format, keep the decoded element as the result
+            if (wireEncoded) {
+                decoded = _wire_decoder(elem);
+            } else {
+                decoded = std::move(elem);
+                elem = _wire_encoder(decoded);
+            }
+            _base_msg.payload = std::move(elem);
+        } else {
+            receiveFinalElem(std::move(elem));
+        }
         if (_expected_child_ranks.first >= 0) {
             _base_msg.treeIndexOfDestination = _expected_child_indices.first;
             _base_msg.contextIdOfDestination = _expected_child_ctx_ids.first;
@@ -267,5 +303,7 @@ private:
             _base_msg.contextIdOfDestination = _expected_child_ctx_ids.second;
             MyMpi::isend(_expected_child_ranks.second, MSG_JOB_TREE_BROADCAST, _base_msg);
         }
+        // (the payload has been serialized by now and can be replaced)
+        if (_has_wire_codec && (wireEncoded || hasChildren)) receiveFinalElem(std::move(decoded));
     }
 };
@@ -0,0 +1,337 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <vector>
+
+#include "comm/job_tree_snapshot.hpp"
+#include "comm/msgtags.h"
+#include "comm/mympi.hpp"
+#include "data/job_transfer.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+
+// All-reduction of a vector of floats along the job tree, similar to JobTreeAllReduction.
+// The element is split into segments of a fixed number of floats, and each segment is
+// reduced and broadcast independently: a process sends a segment to its parent as soon as
+// its local element and this segment of each child are present, and forwards each
+// broadcast segment to its children as soon as it arrives. For large elements, the
+// transfers at the different levels of the tree thus overlap instead of adding up.
+// The aggregator is applied to pairs of segments, in the order (local, left, right),
+// which renders the aggregation deterministic.
+// Floats are copied into the message payload as they are, behind a small header of ints.
+// All processes must use the same element size and segment size.
+class JobTreePipelinedAllReduction {
+
+public:
+    typedef std::vector<float> AllReduceElement;
+    // Aggregates the segment "other" into the segment "acc" of the same size.
+    // "offset" is the position of the segments' first float within the element.
+    typedef std::function<void(float* acc, const float* other, size_t offset, size_t size)> SegmentAggregator;
+    typedef std::function<void(int rank, int mpiTag, JobMessage& msg)> MessageSender;
+
+private:
+    static constexpr size_t REDUCTION_HEADER_SIZE = 1; // segment index
+    static constexpr size_t BROADCAST_HEADER_SIZE = 3; // segment index, #segments, element size
+
+    JobMessage _base_msg;
+    AllReduceElement _neutral_elem;
+    const size_t _segment_size;
+    const int _nb_segments;
+    SegmentAggregator _aggregator;
+    MessageSender _sender;
+
+    std::optional<AllReduceElement> _local_elem;
+
+    struct Child {
+        int rank;
+        int index;
+        ctx_id_t ctxId;
+        bool contributed {false};
+        std::vector<AllReduceElement> segments;
+        std::vector<bool> received;
+    };
+    Child _children[2];
+
+    bool _is_root;
+    int _parent_rank;
+    int _parent_index;
+    ctx_id_t _parent_ctx_id;
+
+    std::vector<bool> _segment_reduced;
+    int _nb_reduced_segments {0};
+
+    bool _has_transformation_at_root = false;
+    std::function<AllReduceElement(const AllReduceElement&)> _transformation_at_root;
+
+    AllReduceElement _result;
+    int _nb_broadcast_segments {-1};
+    int _nb_received_broadcast_segments {0};
+
+    float _time_first_contribution {-1};
+    float _time_locally_reduced {-1};
+
+    bool _has_producer = false;
+    bool _finished = false;
+    bool _valid = true;
+    bool _broadcast_enabled = true;
+
+public:
+    JobTreePipelinedAllReduction(const JobTreeSnapshot& tree, JobMessage baseMsg, AllReduceElement&& neutralElem,
+            size_t segmentSize, SegmentAggregator aggregator) :
+        _base_msg(baseMsg), _neutral_elem(std::move(neutralElem)), _segment_size(std::max((size_t) 1, segmentSize)),
+        _nb_segments(std::max((size_t) 1, (_neutral_elem.size() + _segment_size - 1) / _segment_size)),
+        _aggregator(aggregator), _segment_reduced(_nb_segments, false) {
+
+        _sender = [](int rank, int mpiTag, JobMessage& msg) {MyMpi::isend(rank, mpiTag, msg);};
+
+        _children[0].rank = tree.leftChildNodeRank;
+        _children[0].index = tree.leftChildNodeRank<0 ? -1 : tree.leftChildIndex;
+        _children[0].ctxId = tree.leftChildNodeRank<0 ? 0 : tree.leftChildContextId;
+        _children[1].rank = tree.rightChildNodeRank;
+        _children[1].index = tree.rightChildNodeRank<0 ? -1 : tree.rightChildIndex;
+        _children[1].ctxId = tree.rightChildNodeRank<0 ? 0 : tree.rightChildContextId;
+        for (auto& child : _children) {
+            child.segments.resize(_nb_segments);
+            child.received.assign(_nb_segments, false);
+        }
+
+        _parent_rank = tree.parentNodeRank;
+        _parent_index = tree.parentIndex;
+        _parent_ctx_id = tree.parentContextId;
+
+        _is_root = tree.index == 0;
+        _base_msg.treeIndexOfSender = tree.index;
+        _base_msg.contextIdOfSender = tree.contextId;
+    }
+
+    // Do not wait for the given child, which must not have contributed anything yet.
+    void pruneChild(int rank) {
+        assert(rank >= 0);
+        for (auto& child : _children) {
+            if (child.rank == rank && !child.contributed) child.rank = -1;
+        }
+        reduceReadySegments();
+    }
+    // Same as pruneChild, but the child is identified by its index in the job tree.
+    void pruneChildByIndex(int index) {
+        assert(index >= 0);
+        for (auto& child : _children) {
+            if (child.rank >= 0 && child.index == index && !child.contributed) child.rank = -1;
+        }
+        reduceReadySegments();
+    }
+
+    // Set the function to compute the local contribution for the all-reduction.
+    // This function is invoked immediately, and all segments which are ready are forwarded.
+    void produce(std::function<AllReduceElement()> localProducer) {
+        assert(!_has_producer);
+        _has_producer = true;
+        _local_elem = localProducer();
+        assert(_local_elem->size() == _neutral_elem.size()
+            || log_return_false("[ERROR] all-reduction element of size %lu instead of %lu\n",
+            _local_elem->size(), _neutral_elem.size()));
+        if (_time_first_contribution < 0) _time_first_contribution = Timer::elapsedSeconds();
+        reduceReadySegments();
+    }
+
+    void setTransformationOfElementAtRoot(std::function<AllReduceElement(const AllReduceElement&)> transformation) {
+        _transformation_at_root = transformation;
+        _has_transformation_at_root = true;
+    }
+
+    // Replace the sending of messages via MyMpi, e.g., to connect several instances within a test.
+    void setMessageSender(MessageSender sender) {
+        _sender = sender;
+    }
+
+    void enableBroadcast() {
+        _broadcast_enabled = true;
+    }
+
+    void disableBroadcast() {
+        _broadcast_enabled = false;
+    }
+
+    // Process an incoming message and advance the all-reduction accordingly.
+    bool receive(int source, int tag, JobMessage& msg) {
+
+        assert(tag == MSG_JOB_TREE_REDUCTION || tag == MSG_JOB_TREE_BROADCAST);
+
+        bool accept = msg.epoch == _base_msg.epoch && msg.tag == _base_msg.tag;
+        if (!accept || _finished) return false;
+
+        if (tag == MSG_JOB_TREE_REDUCTION) {
+            Child* child = nullptr;
+            for (auto& c : _children) if (c.rank >= 0 && c.rank == source) child = &c;
+            if (!child || msg.payload.size() < REDUCTION_HEADER_SIZE) return false;
+
+            const int segmentIdx = msg.payload[0];
+            if (segmentIdx < 0 || segmentIdx >= _nb_segments || child->received[segmentIdx]
+                || _segment_reduced[segmentIdx]) return false;
+            const size_t size = getSegmentSize(segmentIdx, _neutral_elem.size());
+            if (msg.payload.size() != REDUCTION_HEADER_SIZE + size) return false;
+
+            child->segments[segmentIdx].resize(size);
+            readFloats(msg.payload, REDUCTION_HEADER_SIZE, child->segments[segmentIdx].data(), size);
+            child->received[segmentIdx] = true;
+            child->contributed = true;
+            if (_time_first_contribution < 0) _time_first_contribution = Timer::elapsedSeconds();
+            LOG_ADD_SRC(V6_DEBGV, "PAR got segment %i/%i", source, segmentIdx, _nb_segments);
+            reduceSegmentIfReady(segmentIdx);
+        }
+        if (tag == MSG_JOB_TREE_BROADCAST) {
+            if (!_broadcast_enabled || msg.payload.size() < BROADCAST_HEADER_SIZE) return false;
+            receiveAndForwardBroadcastSegment(msg);
+        }
+        return true;
+    }
+
+    void cancel() {
+
+        if (_finished) return;
+
+        if (!_is_root) {
+            // Send neutral elements upwards for all segments which were not reduced yet
+            for (int s = 0; s < _nb_segments; s++) {
+                if (_segment_reduced[s]) continue;
+                sendSegmentToParent(s, _neutral_elem.data() + s * _segment_size);
+            }
+        }
+        // finished but not valid
+        _finished = true;
+        _valid = false;
+    }
+
+    bool hasProducer() const {return _has_producer;}
+    bool isValid() const {return _valid;}
+    int getNbSegments() const {return _nb_segments;}
+
+    // Whether the final result to the all-reduction is present.
+    bool hasResult() const {return _finished && _valid;}
+
+    // Extract the final result to the all-reduction. hasResult() must be true.
+    // After this call, hasResult() returns false.
+    AllReduceElement extractResult() {
+        assert(hasResult());
+        _valid = false;
+        return std::move(_result);
+    }
+
+    // Points in time (Timer::elapsedSeconds) at which the first contribution (local or
+    // from a child) arrived and at which all segments were reduced locally (-1 if not yet).
+    float getTimeOfFirstContribution() const {return _time_first_contribution;}
+    float getTimeOfLocalReduction() const {return _time_locally_reduced;}
+
+    // Write the given header and then the given floats to a message payload.
+    static void writeFloats(std::vector<int>& payload, std::initializer_list<int> header, const float* data, size_t size) {
+        static_assert(sizeof(float) == sizeof(int));
+        payload.resize(header.size() + size);
+        std::copy(header.begin(), header.end(), payload.begin());
+        if (size > 0) memcpy(payload.data() + header.size(), data, size * sizeof(float));
+    }
+    // Read the floats which follow a header of the given size in a message payload.
+    static void readFloats(const std::vector<int>& payload, size_t headerSize, float* out, size_t size) {
+        assert(payload.size() >= headerSize + size);
+        if (size > 0) memcpy(out, payload.data() + headerSize, size * sizeof(float));
+    }
+
+private:
+    size_t getSegmentSize(int segmentIdx, size_t elemSize) const {
+        const size_t begin = segmentIdx * _segment_size;
+        return std::min(elemSize, begin + _segment_size) - std::min(elemSize, begin);
+    }
+
+    void reduceReadySegments() {
+        for (int s = 0; s < _nb_segments; s++) reduceSegmentIfReady(s);
+    }
+
+    void reduceSegmentIfReady(int segmentIdx) {
+        if (_finished || !_local_elem.has_value() || _segment_reduced[segmentIdx]) return;
+        for (auto& child : _children) {
+            if (child.rank >= 0 && !child.received[segmentIdx]) return;
+        }
+
+        const size_t offset = segmentIdx * _segment_size;
+        const size_t size = getSegmentSize(segmentIdx, _neutral_elem.size());
+        float* acc = _local_elem->data() + offset;
+        for (auto& child : _children) {
+            if (!child.received[segmentIdx]) continue;
+            _aggregator(acc, child.segments[segmentIdx].data(), offset, size);
+            AllReduceElement().swap(child.segments[segmentIdx]);
+        }
+        _segment_reduced[segmentIdx] = true;
+        _nb_reduced_segments++;
+
+        if (!_is_root) sendSegmentToParent(segmentIdx, acc);
+        if (_nb_reduced_segments < _nb_segments) return;
+
+        _time_locally_reduced = Timer::elapsedSeconds();
+        if (!_is_root) {
+            // Wait for the broadcast (if any)
+            if (!_broadcast_enabled) finish(AllReduceElement());
+            return;
+        }
+        AllReduceElement elem = std::move(_local_elem.value());
+        _local_elem.reset();
+        if (_has_transformation_at_root) elem = _transformation_at_root(elem);
+        if (_broadcast_enabled) broadcast(elem);
+        finish(std::move(elem));
+    }
+
+    void sendSegmentToParent(int segmentIdx, const float* data) {
+        writeFloats(_base_msg.payload, {segmentIdx}, data, getSegmentSize(segmentIdx, _neutral_elem.size()));
+        _base_msg.treeIndexOfDestination = _parent_index;
+        _base_msg.contextIdOfDestination = _parent_ctx_id;
+        _sender(_parent_rank, MSG_JOB_TREE_REDUCTION, _base_msg);
+    }
+
+    void broadcast(const AllReduceElement& elem) {
+        const int nbSegments = std::max((size_t) 1, (elem.size() + _segment_size - 1) / _segment_size);
+        for (int s = 0; s < nbSegments; s++) {
+            writeFloats(_base_msg.payload, {s, nbSegments, (int) elem.size()},
+                elem.data() + s * _segment_size, getSegmentSize(s, elem.size()));
+            forwardToChildren(_base_msg);
+        }
+    }
+
+    void receiveAndForwardBroadcastSegment(JobMessage& msg) {
+        const int segmentIdx = msg.payload[0];
+        const int nbSegments = msg.payload[1];
+        const size_t elemSize = msg.payload[2];
+        const size_t size = getSegmentSize(segmentIdx, elemSize);
+        if (segmentIdx < 0 || segmentIdx >= nbSegments || msg.payload.size() != BROADCAST_HEADER_SIZE + size) return;
+
+        // Forward right away, before copying the segment
+        forwardToChildren(msg);
+
+        if (_nb_broadcast_segments < 0) {
+            _nb_broadcast_segments = nbSegments;
+            _result.resize(elemSize);
+        }
+        readFloats(msg.payload, BROADCAST_HEADER_SIZE, _result.data() + segmentIdx * _segment_size, size);
+        _nb_received_broadcast_segments++;
+        if (_nb_received_broadcast_segments == _nb_broadcast_segments) _finished = true;
+    }
+
+    void forwardToChildren(JobMessage& msg) {
+        for (auto& child : _children) {
+            if (child.rank < 0) continue;
+            msg.treeIndexOfSender = _base_msg.treeIndexOfSender;
+            msg.contextIdOfSender = _base_msg.contextIdOfSender;
+            msg.treeIndexOfDestination = child.index;
+            msg.contextIdOfDestination = child.ctxId;
+            _sender(child.rank, MSG_JOB_TREE_BROADCAST, msg);
+        }
+    }
+
+    void finish(AllReduceElement&& result) {
+        _result = std::move(result);
+        _finished = true;
+    }
+};
@@ -0,0 +1,51 @@
+
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+
+/*
+A number of small messages to the same destination which are sent together
+as a single MPI message with tag MSG_COALESCED_ENVELOPE.
+Each message is written as [tag (int)][size (int)][data] without padding.
+*/
+struct CoalescingEnvelope {
+
+    std::vector<uint8_t> data;
+    int numMessages = 0;
+    float timeOfFirstMessage = 0;
+    double sumOfEnqueueTimes = 0;
+
+    void append(int tag, const std::vector<uint8_t>& msg, float time) {
+        if (numMessages == 0) timeOfFirstMessage = time;
+        size_t offset = data.size();
+        int size = msg.size();
+        data.resize(offset + 2*sizeof(int) + size);
+        memcpy(data.data()+offset, &tag, sizeof(int));
+        memcpy(data.data()+offset+sizeof(int), &size, sizeof(int));
+        if (size > 0) memcpy(data.data()+offset+2*sizeof(int), msg.data(), size);
+        numMessages++;
+        sumOfEnqueueTimes += time;
+    }
+
+    // Calls callback(tag, data, size) for each message in the received envelope, in order.
+    template <typename Callback>
+    static void unpack(const uint8_t* data, size_t size, Callback callback) {
+        size_t offset = 0;
+        while (offset < size) {
+            assert(offset + 2*sizeof(int) <= size);
+            int tag, msgSize;
+            memcpy(&tag, data+offset, sizeof(int));
+            memcpy(&msgSize, data+offset+sizeof(int), sizeof(int));
+            offset += 2*sizeof(int);
+            assert(msgSize >= 0 && offset + msgSize <= size
+                || LOG_RETURN_FALSE("[ERROR] malformed envelope: message of size %i at %lu/%lu\n", msgSize, offset, size));
+            callback(tag, data+offset, (size_t) msgSize);
+            offset += msgSize;
+        }
+    }
+};
@@ -14,8 +14,8 @@ private:
     std::vector<uint8_t> data;
 
 public:
-    int tag;
-    int source;
+    int tag {0};
+    int source {-1};
 
     MessageHandle() = default;
     MessageHandle(const MessageHandle& copied) {
@@ -19,6 +19,7 @@
 #include "util/sys/atomics.hpp"                 // for incrementRelaxed, dec...
 #include "util/sys/background_worker.hpp"       // for BackgroundWorker
 #include "util/sys/proc.hpp"                    // for Proc
+#include "util/sys/timer.hpp"                   // for Timer
 
 
 MessageQueue::MessageQueue(int maxMsgSize) : _max_msg_size(maxMsgSize) {
@@ -45,14 +46,24 @@ MessageQueue::MessageQueue(int maxMsgSize) : _max_msg_size(maxMsgSize) {
 
 void MessageQueue::close() {
 
+    // Send remaining coalesced messages
+    flushEnvelopes(true);
+    if (_coalescing_max_msg_size > 0) logCoalescingStats();
     // Cancel batched send messages
-    for (auto& h : _send_queue) h.cancel();
+    if (_progress_thread_enabled) {
+        SendCommand cmd;
+        cmd.type = SendCommand::CANCEL_ALL;
+        _send_commands.push(std::move(cmd));
+    } else for (auto& h : _send_queue) h.cancel();
     // Advance until all outgoing messages have been processed
     while (hasOpenSends()) advance();
     // Make sure that all sent handles are also processed at the receiver side
     for (int i = 0; i < 1 + (MyMpi::size(MPI_COMM_WORLD) * _max_concurrent_sends) / _base_num_receives_per_loop; i++)
         advance();
 
+    // The receive request and all send handles belong to this thread again
+    _progress_thread.stop();
+
     // Notify background threads to stop and wake them up
     _batch_assembler.stopWithoutWaiting();
     {
@@ -101,15 +112,68 @@ void MessageQueue::registerSentCallback(int tag, const SendDoneCallback& cb) {
     _send_done_callbacks[tag] = cb;
 }
 
+void MessageQueue::registerRelayCallback(int tag, const RelayCallback& cb) {
+    auto lock = _relay_mutex.getLock();
+    if (_relay_callbacks.count(tag)) {
+        LOG(V0_CRIT, "More than one relay callback for tag %i!\n", tag);
+        abort();
+    }
+    _relay_callbacks[tag] = cb;
+    _num_relay_callbacks.store(_relay_callbacks.size(), std::memory_order_relaxed);
+}
+
+void MessageQueue::clearRelayCallback(int tag) {
+    auto lock = _relay_mutex.getLock();
+    _relay_callbacks.erase(tag);
+    _num_relay_callbacks.store(_relay_callbacks.size(), std::memory_order_relaxed);
+}
+
 void MessageQueue::clearCallbacks() {
     _callbacks.clear();
     _send_done_callbacks.clear();
+    auto lock = _relay_mutex.getLock();
+    _relay_callbacks.clear();
+    _num_relay_callbacks.store(0, std::memory_order_relaxed);
 }
 
 void MessageQueue::clearCallback(int tag, const CallbackRef& ref) {
     _callbacks[tag].erase(ref);
 }
 
+void MessageQueue::startProgressThread(int idleSleepMicros) {
+    if (_progress_thread_enabled) return;
+    assert(_send_queue.empty() || log_return_false("[ERROR] progress thread started with %lu open sends\n", _send_queue.size()));
+    _progress_idle_sleep_micros = idleSleepMicros;
+    _num_open_recv_fragments.store(_fragmented_messages.size(), std::memory_order_relaxed);
+    _progress_thread_enabled = true;
+    _progress_thread.run([&]() {
+        Proc::nameThisThread("MsgProgress");
+        runProgressThread();
+    });
+}
+
+MessageQueue::HandoffStats MessageQueue::extractHandoffStats() {
+    HandoffStats stats;
+    stats.numMessages = _handoff_window_count.exchange(0, std::memory_order_relaxed);
+    unsigned long sumMicros = _handoff_window_sum_micros.exchange(0, std::memory_order_relaxed);
+    unsigned long maxMicros = _handoff_window_max_micros.exchange(0, std::memory_order_relaxed);
+    stats.avgLatency = stats.numMessages == 0 ? 0 : 0.000001 * sumMicros / stats.numMessages;
+    stats.maxLatency = 0.000001 * maxMicros;
+    // Read the handled messages first such that they never exceed the arrived ones
+    unsigned long handled = _handoff_num_handled.load(std::memory_order_acquire);
+    unsigned long arrived = _handoff_num_arrived.load(std::memory_order_acquire);
+    stats.numPending = arrived > handled ? arrived - handled : 0;
+    return stats;
+}
+
+void MessageQueue::setCoalescing(size_t maxMsgSize, size_t maxEnvelopeSize, float windowSeconds) {
+    _coalescing_max_msg_size = maxMsgSize;
+    // An envelope must not be split into fragments
+    _coalescing_max_envelope_size = std::min(maxEnvelopeSize, _max_msg_size);
+    _coalescing_window = windowSeconds;
+    if (_coalescing_max_msg_size == 0) flushEnvelopes(true);
+}
+
 int MessageQueue::send(const DataPtr& data, int dest, int tag) {
 
     *_current_send_tag = tag;
@@ -123,20 +187,99 @@ int MessageQueue::send(const DataPtr& data, int dest, int tag) {
         return h.id;
     }
 
-    _send_queue.emplace_back(_running_send_id++, dest, tag, data, _max_msg_size);
+    int id = _running_send_id++;
+    if (_coalescing_max_msg_size > 0) {
+        if (data->size() <= _coalescing_max_msg_size
+                && data->size() + 2*sizeof(int) <= _coalescing_max_envelope_size
+                && !_send_done_callbacks.count(tag)) {
+            // Append message to the envelope for this destination
+            LOG(V5_DEBG, "MQ COALESCE n=%lu d=[%i] t=%i\n", data->size(), dest, tag);
+            auto& envelope = _envelopes[dest];
+            envelope.append(tag, *data, Timer::elapsedSeconds());
+            if (envelope.data.size() >= _coalescing_max_envelope_size) flushEnvelope(dest);
+            *_current_send_tag = 0;
+            return id;
+        }
+        // Messages to this destination must not overtake the coalesced ones
+        if (_envelopes.count(dest)) flushEnvelope(dest);
+    }
+
+    initiateSend(data, dest, tag, id);
+    *_current_send_tag = 0;
+    return id;
+}
+
+void MessageQueue::initiateSend(const DataPtr& data, int dest, int tag, int id) {
+    if (_progress_thread_enabled) {
+        // Hand the send to the progress thread
+        atomics::incrementRelaxed(_num_open_sends);
+        SendCommand cmd;
+        cmd.id = id;
+        cmd.dest = dest;
+        cmd.tag = tag;
+        cmd.notifyWhenSent = _send_done_callbacks.count(tag);
+        cmd.data = data;
+        _send_commands.push(std::move(cmd));
+        return;
+    }
+    enqueueSend(data, dest, tag, id);
+}
+
+SendHandle& MessageQueue::enqueueSend(const DataPtr& data, int dest, int tag, int id) {
+    _send_queue.emplace_back(id, dest, tag, data, _max_msg_size);
     SendHandle& h = _send_queue.back();
     h.printSendMsg();
     if (_num_concurrent_sends < _max_concurrent_sends) {
         h.sendNext(_max_msg_size);
         _num_concurrent_sends++;
     }
+    return h;
+}
 
-    *_current_send_tag = 0;
-    return h.id;
+void MessageQueue::flushEnvelopes(bool all) {
+    if (_envelopes.empty()) return;
+    const float time = Timer::elapsedSeconds();
+    std::vector<int> dests;
+    for (auto& [dest, envelope] : _envelopes) {
+        if (all || time - envelope.timeOfFirstMessage >= _coalescing_window) dests.push_back(dest);
+    }
+    for (int dest : dests) flushEnvelope(dest);
+}
+
+void MessageQueue::flushEnvelope(int dest) {
+    auto it = _envelopes.find(dest);
+    assert(it != _envelopes.end());
+    CoalescingEnvelope envelope = std::move(it->second);
+    _envelopes.erase(it);
+
+    const float time = Timer::elapsedSeconds();
+    _coalescing_stats.numMessages += envelope.numMessages;
+    _coalescing_stats.numEnvelopes++;
+    _coalescing_stats.sumAddedLatency += envelope.numMessages * (double) time - envelope.sumOfEnqueueTimes;
+    _coalescing_stats.maxAddedLatency = std::max(_coalescing_stats.maxAddedLatency, time - envelope.timeOfFirstMessage);
+    if (_coalescing_stats.numEnvelopes % 100000 == 0) logCoalescingStats();
+
+    initiateSend(DataPtr(new std::vector<uint8_t>(std::move(envelope.data))),
+        dest, MSG_COALESCED_ENVELOPE, _running_send_id++);
+}
+
+void MessageQueue::logCoalescingStats() {
+    auto& stats = _coalescing_stats;
+    LOG(V3_VERB, "MQ coalesced %lu msgs into %lu envelopes (%.2f msgs/send), added latency avg %.6fs max %.6fs\n",
+        stats.numMessages, stats.numEnvelopes, stats.numMessages / (double) std::max(1UL, stats.numEnvelopes),
+        stats.sumAddedLatency / std::max(1UL, stats.numMessages), stats.maxAddedLatency);
 }
 
 void MessageQueue::cancelSend(int sendId) {
 
+    if (_progress_thread_enabled) {
+        SendCommand cmd;
+        cmd.type = SendCommand::CANCEL;
+        cmd.id = sendId;
+        _send_commands.push(std::move(cmd));
+        return;
+    }
+
     for (auto& h : _send_queue) {
         if (h.id != sendId) continue;
 
@@ -149,21 +292,62 @@ void MessageQueue::cancelSend(int sendId) {
 void MessageQueue::advance() {
     //log(V5_DEBG, "BEGADV\n");
     _iteration++;
-    processReceived();
+    if (!_progress_thread_enabled) processReceived();
     processSelfReceived();
     processAssembledReceived();
-    processSent();
+    flushEnvelopes(false);
+    if (_progress_thread_enabled) processProgressEvents();
+    else processSent();
     //log(V5_DEBG, "ENDADV\n");
 }
 
 bool MessageQueue::hasOpenSends() {
-    return !_send_queue.empty();
+    if (_progress_thread_enabled)
+        return _num_open_sends.load(std::memory_order_acquire) > 0 || !_envelopes.empty();
+    return !_send_queue.empty() || !_envelopes.empty() || !_relays.empty();
 }
 
 bool MessageQueue::hasOpenRecvFragments() {
+    if (_progress_thread_enabled)
+        return _num_open_recv_fragments.load(std::memory_order_relaxed) > 0;
     return !_fragmented_messages.empty();
 }
 
+void MessageQueue::runProgressThread() {
+
+    SendCommand cmd;
+    while (_progress_thread.continueRunning()) {
+        bool active = false;
+        while (_send_commands.pop(cmd)) {
+            applySendCommand(cmd);
+            active = true;
+        }
+        active |= processReceived();
+        active |= processSent();
+        if (!active && _progress_idle_sleep_micros > 0) usleep(_progress_idle_sleep_micros);
+    }
+}
+
+void MessageQueue::applySendCommand(SendCommand& cmd) {
+    switch (cmd.type) {
+    case SendCommand::SEND: {
+        SendHandle& h = enqueueSend(cmd.data, cmd.dest, cmd.tag, cmd.id);
+        h.notifyWhenSent = cmd.notifyWhenSent;
+        cmd.data.reset();
+        break;
+    }
+    case SendCommand::CANCEL:
+        for (auto& h : _send_queue) if (h.id == cmd.id) {
+            h.cancel();
+            break;
+        }
+        break;
+    case SendCommand::CANCEL_ALL:
+        for (auto& h : _send_queue) h.cancel();
+        break;
+    }
+}
+
 void MessageQueue::runFragmentedMessageAssembler() {
 
     while (_batch_assembler.continueRunning()) {
@@ -216,6 +400,15 @@ void MessageQueue::runFragmentedMessageAssembler() {
             offset += frag->size();
         }
         h.setReceive(std::move(outData));
+        if (_progress_thread_enabled) {
+            // Hand directly to the main thread
+            ProgressEvent event;
+            event.handle = std::move(h);
+            event.arrivalTime = Timer::elapsedSeconds();
+            atomics::incrementRelaxed(_handoff_num_arrived);
+            _progress_events.push(std::move(event));
+            continue;
+        }
         // Put into finished queue
         {
             auto lock = _fused_mutex.getLock();
@@ -239,8 +432,9 @@ void MessageQueue::runGarbageCollector() {
     }
 }
 
-void MessageQueue::processReceived() {
+bool MessageQueue::processReceived() {
 
+    bool received = false;
     int k = 0;
     while (k < _num_receives_per_loop) {
         k++;
@@ -254,10 +448,11 @@ void MessageQueue::processReceived() {
             // Handle is not finished:
             // reset #receives per loop
             _num_receives_per_loop = _base_num_receives_per_loop;
-            return;
+            return received;
         }
 
         // Message finished
+        received = true;
         const uint8_t* recvData = _active_recv_data;
         const int source = status.MPI_SOURCE;
         int tag = status.MPI_TAG;
@@ -284,6 +479,8 @@ void MessageQueue::processReceived() {
             }
             auto& fragment = _fragmented_messages[key];
 
+            if (_num_relay_callbacks.load(std::memory_order_relaxed) > 0 || !_relays.empty())
+                relayFragment(source, tag, recvData, msglen);
             fragment.receiveNext(source, tag, recvData, msglen);
 
             if (fragment.isCancelled() || fragment.isFinished()) {
@@ -294,11 +491,31 @@ void MessageQueue::processReceived() {
                 }
                 _fragmented_cond_var.notify();
             }
+            if (_progress_thread_enabled)
+                _num_open_recv_fragments.store(_fragmented_messages.size(), std::memory_order_relaxed);
 
             // Receive next message
             continue;
         }
 
+        if (_progress_thread_enabled) {
+            // Hand a copy of the message to the main thread
+            ProgressEvent event;
+            event.handle.setReceive(msglen, recvData);
+            event.handle.tag = tag;
+            event.handle.source = source;
+            event.arrivalTime = Timer::elapsedSeconds();
+            atomics::incrementRelaxed(_handoff_num_arrived);
+            _progress_events.push(std::move(event));
+            continue;
+        }
+
+        if (tag == MSG_COALESCED_ENVELOPE) {
+            // Several messages: process each according to its tag
+            digestEnvelope(source, recvData, msglen);
+            continue;
+        }
+
         // Single message
         _received_handle.setReceive(msglen, recvData);
         _received_handle.tag = tag;
@@ -314,6 +531,64 @@ void MessageQueue::processReceived() {
     if (k == _num_receives_per_loop && _num_receives_per_loop < 1000) {
         _num_receives_per_loop *= 2;
     }
+    return received;
+}
+
+void MessageQueue::digestEnvelope(int source, const uint8_t* data, size_t size) {
+    CoalescingEnvelope::unpack(data, size, [&](int msgTag, const uint8_t* msgData, size_t msgSize) {
+        _received_handle.setReceive(msgSize, msgData);
+        _received_handle.tag = msgTag;
+        _received_handle.source = source;
+        *_current_recv_tag = msgTag;
+        digestReceivedMessage(_received_handle);
+        *_current_recv_tag = 0;
+    });
+}
+
+void MessageQueue::processProgressEvents() {
+
+    ProgressEvent event;
+    int k = 0;
+    while (k < _num_events_per_loop && _progress_events.pop(event)) {
+        k++;
+        MessageHandle& h = event.handle;
+
+        if (event.sentId >= 0) {
+            signalCompletion(h.tag, event.sentId);
+            continue;
+        }
+
+        recordHandoffLatency(event.arrivalTime, Timer::elapsedSeconds());
+        if (h.tag == MSG_COALESCED_ENVELOPE) {
+            digestEnvelope(h.source, h.getRecvData().data(), h.getRecvData().size());
+            continue;
+        }
+        *_current_recv_tag = h.tag;
+        digestReceivedMessage(h);
+        *_current_recv_tag = 0;
+
+        if (h.getRecvData().size() > _max_msg_size) {
+            // Concurrent deallocation of large chunk of data
+            {
+                auto lock = _garbage_mutex.getLock();
+                _garbage_queue.emplace_back(new std::vector<uint8_t>(h.moveRecvData()));
+            }
+            _garbage_cond_var.notify();
+        }
+    }
+
+    // Adjust #events per loop in the same manner as #receives per loop
+    if (k < _num_events_per_loop) _num_events_per_loop = _base_num_events_per_loop;
+    else if (_num_events_per_loop < 1000) _num_events_per_loop *= 2;
+}
+
+void MessageQueue::recordHandoffLatency(float arrivalTime, float time) {
+    unsigned long micros = (unsigned long) std::max(0.0f, 1000000 * (time - arrivalTime));
+    atomics::incrementRelaxed(_handoff_window_count);
+    atomics::addRelaxed(_handoff_window_sum_micros, micros);
+    unsigned long max = _handoff_window_max_micros.load(std::memory_order_relaxed);
+    while (micros > max && !_handoff_window_max_micros.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {}
+    _handoff_num_handled.fetch_add(1, std::memory_order_release);
 }
 
 void MessageQueue::resetReceiveHandle() {
@@ -386,8 +661,9 @@ void MessageQueue::processAssembledReceived() {
     }
 }
 
-void MessageQueue::processSent() {
+bool MessageQueue::processSent() {
 
+    bool progressed = false;
     // Test each send handle
     auto it = _send_queue.begin();
     while (it != _send_queue.end()) {
@@ -400,6 +676,7 @@ void MessageQueue::processSent() {
                 // can initiate sending
                 h.sendNext(_max_msg_size);
                 _num_concurrent_sends++;
+                progressed = true;
             }
             ++it; // go to next handle
             continue;
@@ -409,6 +686,7 @@ void MessageQueue::processSent() {
             ++it; // go to next handle
             continue;
         }
+        progressed = true;
         
         // Sent!
         //log(V5_DEBG, "MQ SENT n=%i d=[%i] t=%i\n", h.data->size(), h.dest, h.tag);
@@ -429,7 +707,7 @@ void MessageQueue::processSent() {
 
         if (completed) {
             // Notify completion
-            signalCompletion(h.tag, h.id);
+            onSendCompleted(h);
             _num_concurrent_sends--;
 
             if (h.dataPtr->size() > _max_msg_size) {
@@ -447,6 +725,76 @@ void MessageQueue::processSent() {
             ++it; // go to next handle
         }
     }
+    if (!_relays.empty()) progressed |= processRelays();
+    return progressed;
+}
+
+void MessageQueue::relayFragment(int source, int tag, const uint8_t* data, int msglen) {
+
+    const int id = ReceiveFragment::readId(data, msglen);
+    const int batchIdx = ReceiveFragment::readBatchIndex(data, msglen);
+    const int numBatches = ReceiveFragment::readNumBatches(data, msglen);
+    const bool cancelled = batchIdx == 0 && numBatches == 0;
+
+    if (batchIdx == 0 && !cancelled && _num_relay_callbacks.load(std::memory_order_relaxed) > 0) {
+        // First fragment of a message: relay it?
+        std::vector<int> dests;
+        {
+            auto lock = _relay_mutex.getLock();
+            auto it = _relay_callbacks.find(tag);
+            if (it != _relay_callbacks.end())
+                dests = it->second(source, data, msglen - 3*sizeof(int));
+        }
+        for (int dest : dests) {
+            if (dest == _my_rank) continue;
+            int relayId = _running_relay_id++;
+            if (_running_relay_id == INT32_MAX) _running_relay_id = RELAY_ID_OFFSET;
+            LOG(V4_VVER, "MQ RELAY id=%i from [%i] as id=%i to [%i] (%i fragments)\n",
+                id, source, relayId, dest, numBatches);
+            _relays.emplace_back(source, id, relayId, dest, tag);
+            if (_progress_thread_enabled) atomics::incrementRelaxed(_num_open_sends);
+        }
+    }
+
+    // Pass the fragment on to each relay of this message
+    const bool last = cancelled || batchIdx+1 == numBatches;
+    for (auto& relay : _relays) {
+        if (relay.matches(source, id) && !relay.complete) relay.push(data, msglen, last);
+    }
+}
+
+bool MessageQueue::processRelays() {
+
+    bool progressed = false;
+    auto it = _relays.begin();
+    while (it != _relays.end()) {
+        auto& relay = *it;
+        progressed |= relay.advance();
+        if (!relay.isFinished()) {
+            ++it;
+            continue;
+        }
+        LOG(V4_VVER, "MQ RELAYED id=%i from [%i] as id=%i to [%i]: %i fragments in %.4fs\n",
+            relay.sourceId, relay.source, relay.id, relay.dest, relay.numForwarded,
+            Timer::elapsedSeconds() - relay.startTime);
+        if (_progress_thread_enabled) _num_open_sends.fetch_sub(1, std::memory_order_release);
+        it = _relays.erase(it);
+    }
+    return progressed;
+}
+
+void MessageQueue::onSendCompleted(SendHandle& h) {
+    if (!_progress_thread_enabled) {
+        signalCompletion(h.tag, h.id);
+        return;
+    }
+    if (h.notifyWhenSent) {
+        ProgressEvent event;
+        event.handle.tag = h.tag;
+        event.sentId = h.id;
+        _progress_events.push(std::move(event));
+    }
+    _num_open_sends.fetch_sub(1, std::memory_order_release);
 }
 
 void MessageQueue::digestReceivedMessage(MessageHandle& h) {
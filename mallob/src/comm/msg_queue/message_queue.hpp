@@ -8,12 +8,16 @@
 #include <functional>                      // for function
 #include <list>                            // for list, list<>::iterator
 #include <utility>                         // for pair
+#include <vector>                          // for vector
 
+#include "coalescing_envelope.hpp"         // for CoalescingEnvelope
 #include "comm/mpi_base.hpp"               // for MPI_REQUEST_NULL, MPI_Request
 #include "message_handle.hpp"              // for MessageHandle
 #include "receive_fragment.hpp"            // for ReceiveFragment
+#include "relay_handle.hpp"                // for RelayHandle
 #include "send_handle.hpp"                 // for DataPtr, SendHandle
 #include "util/hashing.hpp"
+#include "util/mpsc_queue.hpp"             // for MPSCQueue
 #include "util/robin_hood.hpp"             // for unordered_map, unordered_n...
 #include "util/sys/background_worker.hpp"  // for BackgroundWorker
 #include "util/sys/threading.hpp"          // for Mutex, ConditionVariable
@@ -26,6 +30,25 @@ class MessageQueue {
 public:
     typedef std::function<void(MessageHandle&)> MsgCallback;
     typedef std::function<void(int)> SendDoneCallback;
+    // Called with the source and the payload of the first fragment of a large message;
+    // returns the ranks to which the message is to be relayed.
+    typedef std::function<std::vector<int>(int, const uint8_t*, size_t)> RelayCallback;
+
+    struct CoalescingStats {
+        unsigned long numMessages {0};  // messages sent within envelopes
+        unsigned long numEnvelopes {0}; // MPI sends of envelopes
+        double sumAddedLatency {0};     // seconds by which the messages were held back
+        float maxAddedLatency {0};
+    };
+
+    // Time between the arrival of messages at the progress thread and their handling
+    // by the main thread, since the last call of extractHandoffStats()
+    struct HandoffStats {
+        unsigned long numMessages {0}; // messages handed to callbacks
+        unsigned long numPending {0};  // messages arrived but not handled yet
+        float avgLatency {0};          // seconds
+        float maxLatency {0};
+    };
 
 private:
     size_t _max_msg_size;
@@ -53,12 +76,58 @@ private:
     Mutex _fused_mutex;
     std::list<MessageHandle> _fused_queue;
 
+    // Cut-through forwarding of fragmented messages (see registerRelayCallback)
+    static constexpr int RELAY_ID_OFFSET = 1<<30; // keeps relayed and regular message IDs disjoint
+    Mutex _relay_mutex;
+    robin_hood::unordered_map<int, RelayCallback> _relay_callbacks;
+    std::atomic_int _num_relay_callbacks {0};
+    std::list<RelayHandle> _relays;
+    int _running_relay_id = RELAY_ID_OFFSET;
+
     // Send stuff
     std::list<SendHandle> _send_queue;
     int _running_send_id = 1;
     int _num_concurrent_sends = 0;
     int _max_concurrent_sends = 16;
 
+    // Coalescing of small messages (disabled if max. message size is zero)
+    size_t _coalescing_max_msg_size {0};
+    size_t _coalescing_max_envelope_size {0};
+    float _coalescing_window {0};
+    robin_hood::unordered_map<int, CoalescingEnvelope> _envelopes; // by destination
+    CoalescingStats _coalescing_stats;
+
+    // Progress thread (if enabled): owns the receive request and all send handles.
+    // The main thread passes sends and cancellations via _send_commands, and the
+    // progress thread and the assembler pass received messages and completed
+    // sends via _progress_events.
+    struct SendCommand {
+        enum Type {SEND, CANCEL, CANCEL_ALL} type {SEND};
+        int id {0};
+        int dest {0};
+        int tag {0};
+        bool notifyWhenSent {false};
+        DataPtr data;
+    };
+    struct ProgressEvent {
+        MessageHandle handle;
+        int sentId {-1}; // >= 0: completion of the send with this ID (and handle.tag)
+        float arrivalTime {0};
+    };
+    bool _progress_thread_enabled {false};
+    int _progress_idle_sleep_micros {0};
+    MPSCQueue<SendCommand> _send_commands;
+    MPSCQueue<ProgressEvent> _progress_events;
+    std::atomic_int _num_open_sends {0};
+    std::atomic_int _num_open_recv_fragments {0};
+    std::atomic_ulong _handoff_num_arrived {0};
+    std::atomic_ulong _handoff_num_handled {0};
+    std::atomic_ulong _handoff_window_count {0};
+    std::atomic_ulong _handoff_window_sum_micros {0};
+    std::atomic_ulong _handoff_window_max_micros {0};
+    int _base_num_events_per_loop = 10;
+    int _num_events_per_loop = _base_num_events_per_loop;
+
     // Garbage collection
     Mutex _garbage_mutex;
     ConditionVariable _garbage_cond_var;
@@ -73,6 +142,7 @@ private:
 
     BackgroundWorker _batch_assembler;
     BackgroundWorker _gc;
+    BackgroundWorker _progress_thread;
 
 public:
     MessageQueue(int maxMsgSize);
@@ -82,6 +152,13 @@ public:
     typedef std::list<MsgCallback>::iterator CallbackRef;
     CallbackRef registerCallback(int tag, const MsgCallback& cb);
     void registerSentCallback(int tag, const SendDoneCallback& cb);
+    // Cut-through forwarding: Upon the first fragment of a large message with the given tag,
+    // the callback decides to which ranks the message is relayed. Each further fragment is
+    // then passed on as soon as it arrives, while the message is still assembled and handed
+    // to the tag's callback as usual. The callback is executed by the thread which receives
+    // messages (see startProgressThread) and must be thread-safe accordingly.
+    void registerRelayCallback(int tag, const RelayCallback& cb);
+    void clearRelayCallback(int tag);
     void clearCallbacks();
     void clearCallback(int tag, const CallbackRef& ref);
     void setCurrentTagPointers(int* recvTag, int* sendTag) {
@@ -89,6 +166,24 @@ public:
         _current_send_tag = sendTag;
     }
 
+    // Coalesce each message of at most maxMsgSize bytes with other such messages to the
+    // same destination. An envelope is sent as soon as it holds maxEnvelopeSize bytes
+    // or once its first message is windowSeconds old (checked in advance()).
+    // Messages with a sent callback are never coalesced. Envelopes are unpacked
+    // transparently at the receiver, regardless of its own setting.
+    void setCoalescing(size_t maxMsgSize, size_t maxEnvelopeSize, float windowSeconds);
+    const CoalescingStats& getCoalescingStats() const {return _coalescing_stats;}
+
+    // Hand all MPI calls of this queue (receive polling, sends, fragment handling) to a
+    // dedicated thread, so that messages keep being received and assembled while the
+    // main thread is busy. advance() then only hands completed messages to the callbacks.
+    // Requires MPI_THREAD_MULTIPLE and must be called while no sends are open.
+    // The thread sleeps for idleSleepMicros whenever it found nothing to do.
+    void startProgressThread(int idleSleepMicros);
+    bool hasProgressThread() const {return _progress_thread_enabled;}
+    // Thread-safe. Resets the measured latencies (but not the number of pending messages).
+    HandoffStats extractHandoffStats();
+
     int send(const DataPtr& data, int dest, int tag);
     void cancelSend(int sendId);
     void advance();
@@ -100,10 +195,24 @@ private:
     void runFragmentedMessageAssembler();
     void runGarbageCollector();
 
-    void processReceived();
+    void runProgressThread();
+
+    bool processReceived();
+    void applySendCommand(SendCommand& cmd);
+    void processProgressEvents();
+    void digestEnvelope(int source, const uint8_t* data, size_t size);
+    void recordHandoffLatency(float arrivalTime, float time);
     void processSelfReceived();
     void processAssembledReceived();
-    void processSent();
+    bool processSent();
+    void relayFragment(int source, int tag, const uint8_t* data, int msglen);
+    bool processRelays();
+    void onSendCompleted(SendHandle& h);
+    void flushEnvelopes(bool all);
+    void flushEnvelope(int dest);
+    void initiateSend(const DataPtr& data, int dest, int tag, int id);
+    SendHandle& enqueueSend(const DataPtr& data, int dest, int tag, int id);
+    void logCoalescingStats();
 
     void resetReceiveHandle();
     void signalCompletion(int tag, int id);
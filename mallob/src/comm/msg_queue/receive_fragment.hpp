@@ -46,6 +46,12 @@ struct ReceiveFragment {
     static int readId(const uint8_t* data, int msglen) {
         return * (int*) (data+msglen - 3*sizeof(int));
     }
+    static int readBatchIndex(const uint8_t* data, int msglen) {
+        return * (int*) (data+msglen - 2*sizeof(int));
+    }
+    static int readNumBatches(const uint8_t* data, int msglen) {
+        return * (int*) (data+msglen - 1*sizeof(int));
+    }
 
     void receiveNext(int source, int tag, const uint8_t* data, int msglen) {
         assert(this->source >= 0);
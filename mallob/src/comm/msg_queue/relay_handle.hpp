@@ -0,0 +1,83 @@
+
+#pragma once
+
+#include <list>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+#include "util/assert.hpp"
+#include "comm/mpi_base.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+#include "comm/msgtags.h"
+
+/*
+Forwards the fragments of a large message which is still being received to another rank,
+each fragment as soon as it has arrived (cut-through forwarding). At the destination,
+the relayed message looks like any other fragmented message sent by this rank.
+*/
+struct RelayHandle {
+
+    int source; // source of the relayed message
+    int sourceId; // ID of the relayed message at its source
+    int id; // ID of the relayed message at this rank
+    int dest;
+    int tag;
+    MPI_Request request = MPI_REQUEST_NULL;
+    std::list<std::vector<uint8_t>> pendingFragments; // incl. meta data
+    std::vector<uint8_t> sentFragment;
+    int numForwarded {0};
+    bool complete {false}; // last fragment (or cancellation) was pushed
+    float startTime;
+
+    RelayHandle(int source, int sourceId, int id, int dest, int tag) :
+        source(source), sourceId(sourceId), id(id), dest(dest), tag(tag),
+        startTime(Timer::elapsedSeconds()) {}
+    RelayHandle(const RelayHandle& other) = delete;
+    RelayHandle(RelayHandle&& moved) = delete;
+
+    ~RelayHandle() {
+        if (request != MPI_REQUEST_NULL) {
+            MPI_Cancel(&request);
+            MPI_Request_free(&request);
+        }
+    }
+
+    bool matches(int source, int sourceId) const {
+        return this->source == source && this->sourceId == sourceId;
+    }
+
+    // data: a received fragment including its meta data (see SendHandle::sendNext)
+    void push(const uint8_t* data, int msglen, bool last) {
+        assert(!complete);
+        assert(msglen >= 3*sizeof(int));
+        pendingFragments.emplace_back(data, data+msglen);
+        // Replace the ID of the message with the one of the relayed message
+        memcpy(pendingFragments.back().data()+msglen-3*sizeof(int), &id, sizeof(int));
+        complete = last;
+    }
+
+    // Returns true iff a fragment has been sent or its sending has completed.
+    bool advance() {
+        bool progressed = false;
+        if (request != MPI_REQUEST_NULL) {
+            int flag = false;
+            MPI_Test(&request, &flag, MPI_STATUS_IGNORE);
+            if (!flag) return false;
+            request = MPI_REQUEST_NULL;
+            progressed = true;
+        }
+        if (pendingFragments.empty()) return progressed;
+        sentFragment = std::move(pendingFragments.front());
+        pendingFragments.pop_front();
+        MPI_Isend(sentFragment.data(), sentFragment.size(), MPI_BYTE, dest,
+            tag+MSG_OFFSET_BATCHED, MPI_COMM_WORLD, &request);
+        numForwarded++;
+        return true;
+    }
+
+    bool isFinished() const {
+        return complete && pendingFragments.empty() && request == MPI_REQUEST_NULL;
+    }
+};
@@ -25,6 +25,7 @@ struct SendHandle {
     int sentBatches = -1;
     int totalNumBatches;
     bool cancelled {false};
+    bool notifyWhenSent {false}; // only used with a progress thread
     std::vector<uint8_t> tempStorage;
     
     SendHandle(int id, int dest, int tag, const DataPtr& sendData, int maxMsgSize) 
@@ -50,6 +51,7 @@ struct SendHandle {
         sentBatches = moved.sentBatches;
         totalNumBatches = moved.totalNumBatches;
         cancelled = moved.cancelled;
+        notifyWhenSent = moved.notifyWhenSent;
         tempStorage = std::move(moved.tempStorage);
         
         moved.id = -1;
@@ -65,6 +67,7 @@ struct SendHandle {
         sentBatches = moved.sentBatches;
         totalNumBatches = moved.totalNumBatches;
         cancelled = moved.cancelled;
+        notifyWhenSent = moved.notifyWhenSent;
         tempStorage = std::move(moved.tempStorage);
         
         moved.id = -1;
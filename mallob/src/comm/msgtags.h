@@ -42,6 +42,17 @@ Warning: Length may exceed the default maximum message length.
 const int MSG_SEND_JOB_DESCRIPTION = 9;
 const int MSG_SEND_JOB_DESCRIPTION_SKELETON = 99;
 /*
+Like MSG_SEND_JOB_DESCRIPTION, but the payload (formula and assumptions) is compressed.
+Data type: [meta data][compressed payload][size_t meta data size][size_t #payload ints]
+(see compressIntStream in util/compression.hpp)
+*/
+const int MSG_SEND_JOB_DESCRIPTION_COMPRESSED = 98;
+/*
+A worker informs the job's root that it received a full job description revision.
+Data type: [jobId, revision]
+*/
+const int MSG_NOTIFY_DESCRIPTION_READY = 97;
+/*
 The sender informs the receiver that a solution was found for the job
 of the specified ID.
 Data type: [jobId, resultCode]
@@ -169,6 +180,9 @@ const int MSG_MATCHING_REQUEST_CANCELLED = 84;
 
 const int MSG_DEPLOY_NEW_REVISION = 85;
 
+// Several small messages packed into a single MPI message (see MessageQueue::setCoalescing)
+const int MSG_COALESCED_ENVELOPE = 86;
+
 const int MSG_OFFSET_BATCHED = 10000;
 
 
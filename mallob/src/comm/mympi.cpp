@@ -13,24 +13,55 @@
 #include "util/logger.hpp"                   // for V2_INFO, V4_VVER
 #include "util/option.hpp"                   // for IntOption
 #include "util/params.hpp"                   // for Parameters
+#include "util/sys/proc.hpp"                 // for Proc
 #include "util/sys/process.hpp"              // for Process
 
 
 MessageQueue* MyMpi::_msg_queue;
+bool MyMpi::_thread_multiple {false};
+int MyMpi::_host_size {1};
+std::string MyMpi::_host_run_id;
 
-void MyMpi::init() {
+void MyMpi::init(bool multiThreaded) {
     int provided = -1;
-    MPICALL(MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided), std::string("init"))
-    if (provided != MPI_THREAD_FUNNELED) {
-        std::cout << "[ERROR] MPI: wanted id=" << MPI_THREAD_FUNNELED 
+    int wanted = multiThreaded ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED;
+    MPICALL(MPI_Init_thread(nullptr, nullptr, wanted, &provided), std::string("init"))
+    // Without MPI_THREAD_MULTIPLE, we can still proceed single-threaded (see setOptions)
+    if (provided < MPI_THREAD_FUNNELED) {
+        std::cout << "[ERROR] MPI: wanted id=" << wanted 
                 << ", got id=" << provided << std::endl;
         Process::doExit(1);
     }
+    _thread_multiple = provided >= MPI_THREAD_MULTIPLE;
 }
 
 void MyMpi::setOptions(const Parameters& params) {
     int verb = MyMpi::rank(MPI_COMM_WORLD) == 0 ? V2_INFO : V4_VVER;
     _msg_queue = new MessageQueue(params.messageBatchingThreshold());
+    if (params.messageCoalescingThreshold() > 0) {
+        _msg_queue->setCoalescing(params.messageCoalescingThreshold(), params.messageCoalescingBytes(),
+            0.000001f * params.messageCoalescingMicrosecs());
+    }
+    if (params.messageProgressThread()) {
+        if (_thread_multiple) {
+            _msg_queue->startProgressThread(params.messageProgressSleepMicrosecs());
+        } else {
+            LOG(V1_WARN, "[WARN] MPI does not provide MPI_THREAD_MULTIPLE - no message progress thread\n");
+        }
+    }
+
+    // Identify the processes on this host (only needed for host-wide deduplication of
+    // job descriptions): they share the PID of their first process
+    if (params.hostDescriptionDedupWait() <= 0) return;
+    MPI_Comm hostComm;
+    MPICALL(MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, MyMpi::rank(MPI_COMM_WORLD),
+        MPI_INFO_NULL, &hostComm), std::string("splitHost"))
+    _host_size = MyMpi::size(hostComm);
+    long pid = Proc::getPid();
+    MPICALL(MPI_Bcast(&pid, 1, MPI_LONG, 0, hostComm), std::string("bcastHostId"))
+    MPI_Comm_free(&hostComm);
+    _host_run_id = std::to_string(pid);
+    LOG(V4_VVER, "%i processes on this host, host run ID %s\n", _host_size, _host_run_id.c_str());
 }
 
 int MyMpi::isend(int recvRank, int tag, const Serializable& object) {
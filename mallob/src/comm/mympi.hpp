@@ -3,6 +3,7 @@
 
 #include <stddef.h>                        // for size_t
 #include <stdint.h>                        // for uint8_t
+#include <string>                          // for string
 #include <vector>                          // for vector
 
 #include "comm/mpi_base.hpp"               // for MPI_Comm, MPI_Request, MPI_Op
@@ -25,8 +26,13 @@ public:
     static ConcurrentAllocator<RecvBundle> _alloc;
     */
     static MessageQueue* _msg_queue;
+    static bool _thread_multiple;
+    static int _host_size;
+    static std::string _host_run_id;
 
-    static void init();
+    // With multiThreaded, MPI_THREAD_MULTIPLE is requested instead of MPI_THREAD_FUNNELED.
+    static void init(bool multiThreaded = false);
+    static bool isThreadMultiple() {return _thread_multiple;}
     static void setOptions(const Parameters& params);
 
     static int isend(int recvRank, int tag, const Serializable& object);
@@ -43,6 +49,12 @@ public:
     static int size(MPI_Comm comm);
     static int rank(MPI_Comm comm);
 
+    // Number of processes of this run on this host (known after setOptions, only with -hddw > 0)
+    static int getHostSize() {return _host_size;}
+    // Identifier which is shared by exactly the processes of this run on this host,
+    // e.g., to name machine-local files (known after setOptions, only with -hddw > 0)
+    static const std::string& getHostRunId() {return _host_run_id;}
+
     static MessageQueue& getMessageQueue();
 
     static void broadcastExitSignal();
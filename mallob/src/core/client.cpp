@@ -134,20 +134,32 @@ void Client::readIncomingJobs() {
                 
                 auto& foundJob = *foundJobPtr;
                 if (!_instance_reader.continueRunning()) return;
+
+                if (foundJob.hasLiteralStream() && !app_registry::isClientSide(foundJob.description->getApplicationId())) {
+                    // Schedule the job while its literals are still arriving
+                    readLiteralStream(foundJob, log);
+                    delete foundJobPtr;
+                    return;
+                }
                 
                 // Read job
                 int id = foundJob.description->getId();
                 float time = Timer::elapsedSeconds();
                 bool success = true;
                 auto filesList = foundJob.getFilesList();
-                foundJob.description->beginInitialization(foundJob.description->getRevision());
-                if (foundJob.hasFiles()) {
-                    LOGGER(log, V3_VERB, "[T] Reading job #%i rev. %i %s ...\n", id, foundJob.description->getRevision(), filesList.c_str());
-                    success = app_registry::getJobReader(foundJob.description->getApplicationId())(
-                        _params, foundJob.files, *foundJob.description
-                    );
+                if (!foundJob.initialized) {
+                    foundJob.description->beginInitialization(foundJob.description->getRevision());
+                    if (foundJob.hasFiles()) {
+                        LOGGER(log, V3_VERB, "[T] Reading job #%i rev. %i %s ...\n", id, foundJob.description->getRevision(), filesList.c_str());
+                        success = app_registry::getJobReader(foundJob.description->getApplicationId())(
+                            _params, foundJob.files, *foundJob.description
+                        );
+                    } else if (foundJob.hasLiteralStream()) {
+                        LOGGER(log, V3_VERB, "[T] Reading job #%i rev. %i from stream ...\n", id, foundJob.description->getRevision());
+                        success = digestLiteralStream(*foundJob.description, *foundJob.literalStream, log);
+                    }
+                    foundJob.description->endInitialization();
                 }
-                foundJob.description->endInitialization();
                 if (!success) {
                     LOGGER(log, V1_WARN, "[T] [WARN] Unsuccessful read - skipping #%i\n", id);
                     auto lock = _failed_job_lock.getLock();
@@ -208,6 +220,78 @@ void Client::readIncomingJobs() {
     log.flush();
 }
 
+void Client::readLiteralStream(JobMetadata& job, Logger& log) {
+
+    JobDescription* desc = job.description.get();
+    auto stream = job.literalStream;
+    const int id = desc->getId();
+    const int rev = desc->getRevision();
+    float time = Timer::elapsedSeconds();
+    desc->beginInitialization(rev);
+    desc->getStatistics(); // allocate now: the main thread accesses the statistics concurrently
+
+    // Publish the job right away such that a root node can be found during the upload.
+    // The description itself is sent only after the stream has been parsed completely.
+    {
+        auto lock = _literal_streams_lock.getLock();
+        _literal_streams[std::pair<int, int>(id, rev)] = stream;
+    }
+    {
+        auto lock = _ready_job_lock.getLock();
+        _ready_job_queue.push_back(std::move(job.description));
+        atomics::incrementRelaxed(_num_ready_jobs);
+    }
+    atomics::incrementRelaxed(_num_loaded_jobs);
+    LOGGER(log, V3_VERB, "[T] Reading job #%i rev. %i from stream while scheduling ...\n", id, rev);
+
+    bool success = digestLiteralStream(*desc, *stream, log);
+    // Discard an incomplete formula: the job will be interrupted right after its start
+    if (!success) desc->beginInitialization(rev);
+    desc->endInitialization();
+    time = Timer::elapsedSeconds() - time;
+    desc->getStatistics().parseTime = time;
+    const float timeOfEnd = stream->getTimeOfEnd();
+    if (success) {
+        LOGGER(log, V3_VERB, "[T] Initialized job #%i from stream in %.3fs (%.4fs after upload): %ld lits w/ separators, %ld assumptions\n", 
+            id, time, timeOfEnd < 0 ? 0 : Timer::elapsedSeconds() - timeOfEnd,
+            desc->getNumFormulaLiterals(), desc->getNumAssumptionLiterals());
+    }
+    // The main thread may now send the description (or deal with the failed upload)
+    stream->setParsed(success);
+    _sys_state.addLocal(SYSSTATE_PARSED_JOBS, 1);
+}
+
+bool Client::digestLiteralStream(JobDescription& desc, LiteralStream& stream, Logger& log) {
+
+    std::vector<int> chunk;
+    int lastLit = 0;
+    while (true) {
+        auto res = stream.pop(chunk, 100);
+        if (res == LiteralStream::END) break;
+        if (res == LiteralStream::TIMEOUT) {
+            if (!_instance_reader.continueRunning()) {
+                stream.conclude(false);
+                break;
+            }
+            continue;
+        }
+        if (chunk.empty()) continue;
+        desc.addPermanentData(chunk.data(), chunk.size());
+        lastLit = chunk.back();
+    }
+
+    if (stream.getState() != LiteralStream::COMPLETE) {
+        LOGGER(log, V1_WARN, "[T] [WARN] Upload of #%i rev. %i aborted after %lu literals\n",
+            desc.getId(), desc.getRevision(), stream.getNbLiterals());
+        return false;
+    }
+    if (lastLit != 0) {
+        LOGGER(log, V1_WARN, "[T] [WARN] Upload of #%i rev. %i ends within a clause\n", desc.getId(), desc.getRevision());
+        return false;
+    }
+    return true;
+}
+
 void Client::handleNewJob(JobMetadata&& data) {
 
     if (data.done) {
@@ -370,7 +454,15 @@ void Client::advance() {
                 MyMpi::isend(_root_nodes.at(jobId), MSG_NOTIFY_JOB_ABORTING, IntVec({jobId, rev, JobInterruptReason::USER}));
                 it = _jobs_to_interrupt.erase(it);
                 atomics::decrementRelaxed(_num_jobs_to_interrupt);
-            } else ++it;
+            } else {
+                // Description not sent yet: cancel a pending upload so that it can be sent (and interrupted) soon
+                {
+                    auto lock = _literal_streams_lock.getLock();
+                    auto itStream = _literal_streams.find(std::pair<int, int>(jobId, rev));
+                    if (itStream != _literal_streams.end()) itStream->second->conclude(false);
+                }
+                ++it;
+            }
         }
         _jobs_to_interrupt_lock.unlock();
     }
@@ -410,6 +502,22 @@ void Client::advance() {
         }
     }
 
+    // Send descriptions of streamed jobs which have been parsed in the meantime
+    for (auto it = _deferred_description_transfers.begin(); it != _deferred_description_transfers.end(); ) {
+        if (!it->stream->isParsed()) {
+            ++it;
+            continue;
+        }
+        auto transfer = std::move(*it);
+        it = _deferred_description_transfers.erase(it);
+        sendJobDescription(transfer.req, transfer.destRank);
+    }
+    // Release descriptions of finished jobs which the job reader is done with
+    for (auto it = _descriptions_in_upload.begin(); it != _descriptions_in_upload.end(); ) {
+        if (it->second->isParsed()) it = _descriptions_in_upload.erase(it);
+        else ++it;
+    }
+
     // Introduce next job(s) as applicable
     // (only one job at a time to react better
     // to outside events without too much latency)
@@ -495,6 +603,7 @@ void Client::introduceNextJob() {
     // Store as an active job
     JobDescription& job = *jobPtr;
     int jobId = job.getId();
+    if (_active_jobs.count(jobId)) releaseDescription(std::move(_active_jobs[jobId]));
     _active_jobs[jobId] = std::move(jobPtr);
     _sys_state.addLocal(SYSSTATE_SCHEDULED_JOBS, 1);
 
@@ -544,7 +653,41 @@ void Client::sendJobDescription(JobRequest& req, int destRank) {
     float schedulingTime = Timer::elapsedSeconds() - req.timeOfBirth;
     LOG(V3_VERB, "Scheduling %s on [%i] (latency: %.5fs)\n", req.toStr().c_str(), destRank, schedulingTime);
 
-    JobDescription& desc = *_active_jobs[req.jobId];
+    auto itJob = _active_jobs.find(req.jobId);
+    if (itJob == _active_jobs.end()) {
+        LOG(V3_VERB, "Drop desc. transfer of #%i: job not active anymore\n", req.jobId);
+        return;
+    }
+    JobDescription& desc = *itJob->second;
+
+    // Streamed job: send the description only after all of its literals have been parsed
+    std::shared_ptr<LiteralStream> stream;
+    {
+        auto lock = _literal_streams_lock.getLock();
+        auto it = _literal_streams.find(std::pair<int, int>(req.jobId, desc.getRevision()));
+        if (it != _literal_streams.end()) stream = it->second;
+    }
+    if (stream) {
+        if (!stream->isParsed()) {
+            LOG(V3_VERB, "Defer sending desc. of #%i rev. %i: literals still arriving\n", req.jobId, desc.getRevision());
+            _deferred_description_transfers.push_back({req, destRank, stream});
+            return;
+        }
+        {
+            auto lock = _literal_streams_lock.getLock();
+            _literal_streams.erase(std::pair<int, int>(req.jobId, desc.getRevision()));
+        }
+        if (!stream->isValid()) {
+            // The job has been scheduled already, so it needs to be run and interrupted
+            LOG(V1_WARN, "[WARN] Interrupting #%i rev. %i: incomplete upload\n", req.jobId, desc.getRevision());
+            _failed_uploads.insert(req.jobId);
+            {
+                auto lock = _jobs_to_interrupt_lock.getLock();
+                _jobs_to_interrupt.push_back({req.jobId, desc.getRevision()});
+            }
+            atomics::incrementRelaxed(_num_jobs_to_interrupt);
+        }
+    }
     desc.getStatistics().schedulingTime = schedulingTime;
     desc.getStatistics().timeOfScheduling = Timer::elapsedSeconds();
     assert(desc.getId() == req.jobId || LOG_RETURN_FALSE("%i != %i\n", desc.getId(), req.jobId));
@@ -557,6 +700,7 @@ void Client::sendJobDescription(JobRequest& req, int destRank) {
     int tag = desc.isIncremental() && req.revision>0 ?
         MSG_DEPLOY_NEW_REVISION : MSG_SEND_JOB_DESCRIPTION;
 
+    desc.setTimeSinceSubmission(Timer::elapsedSeconds() - desc.getStatistics().timeOfSubmission);
     auto data = desc.getSerialization(desc.getRevision());
 
     log(V5_DEBG, "Set up formula : %s\n",
@@ -604,6 +748,13 @@ void Client::handleSendJobResult(MessageHandle& handle) {
     if (!descPtr) return; // user-side terminated in the meantime?
     JobDescription& desc = *descPtr;
     if (desc.getRevision() > revision) return; // revision obsolete!
+    if (_failed_uploads.count(jobId)) {
+        // The job's streamed formula was incomplete: the result is meaningless
+        LOG_ADD_SRC(V1_WARN, "[WARN] Discarding result of #%i rev. %i with incomplete upload", handle.source, jobId, revision);
+        jobResult.result = 0;
+        jobResult.setSolution(std::vector<int>());
+        resultCode = 0;
+    }
     int surrogateId = desc.getAppConfiguration().map.count("__surrogate") ?
         desc.getAppConfiguration().fixedSizeEntryToInt("__surrogate") : 0;
     float timeOfParentTask = 0;
@@ -764,9 +915,25 @@ void Client::finishJob(int jobId, bool hasIncrementalSuccessors) {
         _done_jobs[jobId] = DoneInfo{_active_jobs[jobId]->getRevision(), _active_jobs[jobId]->getChecksum()};
     }
 
+    _failed_uploads.erase(jobId);
+
+    // Descriptions which are still being uploaded will not be sent anymore
+    for (auto it = _deferred_description_transfers.begin(); it != _deferred_description_transfers.end(); ) {
+        if (it->req.jobId != jobId) {
+            ++it;
+            continue;
+        }
+        it = _deferred_description_transfers.erase(it);
+        {
+            auto lock = _incoming_job_lock.getLock();
+            _num_loaded_jobs--;
+        }
+    }
+
     // Clean up job, remember as done
     if (!hasIncrementalSuccessors) {
         _root_nodes.erase(jobId);
+        if (_active_jobs.count(jobId)) releaseDescription(std::move(_active_jobs[jobId]));
         _active_jobs.erase(jobId);
         _sys_state.addLocal(SYSSTATE_PROCESSED_JOBS, 1);
     }
@@ -774,6 +941,28 @@ void Client::finishJob(int jobId, bool hasIncrementalSuccessors) {
     _incoming_job_cond_var.notify(); // waiting instance reader might be able to continue now
 }
 
+void Client::releaseDescription(std::unique_ptr<JobDescription>&& desc) {
+
+    std::shared_ptr<LiteralStream> stream;
+    {
+        auto lock = _literal_streams_lock.getLock();
+        auto it = _literal_streams.find(std::pair<int, int>(desc->getId(), desc->getRevision()));
+        if (it != _literal_streams.end()) {
+            stream = std::move(it->second);
+            _literal_streams.erase(it);
+        }
+    }
+    if (!stream || stream->isParsed()) {
+        desc.reset();
+        return;
+    }
+    // The job reader still writes into the description: cancel the upload
+    // and keep the description alive until the reader is done with it.
+    LOG(V3_VERB, "Cancel upload of #%i rev. %i\n", desc->getId(), desc->getRevision());
+    stream->conclude(false);
+    _descriptions_in_upload.emplace_back(std::move(desc), std::move(stream));
+}
+
 JobDescription* Client::getActiveJob(int jobId) {
     if (_active_jobs.count(jobId)) return _active_jobs[jobId].get();
     for (auto& j : _done_client_side_jobs) if (j.desc->getId() == jobId) return j.desc.get();
@@ -19,6 +19,8 @@
 #include "util/sys/threading.hpp"
 #include "interface/json_interface.hpp"
 #include "data/job_metadata.hpp"
+#include "data/job_transfer.hpp"
+#include "data/literal_stream.hpp"
 #include "comm/sysstate.hpp"
 #include "util/sys/background_worker.hpp"
 #include "util/periodic_event.hpp"
@@ -111,6 +113,25 @@ private:
     std::list<std::pair<int, int>> _jobs_to_interrupt; // job id, revision
     Mutex _jobs_to_interrupt_lock;
 
+    // Streamed jobs which are scheduled while their literals are still arriving, per (id, revision).
+    std::map<std::pair<int, int>, std::shared_ptr<LiteralStream>> _literal_streams;
+    // Safeguards _literal_streams.
+    Mutex _literal_streams_lock;
+    // Adopted jobs whose description is sent as soon as its literals have been parsed.
+    // ONLY ACCESSIBLE FROM CLIENT'S MAIN THREAD.
+    struct DeferredDescriptionTransfer {
+        JobRequest req;
+        int destRank;
+        std::shared_ptr<LiteralStream> stream;
+    };
+    std::list<DeferredDescriptionTransfer> _deferred_description_transfers;
+    // Descriptions of finished jobs which the job reader still writes into. They are
+    // released as soon as the reader is done, i.e., their stream has been parsed.
+    // ONLY ACCESSIBLE FROM CLIENT'S MAIN THREAD.
+    std::list<std::pair<std::unique_ptr<JobDescription>, std::shared_ptr<LiteralStream>>> _descriptions_in_upload;
+    // Jobs whose streamed formula is incomplete: their results must not be reported.
+    robin_hood::unordered_flat_set<int, robin_hood::hash<int>> _failed_uploads;
+
     std::map<int, int> _root_nodes;
     std::set<int> _client_ranks;
     SysState<5> _sys_state;
@@ -159,6 +180,8 @@ public:
 
 private:
     void readIncomingJobs();
+    void readLiteralStream(JobMetadata& job, Logger& log);
+    bool digestLiteralStream(JobDescription& desc, LiteralStream& stream, Logger& log);
     
     void handleOfferAdoption(MessageHandle& handle);
     void sendJobDescription(JobRequest& req, int destRank);
@@ -171,6 +194,7 @@ private:
     int getMaxNumParallelJobs();
     void introduceNextJob();
     void finishJob(int jobId, bool hasIncrementalSuccessors);
+    void releaseDescription(std::unique_ptr<JobDescription>&& desc);
 
     JobDescription* getActiveJob(int jobId);
 };
@@ -0,0 +1,158 @@
+
+#pragma once
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "util/logger.hpp"
+#include "util/sys/fileutils.hpp"
+#include "util/sys/proc.hpp"
+#include "util/sys/shared_memory.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/tmpdir.hpp"
+
+// Host-level store of full job description revisions, so that each revision needs to be
+// transferred to a host only once. The first process on the host which needs a revision
+// claims it and fetches it from its parent as usual; upon arrival, it publishes the revision
+// as a shared memory segment. Other processes on the host wait for the publication and copy
+// the revision from there. Like SharedMemoryCache, all state is kept in the file system of
+// the machine, and claims of processes which died are discarded. This is a best-effort
+// mechanism: a waiting process may always give up and fetch a revision itself.
+class HostDescriptionStore {
+
+public:
+    enum Status {CLAIMED, CLAIMED_ELSEWHERE, PUBLISHED};
+
+private:
+    std::string _prefix;
+    struct Claim {
+        std::future<void> publication;
+    };
+    std::map<std::pair<int, int>, Claim> _claims; // by (job ID, revision)
+
+public:
+    // hostRunId must be shared by exactly the processes of this run on this host.
+    HostDescriptionStore(const std::string& hostRunId) :
+        _prefix("/edu.kit.iti.mallob.hostdesc." + hostRunId + ".") {}
+    ~HostDescriptionStore() {
+        while (!_claims.empty()) release(_claims.begin()->first.first);
+    }
+
+    Status claim(int jobId, int revision) {
+        if (_claims.count({jobId, revision})) return CLAIMED;
+        if (FileUtils::exists(getReadyFile(jobId, revision))) return PUBLISHED;
+        if (tryCreateClaimFile(jobId, revision)) {
+            _claims[{jobId, revision}];
+            LOG(V4_VVER, "HOSTDESC claimed #%i rev. %i\n", jobId, revision);
+            return CLAIMED;
+        }
+        // Discard the claim of a process which died
+        pid_t pid = readNumber(getClaimFile(jobId, revision));
+        if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+            LOG(V4_VVER, "HOSTDESC discard stale claim of #%i rev. %i by pid %i\n", jobId, revision, pid);
+            FileUtils::rm(getClaimFile(jobId, revision));
+            return claim(jobId, revision);
+        }
+        return CLAIMED_ELSEWHERE;
+    }
+
+    bool hasClaimed(int jobId, int revision) const {
+        return _claims.count({jobId, revision});
+    }
+
+    // Publish a claimed revision concurrently.
+    void publish(int jobId, int revision, const std::shared_ptr<std::vector<uint8_t>>& data) {
+        auto it = _claims.find({jobId, revision});
+        if (it == _claims.end() || it->second.publication.valid()) return;
+        const std::string shmemId = getShmemId(jobId, revision);
+        const std::string readyFile = getReadyFile(jobId, revision);
+        it->second.publication = ProcessWideThreadPool::get().addTask([shmemId, readyFile, data]() {
+            void* shmem = SharedMemory::create(shmemId, data->size());
+            if (!shmem || shmem == MAP_FAILED) {
+                LOG(V1_WARN, "[WARN] HOSTDESC cannot create %s\n", shmemId.c_str());
+                return;
+            }
+            memcpy(shmem, data->data(), data->size());
+            SharedMemory::close((char*) shmem, data->size());
+            // Announce the segment only after it is complete
+            {
+                std::ofstream ofs(readyFile + ".tmp");
+                ofs << data->size();
+            }
+            std::rename((readyFile + ".tmp").c_str(), readyFile.c_str());
+            LOG(V4_VVER, "HOSTDESC published %s (size %lu)\n", shmemId.c_str(), data->size());
+        });
+    }
+
+    // Copy a published revision; returns an empty pointer if it is not available (anymore).
+    std::shared_ptr<std::vector<uint8_t>> fetch(int jobId, int revision) {
+        std::shared_ptr<std::vector<uint8_t>> result;
+        long size = readNumber(getReadyFile(jobId, revision));
+        if (size <= 0) return result;
+        void* shmem = SharedMemory::access(getShmemId(jobId, revision), size, SharedMemory::READONLY);
+        if (!shmem || shmem == MAP_FAILED) return result;
+        result.reset(new std::vector<uint8_t>((uint8_t*) shmem, ((uint8_t*) shmem) + size));
+        SharedMemory::close((char*) shmem, size);
+        LOG(V4_VVER, "HOSTDESC fetched #%i rev. %i (size %lu)\n", jobId, revision, size);
+        return result;
+    }
+
+    // Withdraw all claims and publications of this process concerning the given job.
+    void release(int jobId) {
+        auto it = _claims.lower_bound({jobId, 0});
+        while (it != _claims.end() && it->first.first == jobId) {
+            const int revision = it->first.second;
+            if (it->second.publication.valid()) it->second.publication.get();
+            FileUtils::rm(getReadyFile(jobId, revision));
+            shm_unlink(getShmemId(jobId, revision).c_str());
+            FileUtils::rm(getClaimFile(jobId, revision));
+            LOG(V5_DEBG, "HOSTDESC released #%i rev. %i\n", jobId, revision);
+            it = _claims.erase(it);
+        }
+    }
+
+private:
+    std::string getShmemId(int jobId, int revision) const {
+        return _prefix + std::to_string(jobId) + "." + std::to_string(revision);
+    }
+    std::string getFilePrefix(int jobId, int revision) const {
+        return TmpDir::getMachineLocalTmpDir() + getShmemId(jobId, revision).substr(1);
+    }
+    std::string getClaimFile(int jobId, int revision) const {
+        return getFilePrefix(jobId, revision) + ".claim";
+    }
+    std::string getReadyFile(int jobId, int revision) const {
+        return getFilePrefix(jobId, revision) + ".ready";
+    }
+
+    // Atomically create the claim file including this process' PID.
+    bool tryCreateClaimFile(int jobId, int revision) {
+        const std::string claimFile = getClaimFile(jobId, revision);
+        const std::string tmpFile = claimFile + "." + std::to_string(Proc::getPid());
+        {
+            std::ofstream ofs(tmpFile);
+            ofs << Proc::getPid();
+        }
+        bool success = link(tmpFile.c_str(), claimFile.c_str()) == 0;
+        FileUtils::rm(tmpFile);
+        return success;
+    }
+
+    static long readNumber(const std::string& file) {
+        std::ifstream ifs(file);
+        long number;
+        if (!(ifs >> number)) return -1;
+        return number;
+    }
+};
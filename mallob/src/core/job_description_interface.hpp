@@ -6,8 +6,14 @@
 #include "util/hashing.hpp"
 #include "app/job.hpp"
 #include "job_registry.hpp"
+#include "host_description_store.hpp"
+#include "util/compression.hpp"
+#include "util/data_statistics.hpp"
 #include "util/logger.hpp"
+#include "util/params.hpp"
 #include "util/sys/thread_pool.hpp"
+#include "util/sys/threading.hpp"
+#include "util/sys/timer.hpp"
 #include "comm/msg_queue/message_subscription.hpp"
 
 class JobDescriptionInterface {
@@ -20,8 +26,69 @@ private:
 
     const bool _query_desc_skeleton_first;
 
+    // Cut-through forwarding: ranks waiting for a full revision which has not arrived yet,
+    // by (job ID, revision). The message queue relays a large incoming description to these
+    // ranks fragment by fragment; shared with the thread receiving messages.
+    struct RelayRoute {
+        std::vector<int> waitingRanks;
+        std::vector<int> relayedRanks;
+        float timeOfFirstFragment {-1};
+    };
+    const bool _cut_through;
+    Mutex _relay_mutex;
+    robin_hood::unordered_map<std::pair<int, int>, RelayRoute, IntPairHasher> _relay_routes;
+
+    // Compressed transfer: compressed full revisions by (job ID, revision), kept for further
+    // children so that each revision is compressed at most once (at the job's root).
+    const bool _compress;
+    robin_hood::unordered_map<std::pair<int, int>, std::shared_ptr<std::vector<uint8_t>>, IntPairHasher> _compressed_descs;
+    // Received compressed revisions which are being decompressed by the thread pool.
+    // Each is delivered like a received description as soon as it is done.
+    struct PendingDecompression {
+        int jobId;
+        int revision;
+        int source;
+        std::shared_ptr<std::vector<uint8_t>> compressed;
+        std::shared_ptr<std::vector<uint8_t>> data;
+        bool success {false};
+        std::atomic_bool done {false};
+        std::future<void> future;
+    };
+    std::list<PendingDecompression> _pending_decompressions;
+    std::shared_ptr<std::vector<uint8_t>> _delivered_compressed; // set while delivering a decompressed revision
+
+    // Host-level deduplication: full revisions which another process on this host
+    // is already fetching, to be copied from the host's shared memory instead.
+    std::unique_ptr<HostDescriptionStore> _host_store;
+    const float _host_dedup_wait;
+    struct HostQuery {
+        int jobId;
+        int revision;
+        int source;
+        float deadline;
+    };
+    std::list<HostQuery> _host_queries;
+    bool _delivering_from_host {false};
+
+    // Reporting: at a job's root, the arrival time of each revision by (job ID, revision)
+    // and the number of PEs which reported to have received it since then.
+    const bool _report_readiness;
+    robin_hood::unordered_map<std::pair<int, int>, std::pair<float, int>, IntPairHasher> _ready_reports;
+    std::vector<float> _ready_latencies;
+    struct TransferStats {
+        size_t bytesSent {0};
+        size_t rawBytesSent {0};
+        size_t bytesReceived {0};
+        size_t rawBytesReceived {0};
+        size_t numHostFetches {0};
+        size_t bytesFetchedFromHost {0};
+    } _stats;
+
 public:
-    JobDescriptionInterface(JobRegistry& jobRegistry, bool queryDescSkeletonFirst) : _job_registry(jobRegistry), _query_desc_skeleton_first(queryDescSkeletonFirst) {
+    JobDescriptionInterface(JobRegistry& jobRegistry, const Parameters& params) : 
+            _job_registry(jobRegistry), _query_desc_skeleton_first(params.aggressiveDescriptionCaching()),
+            _cut_through(params.descriptionCutThrough()), _compress(params.compressDescriptionTransfer()),
+            _host_dedup_wait(params.hostDescriptionDedupWait()), _report_readiness(params.reportDescriptionReadiness()) {
 
         _subscriptions.emplace_back(MSG_QUERY_JOB_DESCRIPTION,
             [&](auto& h) {handleQueryForJobDescription(h);});
@@ -30,9 +97,39 @@ public:
         _subscriptions.emplace_back(MSG_QUERY_JOB_DESCRIPTION_BY_PROXY,
             [&](auto& h) {handleProxyQueryForJobDescription(h);});
 
-        MyMpi::getMessageQueue().registerSentCallback(MSG_SEND_JOB_DESCRIPTION, [&](int sendId) {
-            handleJobDescriptionSent(sendId);
-        });
+        if (_report_readiness) _subscriptions.emplace_back(MSG_NOTIFY_DESCRIPTION_READY,
+            [&](auto& h) {handleDescriptionReady(h);});
+
+        for (int tag : {MSG_SEND_JOB_DESCRIPTION, MSG_SEND_JOB_DESCRIPTION_COMPRESSED}) {
+            MyMpi::getMessageQueue().registerSentCallback(tag, [&](int sendId) {
+                handleJobDescriptionSent(sendId);
+            });
+            if (_cut_through) MyMpi::getMessageQueue().registerRelayCallback(tag,
+                [&](int source, const uint8_t* data, size_t size) {
+                    return takeRelayDestinations(data, size);
+                });
+        }
+
+        if (_host_dedup_wait > 0 && MyMpi::getHostSize() > 1)
+            _host_store.reset(new HostDescriptionStore(MyMpi::getHostRunId()));
+    }
+    ~JobDescriptionInterface() {
+        for (auto& pending : _pending_decompressions) pending.future.get();
+        if (_cut_through) for (int tag : {MSG_SEND_JOB_DESCRIPTION, MSG_SEND_JOB_DESCRIPTION_COMPRESSED})
+            MyMpi::getMessageQueue().clearRelayCallback(tag);
+
+        if (_stats.rawBytesSent > 0 || _stats.rawBytesReceived > 0 || _stats.numHostFetches > 0) {
+            LOG(V3_VERB, "STATS desc_transfer sent:%lu sentraw:%lu received:%lu receivedraw:%lu hostfetches:%lu hostfetchedbytes:%lu\n",
+                _stats.bytesSent, _stats.rawBytesSent, _stats.bytesReceived, _stats.rawBytesReceived,
+                _stats.numHostFetches, _stats.bytesFetchedFromHost);
+        }
+        if (!_ready_latencies.empty()) {
+            // Report statistics on latencies from a revision's arrival at the root until its arrival at a PE
+            DataStatistics stats(std::move(_ready_latencies));
+            stats.computeStats();
+            LOG(V3_VERB, "STATS desc_ready_latencies num:%ld min:%.6f max:%.6f med:%.6f mean:%.6f\n", 
+                stats.num(), stats.min(), stats.max(), stats.median(), stats.mean());
+        }
     }
 
     void updateRevisionAndDescription(Job& job, int revision, int source) {
@@ -47,29 +144,122 @@ public:
             assert(missingRev >= 0);
             const int msgTag = job.getRevision() < missingRev && _query_desc_skeleton_first ?
                 MSG_QUERY_JOB_DESCRIPTION_SKELETON : MSG_QUERY_JOB_DESCRIPTION;
+            if (msgTag == MSG_QUERY_JOB_DESCRIPTION && deferToHostStore(job.getId(), missingRev, source))
+                return;
             MyMpi::isend(source, msgTag, IntPair(job.getId(), missingRev));
         }
     }
 
+    // Copies full revisions which were deferred to the host-level store as soon as they are
+    // published and delivers them like received descriptions. Gives up on a revision and
+    // queries it from the original source after a timeout or if its claim was withdrawn.
+    void fetchHostLocalDescriptions(const std::function<void(MessageHandle&)>& deliver) {
+        auto it = _host_queries.begin();
+        while (it != _host_queries.end()) {
+            auto q = *it;
+            if (!_job_registry.has(q.jobId) || hasFullRevision(_job_registry.get(q.jobId), q.revision)) {
+                it = _host_queries.erase(it);
+                continue;
+            }
+            auto data = _host_store->fetch(q.jobId, q.revision);
+            if (data) {
+                it = _host_queries.erase(it);
+                _stats.numHostFetches++;
+                _stats.bytesFetchedFromHost += data->size();
+                MessageHandle handle;
+                handle.tag = MSG_SEND_JOB_DESCRIPTION;
+                handle.source = q.source;
+                handle.setReceive(std::move(*data));
+                _delivering_from_host = true;
+                deliver(handle);
+                _delivering_from_host = false;
+                continue;
+            }
+            if (Timer::elapsedSeconds() >= q.deadline
+                    || _host_store->claim(q.jobId, q.revision) == HostDescriptionStore::CLAIMED) {
+                LOG(V4_VVER, "#%i rev. %i not available on host : query [%i]\n", q.jobId, q.revision, q.source);
+                it = _host_queries.erase(it);
+                MyMpi::isend(q.source, MSG_QUERY_JOB_DESCRIPTION, IntPair(q.jobId, q.revision));
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    // Delivers compressed revisions whose decompression by the thread pool is done
+    // like received (uncompressed) descriptions.
+    void fetchDecompressedDescriptions(const std::function<void(MessageHandle&)>& deliver) {
+        auto it = _pending_decompressions.begin();
+        while (it != _pending_decompressions.end()) {
+            auto& pending = *it;
+            if (!pending.done.load(std::memory_order_acquire)) {
+                ++it;
+                continue;
+            }
+            pending.future.get();
+            if (!pending.success) {
+                LOG(V1_WARN, "[WARN] #%i rev. %i : malformed compressed desc. of size %lu\n",
+                    pending.jobId, pending.revision, pending.compressed->size());
+                ProcessWideThreadPool::get().addTask([compressed = std::move(pending.compressed),
+                        data = std::move(pending.data)]() mutable {
+                    compressed.reset();
+                    data.reset();
+                });
+                it = _pending_decompressions.erase(it);
+                continue;
+            }
+            _stats.rawBytesReceived += pending.data->size();
+            MessageHandle handle;
+            handle.tag = MSG_SEND_JOB_DESCRIPTION;
+            handle.source = pending.source;
+            handle.setReceive(std::move(*pending.data));
+            _delivered_compressed = std::move(pending.compressed);
+            it = _pending_decompressions.erase(it);
+            deliver(handle);
+            _delivered_compressed.reset();
+        }
+    }
+
     bool handleIncomingJobDescription(MessageHandle& handle, int& outJobId) {
 
         const auto& data = handle.getRecvData();
         outJobId = data.size() >= sizeof(int) ? Serializable::get<int>(data) : -1;
         LOG_ADD_SRC(V4_VVER, "Got desc. of size %lu for job #%i", handle.source, data.size(), outJobId);
+        const bool compressed = handle.tag == MSG_SEND_JOB_DESCRIPTION_COMPRESSED;
+        const bool fullDesc = (handle.tag == MSG_SEND_JOB_DESCRIPTION || handle.tag == MSG_DEPLOY_NEW_REVISION
+            || compressed) && data.size() >= 3*sizeof(int)+2*sizeof(size_t);
+        const int revision = fullDesc ? JobDescription::readRevisionIndex(data) : -1;
+        if (_cut_through && fullDesc && handle.tag != MSG_DEPLOY_NEW_REVISION)
+            concludeRelayRoute(outJobId, revision, data.size(), handle.source);
+
+        if (compressed) {
+            // Decompressing a large description takes too much time in the main thread
+            deferDecompression(handle, outJobId, revision);
+            return false;
+        }
+        // A compressed revision being delivered after its decompression
+        std::shared_ptr<std::vector<uint8_t>> compressedPtr = std::move(_delivered_compressed);
+        std::shared_ptr<std::vector<uint8_t>> dataPtr(new std::vector<uint8_t>(handle.moveRecvData()));
+        if (!_delivering_from_host && !compressedPtr) {
+            _stats.bytesReceived += dataPtr->size();
+            _stats.rawBytesReceived += dataPtr->size();
+        }
 
-        auto dataPtr = std::shared_ptr<std::vector<uint8_t>>(
-            new std::vector<uint8_t>(handle.moveRecvData())
-        );
         bool valid = _job_registry.has(outJobId) && 
             appendRevision(_job_registry.get(outJobId), dataPtr, handle.source);
         if (!valid) {
-            // Need to clean up shared pointer concurrently 
+            // Need to clean up shared pointers concurrently 
             // because it might take too much time in the main thread
-            ProcessWideThreadPool::get().addTask([sharedPtr = std::move(dataPtr)]() mutable {
+            ProcessWideThreadPool::get().addTask([sharedPtr = std::move(dataPtr), 
+                    compressedSharedPtr = std::move(compressedPtr)]() mutable {
                 sharedPtr.reset();
+                compressedSharedPtr.reset();
             });
             return false;
         }
+        // Keep the compressed revision for forwarding it to children
+        if (compressedPtr && _compress) _compressed_descs[{outJobId, revision}] = std::move(compressedPtr);
+        if (fullDesc) handleFullRevisionArrived(_job_registry.get(outJobId), revision, dataPtr);
         return true;
     }
 
@@ -93,8 +283,167 @@ public:
         }
     }
 
+    // Drop all transfer-related state concerning the given job.
+    void forget(int jobId) {
+        if (_cut_through) {
+            auto lock = _relay_mutex.getLock();
+            eraseKeysOfJob(_relay_routes, jobId);
+        }
+        eraseKeysOfJob(_compressed_descs, jobId);
+        eraseKeysOfJob(_ready_reports, jobId);
+        if (_host_store) {
+            _host_queries.remove_if([&](const HostQuery& q) {return q.jobId == jobId;});
+            _host_store->release(jobId);
+        }
+    }
+
 private:
 
+    template <typename Map>
+    static void eraseKeysOfJob(Map& map, int jobId) {
+        std::vector<std::pair<int, int>> keys;
+        for (auto& [key, val] : map) if (key.first == jobId) keys.push_back(key);
+        for (auto& key : keys) map.erase(key);
+    }
+
+    bool hasFullRevision(Job& job, int revision) {
+        return job.hasDescription() && job.getRevision() >= revision
+            && !job.getDescription().isRevisionIncomplete(revision);
+    }
+
+    // Returns true iff the given full revision should be awaited from the host-level store.
+    bool deferToHostStore(int jobId, int revision, int source) {
+        if (!_host_store) return false;
+        for (auto& q : _host_queries) if (q.jobId == jobId && q.revision == revision) return true;
+        if (_host_store->claim(jobId, revision) == HostDescriptionStore::CLAIMED) return false;
+        LOG(V4_VVER, "#%i rev. %i: await desc. on host\n", jobId, revision);
+        _host_queries.push_back({jobId, revision, source, Timer::elapsedSeconds() + _host_dedup_wait});
+        return true;
+    }
+
+    void handleFullRevisionArrived(Job& job, int revision, const std::shared_ptr<std::vector<uint8_t>>& data) {
+        if (_host_store && _host_store->hasClaimed(job.getId(), revision))
+            _host_store->publish(job.getId(), revision, data);
+        if (!_report_readiness) return;
+        if (job.getJobTree().isRoot()) {
+            _ready_reports[{job.getId(), revision}] = {Timer::elapsedSeconds(), 1};
+        } else {
+            MyMpi::isend(job.getJobTree().getRootNodeRank(), MSG_NOTIFY_DESCRIPTION_READY,
+                IntPair(job.getId(), revision));
+        }
+    }
+
+    void handleDescriptionReady(MessageHandle& handle) {
+        IntPair pair = Serializable::get<IntPair>(handle.getRecvData());
+        auto it = _ready_reports.find({pair.first, pair.second});
+        if (it == _ready_reports.end()) return;
+        auto& [time, numReady] = it->second;
+        numReady++;
+        const float latency = Timer::elapsedSeconds() - time;
+        _ready_latencies.push_back(latency);
+        LOG_ADD_SRC(V4_VVER, "#%i rev. %i ready after %.4fs (%i PEs)", handle.source,
+            pair.first, pair.second, latency, numReady);
+        if (_job_registry.has(pair.first) && numReady == _job_registry.get(pair.first).getVolume()) {
+            LOG(V3_VERB, "#%i rev. %i: all %i PEs ready after %.4fs\n", pair.first, pair.second, numReady, latency);
+        }
+    }
+
+    // Serializes a full revision as [meta data][compressed payload][size_t meta size][size_t #payload ints].
+    const std::shared_ptr<std::vector<uint8_t>>& getCompressedDescription(Job& job, int revision) {
+        auto& compressed = _compressed_descs[{job.getId(), revision}];
+        if (compressed) return compressed;
+        const auto& data = *job.getDescription().getRevisionData(revision);
+        const size_t metaSize = (const uint8_t*) job.getDescription().getFormulaPayload(revision) - data.data();
+        const size_t numInts = (data.size() - metaSize) / sizeof(int);
+        float time = Timer::elapsedSeconds();
+        compressed.reset(new std::vector<uint8_t>(data.begin(), data.begin()+metaSize));
+        compressIntStream((const int*) (data.data()+metaSize), numInts, *compressed);
+        compressed->resize(compressed->size() + 2*sizeof(size_t));
+        memcpy(compressed->data()+compressed->size()-2*sizeof(size_t), &metaSize, sizeof(size_t));
+        memcpy(compressed->data()+compressed->size()-sizeof(size_t), &numInts, sizeof(size_t));
+        LOG(V4_VVER, "%s rev. %i: compressed desc. of size %lu to %lu (%.4fs)\n", job.toStr(), revision,
+            data.size(), compressed->size(), Timer::elapsedSeconds() - time);
+        return compressed;
+    }
+
+    void deferDecompression(MessageHandle& handle, int jobId, int revision) {
+        _stats.bytesReceived += handle.getRecvData().size();
+        _pending_decompressions.emplace_back();
+        auto& pending = _pending_decompressions.back();
+        pending.jobId = jobId;
+        pending.revision = revision;
+        pending.source = handle.source;
+        pending.compressed.reset(new std::vector<uint8_t>(handle.moveRecvData()));
+        pending.data.reset(new std::vector<uint8_t>());
+        pending.future = ProcessWideThreadPool::get().addTask([&pending]() {
+            pending.success = decompressDescription(*pending.compressed, *pending.data);
+            pending.done.store(true, std::memory_order_release);
+        });
+    }
+
+    static bool decompressDescription(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+        if (in.size() < 2*sizeof(size_t)) return false;
+        size_t metaSize, numInts;
+        memcpy(&metaSize, in.data()+in.size()-2*sizeof(size_t), sizeof(size_t));
+        memcpy(&numInts, in.data()+in.size()-sizeof(size_t), sizeof(size_t));
+        const size_t payloadSize = in.size() - 2*sizeof(size_t);
+        // Each integer is encoded by at least one byte
+        if (metaSize > payloadSize || numInts > payloadSize - metaSize) return false;
+        out.resize(metaSize + numInts*sizeof(int));
+        memcpy(out.data(), in.data(), metaSize);
+        return decompressIntStream(in.data()+metaSize, payloadSize-metaSize, (int*) (out.data()+metaSize), numInts);
+    }
+
+    void addRelayRoute(int jobId, int revision, int rank) {
+        if (!_cut_through) return;
+        auto lock = _relay_mutex.getLock();
+        auto& ranks = _relay_routes[{jobId, revision}].waitingRanks;
+        if (std::find(ranks.begin(), ranks.end(), rank) == ranks.end()) ranks.push_back(rank);
+    }
+
+    // Called by the message queue upon the first fragment of a large job description
+    std::vector<int> takeRelayDestinations(const uint8_t* data, size_t size) {
+        // The description begins with the job ID and the revision
+        if (size < 2*sizeof(int)) return {};
+        int jobId, revision;
+        memcpy(&jobId, data, sizeof(int));
+        memcpy(&revision, data+sizeof(int), sizeof(int));
+        auto lock = _relay_mutex.getLock();
+        auto& route = _relay_routes[{jobId, revision}];
+        route.timeOfFirstFragment = Timer::elapsedSeconds();
+        auto dests = std::move(route.waitingRanks);
+        route.waitingRanks.clear();
+        route.relayedRanks.insert(route.relayedRanks.end(), dests.begin(), dests.end());
+        return dests;
+    }
+
+    // Called once a full description has arrived: the ranks to which it has been relayed
+    // do not wait for it anymore. Logs the arrival time at this level of the job tree.
+    void concludeRelayRoute(int jobId, int revision, size_t size, int source) {
+        RelayRoute route;
+        {
+            auto lock = _relay_mutex.getLock();
+            auto it = _relay_routes.find({jobId, revision});
+            if (it == _relay_routes.end()) return;
+            route = std::move(it->second);
+            _relay_routes.erase(it);
+        }
+        if (!_job_registry.has(jobId)) return;
+        Job& job = _job_registry.get(jobId);
+        auto& waitingChildren = job.getChildrenWaitingForDescription();
+        for (int rank : route.relayedRanks) {
+            waitingChildren.erase({rank, revision, false, true});
+            waitingChildren.erase({rank, revision, false, false});
+        }
+        if (route.timeOfFirstFragment < 0) return; // not fragmented
+        const int index = job.getJobTree().getIndex();
+        int depth = 0;
+        while ((1 << (depth+1)) <= index+1) depth++;
+        LOG_ADD_SRC(V3_VERB, "%s rev. %i: desc. of size %lu arrived at depth %i, %.4fs after its first fragment, relayed to %lu PEs",
+            source, job.toStr(), revision, size, depth, Timer::elapsedSeconds() - route.timeOfFirstFragment,
+            route.relayedRanks.size());
+    }
+
     void send(Job& job, int revision, int dest, bool sendSkeletonOnly) {
         // Retrieve and send concerned job description
         if (sendSkeletonOnly) {
@@ -110,7 +459,16 @@ private:
                     ((const uint8_t*)job.getDescription().getFormulaPayload(revision) - job.getDescription().getRevisionData(revision)->data()));
             assert(descPtr->size() == job.getDescription().getTransferSize(revision) 
                 || LOG_RETURN_FALSE("%i != %i\n", descPtr->size(), job.getDescription().getTransferSize(revision)));
-            int sendId = MyMpi::isend(dest, MSG_SEND_JOB_DESCRIPTION, descPtr);
+            int sendId;
+            if (_compress) {
+                const auto& compressed = getCompressedDescription(job, revision);
+                sendId = MyMpi::isend(dest, MSG_SEND_JOB_DESCRIPTION_COMPRESSED, compressed);
+                _stats.bytesSent += compressed->size();
+            } else {
+                sendId = MyMpi::isend(dest, MSG_SEND_JOB_DESCRIPTION, descPtr);
+                _stats.bytesSent += descPtr->size();
+            }
+            _stats.rawBytesSent += descPtr->size();
             job.getJobTree().addSendHandle(dest, sendId);
             _send_id_to_job_id[sendId] = job.getId();
             LOG_ADD_DEST(V4_VVER, "Sent id=%i", dest, sendId);
@@ -188,6 +546,7 @@ private:
         Job& job = _job_registry.get(jobId);
         if (job.getRevision() < revision) {
             job.addChildWaitingForRevision(requestingRank, revision, false, false);
+            addRelayRoute(jobId, revision, requestingRank);
             return;
         }
 
@@ -197,6 +556,7 @@ private:
             MyMpi::isend(job.getJobTree().getParentNodeRank(), MSG_QUERY_JOB_DESCRIPTION_BY_PROXY, IntVec{jobId, revision, handle.source});
         } else {
             job.addChildWaitingForRevision(requestingRank, revision, false, false);
+            addRelayRoute(jobId, revision, requestingRank);
         }
     }
 };
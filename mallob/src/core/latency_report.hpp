@@ -8,9 +8,19 @@ class LatencyReport {
 
 private:
     std::list<std::vector<float>> _desire_latencies;
+    std::vector<float> _submission_latencies;
 
 public:
     ~LatencyReport() {
+        if (!_submission_latencies.empty()) {
+            // Report statistics on latencies from submission to the start of a job's root
+            DataStatistics stats(std::move(_submission_latencies));
+            stats.computeStats();
+            LOG(V3_VERB, "STATS submission_latencies num:%ld min:%.6f max:%.6f med:%.6f mean:%.6f\n", 
+                stats.num(), stats.min(), stats.max(), stats.median(), stats.mean());
+            stats.logFullDataIntoFile(".submission-latencies");
+        }
+
         if (_desire_latencies.empty()) return;
         
         // Report statistics on treegrowth ("desire") latencies
@@ -22,6 +32,14 @@ public:
     }
 
     void report(Job& job) {
+        // Latency from the job's submission until its root node started solving
+        float submissionLatency = job.getJobTree().isRoot() ? job.getSubmissionLatency() : -1;
+        if (submissionLatency >= 0) {
+            LOG(V3_VERB, "%s submission latency %.5f\n", job.toStr(), submissionLatency);
+            _submission_latencies.push_back(submissionLatency);
+        }
+
+
         // Gather statistics
         auto numDesires = job.getJobTree().getNumDesires();
         auto numFulfilledDesires = job.getJobTree().getNumFulfiledDesires();
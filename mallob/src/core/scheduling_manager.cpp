@@ -45,7 +45,7 @@ SchedulingManager::SchedulingManager(Parameters& params, MPI_Comm& comm,
         _sys_state(sysstate), _job_registry(jobRegistry),
         _req_matcher(createRequestMatcher()),
         _req_mgr(_params, _sys_state, _routing_tree, _req_matcher.get()),
-        _balancer(_comm, _params), _desc_interface(_job_registry, _params.aggressiveDescriptionCaching()),
+        _balancer(_comm, _params), _desc_interface(_job_registry, _params),
         _reactivation_scheduler(_params, _job_registry,
             // Callback for emitting a job request
             [&](JobRequest& req, int tag, bool left, int dest) {
@@ -122,6 +122,8 @@ SchedulingManager::SchedulingManager(Parameters& params, MPI_Comm& comm,
         [&](auto& h) {handleApplicationMessage(h);});
     _subscriptions.emplace_back(MSG_SEND_JOB_DESCRIPTION, 
         [&](auto& h) {handleIncomingJobDescription(h, false);});
+    _subscriptions.emplace_back(MSG_SEND_JOB_DESCRIPTION_COMPRESSED, 
+        [&](auto& h) {handleIncomingJobDescription(h, false);});
     _subscriptions.emplace_back(MSG_SEND_JOB_DESCRIPTION_SKELETON, 
         [&](auto& h) {handleIncomingJobDescription(h, false);});
     _subscriptions.emplace_back(MSG_DEPLOY_NEW_REVISION,
@@ -270,6 +272,14 @@ void SchedulingManager::checkSuspendedJobs() {
     }
 }
 
+void SchedulingManager::checkDeferredDescriptions() {
+    auto deliver = [&](MessageHandle& h) {
+        handleIncomingJobDescription(h, false);
+    };
+    _desc_interface.fetchHostLocalDescriptions(deliver);
+    _desc_interface.fetchDecompressedDescriptions(deliver);
+}
+
 void SchedulingManager::checkOldJobs() {
     _job_registry.checkOldJobs();
 }
@@ -1263,6 +1273,7 @@ void SchedulingManager::forgetOldJobs() {
 
 void SchedulingManager::eraseJobAndQueueForDeletion(Job& job) {
     LOG(V4_VVER, "FORGET %s\n", job.toStr());
+    _desc_interface.forget(job.getId());
     if (job.getState() != PAST) job.terminate();
     assert(job.getState() == PAST);
     _job_registry.erase(&job);
@@ -60,6 +60,7 @@ public:
 
     void checkActiveJob();
     void checkSuspendedJobs();
+    void checkDeferredDescriptions();
     void checkOldJobs();
 
     void advanceBalancing();
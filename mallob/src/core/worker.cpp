@@ -34,6 +34,7 @@ Worker::Worker(MPI_Comm comm, Parameters& params) :
 {
     _watchdog.setWarningPeriod(50); // warn after 50ms without a reset
     _watchdog.setAbortPeriod(_params.watchdogAbortMillis()); // abort after X ms without a reset
+    SharedMemoryCache::setRetentionCap(1024UL * 1024UL * _params.shmemCacheCap());
 }
 
 void Worker::init() {
@@ -41,6 +42,19 @@ void Worker::init() {
     // Write tag of currently handled message into watchdog
     MyMpi::getMessageQueue().setCurrentTagPointers(_watchdog.activityRecvTag(), _watchdog.activitySendTag());
 
+    // Let the watchdog measure how long received messages wait for the main loop
+    if (MyMpi::getMessageQueue().hasProgressThread()) {
+        _watchdog.setMessageLatencyProbe([]() {
+            auto stats = MyMpi::getMessageQueue().extractHandoffStats();
+            Watchdog::MessageLatency latency;
+            latency.numHandled = stats.numMessages;
+            latency.numPending = stats.numPending;
+            latency.avgSeconds = stats.avgLatency;
+            latency.maxSeconds = stats.maxLatency;
+            return latency;
+        });
+    }
+
     // Send warm-up messages
     if (_params.warmup()) {
         MessageWarmup(_comm, _routing_tree.getNeighbors()).performWarmup();
@@ -181,6 +195,7 @@ void Worker::checkJobs() {
         checkActiveJob();
     }
     _sched_man.checkSuspendedJobs();
+    _sched_man.checkDeferredDescriptions();
     _sched_man.checkOldJobs();
 }
 
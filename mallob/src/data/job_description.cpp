@@ -53,6 +53,7 @@ void JobDescription::writeMetadata() {
     n = sizeof(int);         memcpy(data->data()+i, &_description_id, n); i += n;
     n = sizeof(int);         memcpy(data->data()+i, &_first_balancing_epoch, n); i += n;
     n = sizeof(Checksum);    memcpy(data->data()+i, &_checksum, n); i += n;
+    n = sizeof(float);       memcpy(data->data()+i, &_time_since_submission, n); i += n;
 
     auto configSerialized = _app_config.serialize();
     n = configSerialized.size();
@@ -123,7 +124,7 @@ size_t JobDescription::getTransferSize(int revision) const {
 int JobDescription::getMetadataSize() const {
     return 10*sizeof(int)
            +2*sizeof(size_t)
-           +3*sizeof(float)
+           +4*sizeof(float)
            +sizeof(bool)
            +sizeof(Checksum)
            +sizeof(int)+_app_config.getSerializedSize();
@@ -189,6 +190,7 @@ void JobDescription::deserialize() {
     n = sizeof(int);         memcpy(&_description_id, latestData->data()+i, n);  i += n;
     n = sizeof(int);   memcpy(&_first_balancing_epoch, latestData->data()+i, n); i += n;
     n = sizeof(Checksum);    memcpy(&_checksum, latestData->data()+i, n);        i += n;
+    n = sizeof(float);       memcpy(&_time_since_submission, latestData->data()+i, n); i += n;
     // size of config
     memcpy(&n, latestData->data()+i, sizeof(int)); i += sizeof(int);
     // bytes of config
@@ -45,6 +45,8 @@ private:
     const bool _use_checksums = false;
 
     float _arrival; // only for introducing a job
+    // Seconds from the job's submission until the client sent this revision's description
+    float _time_since_submission {0};
 
     // configuration options
     AppConfiguration _app_config;
@@ -110,6 +112,7 @@ public:
         _application_id = std::move(other._application_id);
         _checksum = std::move(other._checksum);
         _arrival = std::move(other._arrival);
+        _time_since_submission = std::move(other._time_since_submission);
         _app_config = std::move(other._app_config);
         _num_vars = std::move(other._num_vars);
         _f_size = std::move(other._f_size);
@@ -148,6 +151,24 @@ public:
         _f_size++;
         if (_use_checksums) _checksum.combine(data);
     }
+    inline void addPermanentData(const int* lits, size_t size) {
+        // Append a block of literals at once
+        auto& data = _data_per_revision[_revision];
+        const size_t offset = data->size();
+        data->resize(offset + size*sizeof(int));
+        memcpy(data->data()+offset, lits, size*sizeof(int));
+        _f_size += size;
+        if (_use_checksums) for (size_t i = 0; i < size; i++) _checksum.combine(lits[i]);
+    }
+    inline void addPermanentData(const float* values, size_t size) {
+        // Append a block of floats at once
+        auto& data = _data_per_revision[_revision];
+        const size_t offset = data->size();
+        data->resize(offset + size*sizeof(float));
+        memcpy(data->data()+offset, values, size*sizeof(float));
+        _f_size += size;
+        if (_use_checksums) for (size_t i = 0; i < size; i++) _checksum.combine(values[i]);
+    }
     inline void addTransientData(int lit) {
         // Push literal to raw data, update counter
         push_obj<int>(_data_per_revision[_revision], lit);
@@ -189,6 +210,7 @@ public:
     bool isIncremental() const {return _incremental;}
     int getGroupId() const {return _group_id;}
     int getFirstBalancingEpoch() const {return _first_balancing_epoch;}
+    float getTimeSinceSubmission() const {return _time_since_submission;}
     int getMetadataSize() const;
     
     size_t getFullNonincrementalTransferSize() const {return _data_per_revision[0]->size();}
@@ -212,6 +234,10 @@ public:
         _first_balancing_epoch = nb;
         writeMetadata();
     }
+    void setTimeSinceSubmission(float time) {
+        _time_since_submission = time;
+        writeMetadata();
+    }
 
     Checksum getChecksum() const {return _checksum;}
     void setChecksum(const Checksum& checksum) {_checksum = checksum;}
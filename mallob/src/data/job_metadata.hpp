@@ -7,6 +7,7 @@
 #include <memory>
 
 #include "data/job_description.hpp"
+#include "data/literal_stream.hpp"
 
 struct JobMetadata {
 
@@ -14,6 +15,10 @@ struct JobMetadata {
     std::unique_ptr<JobDescription> description;
     std::vector<std::string> files;
     std::vector<int> dependencies;
+    // Formula literals which are still arriving (instead of files to read)
+    std::shared_ptr<LiteralStream> literalStream;
+    // The description was already initialized by the submitter: nothing to read
+    bool initialized = false;
     bool done = false;
     bool interrupt = false;
     
@@ -25,7 +30,8 @@ struct JobMetadata {
         description(std::move(other.description)), 
         files(std::move(other.files)), 
         dependencies(std::move(other.dependencies)),
-        done(other.done), interrupt(other.interrupt) {}
+        literalStream(std::move(other.literalStream)),
+        initialized(other.initialized), done(other.done), interrupt(other.interrupt) {}
     
     JobMetadata& operator=(JobMetadata&& other) {
         *this = JobMetadata(std::move(other));
@@ -46,6 +52,9 @@ struct JobMetadata {
     bool hasFiles() const {
         return !files.empty();
     }
+    bool hasLiteralStream() const {
+        return (bool) literalStream;
+    }
 
     std::string getFilesList() const {
         std::string list = "{";
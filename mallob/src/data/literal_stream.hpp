@@ -0,0 +1,119 @@
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <vector>
+#include <atomic>
+
+#include "util/sys/threading.hpp"
+#include "util/sys/timer.hpp"
+
+/*
+Formula literals of a job which arrive incrementally over an external interface
+(e.g., an IPC socket connection) while the job is already being parsed and scheduled.
+The producer (the connection) pushes chunks of literals, the consumer (the client's
+job reader) pops them and appends them to the job description.
+Flow control is credit-based: the producer may only push as many bytes as it has been
+granted so far. Initially, a full window is granted; whenever the consumer has digested
+a quarter of the window, the digested amount is granted anew via the provided callback.
+*/
+class LiteralStream {
+
+public:
+    enum State {OPEN, COMPLETE, FAILED};
+    enum PopResult {CHUNK, END, TIMEOUT};
+
+private:
+    const size_t _window;
+    std::function<void(size_t)> _grant_credit;
+
+    Mutex _mtx;
+    ConditionVariable _cond_var;
+    std::list<std::vector<int>> _chunks;
+    State _state {OPEN};
+    size_t _credit; // bytes which the producer may still push
+    size_t _undeclared_credit {0}; // digested bytes not yet granted anew
+    size_t _nb_literals {0};
+    float _time_of_end {-1};
+
+    // Set by the consumer as soon as the job description is complete
+    std::atomic_bool _parsed {false};
+    std::atomic_bool _valid {false};
+
+public:
+    LiteralStream(size_t window, std::function<void(size_t)> grantCredit) :
+        _window(window), _grant_credit(grantCredit), _credit(window) {}
+
+    size_t getWindow() const {return _window;}
+
+    // Producer side: returns false if the chunk exceeds the granted credit
+    // or if the stream has been concluded already.
+    bool push(std::vector<int>&& chunk) {
+        {
+            auto lock = _mtx.getLock();
+            const size_t bytes = chunk.size() * sizeof(int);
+            if (_state != OPEN || bytes > _credit) return false;
+            _credit -= bytes;
+            _nb_literals += chunk.size();
+            _chunks.push_back(std::move(chunk));
+        }
+        _cond_var.notify();
+        return true;
+    }
+    // Producer side: no more literals will be pushed. Only the first call has an effect.
+    void conclude(bool success) {
+        {
+            auto lock = _mtx.getLock();
+            if (_state != OPEN) return;
+            _state = success ? COMPLETE : FAILED;
+            _time_of_end = Timer::elapsedSeconds();
+        }
+        _cond_var.notify();
+    }
+
+    // Consumer side: moves the next chunk into out (CHUNK), reports that all chunks
+    // have been popped and the stream is concluded (END), or gives up after the timeout.
+    PopResult pop(std::vector<int>& out, int timeoutMillis) {
+        size_t grant = 0;
+        {
+            auto lock = _mtx.getLock();
+            _cond_var.waitWithLockedMutexFor(lock, timeoutMillis, [&]() {
+                return !_chunks.empty() || _state != OPEN;
+            });
+            if (_chunks.empty()) return _state == OPEN ? TIMEOUT : END;
+            out = std::move(_chunks.front());
+            _chunks.pop_front();
+            _undeclared_credit += out.size() * sizeof(int);
+            if (_state == OPEN && _undeclared_credit >= _window/4) {
+                grant = _undeclared_credit;
+                _credit += grant;
+                _undeclared_credit = 0;
+            }
+        }
+        if (grant > 0 && _grant_credit) _grant_credit(grant);
+        return CHUNK;
+    }
+
+    State getState() {
+        auto lock = _mtx.getLock();
+        return _state;
+    }
+    size_t getNbLiterals() {
+        auto lock = _mtx.getLock();
+        return _nb_literals;
+    }
+    float getTimeOfEnd() {
+        auto lock = _mtx.getLock();
+        return _time_of_end;
+    }
+
+    // Consumer side: the job description is complete. valid is false if the stream
+    // was aborted or its literals did not form a proper formula.
+    void setParsed(bool valid) {
+        _valid.store(valid, std::memory_order_relaxed);
+        _parsed.store(true, std::memory_order_release);
+    }
+    bool isParsed() const {return _parsed.load(std::memory_order_acquire);}
+    bool isValid() const {return isParsed() && _valid.load(std::memory_order_relaxed);}
+};
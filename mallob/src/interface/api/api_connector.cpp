@@ -21,4 +21,9 @@ std::promise<nlohmann::json> APIConnector::processAsync(nlohmann::json& input) {
 
 JsonInterface::Result APIConnector::submit(nlohmann::json& data, std::function<void(nlohmann::json&)> callback) {
     return _interface.handle(data, callback);
-}
\ No newline at end of file
+}
+
+JsonInterface::Result APIConnector::submitBinary(JsonInterface::BinarySubmission& submission,
+        std::function<void(const std::vector<uint8_t>&)> callback) {
+    return _interface.handleBinary(submission, callback);
+}
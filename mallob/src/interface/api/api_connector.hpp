@@ -33,6 +33,14 @@ public:
     and _may_ later call `callback(nlohmann::json& response)` to return a response JSON.
     */
     JsonInterface::Result submit(nlohmann::json& data, std::function<void(nlohmann::json&)> callback = CALLBACK_IGNORE);
+
+    /*
+    Submits a job (revision) without any JSON (see JsonInterface::BinarySubmission), immediately
+    returns the status of processing it, and later calls `callback(const std::vector<uint8_t>& record)`
+    with the job's result as a binary ResultRecord.
+    */
+    JsonInterface::Result submitBinary(JsonInterface::BinarySubmission& submission,
+        std::function<void(const std::vector<uint8_t>&)> callback);
     
     /*
     Submits a kind of JSON request which requires a JSON response. Processes the request,
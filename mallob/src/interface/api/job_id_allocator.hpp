@@ -11,6 +11,8 @@ private:
     int _num_clients;
     int _running_id {0};
     std::string _id_file;
+    int _last_id {-1};
+    bool _deferred {false};
 
 public:
     JobIdAllocator() {}
@@ -41,14 +43,34 @@ public:
     int getNext() {
         int nextId = _running_id;
         _running_id += _num_clients;
-        {
-            std::ofstream ofs(_id_file);
-            if (ofs.is_open()) ofs << nextId;
-        }
+        _last_id = nextId;
+        if (!_deferred) writeLastId();
         return nextId;
     }
 
+    // Within a batch of submissions, the last used ID is only written once at the end.
+    void beginBatch() {
+        _deferred = true;
+    }
+    void endBatch() {
+        _deferred = false;
+        if (_last_id != -1) writeLastId();
+    }
+    // Scope of a batch of submissions which ends the batch in any case (also on exceptions).
+    struct BatchScope {
+        JobIdAllocator& allocator;
+        BatchScope(JobIdAllocator& allocator) : allocator(allocator) {allocator.beginBatch();}
+        ~BatchScope() {allocator.endBatch();}
+    };
+
+
     int getNbClients() const {
         return _num_clients;
     }
+
+private:
+    void writeLastId() {
+        std::ofstream ofs(_id_file);
+        if (ofs.is_open()) ofs << _last_id;
+    }
 };
@@ -6,6 +6,7 @@
 
 #include "interface/connector.hpp"
 #include "interface/json_interface.hpp"
+#include "interface/result_record.hpp"
 #include "util/sys/file_watcher.hpp"
 
 class InotifyFilesystemConnector : public Connector {
@@ -15,6 +16,10 @@ private:
     const Parameters& _params;
     Logger _logger;
 
+    // Binary results of batch submissions with "result-stream": "binary"
+    // (declared before the watcher, which may report files right away)
+    ResultRecordFile _result_stream;
+
     FileWatcher _watcher;
 
     std::string _base_path;
@@ -23,6 +28,7 @@ public:
 
     InotifyFilesystemConnector(JsonInterface& interface, const Parameters& params, Logger&& logger, const std::string& basePath) :
         _interface(interface), _params(params), _logger(std::move(logger)),
+        _result_stream(basePath + "/out/results.bin"),
         _watcher(basePath + "/in/", (int) (IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE), 
             [&](const FileWatcher::Event& event, Logger& log) {
                 // Receiving a certain file event
@@ -86,6 +92,14 @@ public:
             };
 
             // Handle JSON file
+            if (JsonInterface::isBatch(j)) {
+                // Many jobs in a single file; their results may be appended to the binary result stream
+                _interface.handleBatch(j, cb, [&](const std::vector<uint8_t>& record) {
+                    _result_stream.append(record);
+                });
+                FileUtils::rm(eventFile);
+                return;
+            }
             auto res = _interface.handle(j, cb);
             // TODO handle res
 
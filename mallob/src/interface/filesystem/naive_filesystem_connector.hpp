@@ -7,6 +7,7 @@
 
 #include "interface/connector.hpp"
 #include "interface/json_interface.hpp"
+#include "interface/result_record.hpp"
 #include "util/sys/file_watcher.hpp"
 
 class NaiveFilesystemConnector : public Connector {
@@ -17,6 +18,8 @@ private:
     Logger _logger;
 
     std::string _base_path;
+    // Binary results of batch submissions with "result-stream": "binary"
+    ResultRecordFile _result_stream;
 
     Logger _watch_logger;
     BackgroundWorker _watch_worker;
@@ -25,7 +28,7 @@ public:
 
     NaiveFilesystemConnector(JsonInterface& interface, const Parameters& params, Logger&& logger, const std::string& basePath) :
         _interface(interface), _params(params), _logger(std::move(logger)), _base_path(basePath),
-        _watch_logger(_logger.copy("T", ".watcher")) {
+        _result_stream(basePath + "/out/results.bin"), _watch_logger(_logger.copy("T", ".watcher")) {
 
         FileUtils::mkdir(_base_path + "/in/");
         FileUtils::mkdir(_base_path + "/out/");
@@ -71,6 +74,14 @@ public:
             };
 
             // Handle JSON file
+            if (JsonInterface::isBatch(j)) {
+                // Many jobs in a single file; their results may be appended to the binary result stream
+                _interface.handleBatch(j, cb, [&](const std::vector<uint8_t>& record) {
+                    _result_stream.append(record);
+                });
+                FileUtils::rm(eventFile);
+                return;
+            }
             auto res = _interface.handle(j, cb);
             // TODO handle res
 
@@ -24,157 +24,328 @@
 #include "data/job_metadata.hpp"
 #include "data/job_result.hpp"
 #include "interface/api/job_id_allocator.hpp"
+#include "interface/result_record.hpp"
 #include "optionslist.hpp"
 #include "util/option.hpp"
 #include "util/sys/timer.hpp"
 
 JsonInterface::Result JsonInterface::handle(nlohmann::json& inputJson, 
-    std::function<void(nlohmann::json&)> feedback) {
+    std::function<void(nlohmann::json&)> feedback, std::shared_ptr<LiteralStream> literalStream) {
 
     if (!_active || Terminator::isTerminating()) return DISCARD;
 
-    std::string userFile, jobName;
-    int id;
-    float userPrio, arrival, priority;
-    int applicationId;
-    bool incremental;
-    JobImage* img = nullptr;
+    Submission sub;
+    Result result;
+    {
+        auto lock = _job_map_mutex.getLock();
+        result = registerSubmission(inputJson, feedback, {}, std::move(literalStream), sub);
+    }
+    if (sub.img) introduceSubmission(sub);
+    return result;
+}
+
+std::vector<JsonInterface::Result> JsonInterface::handleBatch(nlohmann::json& inputJson, 
+    std::function<void(nlohmann::json&)> feedback, std::function<void(const std::vector<uint8_t>&)> binaryFeedback) {
+
+    auto& batch = inputJson["batch"];
+    if (!batch.is_array()) {
+        LOGGER(_logger, V1_WARN, "[WARN] Rejecting batch submission - reason: \"batch\" is not an array.\n");
+        return {};
+    }
+    std::vector<Result> results(batch.size(), DISCARD);
+    if (!_active || Terminator::isTerminating()) return results;
+
+    const bool binary = inputJson.contains("result-stream")
+        && inputJson["result-stream"].is_string()
+        && inputJson["result-stream"].get<std::string>() == "binary";
+    if (binary && !binaryFeedback) {
+        LOGGER(_logger, V1_WARN, "[WARN] Rejecting batch submission - reason: Binary result stream not supported by this interface.\n");
+        return results;
+    }
+
+    // Register all jobs at once, then introduce them to the client
+    std::vector<Submission> subs(batch.size());
+    {
+        auto lock = _job_map_mutex.getLock();
+        JobIdAllocator::BatchScope batchScope(_job_id_allocator);
+        for (size_t i = 0; i < batch.size(); i++) {
+            auto& job = batch[i];
+            try {
+                if (!job.is_object()) throw std::invalid_argument("entry is not a JSON object");
+                for (auto it = inputJson.begin(); it != inputJson.end(); ++it) {
+                    if (it.key() == "batch" || it.key() == "result-stream") continue;
+                    if (!job.contains(it.key())) job[it.key()] = it.value();
+                }
+                results[i] = registerSubmission(job, feedback, 
+                    binary ? binaryFeedback : std::function<void(const std::vector<uint8_t>&)>(),
+                    std::shared_ptr<LiteralStream>(), subs[i]);
+            } catch (const std::exception& e) {
+                LOGGER(_logger, V1_WARN, "[WARN] Rejecting batch entry %lu - reason: %s\n", i, e.what());
+                results[i] = DISCARD;
+            }
+        }
+    }
+    for (auto& sub : subs) if (sub.img) introduceSubmission(sub);
+    LOGGER(_logger, V4_VVER, "Batch of %lu jobs handled\n", results.size());
+    return results;
+}
+
+JsonInterface::Result JsonInterface::handleBinary(BinarySubmission& bin,
+    std::function<void(const std::vector<uint8_t>&)> binaryFeedback) {
 
+    if (!_active || Terminator::isTerminating()) return DISCARD;
+
+    const std::string jobName = bin.user + "." + bin.name + ".json";
     auto baseErrorMsg = "[WARN] Rejecting submission %s - reason: %s\n";
+    if (bin.applicationId == -1 || bin.priority <= 0 || !binaryFeedback) {
+        LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Invalid binary submission.");
+        return DISCARD;
+    }
 
+    const float arrival = Timer::elapsedSeconds();
+    int id, revision;
     {
         auto lock = _job_map_mutex.getLock();
-        
-        // Check and read essential fields from JSON
-        if (!inputJson.contains("user") || !inputJson.contains("name")) {
-            LOGGER(_logger, V1_WARN, baseErrorMsg, "?.?", "Job file missing essential field(s) \"user\" and/or \"name\".");
-            return DISCARD;
+        if (bin.incremental && !bin.precursor.empty()) {
+            // New increment of a former job
+            auto precursorName = bin.user + "." + bin.precursor + ".json";
+            if (!_job_name_to_id_rev.count(precursorName)) {
+                auto warningMsg = "Unknown precursor job \"" + precursorName + "\".";
+                LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), warningMsg.c_str());
+                return DISCARD;
+            }
+            id = _job_name_to_id_rev[precursorName].first;
+            revision = _job_name_to_id_rev[precursorName].second + 1;
+        } else {
+            if (!_job_name_to_id_rev.count(jobName)) {
+                _job_name_to_id_rev[jobName] = std::pair<int, int>(_job_id_allocator.getNext(), 0);
+            }
+            id = _job_name_to_id_rev[jobName].first;
+            revision = 0;
+            if (_job_id_rev_to_image.count(std::pair<int, int>(id, 0))) {
+                LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Job was already submitted before.");
+                return DISCARD;
+            }
         }
-        std::string user = inputJson["user"].get<std::string>();
-        std::string name = inputJson["name"].get<std::string>();
-        jobName = user + "." + name + ".json";
-        incremental = inputJson.contains("incremental") ? inputJson["incremental"].get<bool>() : false;
-
-        // Check priority
-        priority = inputJson.contains("priority") ? inputJson["priority"].get<float>() : 1.0f;
-        if (_params.jitterJobPriorities()) {
-            // Jitter job priority
-            priority *= 0.99 + 0.01 * Random::rand();
+        _job_id_to_latest_rev[id] = revision;
+        _job_name_to_id_rev[jobName] = std::pair<int, int>(id, revision);
+        JobImage* img = new JobImage(id, jobName, arrival, [](nlohmann::json&) {});
+        img->incremental = bin.incremental;
+        img->binaryFeedback = std::move(binaryFeedback);
+        _job_id_rev_to_image[std::pair<int, int>(id, revision)] = img;
+    }
+
+    // Initialize new job
+    JobDescription* job = new JobDescription(id, bin.priority, bin.applicationId);
+    job->setIncremental(bin.incremental);
+    job->setRevision(revision);
+    job->setArrival(arrival);
+    job->setChecksum(bin.checksum);
+    job->setJobDescriptionId(bin.descriptionId.empty() ? 0 :
+        _job_desc_id_allocator.getId(bin.user + "." + bin.descriptionId));
+    if (!bin.groupId.empty())
+        job->setGroupId(_job_desc_id_allocator.getId(bin.user + "." + bin.groupId));
+    AppConfiguration config;
+    config.deserialize(_params.applicationConfiguration());
+    for (auto& [key, val] : bin.configuration) config.map[key] = val;
+    job->setAppConfiguration(std::move(config));
+
+    // Write the payload directly into the revision buffer (meta data depend on the configuration)
+    job->beginInitialization(revision);
+    if (bin.fillDescription) bin.fillDescription(*job);
+    job->endInitialization();
+
+    // Callback to client: New job arrival.
+    JobMetadata metadata;
+    metadata.jobName = jobName;
+    metadata.description = std::unique_ptr<JobDescription>(job);
+    metadata.initialized = true;
+    _job_callback(std::move(metadata));
+    return ACCEPT;
+}
+
+JsonInterface::Result JsonInterface::registerSubmission(nlohmann::json& inputJson, 
+    std::function<void(nlohmann::json&)> feedback, std::function<void(const std::vector<uint8_t>&)> binaryFeedback,
+    std::shared_ptr<LiteralStream> literalStream, Submission& sub) {
+
+    auto& jobName = sub.jobName;
+    auto& id = sub.id;
+    auto& priority = sub.priority;
+    auto& arrival = sub.arrival;
+    auto& applicationId = sub.applicationId;
+    auto& incremental = sub.incremental;
+    JobImage* img = nullptr;
+
+    auto baseErrorMsg = "[WARN] Rejecting submission %s - reason: %s\n";
+
+    // Check and read essential fields from JSON
+    if (!inputJson.contains("user") || !inputJson.contains("name")) {
+        LOGGER(_logger, V1_WARN, baseErrorMsg, "?.?", "Job file missing essential field(s) \"user\" and/or \"name\".");
+        return DISCARD;
+    }
+    std::string user = inputJson["user"].get<std::string>();
+    std::string name = inputJson["name"].get<std::string>();
+    jobName = user + "." + name + ".json";
+    incremental = inputJson.contains("incremental") ? inputJson["incremental"].get<bool>() : false;
+
+    // Check priority
+    priority = inputJson.contains("priority") ? inputJson["priority"].get<float>() : 1.0f;
+    if (_params.jitterJobPriorities()) {
+        // Jitter job priority
+        priority *= 0.99 + 0.01 * Random::rand();
+    }
+    if (priority <= 0) {
+        LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Priority negative.");
+        return DISCARD;
+    }
+
+    applicationId = -1;
+    if (inputJson.contains("application")) {
+        auto appStr = inputJson["application"].get<std::string>();
+        applicationId = app_registry::getAppId(appStr);
+    }
+    if (applicationId == -1) {
+        LOGGER(_logger, V1_WARN, "[WARN] No valid application given. Ignoring this file.\n");
+        return DISCARD;
+    }
+
+    if (inputJson.contains("stream") && inputJson["stream"].get<bool>()) {
+        if (!literalStream) {
+            LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Streamed submission not supported by this interface.");
+            return DISCARD;
         }
-        if (priority <= 0) {
-            LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Priority negative.");
+        if (inputJson.contains("files") || inputJson.contains("literals") || inputJson.contains("internalliterals")) {
+            LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Streamed submission must not specify files or literals.");
             return DISCARD;
         }
+    } else literalStream.reset();
 
-        applicationId = -1;
-        if (inputJson.contains("application")) {
-            auto appStr = inputJson["application"].get<std::string>();
-            applicationId = app_registry::getAppId(appStr);
-        }
-        if (applicationId == -1) {
-            LOGGER(_logger, V1_WARN, "[WARN] No valid application given. Ignoring this file.\n");
+    if (inputJson.contains("interrupt") && inputJson["interrupt"].get<bool>()) {
+        if (!_job_name_to_id_rev.count(jobName)) {
+            LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Cannot interrupt unknown job.");
             return DISCARD;
         }
+        auto [id, rev] = _job_name_to_id_rev.at(jobName);
+
+        // Interrupt a job which is already present
+        JobMetadata data;
+        data.jobName = jobName;
+        data.description = std::unique_ptr<JobDescription>(new JobDescription(id, 0, applicationId));
+        data.description->setIncremental(incremental);
+        data.description->setRevision(rev);
+        data.interrupt = true;
+        _job_callback(std::move(data));
+        return ACCEPT;
+    }
 
-        if (inputJson.contains("interrupt") && inputJson["interrupt"].get<bool>()) {
-            if (!_job_name_to_id_rev.count(jobName)) {
-                LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), "Cannot interrupt unknown job.");
-                return DISCARD;
+    arrival = inputJson.contains("arrival") ? std::max(Timer::elapsedSeconds(), inputJson["arrival"].get<float>()) 
+        : Timer::elapsedSeconds();
+
+    if (incremental && inputJson.contains("precursor")) {
+
+        // This is a new increment of a former job - assign SAME internal ID
+        auto precursorName = inputJson["precursor"].get<std::string>() + ".json";
+        if (!_job_name_to_id_rev.count(precursorName)) {
+            auto warningMsg = "Unknown precursor job \"" + precursorName + "\".";
+            LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), warningMsg.c_str());
+            return DISCARD;
+        }
+        auto [jobId, rev] = _job_name_to_id_rev[precursorName];
+        id = jobId;
+
+        if (inputJson.contains("done") && inputJson["done"].get<bool>()) {
+
+            // Incremental job is notified to be done
+            LOGGER(_logger, V3_VERB, "Incremental job #%i is done\n", jobId);
+            _job_name_to_id_rev.erase(precursorName);
+            for (int rev = 0; rev <= _job_id_to_latest_rev[id]; rev++) {
+                auto key = std::pair<int, int>(id, rev);
+                JobImage* foundImg = _job_id_rev_to_image.at(key);
+                _job_id_rev_to_image.erase(key);
+                delete foundImg;
             }
-            auto [id, rev] = _job_name_to_id_rev.at(jobName);
+            _job_id_to_latest_rev.erase(id);
 
-            // Interrupt a job which is already present
+            // Notify client that this incremental job is done
             JobMetadata data;
-            data.jobName = jobName;
             data.description = std::unique_ptr<JobDescription>(new JobDescription(id, 0, applicationId));
             data.description->setIncremental(incremental);
-            data.description->setRevision(rev);
-            data.interrupt = true;
+            data.jobName = jobName;
+            data.done = true;
             _job_callback(std::move(data));
-            return ACCEPT;
-        }
+            return ACCEPT_CONCLUDE;
 
-        arrival = inputJson.contains("arrival") ? std::max(Timer::elapsedSeconds(), inputJson["arrival"].get<float>()) 
-            : Timer::elapsedSeconds();
-
-        if (incremental && inputJson.contains("precursor")) {
+        } else {
 
-            // This is a new increment of a former job - assign SAME internal ID
-            auto precursorName = inputJson["precursor"].get<std::string>() + ".json";
-            if (!_job_name_to_id_rev.count(precursorName)) {
-                auto warningMsg = "Unknown precursor job \"" + precursorName + "\".";
-                LOGGER(_logger, V1_WARN, baseErrorMsg, jobName.c_str(), warningMsg.c_str());
-                return DISCARD;
-            }
-            auto [jobId, rev] = _job_name_to_id_rev[precursorName];
-            id = jobId;
-
-            if (inputJson.contains("done") && inputJson["done"].get<bool>()) {
-
-                // Incremental job is notified to be done
-                LOGGER(_logger, V3_VERB, "Incremental job #%i is done\n", jobId);
-                _job_name_to_id_rev.erase(precursorName);
-                for (int rev = 0; rev <= _job_id_to_latest_rev[id]; rev++) {
-                    auto key = std::pair<int, int>(id, rev);
-                    JobImage* foundImg = _job_id_rev_to_image.at(key);
-                    _job_id_rev_to_image.erase(key);
-                    delete foundImg;
-                }
-                _job_id_to_latest_rev.erase(id);
-
-                // Notify client that this incremental job is done
-                JobMetadata data;
-                data.description = std::unique_ptr<JobDescription>(new JobDescription(id, 0, applicationId));
-                data.description->setIncremental(incremental);
-                data.jobName = jobName;
-                data.done = true;
-                _job_callback(std::move(data));
-                return ACCEPT_CONCLUDE;
-
-            } else {
-
-                // Job is not done -- add increment to job
-                _job_id_to_latest_rev[id] = rev+1;
-                _job_name_to_id_rev[jobName] = std::pair<int, int>(id, rev+1);
-                img = new JobImage(id, jobName, arrival, feedback);
-                img->incremental = true;
-                img->baseJson = std::move(inputJson);
-                _job_id_rev_to_image[std::pair<int, int>(id, rev+1)] = img;
-            }
+            // Job is not done -- add increment to job
+            _job_id_to_latest_rev[id] = rev+1;
+            _job_name_to_id_rev[jobName] = std::pair<int, int>(id, rev+1);
+            img = new JobImage(id, jobName, arrival, feedback);
+            img->incremental = true;
+            img->baseJson = std::move(inputJson);
+            _job_id_rev_to_image[std::pair<int, int>(id, rev+1)] = img;
+        }
 
-        } else {
+    } else {
 
-            // Create new internal ID for this job
-            if (!_job_name_to_id_rev.count(jobName)) {
-                _job_name_to_id_rev[jobName] = std::pair<int, int>(_job_id_allocator.getNext(), 0);
-            }
-            auto pair = _job_name_to_id_rev[jobName];
-            id = pair.first;
-            LOGGER(_logger, V3_VERB, "Mapping job \"%s\" to internal ID #%i\n", jobName.c_str(), id);
+        // Create new internal ID for this job
+        if (!_job_name_to_id_rev.count(jobName)) {
+            _job_name_to_id_rev[jobName] = std::pair<int, int>(_job_id_allocator.getNext(), 0);
+        }
+        auto pair = _job_name_to_id_rev[jobName];
+        id = pair.first;
+        LOGGER(_logger, V3_VERB, "Mapping job \"%s\" to internal ID #%i\n", jobName.c_str(), id);
+
+        // Was job already parsed before?
+        if (_job_id_rev_to_image.count(std::pair<int, int>(id, 0))) {
+            LOGGER(_logger, V1_WARN, "[WARN] Modification of a file I already parsed! Ignoring.\n");
+            throw std::invalid_argument("File was already parsed before");
+            return DISCARD;
+        }
 
-            // Was job already parsed before?
-            if (_job_id_rev_to_image.count(std::pair<int, int>(id, 0))) {
-                LOGGER(_logger, V1_WARN, "[WARN] Modification of a file I already parsed! Ignoring.\n");
-                throw std::invalid_argument("File was already parsed before");
-                return DISCARD;
-            }
+        img = new JobImage(id, jobName, arrival, feedback);
+        img->incremental = incremental;
+        img->baseJson = std::move(inputJson);
+        _job_id_rev_to_image[std::pair<int, int>(id, 0)] = std::move(img);
+        _job_id_to_latest_rev[id] = 0;
+    }
+    img->binaryFeedback = std::move(binaryFeedback);
+    sub.revision = _job_id_to_latest_rev[id];
 
-            img = new JobImage(id, jobName, arrival, feedback);
-            img->incremental = incremental;
-            img->baseJson = std::move(inputJson);
-            _job_id_rev_to_image[std::pair<int, int>(id, 0)] = std::move(img);
-            _job_id_to_latest_rev[id] = 0;
+    // Translate dependencies (if any) to internal job IDs
+    auto& json = img->baseJson;
+    std::vector<std::string> nameDependencies;
+    if (json.contains("dependencies")) 
+        nameDependencies = json["dependencies"].get<std::vector<std::string>>();
+    const std::string ending = ".json";
+    for (auto name : nameDependencies) {
+        // Convert to the name with ".json" file ending
+        name += ending;
+        // If the job is not yet known, assign to it a new ID
+        // that will be used by the job later
+        if (!_job_name_to_id_rev.count(name)) {
+            _job_name_to_id_rev[name] = std::pair<int, int>(_job_id_allocator.getNext(), 0);
+            LOGGER(_logger, V3_VERB, "Forward mapping job \"%s\" to internal ID #%i\n", name.c_str(), _job_name_to_id_rev[name].first);
         }
+        sub.idDependencies.push_back(_job_name_to_id_rev[name].first); // TODO inexact: introduce dependencies for job revisions
     }
 
+    sub.literalStream = std::move(literalStream);
+    sub.img = img;
+    return ACCEPT;
+}
+
+void JsonInterface::introduceSubmission(Submission& sub) {
+
     // From here on, use the json inside the JobImage because the parameter JSON has been moved
-    assert(img->baseJson != nullptr);
-    auto& json = img->baseJson;
+    assert(sub.img->baseJson != nullptr);
+    auto& json = sub.img->baseJson;
+    const int id = sub.id;
 
     // Initialize new job
-    JobDescription* job = new JobDescription(id, priority, applicationId);
-    job->setIncremental(incremental);
-    job->setRevision(_job_id_to_latest_rev[id]);
+    JobDescription* job = new JobDescription(id, sub.priority, sub.applicationId);
+    job->setIncremental(sub.incremental);
+    job->setRevision(sub.revision);
     if (json.contains("wallclock-limit")) {
         float limit = TimePeriod(json["wallclock-limit"].get<std::string>()).get(TimePeriod::Unit::SECONDS);
         job->setWallclockLimit(limit);
@@ -211,7 +382,7 @@ JsonInterface::Result JsonInterface::handle(nlohmann::json& inputJson,
         job->setGroupId(groupId);
         LOGGER(_logger, V4_VVER, "Job #%i rev. %i: set group ID %i\n", id, job->getRevision(), groupId);
     }
-    job->setArrival(arrival);
+    job->setArrival(sub.arrival);
     std::vector<std::string> files = json.contains("files") ? 
         json["files"].get<std::vector<std::string>>() : std::vector<std::string>();
     if (json.contains("checksum"))
@@ -232,34 +403,14 @@ JsonInterface::Result JsonInterface::handle(nlohmann::json& inputJson,
     }
     job->setAppConfiguration(std::move(config));
     
-    // Translate dependencies (if any) to internal job IDs
-    std::vector<int> idDependencies;
-    std::vector<std::string> nameDependencies;
-    if (json.contains("dependencies")) 
-        nameDependencies = json["dependencies"].get<std::vector<std::string>>();
-    const std::string ending = ".json";
-    for (auto name : nameDependencies) {
-        // Convert to the name with ".json" file ending
-        name += ending;
-        // If the job is not yet known, assign to it a new ID
-        // that will be used by the job later
-        auto lock = _job_map_mutex.getLock();
-        if (!_job_name_to_id_rev.count(name)) {
-            _job_name_to_id_rev[name] = std::pair<int, int>(_job_id_allocator.getNext(), 0);
-            LOGGER(_logger, V3_VERB, "Forward mapping job \"%s\" to internal ID #%i\n", name.c_str(), _job_name_to_id_rev[name].first);
-        }
-        idDependencies.push_back(_job_name_to_id_rev[name].first); // TODO inexact: introduce dependencies for job revisions
-    }
-
     // Callback to client: New job arrival.
     JobMetadata metadata;
-    metadata.jobName = jobName;
+    metadata.jobName = sub.jobName;
     metadata.description = std::unique_ptr<JobDescription>(job);
     metadata.files = std::move(files);
-    metadata.dependencies = std::move(idDependencies);
+    metadata.dependencies = std::move(sub.idDependencies);
+    metadata.literalStream = std::move(sub.literalStream);
     _job_callback(std::move(metadata));
-
-    return ACCEPT;
 }
 
 void JsonInterface::handleJobDone(JobResult&& result, const JobProcessingStatistics& stats, int applicationId) {
@@ -269,6 +420,20 @@ void JsonInterface::handleJobDone(JobResult&& result, const JobProcessingStatist
     JobImage* img = _job_id_rev_to_image[std::pair<int, int>(result.id, result.revision)];
     auto& j = img->baseJson;
 
+    if (img->binaryFeedback) {
+        // Compact binary result record: no JSON encoding, solution included inline
+        const auto& name = img->userQualifiedName;
+        auto record = ResultRecord::serialize(name.substr(0, name.size() - std::string(".json").size()),
+            result, Timer::elapsedSeconds() - img->arrivalTime, stats.processingTime);
+        img->binaryFeedback(record);
+        if (!img->incremental) {
+            _job_name_to_id_rev.erase(img->userQualifiedName);
+            _job_id_rev_to_image.erase(std::pair<int, int>(result.id, result.revision));
+            delete img;
+        }
+        return;
+    }
+
     bool useSolutionFile = (_params.pipeSolutions() == MALLOB_PIPE_SOLUTIONS_ALL && result.getSolutionSize() > 0)
         || (_params.pipeSolutions() == MALLOB_PIPE_SOLUTIONS_LARGE && result.getSolutionSize() > 65536);
     auto solutionFile = _output_dir + "/mallob-job-result."
@@ -2,12 +2,15 @@
 #pragma once
 
 #include <functional>
+#include <map>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "interface/api/job_description_id_allocator.hpp"
 #include "util/logger.hpp"
 #include "util/hashing.hpp"
+#include "data/checksum.hpp"
 #include "data/job_result.hpp"
 #include "data/job_metadata.hpp"
 #include "util/json.hpp"
@@ -18,6 +21,7 @@
 #include "util/sys/tmpdir.hpp"
 #include "util/robin_hood.hpp"
 #include "data/job_processing_statistics.hpp"
+#include "data/literal_stream.hpp"
 
 class Parameters; // fwd declaration
 struct IntPairHasher;
@@ -35,6 +39,8 @@ public:
         bool incremental = false;
         nlohmann::json baseJson;
         std::function<void(nlohmann::json&)> feedback;
+        // If set, the result is reported as a binary ResultRecord instead of a JSON
+        std::function<void(const std::vector<uint8_t>&)> binaryFeedback;
 
         JobImage() = default;
         JobImage(int id, const std::string& userQualifiedName, float arrivalTime, 
@@ -60,6 +66,20 @@ private:
 
     bool _active {true};
 
+    // A job submission which has been registered but not yet introduced to the client
+    struct Submission {
+        JobImage* img {nullptr};
+        std::string jobName;
+        int id;
+        int revision;
+        float priority;
+        float arrival;
+        int applicationId;
+        bool incremental;
+        std::vector<int> idDependencies;
+        std::shared_ptr<LiteralStream> literalStream;
+    };
+
 public:
     JsonInterface(int clientRank, const Parameters& params, Logger&& logger, 
             std::function<void(JobMetadata&&)> jobCallback, JobIdAllocator&& jobIdAllocator) : 
@@ -78,11 +98,49 @@ public:
 
     // User-side events
     enum Result {ACCEPT, ACCEPT_CONCLUDE, DISCARD};
-    Result handle(nlohmann::json& json, std::function<void(nlohmann::json&)> feedback);
+    // A job with "stream": true receives its formula literals via the provided literal stream
+    // instead of files; only interfaces which support streaming provide such a stream.
+    Result handle(nlohmann::json& json, std::function<void(nlohmann::json&)> feedback,
+        std::shared_ptr<LiteralStream> literalStream = std::shared_ptr<LiteralStream>());
+    // A batch request {"batch": [<job>, ...]} submits many jobs at once. All other top-level
+    // fields serve as defaults for each job. With "result-stream": "binary", the results
+    // are reported via binaryFeedback as ResultRecords instead of JSON documents.
+    // Returns the result of each individual job.
+    std::vector<Result> handleBatch(nlohmann::json& json, std::function<void(nlohmann::json&)> feedback,
+        std::function<void(const std::vector<uint8_t>&)> binaryFeedback);
+    static bool isBatch(const nlohmann::json& json) {
+        return json.contains("batch");
+    }
+    // A job (revision) submitted without any JSON, e.g., by an incremental job stream
+    // of a client-side program. The formula and assumptions are written by fillDescription
+    // directly into the revision buffer of the job description, so the job needs no parsing.
+    // The result is reported via binaryFeedback as a ResultRecord.
+    struct BinarySubmission {
+        std::string user;
+        std::string name;
+        std::string precursor; // name of the preceding revision of an incremental job (if any)
+        bool incremental {false};
+        float priority {1};
+        int applicationId {-1};
+        std::string groupId;
+        std::string descriptionId;
+        Checksum checksum;
+        std::map<std::string, std::string> configuration;
+        std::function<void(JobDescription&)> fillDescription;
+    };
+    Result handleBinary(BinarySubmission& submission, std::function<void(const std::vector<uint8_t>&)> binaryFeedback);
 
     // Mallob-side events
     void handleJobDone(JobResult&& result, const JobProcessingStatistics& stats, int applicationId);
 
     bool isActive() const {return _active;}
     void deactivate() {_active = false;}
+
+private:
+    // Must be called with _job_map_mutex held. If a new job (revision) is registered,
+    // sub.img is set and the job must be introduced via introduceSubmission afterwards.
+    Result registerSubmission(nlohmann::json& json, std::function<void(nlohmann::json&)> feedback,
+        std::function<void(const std::vector<uint8_t>&)> binaryFeedback,
+        std::shared_ptr<LiteralStream> literalStream, Submission& sub);
+    void introduceSubmission(Submission& sub);
 };
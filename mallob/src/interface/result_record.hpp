@@ -0,0 +1,143 @@
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "data/job_result.hpp"
+#include "util/logger.hpp"
+#include "util/sys/threading.hpp"
+
+/*
+Compact binary representation of a job result, as an alternative to a JSON response
+for clients which submit many small jobs. All numbers are in host byte order:
+[char[4] "MRES"][int id][int revision][int result code][float response time]
+[float processing time][int name length][name][int solution size][int solution...]
+The name is the user-qualified job name ("<user>.<name>").
+*/
+struct ResultRecord {
+
+    std::string jobName;
+    int id {0};
+    int revision {0};
+    int resultCode {0};
+    float responseTime {0};
+    float processingTime {0};
+    std::vector<int> solution;
+
+    static constexpr const char* MAGIC = "MRES";
+
+    static std::vector<uint8_t> serialize(const std::string& jobName, const JobResult& result,
+            float responseTime, float processingTime) {
+
+        const int nameLength = jobName.size();
+        const int solutionSize = result.getSolutionSize();
+        std::vector<uint8_t> out(4 + 5*sizeof(int) + 2*sizeof(float) + nameLength + solutionSize*sizeof(int));
+        size_t i = 0;
+        auto put = [&](const void* data, size_t size) {
+            memcpy(out.data()+i, data, size);
+            i += size;
+        };
+        put(MAGIC, 4);
+        put(&result.id, sizeof(int));
+        put(&result.revision, sizeof(int));
+        put(&result.result, sizeof(int));
+        put(&responseTime, sizeof(float));
+        put(&processingTime, sizeof(float));
+        put(&nameLength, sizeof(int));
+        put(jobName.c_str(), nameLength);
+        put(&solutionSize, sizeof(int));
+        for (int k = 0; k < solutionSize; k++) {
+            int lit = result.getSolution(k);
+            put(&lit, sizeof(int));
+        }
+        assert(i == out.size());
+        return out;
+    }
+
+    // Returns false if the data do not contain exactly one well-formed record.
+    bool deserialize(const uint8_t* data, size_t size) {
+        size_t i = 0;
+        auto get = [&](void* out, size_t n) {
+            if (i + n > size) return false;
+            memcpy(out, data+i, n);
+            i += n;
+            return true;
+        };
+        char magic[4];
+        int nameLength, solutionSize;
+        if (!get(magic, 4) || memcmp(magic, MAGIC, 4) != 0) return false;
+        if (!get(&id, sizeof(int)) || !get(&revision, sizeof(int)) || !get(&resultCode, sizeof(int))
+            || !get(&responseTime, sizeof(float)) || !get(&processingTime, sizeof(float))) return false;
+        if (!get(&nameLength, sizeof(int)) || nameLength < 0 || i + nameLength > size) return false;
+        jobName.assign((const char*) data+i, nameLength);
+        i += nameLength;
+        if (!get(&solutionSize, sizeof(int)) || solutionSize < 0 || i + solutionSize*sizeof(int) != size) return false;
+        solution.resize(solutionSize);
+        return get(solution.data(), solutionSize*sizeof(int));
+    }
+};
+
+/*
+Append-only file of result records, each preceded by its size as an int.
+A record is flushed as a whole, so a reader following the file sees
+either a complete record or an incomplete tail which is completed later.
+The file is only created upon the first record.
+*/
+class ResultRecordFile {
+
+private:
+    std::string _path;
+    Mutex _mtx;
+    FILE* _file {nullptr};
+    size_t _nb_records {0};
+
+public:
+    ResultRecordFile(const std::string& path) : _path(path) {}
+    ~ResultRecordFile() {
+        if (_file) fclose(_file);
+    }
+
+    void append(const std::vector<uint8_t>& record) {
+        auto lock = _mtx.getLock();
+        if (!_file) {
+            _file = fopen(_path.c_str(), "ab");
+            if (!_file) {
+                LOG(V1_WARN, "[WARN] Cannot open result stream %s\n", _path.c_str());
+                return;
+            }
+        }
+        const int size = record.size();
+        fwrite(&size, sizeof(int), 1, _file);
+        fwrite(record.data(), 1, record.size(), _file);
+        fflush(_file);
+        _nb_records++;
+    }
+
+    const std::string& getPath() const {return _path;}
+    size_t getNbRecords() {
+        auto lock = _mtx.getLock();
+        return _nb_records;
+    }
+
+    // Reads all complete records from a result stream file.
+    static std::vector<ResultRecord> readAll(const std::string& path) {
+        std::vector<ResultRecord> records;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return records;
+        int size;
+        std::vector<uint8_t> buffer;
+        while (fread(&size, sizeof(int), 1, f) == 1 && size >= 0) {
+            buffer.resize(size);
+            if (fread(buffer.data(), 1, size, f) != (size_t) size) break;
+            ResultRecord record;
+            if (!record.deserialize(buffer.data(), size)) break;
+            records.push_back(std::move(record));
+        }
+        fclose(f);
+        return records;
+    }
+};
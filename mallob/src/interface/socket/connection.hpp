@@ -8,8 +8,11 @@
 #include <optional>
 #include <cctype>
 #include <inttypes.h>
+#include <functional>
+#include <vector>
 
 #include "util/json.hpp"
+#include "util/sys/threading.hpp"
 
 class Connection {
 
@@ -22,6 +25,13 @@ private:
 
     bool _flip_endian = false;
 
+    // Sends may happen from different threads (results, stream credit)
+    Mutex _send_mutex;
+
+    // Set while a binary stream is being received
+    std::function<bool(std::vector<int>&&)> _binary_frame_callback;
+    std::function<void(bool)> _binary_end_callback;
+
 public:
     Connection(int id, int fd, int maxMsgSize) : _id(id), _connection_fd(fd), _max_msg_size(maxMsgSize) {}
     ~Connection() {
@@ -41,22 +51,34 @@ public:
         if (!valid()) return false;
 
         std::string serializedJson = json.dump();
+        LOG(V5_DEBG, "Sending msg len=%i \"%s\"\n", serializedJson.size(), serializedJson.c_str());
+        return sendMessage(serializedJson.c_str(), serializedJson.size());
+    }
 
-        int payloadSize = serializedJson.size();
-        int flippedPayloadSize = _flip_endian ? flipEndian(payloadSize) : payloadSize;
-        int msgSize = sizeof(int)+payloadSize;
-        char msg[msgSize];
-        memcpy(msg, &flippedPayloadSize, sizeof(int));
-        memcpy(msg+sizeof(int), serializedJson.c_str(), payloadSize);
-        
-        int size = ::send(_connection_fd, msg, msgSize, 0);
-        LOG(V5_DEBG, "Sending msg len=%i/%i \"%s\"\n", size, msgSize, serializedJson.c_str());
-        return size >= 0;
+    // Send a binary message, e.g., a ResultRecord. Such a message can be told apart
+    // from a JSON message by its first byte, which is never '{'.
+    bool sendBinary(const std::vector<uint8_t>& data) {
+        if (!valid()) return false;
+        return sendMessage((const char*) data.data(), data.size());
     }
     
+    // Begin a stream of binary frames on this connection: each following message
+    // is a sequence of 32-bit integers which is handed to onFrame until a message
+    // of size zero concludes the stream. If onFrame returns false, the stream is
+    // aborted and the connection is closed. onEnd reports whether the stream
+    // was concluded properly (also if the connection is closed prematurely).
+    void beginBinaryStream(std::function<bool(std::vector<int>&&)> onFrame, std::function<void(bool)> onEnd) {
+        _binary_frame_callback = onFrame;
+        _binary_end_callback = onEnd;
+    }
+
     std::optional<nlohmann::json> receive() {
         if (!valid()) return std::optional<nlohmann::json>();
 
+        // Complete message(s) left over from the previous call?
+        auto result = readBufferedMessages();
+        if (result || !valid()) return result;
+
         // Remember old buffer size and enlarge
         int sizeBefore = _buffer.size();
         _buffer.resize(sizeBefore + _max_msg_size);
@@ -64,17 +86,62 @@ public:
         // Attempt to receive a block of message(s)
         auto size = recv(_connection_fd, _buffer.data()+sizeBefore, _max_msg_size, 0);
 
+        // Received nothing?
+        if (size <= 0) {
+            _buffer.resize(sizeBefore);
+            // Orderly shutdown by the other side?
+            if (size == 0) close();
+            return result;
+        }
+
         // Trim buffer to only contain actual data
         _buffer.resize(sizeBefore + size);
 
-        auto result = std::optional<nlohmann::json>();
+        return readBufferedMessages();
+    }
 
-        // Received nothing?
-        if (size <= 0) return result;
+    bool valid() {
+        return _connection_fd != -1;
+    }
+
+    void close() {
+        if (!valid()) return;
+        ::close(_connection_fd);
+        _connection_fd = -1;
+        endBinaryStream(false);
+    }
+
+    int getId() const {
+        return _id;
+    }
 
-        // Try to read a message from the buffer
-        int begin = 0;
-        while (true) {
+private:
+    bool sendMessage(const char* payload, int payloadSize) {
+        int flippedPayloadSize = _flip_endian ? flipEndian(payloadSize) : payloadSize;
+        std::vector<char> msg(sizeof(int)+payloadSize);
+        memcpy(msg.data(), &flippedPayloadSize, sizeof(int));
+        memcpy(msg.data()+sizeof(int), payload, payloadSize);
+
+        // Write the message as a whole, i.e., without interleaving other messages
+        auto lock = _send_mutex.getLock();
+        size_t sent = 0;
+        while (sent < msg.size()) {
+            auto size = ::send(_connection_fd, msg.data()+sent, msg.size()-sent, 0);
+            if (size < 0) return false;
+            sent += size;
+        }
+        return true;
+    }
+
+    // Reads complete messages from the buffer: binary frames are digested right away,
+    // and the first JSON message (if any) is returned.
+    std::optional<nlohmann::json> readBufferedMessages() {
+
+        auto result = std::optional<nlohmann::json>();
+
+        // Try to read messages from the buffer
+        size_t begin = 0;
+        while (begin + sizeof(int) <= _buffer.size()) {
 
             // How large is the message advertised to be? (Try to be lenient with byte ordering)
             int payloadSize = *((int*) (_buffer.data()+begin));
@@ -83,6 +150,9 @@ public:
                 _flip_endian = true;
             }
             assert(payloadSize >= 0 && payloadSize < INT32_MAX/2);
+
+            // Message has not been read completely: wait for next batch
+            if (payloadSize > _buffer.size()-begin-sizeof(int)) break;
             
             // Proceed to actual payload
             begin += sizeof(int);
@@ -94,11 +164,26 @@ public:
                 close();
                 break;
 
-            } else if (payloadSize > _buffer.size()-begin) {
+            } else if (_binary_frame_callback) {
 
-                // Message has not been read completely: wait for next batch
-                begin -= sizeof(int);
-                break;
+                // Frame of a binary stream
+                if (payloadSize % sizeof(int) != 0) {
+                    LOG(V1_WARN, "[WARN] Binary frame of %i bytes is not a sequence of integers\n", payloadSize);
+                    close();
+                    break;
+                }
+                if (payloadSize == 0) {
+                    endBinaryStream(true);
+                    continue;
+                }
+                std::vector<int> frame(payloadSize / sizeof(int));
+                memcpy(frame.data(), _buffer.data()+begin, payloadSize);
+                if (_flip_endian) for (int& x : frame) x = flipEndian(x);
+                begin += payloadSize;
+                if (!_binary_frame_callback(std::move(frame))) {
+                    close();
+                    break;
+                }
 
             } else {
                 // Parse printable ASCII string
@@ -114,7 +199,7 @@ public:
 
                 //fullStringAsInts = fullStringAsInts.substr(0, fullStringAsInts.size()-1);
                 
-                LOG(V5_DEBG, "Received msg len=%i/%i \"%s\"\n", msgStr.size(), size, msgStr.c_str());
+                LOG(V5_DEBG, "Received msg len=%i \"%s\"\n", msgStr.size(), msgStr.c_str());
                 
                 // Attempt to parse JSON
                 try {
@@ -131,27 +216,19 @@ public:
         }
 
         // Rearrange buffer to begin at beginning of next message
-        auto newbuf = std::vector<char>(_buffer.data()+begin, _buffer.data()+_buffer.size());
-        _buffer = std::move(newbuf);
+        if (begin > 0) _buffer.erase(_buffer.begin(), _buffer.begin()+std::min(begin, _buffer.size()));
 
         return result;
     }
 
-    bool valid() {
-        return _connection_fd != -1;
-    }
-
-    void close() {
-        if (!valid()) return;
-        ::close(_connection_fd);
-        _connection_fd = -1;
-    }
-
-    int getId() const {
-        return _id;
+    void endBinaryStream(bool success) {
+        if (!_binary_frame_callback) return;
+        auto onEnd = std::move(_binary_end_callback);
+        _binary_frame_callback = std::function<bool(std::vector<int>&&)>();
+        _binary_end_callback = std::function<void(bool)>();
+        if (onEnd) onEnd(success);
     }
 
-private:
     int flipEndian(int input) {
         char in[4];
         memcpy(in, &input, sizeof(int));
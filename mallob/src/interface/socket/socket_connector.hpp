@@ -7,6 +7,16 @@
 #include "socket.hpp"
 #include "util/params.hpp"
 
+/*
+Connects an IPC socket to the JSON interface. Each message is a JSON document
+preceded by its size. A job submission with "stream": true is answered with
+{"credit": <bytes>} (or {"credit": 0, "rejected": true}), after which the client
+sends the job's formula literals as binary messages of 32-bit integers, followed
+by a message of size zero. The client must never send more bytes than it has been
+granted in total; further {"credit": <bytes>} messages follow as the literals are parsed.
+A batch request {"batch": [...]} submits many jobs at once and keeps the connection open.
+With "result-stream": "binary", each result arrives as a binary ResultRecord message.
+*/
 class SocketConnector : public Connector {
 
 private:
@@ -22,15 +32,45 @@ public:
         settings.maxMsgSize = 65536;
 
         // Callback to receive a JSON request from a certain user connection
-        settings.receiveCallback = [&interface](Connection& conn, nlohmann::json& json) {
+        settings.receiveCallback = [&interface, window = params.streamSubmissionWindow()](Connection& conn, nlohmann::json& json) {
             // Callback to return an answer for the request being submitted
             auto cb = [&conn](nlohmann::json& result) {
                 // Send result over the associated connection
                 bool sent = conn.send(result);
                 if (!sent) LOG(V1_WARN, "[WARN] IPC socket send unsuccessful!\n");
             };
+            if (JsonInterface::isBatch(json)) {
+                interface.handleBatch(json, cb, [&conn](const std::vector<uint8_t>& record) {
+                    bool sent = conn.sendBinary(record);
+                    if (!sent) LOG(V1_WARN, "[WARN] IPC socket send unsuccessful!\n");
+                });
+                return;
+            }
+            // Streamed submission: the job's literals follow as binary frames,
+            // and the client may only send as many bytes as it has been granted.
+            std::shared_ptr<LiteralStream> stream;
+            const bool streamed = json.contains("stream") && json["stream"].get<bool>();
+            if (streamed) {
+                stream.reset(new LiteralStream(window, [&conn](size_t credit) {
+                    conn.send(nlohmann::json {{"credit", credit}});
+                }));
+            }
             // Submit the request to the JSON interface
-            auto result = interface.handle(json, cb);
+            auto result = interface.handle(json, cb, stream);
+            if (streamed) {
+                if (result == JsonInterface::DISCARD) {
+                    conn.send(nlohmann::json {{"credit", 0}, {"rejected", true}});
+                } else {
+                    conn.beginBinaryStream([stream](std::vector<int>&& frame) {
+                        if (stream->push(std::move(frame))) return true;
+                        LOG(V1_WARN, "[WARN] IPC socket client exceeded its credit for a streamed job\n");
+                        return false;
+                    }, [stream](bool success) {
+                        stream->conclude(success);
+                    });
+                    conn.send(nlohmann::json {{"credit", stream->getWindow()}});
+                }
+            }
             // Close the associated connection if appropriate
             if (result == JsonInterface::ACCEPT_CONCLUDE) conn.close();
         };
@@ -209,7 +209,11 @@ void longStartupWarnMsg(int rank, const char* msg) {
 
 int main(int argc, char *argv[]) {
     
-    MyMpi::init();
+    // Parse parameters first since they determine MPI's threading level
+    Parameters params;
+    params.init(argc, argv);
+
+    MyMpi::init(/*multiThreaded=*/params.messageProgressThread());
     Timer::init();
     Proc::nameThisThread("MainThread");
 
@@ -220,8 +224,6 @@ int main(int argc, char *argv[]) {
 
     longStartupWarnMsg(rank, "Init'd MPI");
 
-    Parameters params;
-    params.init(argc, argv);
     if (rank == 0) params.printBanner();
 
     longStartupWarnMsg(rank, "Init'd params");
@@ -237,6 +239,7 @@ int main(int argc, char *argv[]) {
     logConfig.verbosity = params.verbosity();
     logConfig.coloredOutput = params.coloredOutput();
     logConfig.flushFileImmediately = params.immediateFileFlush();
+    logConfig.async = params.asyncLogging();
     logConfig.quiet = params.quiet();
     if (params.zeroOnlyLogging() && rank > 0) logConfig.quiet = true;
     logConfig.cPrefix = params.monoFilename.isSet();
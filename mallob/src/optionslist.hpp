@@ -52,6 +52,7 @@ OPTION_GROUP(grpInterface, "interface", "Interface")
  OPT_INT(loadedJobsPerClient,             "ljpc", "loaded-jobs-per-client",            32,   0, LARGE_INT,      "Limit for how many job descriptions each client is allowed to have loaded at the same time")
  OPT_INT(maxJobsPerStreamer,              "mjps", "max-jobs-per-streamer",             0,    0, LARGE_INT,      "Maximum number of jobs to introduce per streamer")
  OPT_BOOL(shuffleJobDescriptions,         "sjd", "shuffle-job-descriptions",           false,                   "Shuffle job descriptions given via -job-desc-template option")
+ OPT_INT(streamSubmissionWindow,          "ssw", "stream-submission-window",           1048576, 1024, LARGE_INT, "Credit in bytes for a job streamed over the IPC socket: the client must not send more literals than this ahead of parsing")
  OPT_BOOL(useFilesystemInterface,         "interface-fs", "",                          true,                    "Use filesystem interface ([-apidir]/jobs.*/{in,out}/*.json)")
  OPT_BOOL(useIPCSocketInterface,          "interface-ipc", "",                         false,                   "Use IPC socket interface (.mallob.<pid>.sk)")
  OPT_STRING(streamerResultOutput,         "sro", "streamer-result-output",             "",                      "Path for streamer to write result metadata to")
@@ -59,6 +60,7 @@ OPTION_GROUP(grpInterface, "interface", "Interface")
 ///////////////////////////////////////////////////////////////////////
 
 OPTION_GROUP(grpOutput, "output", "Output")
+ OPT_BOOL(asyncLogging,                   "alog", "async-logging",                     false,                   "Write log lines from a background thread, formatting them only there")
  OPT_BOOL(coloredOutput,                  "colors", "",                                false,                   "Colored terminal output based on messages' verbosity")
  OPT_BOOL(immediateFileFlush,             "iff", "immediate-file-flush",               false,                   "Flush log files after each line instead of buffering")
  OPT_STRING(logDirectory,                 "log", "log-directory",                      "",                      "Directory to save logs in") //[[AUTOCOMPLETE_DIRECTORY]]
@@ -102,6 +104,10 @@ OPTION_GROUP(grpJob, "job", "Global configuration of jobs")
  OPT_INT(maxDemand,                       "md", "max-demand",                          0,    0, LARGE_INT,      "Limit any job's demand to this value")
  OPT_INT(numThreadsPerProcess,            "t", "threads-per-process",                  1,    1, MALLOB_MAX_N_APPTHREADS_PER_PROCESS,      "Number of application worker threads per MPI process")
  OPT_BOOL(aggressiveDescriptionCaching, "adc", "aggressive-desc-caching", false, "Try to reuse cached job descriptions by only transferring them when not repairable without them")
+ OPT_BOOL(descriptionCutThrough, "dct", "description-cut-through", false, "Forward each fragment of a large job description to waiting child PEs as soon as it arrives instead of after receiving the full description")
+ OPT_BOOL(compressDescriptionTransfer,    "cdt", "compress-desc-transfer",             false,                   "Compress the formula payload of job descriptions transferred within job trees")
+ OPT_FLOAT(hostDescriptionDedupWait,      "hddw", "host-desc-dedup-wait",              0,    0, LARGE_INT,      "Fetch each job description only once per host, waiting at most this many seconds for a description fetched by another process on the host (0: disabled)")
+ OPT_BOOL(reportDescriptionReadiness,     "rdr", "report-desc-readiness",              false,                   "Report to a job's root when each PE has received a revision of the job description and log the latencies")
  OPT_BOOL(crossJobCommunication, "cjc", "cross-job-communication", false, "Enable communication across jobs, such as cross-problem clause sharing, within user-specified job groups")
 
 ///////////////////////////////////////////////////////////////////////
@@ -117,8 +123,14 @@ OPTION_GROUP(grpApp, "app", "Application-specific options")
 OPTION_GROUP(grpPerformance, "performance", "Performance")
  OPT_BOOL(memoryPanic,                    "mempanic", "",                              true,                    "Monitor RAM usage per physical machine and switch to memory panic mode if necessary")
  OPT_INT(messageBatchingThreshold,        "mbt", "message-batching-threshold",         8388608, 1000, MAX_INT,  "Employ batching of messages in batches of provided size")
+ OPT_INT(messageCoalescingThreshold,      "mct", "message-coalescing-threshold",       0,    0, MAX_INT,        "Send messages of at most this many bytes to the same destination together in one MPI message (0: disabled)")
+ OPT_INT(messageCoalescingBytes,          "mcb", "message-coalescing-bytes",           65536, 64, MAX_INT,      "Send coalesced messages as soon as they amount to this many bytes")
+ OPT_INT(messageCoalescingMicrosecs,      "mcus", "message-coalescing-microsecs",      200,  0, LARGE_INT,      "Send coalesced messages at the latest this many microseconds after the first of them (checked once per main loop cycle)")
+ OPT_BOOL(messageProgressThread,          "mpt", "message-progress-thread",            false,                   "Receive, assemble and send messages in a dedicated thread which hands received messages to the main thread (requires MPI_THREAD_MULTIPLE)")
+ OPT_INT(messageProgressSleepMicrosecs,   "mpsus", "message-progress-sleep-microsecs", 10,   0, LARGE_INT,      "Sleep this many microseconds whenever the message progress thread found nothing to do")
  OPT_INT(processesPerHost,                "pph", "processes-per-host",                 0,    0, LARGE_INT,      "Tells Mallob how many MPI processes are executed on each physical host")
  OPT_BOOL(regularProcessDistribution,     "rpa", "regular-process-allocation",         false,                   "Signal that processes have been allocated regularly, i.e., the i-th machine hosts ranks c*i through c*i + c-1")
+ OPT_INT(shmemCacheCap,                   "shmcc", "shmem-cache-cap",                  0,    0, MAX_INT,        "Retain unused formulae in the machine-wide shared memory cache up to this many MiB, evicting least recently used ones (0: delete at last reference)")
  OPT_INT(sleepMicrosecs,                  "sleep", "",                                 100,  0, LARGE_INT,      "Sleep this many microseconds between loop cycles of worker main thread")
  OPT_BOOL(yield,                          "yield", "",                                 false,                   "Yield manager thread whenever there are no new messages")
  OPT_INT(maxLiteralsPerThread,              "mlpt", "max-lits-per-thread",               50000000, 0,   MAX_INT,    
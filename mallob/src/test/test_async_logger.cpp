@@ -0,0 +1,165 @@
+
+#include <atomic>
+#include <fstream>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/fileutils.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/timer.hpp"
+
+const std::string logDir = "/tmp/mallob_test_async_logger";
+
+std::string initLogger(const std::string& name, bool async, int verbosity = V5_DEBG) {
+    Logger::LoggerConfig config;
+    config.rank = 0;
+    config.verbosity = verbosity;
+    config.quiet = true;
+    config.async = async;
+    config.logDirOrNull = &logDir;
+    config.logFilenameOrNull = &name;
+    Logger::init(config);
+    std::string path = logDir + "/0/" + name;
+    std::ofstream(path, std::ios::trunc); // start with an empty file
+    return path;
+}
+
+std::vector<std::string> readLines(const std::string& path) {
+    Logger::getMainInstance().flush();
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+    return lines;
+}
+
+void logVariousFormats() {
+    std::string dynamicFormat = "dynamic format %i %s\n";
+    std::string str = "a string";
+    LOG_OMIT_PREFIX(V2_INFO, "ints %i %d %5i %-5i| %05d %+d %u %x %X %o %c\n", -1, 2, 3, 4, 5, 6, 7u, 255u, 255u, 8u, 'z');
+    LOG_OMIT_PREFIX(V2_INFO, "longs %ld %lu %lld %llu %zu %lx\n", -1L, 2UL, -3LL, 4ULL, (size_t) 5, 6UL);
+    LOG_OMIT_PREFIX(V2_INFO, "small %hhd %hd %hu\n", (char) 7, (short) -8, (unsigned short) 9);
+    LOG_OMIT_PREFIX(V2_INFO, "floats %.3f %f %e %g %10.2f %Lf\n", 1.23456f, -2.5, 1e10, 0.0001, 3.14159, (long double) 2.5);
+    LOG_OMIT_PREFIX(V2_INFO, "strings %s|%10s|%-10s|%.3s|%s\n", str.c_str(), "right", "left", "truncated", (const char*) nullptr);
+    LOG_OMIT_PREFIX(V2_INFO, "stars %*i|%-*i|%.*f|%*.*f\n", 6, 1, 6, 2, 2, 3.14159, 8, 3, 2.71828);
+    LOG_OMIT_PREFIX(V2_INFO, "percent 100%% %i%%\n", 50);
+    LOG_OMIT_PREFIX(V2_INFO, "positional %2$i %1$i\n", 1, 2);
+    LOG_OMIT_PREFIX(V2_INFO, dynamicFormat.c_str(), 42, str.c_str());
+    LOG_OMIT_PREFIX(V2_INFO, "%s\n", std::string(100000, 'x').c_str());
+    LOG_OMIT_PREFIX(V2_INFO, "no args\n");
+    LOG_OMIT_PREFIX(V6_DEBGV, "filtered\n");
+    LOG_ADD_DEST(V2_INFO, "with destination %i", 17, 3);
+    LOG_ADD_SRC(V2_INFO, "with source", 5);
+    LOG(V2_INFO, "with prefix %i\n", 1);
+}
+
+// Formatting must be the same as for synchronous logging.
+void testSameOutput() {
+    std::vector<std::string> expected, actual;
+    for (bool async : {false, true}) {
+        auto path = initLogger(async ? "async" : "sync", async);
+        logVariousFormats();
+        (async ? actual : expected) = readLines(path);
+    }
+    assert(expected.size() == actual.size() || log_return_false("[ERROR] %lu lines instead of %lu\n", actual.size(), expected.size()));
+    for (size_t i = 0; i < expected.size(); i++) {
+        // Prefixed lines: the timestamps may differ
+        if (i+3 >= expected.size()) {
+            expected[i] = expected[i].substr(expected[i].find(' '));
+            actual[i] = actual[i].substr(actual[i].find(' '));
+        }
+        assert(expected[i] == actual[i] || log_return_false("[ERROR] line %lu: \"%s\" instead of \"%s\"\n",
+            i, actual[i].c_str(), expected[i].c_str()));
+    }
+    initLogger("test", false);
+    LOG(V2_INFO, "Same output: %lu lines\n", expected.size());
+}
+
+// Lines of each thread must be complete and in order.
+void testConcurrentThreads(int nbThreads, int nbLinesPerThread) {
+    auto path = initLogger("threads", true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nbThreads; t++) {
+        threads.emplace_back([t, nbLinesPerThread]() {
+            for (int i = 0; i < nbLinesPerThread; i++) LOG_OMIT_PREFIX(V4_VVER, "T %i %i\n", t, i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    auto lines = readLines(path);
+    std::vector<int> next(nbThreads, 0);
+    for (auto& line : lines) {
+        int t, i;
+        int nbParsed = sscanf(line.c_str(), "T %i %i", &t, &i);
+        assert(nbParsed == 2);
+        assert(i == next[t] || log_return_false("[ERROR] thread %i: line %i instead of %i\n", t, i, next[t]));
+        next[t]++;
+    }
+    assert(lines.size() == (size_t) nbThreads * nbLinesPerThread);
+    initLogger("test", false);
+    LOG(V2_INFO, "%i threads: %lu lines complete and in order\n", nbThreads, lines.size());
+}
+
+// Average duration of a logging call at verbosity V4 for the given number of threads.
+// Each thread logs burstSize lines at a time; writing out all lines after each burst
+// is not included. With large bursts, the asynchronous backend is limited by the
+// throughput of its drain thread.
+double benchmark(bool async, int nbThreads, int nbBursts, int burstSize) {
+    initLogger(async ? "bench_async" : "bench_sync", async, V4_VVER);
+    auto& backend = AsyncLoggerBackend::get();
+    unsigned long nbWaitsBefore = backend.getNbWaits();
+    std::string str = "some string";
+    std::atomic_int burst {-1};
+    std::atomic_int nbDone {0};
+    std::vector<double> times(nbThreads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nbThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int b = 0; b < nbBursts; b++) {
+                while (burst.load() < b) sched_yield();
+                float startTime = Timer::elapsedSeconds();
+                for (int i = 0; i < burstSize; i++)
+                    LOG(V4_VVER, "Benchmark line %i from thread %i: %s %.4f\n", i, t, str.c_str(), 0.001 * i);
+                times[t] += Timer::elapsedSeconds() - startTime;
+                nbDone++;
+            }
+        });
+    }
+    for (int b = 0; b < nbBursts; b++) {
+        burst.store(b);
+        while (nbDone.load() < (b+1) * nbThreads) sched_yield();
+        Logger::getMainInstance().flush();
+    }
+    for (auto& thread : threads) thread.join();
+    unsigned long nbWaits = backend.getNbWaits() - nbWaitsBefore;
+    initLogger("test", false);
+    double sumOfTimes = 0;
+    for (double time : times) sumOfTimes += time;
+    double nsPerCall = 1e9 * sumOfTimes / ((double) nbThreads * nbBursts * burstSize);
+    LOG(V2_INFO, "%s, %i threads, bursts of %i lines: %.1f ns per log call (%lu waits for a full buffer)\n",
+        async ? "async" : "sync", nbThreads, burstSize, nsPerCall, nbWaits);
+    return nsPerCall;
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    FileUtils::mkdir(logDir);
+    initLogger("test", false);
+    Process::init(0);
+
+    testSameOutput();
+    testConcurrentThreads(1, 100000);
+    testConcurrentThreads(8, 50000);
+
+    for (int nbThreads : {1, 4}) {
+        for (bool async : {false, true}) {
+            benchmark(async, nbThreads, 200, 1000);
+            benchmark(async, nbThreads, 1, 200000);
+        }
+    }
+}
@@ -0,0 +1,271 @@
+
+#include <stdio.h>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/params.hpp"
+#include "util/static_store.hpp"
+#include "util/sys/fileutils.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/proc.hpp"
+#include "util/sys/timer.hpp"
+#include "app/app_registry.hpp"
+#include "data/job_metadata.hpp"
+#include "data/job_result.hpp"
+#include "interface/json_interface.hpp"
+#include "interface/result_record.hpp"
+
+// Compares the throughput of the JSON interface for many tiny jobs:
+// one JSON request and one JSON result file per job (as done by the filesystem
+// connectors) vs. batched requests and an append-only binary result stream.
+
+const int SOLUTION_SIZE = 20;
+
+struct Setup {
+    Parameters params;
+    std::vector<JobMetadata> submitted;
+    std::unique_ptr<JsonInterface> interface;
+
+    Setup(const std::string& dir) {
+        interface.reset(new JsonInterface(0, params, Logger::getMainInstance().copy("I", ".I"),
+            [&](JobMetadata&& data) {submitted.push_back(std::move(data));}, JobIdAllocator(0, 1, dir)));
+    }
+
+    // Plays the role of Mallob: each submitted job is finished right away.
+    void finishJobs() {
+        for (auto& data : submitted) {
+            JobResult result;
+            result.id = data.description->getId();
+            result.revision = data.description->getRevision();
+            result.result = 10;
+            std::vector<int> solution(SOLUTION_SIZE);
+            for (int i = 0; i < SOLUTION_SIZE; i++) solution[i] = i % 2 == 0 ? i : -i;
+            result.setSolution(std::move(solution));
+            JobProcessingStatistics stats;
+            stats.processingTime = 0.001;
+            interface->handleJobDone(std::move(result), stats, data.description->getApplicationId());
+        }
+        submitted.clear();
+    }
+};
+
+nlohmann::json makeJob(int i) {
+    return nlohmann::json {{"user", "test"}, {"name", "job-" + std::to_string(i)},
+        {"application", "DUMMY"}, {"literals", {1, 2, 0, -1, 0}}};
+}
+
+float runIndividual(int nbJobs, const std::string& dir) {
+    Setup setup(dir);
+    // Same procedure as in InotifyFilesystemConnector
+    auto cb = [&](nlohmann::json& result) {
+        std::string jobName = result["user"].get<std::string>() + "." + result["name"].get<std::string>() + ".json";
+        std::string outFilepath = dir + "/~" + jobName;
+        {
+            std::ofstream o(outFilepath);
+            o << std::setw(4) << result << std::endl;
+        }
+        std::rename(outFilepath.c_str(), (dir + "/out/" + jobName).c_str());
+    };
+    float time = Timer::elapsedSeconds();
+    for (int i = 0; i < nbJobs; i++) {
+        auto request = nlohmann::json::parse(makeJob(i).dump());
+        auto res = setup.interface->handle(request, cb);
+        assert(res == JsonInterface::ACCEPT);
+    }
+    assert(setup.submitted.size() == nbJobs);
+    setup.finishJobs();
+    return Timer::elapsedSeconds() - time;
+}
+
+float runBatched(int nbJobs, int batchSize, const std::string& dir) {
+    Setup setup(dir);
+    ResultRecordFile resultStream(dir + "/out/results.bin");
+    auto cb = [&](nlohmann::json& result) {abort();};
+    float time = Timer::elapsedSeconds();
+    for (int begin = 0; begin < nbJobs; begin += batchSize) {
+        nlohmann::json batch {{"user", "test"}, {"application", "DUMMY"}, {"result-stream", "binary"}};
+        batch["batch"] = nlohmann::json::array();
+        for (int i = begin; i < std::min(nbJobs, begin+batchSize); i++) {
+            auto job = makeJob(i);
+            job.erase("user");
+            job.erase("application");
+            batch["batch"].push_back(std::move(job));
+        }
+        auto request = nlohmann::json::parse(batch.dump());
+        auto results = setup.interface->handleBatch(request, cb, [&](const std::vector<uint8_t>& record) {
+            resultStream.append(record);
+        });
+        for (auto res : results) assert(res == JsonInterface::ACCEPT);
+        setup.finishJobs();
+    }
+    time = Timer::elapsedSeconds() - time;
+    assert(resultStream.getNbRecords() == nbJobs);
+
+    // Check all records
+    auto records = ResultRecordFile::readAll(resultStream.getPath());
+    assert(records.size() == nbJobs);
+    for (int i = 0; i < nbJobs; i++) {
+        auto& rec = records[i];
+        assert(rec.jobName == "test.job-" + std::to_string(i) || log_return_false("%s\n", rec.jobName.c_str()));
+        assert(rec.resultCode == 10);
+        assert(rec.revision == 0);
+        assert(rec.processingTime > 0);
+        assert(rec.solution.size() == SOLUTION_SIZE);
+        for (int k = 0; k < SOLUTION_SIZE; k++) assert(rec.solution[k] == (k % 2 == 0 ? k : -k));
+    }
+    return time;
+}
+
+void testMalformedBatch(const std::string& dir) {
+    Setup setup(dir);
+    auto cb = [&](nlohmann::json& result) {};
+    nlohmann::json batch {{"user", "test"}, {"application", "DUMMY"}, {"batch", {makeJob(0), makeJob(0),
+        nlohmann::json {{"name", "x"}, {"application", "UNKNOWN"}}}}};
+    auto results = setup.interface->handleBatch(batch, cb, {});
+    // The duplicate and the job with an unknown application are rejected individually
+    assert(results.size() == 3);
+    assert(results[0] == JsonInterface::ACCEPT);
+    assert(results[1] == JsonInterface::DISCARD);
+    assert(results[2] == JsonInterface::DISCARD);
+    assert(setup.submitted.size() == 1);
+    setup.finishJobs();
+
+    // Binary results requested, but not supported by the caller
+    batch = nlohmann::json {{"result-stream", "binary"}, {"batch", {makeJob(1)}}};
+    results = setup.interface->handleBatch(batch, cb, {});
+    assert(results.size() == 1 && results[0] == JsonInterface::DISCARD);
+    assert(setup.submitted.empty());
+
+    // Entries which are not JSON objects and a result stream which is not a string
+    batch = nlohmann::json {{"user", "test"}, {"application", "DUMMY"}, {"result-stream", 5},
+        {"batch", {1, makeJob(2), "x"}}};
+    results = setup.interface->handleBatch(batch, cb, {});
+    assert(results.size() == 3);
+    assert(results[0] == JsonInterface::DISCARD);
+    assert(results[1] == JsonInterface::ACCEPT);
+    assert(results[2] == JsonInterface::DISCARD);
+    assert(setup.submitted.size() == 1);
+    setup.finishJobs();
+
+    // The batch has been concluded: the ID of an individual submission is persisted right away
+    auto job = makeJob(3);
+    auto res = setup.interface->handle(job, cb);
+    assert(res == JsonInterface::ACCEPT);
+    int lastId = -1;
+    std::ifstream ifs(dir + "/.last_id");
+    ifs >> lastId;
+    assert(lastId == setup.submitted.back().description->getId());
+    setup.finishJobs();
+}
+
+// An incremental job stream as submitted by a client-side program: each increment as a JSON
+// with preloaded literals which the client's reader copies into the description, vs. a binary
+// submission which writes the literals directly into the description's revision buffer.
+float runIncrementalStream(int nbIncrements, bool binary, const std::string& dir) {
+    Setup setup(dir);
+    std::vector<int> lits;
+    for (int c = 0; c < 1000; c++) lits.insert(lits.end(), {c+1, -(c+2), c+3, 0});
+    const std::vector<int> assumptions {1, -2, 3};
+    int nbResults = 0;
+    float time = Timer::elapsedSeconds();
+    for (int i = 0; i < nbIncrements; i++) {
+        const std::string name = "inc-" + std::to_string(i);
+        const std::string precursor = i == 0 ? "" : "inc-" + std::to_string(i-1);
+        if (binary) {
+            JsonInterface::BinarySubmission sub;
+            sub.user = "test";
+            sub.name = name;
+            sub.precursor = precursor;
+            sub.incremental = true;
+            sub.applicationId = app_registry::getAppId("DUMMY");
+            sub.configuration["__NV"] = "1001";
+            sub.fillDescription = [&](JobDescription& desc) {
+                desc.addPermanentData(lits.data(), lits.size());
+                for (int lit : assumptions) desc.addTransientData(lit);
+            };
+            auto res = setup.interface->handleBinary(sub, [&, i](const std::vector<uint8_t>& record) {
+                ResultRecord rec;
+                bool success = rec.deserialize(record.data(), record.size());
+                assert(success);
+                assert(rec.jobName == "test.inc-" + std::to_string(i));
+                assert(rec.revision == i);
+                nbResults++;
+            });
+            assert(res == JsonInterface::ACCEPT);
+            assert(setup.submitted.back().initialized);
+        } else {
+            nlohmann::json json {{"user", "test"}, {"name", name}, {"application", "DUMMY"},
+                {"incremental", true}, {"configuration", {{"__NV", "1001"}}}, {"assumptions", assumptions}};
+            if (!precursor.empty()) json["precursor"] = "test." + precursor;
+            StaticStore<std::vector<int>>::insert(name, std::vector<int>(lits));
+            json["internalliterals"] = name;
+            auto res = setup.interface->handle(json, [&, i](nlohmann::json& result) {
+                assert(result["internal_revision"].get<int>() == i);
+                nbResults++;
+            });
+            assert(res == JsonInterface::ACCEPT);
+            // Done by the client's reader
+            auto& desc = *setup.submitted.back().description;
+            desc.beginInitialization(desc.getRevision());
+            desc.endInitialization();
+        }
+        auto& desc = *setup.submitted.back().description;
+        assert(desc.getRevision() == i);
+        assert(desc.getFormulaPayloadSize(i) == lits.size());
+        assert(desc.getAssumptionsSize(i) == assumptions.size());
+        assert(memcmp(desc.getFormulaPayload(i), lits.data(), lits.size()*sizeof(int)) == 0);
+        assert(memcmp(desc.getAssumptionsPayload(i), assumptions.data(), assumptions.size()*sizeof(int)) == 0);
+        setup.finishJobs();
+    }
+    time = Timer::elapsedSeconds() - time;
+    assert(nbResults == nbIncrements);
+
+    // Conclude the stream
+    nlohmann::json done {{"user", "test"}, {"name", "inc-" + std::to_string(nbIncrements)}, {"application", "DUMMY"},
+        {"incremental", true}, {"precursor", "test.inc-" + std::to_string(nbIncrements-1)}, {"done", true}};
+    auto res = setup.interface->handle(done, [](nlohmann::json&) {});
+    assert(res == JsonInterface::ACCEPT_CONCLUDE);
+    return time;
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V2_INFO);
+    Process::init(0);
+
+    app_registry::registerApplication("DUMMY",
+        [](const Parameters&, const std::vector<std::string>&, JobDescription&) {return true;},
+        [](const Parameters&, const Job::JobSetup&, AppMessageTable&) {return (Job*) nullptr;},
+        [](const Parameters&, const JobResult& result, const JobProcessingStatistics&) {
+            return nlohmann::json(result.copySolution());
+        });
+
+    std::string dir = "/tmp/mallob_test_batch_submission." + std::to_string(Proc::getPid());
+    FileUtils::mkdir(dir + "/out/");
+
+    testMalformedBatch(dir);
+
+    const int nbJobs = 10000;
+    float time = runIndividual(nbJobs, dir);
+    LOG(V2_INFO, "%i jobs: %.1f jobs/s individually with JSON result files\n", nbJobs, nbJobs / time);
+    for (int batchSize : {1, 100, 10000}) {
+        FileUtils::rm(dir + "/out/results.bin");
+        time = runBatched(nbJobs, batchSize, dir);
+        LOG(V2_INFO, "%i jobs: %.1f jobs/s in batches of %i with binary results\n", nbJobs, nbJobs / time, batchSize);
+    }
+
+    const int nbIncrements = 2000;
+    for (bool binary : {false, true}) {
+        time = runIncrementalStream(nbIncrements, binary, dir);
+        LOG(V2_INFO, "%i increments: %.1f increments/s with %s submission\n", nbIncrements, nbIncrements / time,
+            binary ? "binary" : "JSON");
+    }
+    FileUtils::rmrf(dir);
+}
@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/random.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+#include "app/sat/sharing/buffer/buffer_builder.hpp"
+#include "app/sat/sharing/buffer/buffer_merger.hpp"
+#include "app/sat/sharing/buffer/buffer_reader.hpp"
+#include "app/sat/data/clause.hpp"
+#include "app/sat/data/clause_comparison.hpp"
+
+struct MergeSetup {
+    int maxEffClauseLength;
+    bool slotsForSumOfLengthAndLbd;
+};
+
+// Creates buffers of random clauses, each sorted in the order expected by BufferBuilder
+std::vector<std::vector<int>> produceBuffers(const MergeSetup& setup, int nbBuffers, int nbClausesPerBuffer, int maxVar) {
+    std::vector<std::vector<int>> buffers;
+    for (int i = 0; i < nbBuffers; i++) {
+        std::vector<std::vector<int>> clauseLits;
+        std::vector<Clause> clauses;
+        for (int j = 0; j < nbClausesPerBuffer; j++) {
+            int clauseSize = 1 + (int) (Random::rand() * setup.maxEffClauseLength);
+            clauseSize = std::min(clauseSize, setup.maxEffClauseLength);
+            std::vector<int> lits;
+            for (int l = 0; l < clauseSize; l++) {
+                lits.push_back((Random::rand() < 0.5 ? -1 : 1) * (1 + (int) (Random::rand()*maxVar)));
+            }
+            std::sort(lits.begin(), lits.end());
+            int glue = clauseSize == 1 ? 1 : 2 + (int) (Random::rand() * (clauseSize-1));
+            glue = std::min(glue, clauseSize);
+            clauseLits.push_back(std::move(lits));
+            clauses.emplace_back(clauseLits.back().data(), clauseSize, glue);
+        }
+        AbstractClauseThreewayComparator* threewayCompare = setup.slotsForSumOfLengthAndLbd ?
+            (AbstractClauseThreewayComparator*) new LengthLbdSumClauseThreewayComparator(setup.maxEffClauseLength+2) :
+            (AbstractClauseThreewayComparator*) new LexicographicClauseThreewayComparator();
+        std::sort(clauses.begin(), clauses.end(), ClauseComparator(threewayCompare));
+        delete threewayCompare;
+
+        BufferBuilder builder(-1, setup.maxEffClauseLength, setup.slotsForSumOfLengthAndLbd);
+        for (auto& c : clauses) builder.append(c);
+        buffers.push_back(builder.extractBuffer());
+    }
+    return buffers;
+}
+
+std::vector<int> merge(const MergeSetup& setup, std::vector<std::vector<int>>& buffers,
+        int sizeLimit, bool loserTree, std::vector<int>& excess) {
+    BufferMerger merger(sizeLimit, setup.maxEffClauseLength, 0, setup.slotsForSumOfLengthAndLbd);
+    merger.setLoserTreeMerging(loserTree);
+    for (auto& buffer : buffers) merger.add(BufferReader(buffer.data(), buffer.size(),
+        setup.maxEffClauseLength, setup.slotsForSumOfLengthAndLbd));
+    return merger.mergePreservingExcess(excess);
+}
+
+void testEquivalence(bool slotsForSumOfLengthAndLbd) {
+    LOG(V2_INFO, "Testing equivalence of merge engines (sum slots: %s) ...\n", slotsForSumOfLengthAndLbd?"yes":"no");
+
+    MergeSetup setup {10, slotsForSumOfLengthAndLbd};
+
+    for (int nbBuffers : {1, 2, 3, 7, 16, 33}) {
+        for (int maxVar : {20, 10'000}) {
+            auto buffers = produceBuffers(setup, nbBuffers, 2'000, maxVar);
+            // Add some buffers twice to provoke exact duplicates
+            if (nbBuffers > 1) buffers.push_back(buffers.front());
+            for (int sizeLimit : {500, 5'000, 1'000'000}) {
+                std::vector<int> excessList, excessTree;
+                auto mergedList = merge(setup, buffers, sizeLimit, false, excessList);
+                auto mergedTree = merge(setup, buffers, sizeLimit, true, excessTree);
+                assert(mergedList == mergedTree || log_return_false("[ERROR] merged buffers differ "
+                    "(%i buffers, max. var %i, limit %i)\n", nbBuffers, maxVar, sizeLimit));
+                assert(excessList == excessTree || log_return_false("[ERROR] excess buffers differ "
+                    "(%i buffers, max. var %i, limit %i)\n", nbBuffers, maxVar, sizeLimit));
+            }
+        }
+    }
+}
+
+void benchmark(bool loserTree) {
+    MergeSetup setup {60, false};
+
+    for (int nbBuffers : {2, 8, 32}) {
+        auto buffers = produceBuffers(setup, nbBuffers, 20'000, 1'000'000);
+        size_t nbInputClauses = 0;
+        for (auto& buffer : buffers) {
+            BufferReader reader(buffer.data(), buffer.size(), setup.maxEffClauseLength, setup.slotsForSumOfLengthAndLbd);
+            while (reader.getNextIncomingClause().begin != nullptr) nbInputClauses++;
+        }
+        const int nbReps = 5;
+        float time = Timer::elapsedSeconds();
+        for (int rep = 0; rep < nbReps; rep++) {
+            std::vector<int> excess;
+            auto merged = merge(setup, buffers, 1'000'000, loserTree, excess);
+        }
+        time = Timer::elapsedSeconds() - time;
+        LOG(V2_INFO, "%s merge of %i buffers: %.3f Mcls/s\n", loserTree ? "loser tree" : "sorted list",
+            nbBuffers, nbReps * nbInputClauses / time / 1'000'000);
+    }
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(1);
+
+    testEquivalence(false);
+    testEquivalence(true);
+    benchmark(false);
+    benchmark(true);
+}
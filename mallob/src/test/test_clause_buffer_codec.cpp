@@ -0,0 +1,93 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/random.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+#include "app/sat/sharing/buffer/buffer_builder.hpp"
+#include "app/sat/sharing/buffer/buffer_reader.hpp"
+#include "app/sat/sharing/buffer/clause_buffer_codec.hpp"
+#include "app/sat/data/clause.hpp"
+#include "app/sat/data/clause_comparison.hpp"
+
+// Buffer of random clauses with sorted literals, as produced by the sharing manager
+std::vector<int> produceBuffer(int maxEffClauseLength, int nbClauses, int maxVar) {
+    std::vector<std::vector<int>> clauseLits;
+    std::vector<Mallob::Clause> clauses;
+    clauseLits.reserve(nbClauses);
+    for (int i = 0; i < nbClauses; i++) {
+        int clauseSize = std::min(maxEffClauseLength, 1 + (int) (Random::rand() * maxEffClauseLength));
+        std::vector<int> lits;
+        for (int l = 0; l < clauseSize; l++) {
+            lits.push_back((Random::rand() < 0.5 ? -1 : 1) * (1 + (int) (Random::rand()*maxVar)));
+        }
+        std::sort(lits.begin(), lits.end());
+        int glue = clauseSize == 1 ? 1 : 2 + (int) (Random::rand() * (clauseSize-1));
+        glue = std::min(glue, clauseSize);
+        clauseLits.push_back(std::move(lits));
+        clauses.emplace_back(clauseLits.back().data(), clauseSize, glue);
+    }
+    LexicographicClauseThreewayComparator threewayCompare;
+    std::sort(clauses.begin(), clauses.end(), ClauseComparator(&threewayCompare));
+    BufferBuilder builder(-1, maxEffClauseLength, false);
+    for (auto& c : clauses) builder.append(c);
+    return builder.extractBuffer();
+}
+
+void testRoundTrip(const std::vector<int>& buffer) {
+    auto encoded = ClauseBufferCodec::encode(buffer);
+    auto decoded = ClauseBufferCodec::decode(encoded);
+    assert(decoded == buffer || log_return_false("[ERROR] round trip failed for buffer of size %lu\n", buffer.size()));
+}
+
+void testEdgeCases() {
+    LOG(V2_INFO, "Testing edge cases ...\n");
+    testRoundTrip({});
+    testRoundTrip({0});
+    testRoundTrip({0, 0, 0, 1, 0, -1});
+    testRoundTrip({INT_MAX, INT_MIN, INT_MAX, INT_MIN, 0, INT_MIN});
+    std::vector<int> random;
+    for (int i = 0; i < 100'000; i++) random.push_back((int) (Random::rand() * UINT32_MAX));
+    testRoundTrip(random);
+}
+
+void testClauseBuffers() {
+    LOG(V2_INFO, "Testing clause buffers ...\n");
+    for (int maxVar : {100, 10'000, 1'000'000}) {
+        auto buffer = produceBuffer(30, 50'000, maxVar);
+        // Append some trailing metadata like the in-place clause aggregation does
+        buffer.push_back(3); buffer.push_back(-1); buffer.push_back(123'456);
+        testRoundTrip(buffer);
+
+        const int nbReps = 5;
+        float time = Timer::elapsedSeconds();
+        std::vector<int> encoded;
+        for (int rep = 0; rep < nbReps; rep++) encoded = ClauseBufferCodec::encode(buffer);
+        float timeEncode = Timer::elapsedSeconds() - time;
+        time = Timer::elapsedSeconds();
+        for (int rep = 0; rep < nbReps; rep++) ClauseBufferCodec::decode(encoded);
+        float timeDecode = Timer::elapsedSeconds() - time;
+        float mbytes = nbReps * buffer.size() * sizeof(int) / 1'000'000.f;
+        LOG(V2_INFO, "max. var %i: %lu bytes -> %lu bytes (ratio %.3f), encode %.1f MB/s, decode %.1f MB/s\n",
+            maxVar, buffer.size()*sizeof(int), encoded.size()*sizeof(int),
+            buffer.size() / (float) encoded.size(), mbytes / timeEncode, mbytes / timeDecode);
+        assert(encoded.size() < buffer.size());
+    }
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(1);
+
+    testEdgeCases();
+    testClauseBuffers();
+}
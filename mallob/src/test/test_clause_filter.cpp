@@ -0,0 +1,221 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/random.hpp"
+#include "util/logger.hpp"
+#include "util/sys/timer.hpp"
+#include "app/sat/data/clause.hpp"
+#include "app/sat/data/produced_clause_candidate.hpp"
+#include "app/sat/sharing/store/adaptive_clause_store.hpp"
+#include "app/sat/data/sharing_statistics.hpp"
+#include "app/sat/sharing/filter/bloom_clause_filter.hpp"
+#include "app/sat/sharing/filter/exact_clause_filter.hpp"
+#include "app/sat/sharing/filter/fingerprint_clause_filter.hpp"
+
+const int maxEffClauseLength = 20;
+const int epochHorizon = 3;
+
+AdaptiveClauseStore::Setup getStoreSetup(int numLiterals) {
+    AdaptiveClauseStore::Setup setup;
+    setup.maxEffectiveClauseLength = maxEffClauseLength;
+    setup.maxLbdPartitionedSize = 2;
+    setup.numLiterals = numLiterals;
+    setup.slotsForSumOfLengthAndLbd = false;
+    return setup;
+}
+
+std::vector<int> randomClause(int maxVar) {
+    int size = 1 + (int) (Random::rand() * 6);
+    std::vector<int> lits;
+    while (lits.size() < size) {
+        int lit = (Random::rand() < 0.5 ? -1 : 1) * (1 + (int) (Random::rand() * maxVar));
+        if (std::find(lits.begin(), lits.end(), lit) == lits.end()
+            && std::find(lits.begin(), lits.end(), -lit) == lits.end()) lits.push_back(lit);
+    }
+    std::sort(lits.begin(), lits.end());
+    return lits;
+}
+
+// The fingerprint filter must make the same decisions as the exact filter
+// (barring fingerprint collisions, which are practically impossible here).
+void testEquivalenceWithExactFilter() {
+    LOG(V2_INFO, "Testing equivalence with exact filter ...\n");
+
+    AdaptiveClauseStore exactStore(getStoreSetup(20'000)), fpStore(getStoreSetup(20'000));
+    ExactClauseFilter exact(exactStore, epochHorizon, maxEffClauseLength);
+    FingerprintClauseFilter fp(fpStore, epochHorizon, maxEffClauseLength);
+    Logger& logger = Logger::getMainInstance();
+
+    std::vector<std::vector<int>> pool;
+    for (int i = 0; i < 2'000; i++) pool.push_back(randomClause(50));
+
+    for (int epoch = 0; epoch < 30; epoch++) {
+        exact.updateEpoch(epoch);
+        fp.updateEpoch(epoch);
+        for (int i = 0; i < 1'000; i++) {
+            auto& lits = pool[(int) (Random::rand() * pool.size())];
+            int producer = (int) (Random::rand() * 8);
+            int lbd = std::min(2, (int) lits.size());
+            auto resExact = exact.tryRegisterAndInsert(ProducedClauseCandidate(lits.data(), lits.size(), lbd, producer, epoch));
+            auto resFp = fp.tryRegisterAndInsert(ProducedClauseCandidate(lits.data(), lits.size(), lbd, producer, epoch));
+            assert(resExact == resFp || log_return_false("[ERROR] epoch %i: exact=%i fp=%i\n", epoch, resExact, resFp));
+        }
+        assert(exact.size(0) == fp.size(0) || log_return_false("[ERROR] epoch %i: exact size %lu, fp size %lu\n",
+            epoch, exact.size(0), fp.size(0)));
+
+        // Share some clauses
+        for (int i = 0; i < 300; i++) {
+            auto& lits = pool[(int) (Random::rand() * pool.size())];
+            Mallob::Clause c(lits.data(), lits.size(), std::min(2, (int) lits.size()));
+            bool admExact = exact.admitSharing(c, epoch);
+            bool admFp = fp.admitSharing(c, epoch);
+            assert(admExact == admFp);
+            if (!admExact) continue;
+            auto prodExact = exact.confirmSharingAndGetProducers(c, epoch);
+            auto prodFp = fp.confirmSharingAndGetProducers(c, epoch);
+            assert(prodExact == prodFp || log_return_false("[ERROR] producers differ: %u vs. %u\n", prodExact, prodFp));
+        }
+
+        // Flush the stores to make space for new clauses
+        int nbExported, nbLits;
+        exactStore.exportBuffer(100'000, nbExported, nbLits);
+        fpStore.exportBuffer(100'000, nbExported, nbLits);
+        exact.collectGarbage(logger);
+        fp.collectGarbage(logger);
+        assert(exact.size(0) == fp.size(0));
+    }
+}
+
+void testConcurrentInsertion() {
+    LOG(V2_INFO, "Testing concurrent insertion ...\n");
+
+    const int nbThreads = 8;
+    const int nbClauses = 100'000;
+    AdaptiveClauseStore store(getStoreSetup(1'000'000));
+    FingerprintClauseFilter fp(store, epochHorizon, maxEffClauseLength);
+    Logger& logger = Logger::getMainInstance();
+
+    std::vector<std::vector<int>> pool;
+    for (int i = 0; i < nbClauses; i++) pool.push_back(randomClause(1'000'000));
+
+    std::atomic_int nbAdmitted {0}, nbFiltered {0}, nbDropped {0}, nbRefused {0};
+    std::atomic_bool done {false};
+    std::vector<std::thread> threads;
+    float time = Timer::elapsedSeconds();
+    for (int t = 0; t < nbThreads; t++) {
+        threads.emplace_back([&, t]() {
+            // Each thread inserts all clauses, starting at a different offset
+            for (int i = 0; i < nbClauses; i++) {
+                auto& lits = pool[(i + t * nbClauses / nbThreads) % nbClauses];
+                if (!fp.tryAcquireLock(lits.size())) {
+                    nbRefused++;
+                    continue;
+                }
+                auto res = fp.tryRegisterAndInsert(ProducedClauseCandidate(lits.data(), lits.size(),
+                    std::min(2, (int) lits.size()), t, 0));
+                fp.releaseLock(lits.size());
+                if (res == GenericClauseFilter::ADMITTED) nbAdmitted++;
+                if (res == GenericClauseFilter::FILTERED) nbFiltered++;
+                if (res == GenericClauseFilter::DROPPED) nbDropped++;
+            }
+        });
+    }
+    // Concurrently grow the shards
+    std::thread gcThread([&]() {
+        while (!done) fp.collectGarbage(logger);
+    });
+    for (auto& thread : threads) thread.join();
+    time = Timer::elapsedSeconds() - time;
+    done = true;
+    gcThread.join();
+
+    LOG(V2_INFO, "%i threads: adm=%i flt=%i drp=%i ref=%i size=%lu - %.3f Mins/s\n",
+        nbThreads, nbAdmitted.load(), nbFiltered.load(), nbDropped.load(), nbRefused.load(), fp.size(0),
+        nbThreads * nbClauses / time / 1'000'000);
+    assert(nbAdmitted + nbFiltered + nbDropped + nbRefused == nbThreads * nbClauses);
+    // Identical clauses may have been admitted concurrently, but never more often than once per thread
+    assert(nbAdmitted >= fp.size(0));
+    assert(nbAdmitted <= nbThreads * fp.size(0));
+    // Each distinct clause was registered (no overflows with this number of clauses)
+    assert(fp.size(0) <= nbClauses);
+    assert(nbFiltered > 0);
+}
+
+void testBloomFilter() {
+    LOG(V2_INFO, "Testing bloom filter ...\n");
+
+    AdaptiveClauseStore store(getStoreSetup(1'000'000));
+    BloomClauseFilter bloom(store, 2, maxEffClauseLength, false, epochHorizon);
+    Logger& logger = Logger::getMainInstance();
+    auto registerClause = [&](std::vector<int>& lits, int producer) {
+        return bloom.tryRegisterAndInsert(ProducedClauseCandidate(lits.data(), lits.size(),
+            std::min(2, (int) lits.size()), producer, 0), nullptr);
+    };
+    // Only non-unit clauses
+    auto randomNonUnitClause = [&]() {
+        auto lits = randomClause(1'000'000);
+        while (lits.size() < 2) lits = randomClause(1'000'000);
+        return lits;
+    };
+
+    std::vector<std::vector<int>> pool;
+    for (int i = 0; i < 50'000; i++) pool.push_back(randomNonUnitClause());
+    int nbAdmitted = 0;
+    float time = Timer::elapsedSeconds();
+    for (auto& lits : pool) nbAdmitted += registerClause(lits, 0) != GenericClauseFilter::FILTERED;
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, "%.3f Mins/s\n", pool.size() / time / 1'000'000);
+    assert(nbAdmitted >= pool.size() - 5);
+    // Registered clauses are filtered for the same producer, but not for another one
+    int nbFiltered = 0;
+    for (auto& lits : pool) nbFiltered += registerClause(lits, 0) == GenericClauseFilter::FILTERED;
+    assert(nbFiltered == pool.size());
+    nbFiltered = 0;
+    for (int i = 0; i < 100; i++) nbFiltered += registerClause(pool[i], 1) == GenericClauseFilter::FILTERED;
+    assert(nbFiltered == 0);
+
+    // Load the filter heavily to provoke (and measure) false positives
+    for (int i = 0; i < 2'000'000; i++) {
+        auto lits = randomNonUnitClause();
+        registerClause(lits, 0);
+    }
+    SharingStatistics stats;
+    bloom.collectStatistics(stats);
+    LOG(V2_INFO, "false positives: %lu/%lu\n", stats.filterFalsePositives, stats.filterSampledQueries);
+    assert(stats.filterSampledQueries > 0);
+    assert(stats.filterFalsePositives > 0);
+    assert(stats.filterFalsePositives < stats.filterSampledQueries / 10);
+
+    // Registered clauses are forgotten after two rotations
+    bloom.updateEpoch(epochHorizon);
+    bool rotated = bloom.collectGarbage(logger);
+    assert(rotated);
+    nbFiltered = 0;
+    for (int i = 0; i < 100; i++) nbFiltered += registerClause(pool[i], 0) == GenericClauseFilter::FILTERED;
+    assert(nbFiltered == 100);
+    bloom.updateEpoch(2*epochHorizon);
+    rotated = bloom.collectGarbage(logger);
+    assert(rotated);
+    nbFiltered = 0;
+    for (int i = 0; i < 100; i++) nbFiltered += registerClause(pool[i], 0) == GenericClauseFilter::FILTERED;
+    assert(nbFiltered == 0);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(1);
+
+    testEquivalenceWithExactFilter();
+    testConcurrentInsertion();
+    testBloomFilter();
+}
@@ -0,0 +1,94 @@
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/compression.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/timer.hpp"
+
+void roundTrip(const std::vector<int>& data) {
+    std::vector<uint8_t> compressed;
+    compressIntStream(data.data(), data.size(), compressed);
+    std::vector<int> out(data.size());
+    bool success = decompressIntStream(compressed.data(), compressed.size(), out.data(), out.size());
+    assert(success);
+    assert(out == data);
+}
+
+void testRoundTrips() {
+    roundTrip({});
+    roundTrip({0});
+    roundTrip({1, -1, 0, 2, -3, 0});
+    roundTrip({INT_MAX, INT_MIN, 0, INT_MIN, INT_MAX, -1, 1, INT_MIN+1, 0});
+
+    // Arbitrary 32-bit data such as floats
+    std::vector<int> data;
+    for (float f : {0.0f, -0.0f, 1.5f, -1e30f, INFINITY, -INFINITY}) {
+        int i;
+        memcpy(&i, &f, sizeof(int));
+        data.push_back(i);
+    }
+    for (int i = 0; i < 100000; i++) data.push_back((int) (Random::rand() * UINT_MAX));
+    roundTrip(data);
+
+    // Malformed input is detected
+    std::vector<uint8_t> compressed;
+    compressIntStream(data.data(), data.size(), compressed);
+    std::vector<int> out(data.size());
+    bool success = decompressIntStream(compressed.data(), compressed.size()-1, out.data(), out.size());
+    assert(!success);
+    success = decompressIntStream(compressed.data(), compressed.size(), out.data(), out.size()-1);
+    assert(!success);
+    std::vector<uint8_t> overlong(6, 0b10000000);
+    success = decompressIntStream(overlong.data(), overlong.size(), out.data(), 1);
+    assert(!success);
+}
+
+// Random k-CNF with some locality of the variables within each clause,
+// as it is typical for formulas from applications
+std::vector<int> generateFormula(int numVars, int numClauses, int k, int locality) {
+    std::vector<int> lits;
+    for (int c = 0; c < numClauses; c++) {
+        int base = 1 + (int) (Random::rand() * numVars);
+        for (int l = 0; l < k; l++) {
+            int var = std::max(1, std::min(numVars, base + (int) (Random::rand() * 2 * locality) - locality));
+            lits.push_back(Random::rand() < 0.5 ? var : -var);
+        }
+        lits.push_back(0);
+    }
+    return lits;
+}
+
+void testFormula(int numVars, int numClauses, int k, int locality) {
+    auto lits = generateFormula(numVars, numClauses, k, locality);
+    float time = Timer::elapsedSeconds();
+    std::vector<uint8_t> compressed;
+    compressIntStream(lits.data(), lits.size(), compressed);
+    float compressTime = Timer::elapsedSeconds() - time;
+    std::vector<int> out(lits.size());
+    time = Timer::elapsedSeconds();
+    bool success = decompressIntStream(compressed.data(), compressed.size(), out.data(), out.size());
+    float decompressTime = Timer::elapsedSeconds() - time;
+    assert(success);
+    assert(out == lits);
+    const double rawMB = lits.size() * sizeof(int) / 1e6;
+    LOG(V2_INFO, "%i vars, %i clauses, locality %i: %.1f MB -> %.1f MB (ratio %.3f), compress %.0f MB/s, decompress %.0f MB/s\n",
+        numVars, numClauses, locality, rawMB, compressed.size() / 1e6, compressed.size() / (rawMB*1e6),
+        rawMB / compressTime, rawMB / decompressTime);
+    assert(compressed.size() < lits.size() * sizeof(int));
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+
+    testRoundTrips();
+    testFormula(1000000, 4000000, 3, 1000000);
+    testFormula(1000000, 4000000, 3, 1000);
+    testFormula(10000000, 10000000, 5, 100);
+}
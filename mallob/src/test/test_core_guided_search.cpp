@@ -0,0 +1,178 @@
+
+#include <climits>
+#include <vector>
+
+#include "app/maxsat/core_guided_search.hpp"
+#include "app/maxsat/maxsat_instance.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+
+// Minimal DPLL solver to check the reformulation on tiny instances
+struct TinySolver {
+    std::vector<std::vector<int>> clauses;
+    std::vector<int> clause;
+    int nbVars {0};
+    std::vector<int> model;
+
+    void add(int lit) {
+        if (lit == 0) {
+            clauses.push_back(std::move(clause));
+            clause.clear();
+            return;
+        }
+        nbVars = std::max(nbVars, std::abs(lit));
+        clause.push_back(lit);
+    }
+    bool solve(const std::vector<int>& assumptions) {
+        for (int lit : assumptions) nbVars = std::max(nbVars, std::abs(lit));
+        std::vector<int> values(nbVars+1, 0);
+        for (int lit : assumptions) {
+            if (values[std::abs(lit)] == -lit) return false;
+            values[std::abs(lit)] = lit;
+        }
+        if (!dpll(values)) return false;
+        model = values;
+        return true;
+    }
+    bool dpll(std::vector<int>& values) {
+        bool change = true;
+        while (change) {
+            change = false;
+            for (auto& c : clauses) {
+                int nbUnassigned = 0, unassigned = 0;
+                bool sat = false;
+                for (int lit : c) {
+                    if (values[std::abs(lit)] == lit) {sat = true; break;}
+                    if (values[std::abs(lit)] == 0) {nbUnassigned++; unassigned = lit;}
+                }
+                if (sat) continue;
+                if (nbUnassigned == 0) return false;
+                if (nbUnassigned == 1) {
+                    values[std::abs(unassigned)] = unassigned;
+                    change = true;
+                }
+            }
+        }
+        for (int var = 1; var <= nbVars; var++) {
+            if (values[var] != 0) continue;
+            for (int lit : {var, -var}) {
+                auto copy = values;
+                copy[var] = lit;
+                if (dpll(copy)) {
+                    values = std::move(copy);
+                    return true;
+                }
+            }
+            return false;
+        }
+        return true;
+    }
+    // Deletion-based core minimization
+    std::vector<int> minimizeCore(std::vector<int> core) {
+        for (size_t i = 0; i < core.size();) {
+            auto reduced = core;
+            reduced.erase(reduced.begin() + i);
+            if (!solve(reduced)) core = std::move(reduced);
+            else i++;
+        }
+        return core;
+    }
+};
+
+void testRandomInstance(int nbVars, int nbClauses, bool minimizeCores) {
+    TinySolver solver;
+    solver.nbVars = nbVars;
+    for (int c = 0; c < nbClauses; c++) {
+        for (int i = 0; i < 3; i++) {
+            int var = 1 + (int) (Random::rand() * nbVars);
+            solver.add(Random::rand() < 0.7 ? var : -var);
+        }
+        solver.add(0);
+    }
+    std::vector<MaxSatInstance::ObjectiveTerm> objective;
+    for (int var = 1; var <= nbVars; var++) {
+        objective.push_back({1 + (size_t) (Random::rand() * 5), var});
+    }
+    auto getCost = [&](const std::vector<int>& model) {
+        size_t cost = 0;
+        for (auto& term : objective) if (model[std::abs(term.lit)] == term.lit) cost += term.factor;
+        return cost;
+    };
+
+    // Brute-force optimum
+    size_t optimum = ULONG_MAX;
+    for (int x = 0; x < (1 << nbVars); x++) {
+        std::vector<int> model(nbVars+1);
+        for (int var = 1; var <= nbVars; var++) model[var] = ((x >> (var-1)) & 1) ? var : -var;
+        bool sat = true;
+        for (auto& c : solver.clauses) {
+            bool satClause = false;
+            for (int lit : c) satClause |= model[std::abs(lit)] == lit;
+            if (!satClause) {sat = false; break;}
+        }
+        if (sat) optimum = std::min(optimum, getCost(model));
+    }
+    if (optimum == ULONG_MAX) return; // hard clauses unsatisfiable
+
+    CoreGuidedSearch search(objective, nbVars, [&](int lit) {solver.add(lit);});
+    size_t bestCost = ULONG_MAX;
+    int nbCalls = 0;
+    while (true) {
+        std::vector<int> assumptions;
+        search.prepareCall(bestCost, assumptions);
+        nbCalls++;
+        if (solver.solve(assumptions)) {
+            const size_t cost = getCost(solver.model);
+            assert(cost >= optimum);
+            bestCost = std::min(bestCost, cost);
+            if (search.handleSat()) {
+                assert(cost == search.getLowerBound());
+                break;
+            }
+        } else {
+            auto core = minimizeCores ? solver.minimizeCore(assumptions) : assumptions;
+            bool ok = search.handleCore(core);
+            assert(ok);
+            assert(search.getLowerBound() <= optimum);
+        }
+    }
+    LOG(V2_INFO, "optimum %lu found after %i calls\n", optimum, nbCalls);
+    assert(bestCost == optimum);
+    assert(search.getLowerBound() == optimum);
+}
+
+// If the hard clauses are unsatisfiable, the (minimized) core of the first call is empty
+void testUnsatHardClauses() {
+    TinySolver solver;
+    solver.nbVars = 3;
+    for (int lit : {1, 2, 0, 1, -2, 0, -1, 3, 0, -1, -3, 0}) solver.add(lit);
+    std::vector<MaxSatInstance::ObjectiveTerm> objective {{1, 1}, {2, 2}, {3, 3}};
+    CoreGuidedSearch search(objective, 3, [&](int lit) {solver.add(lit);});
+    std::vector<int> assumptions;
+    search.prepareCall(ULONG_MAX, assumptions);
+    assert(!assumptions.empty());
+    bool sat = solver.solve(assumptions);
+    assert(!sat);
+    auto core = solver.minimizeCore(assumptions);
+    assert(core.empty());
+    bool ok = search.handleCore(core);
+    assert(!ok);
+    assert(!search.isCallPrepared());
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(1);
+
+    for (bool minimizeCores : {false, true}) {
+        for (int i = 0; i < 50; i++) testRandomInstance(8, 12, minimizeCores);
+    }
+    testUnsatHardClauses();
+}
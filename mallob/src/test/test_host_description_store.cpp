@@ -0,0 +1,113 @@
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "core/host_description_store.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/fileutils.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+
+const std::string runId = "test" + std::to_string(Proc::getPid());
+
+std::string getFile(int jobId, int revision, const std::string& suffix) {
+    return TmpDir::getMachineLocalTmpDir() + "edu.kit.iti.mallob.hostdesc." + runId + "."
+        + std::to_string(jobId) + "." + std::to_string(revision) + "." + suffix;
+}
+
+std::shared_ptr<std::vector<uint8_t>> awaitFetch(HostDescriptionStore& store, int jobId, int revision) {
+    float time = Timer::elapsedSeconds();
+    while (Timer::elapsedSeconds() - time < 5) {
+        auto data = store.fetch(jobId, revision);
+        if (data) return data;
+        usleep(1000);
+    }
+    return {};
+}
+
+void testPublishAndFetch() {
+    HostDescriptionStore a(runId), b(runId);
+
+    auto res = a.claim(1, 0);
+    assert(res == HostDescriptionStore::CLAIMED);
+    res = a.claim(1, 0);
+    assert(res == HostDescriptionStore::CLAIMED);
+    assert(a.hasClaimed(1, 0));
+    res = b.claim(1, 0);
+    assert(res == HostDescriptionStore::CLAIMED_ELSEWHERE);
+    assert(!b.hasClaimed(1, 0));
+    auto fetched = b.fetch(1, 0);
+    assert(!fetched);
+
+    std::shared_ptr<std::vector<uint8_t>> data(new std::vector<uint8_t>(1'000'000));
+    for (auto& byte : *data) byte = (uint8_t) (Random::rand() * 256);
+    a.publish(1, 0, data);
+    fetched = awaitFetch(b, 1, 0);
+    assert(fetched);
+    assert(*fetched == *data);
+    res = b.claim(1, 0);
+    assert(res == HostDescriptionStore::PUBLISHED);
+
+    // Revisions are independent of each other
+    res = b.claim(1, 1);
+    assert(res == HostDescriptionStore::CLAIMED);
+    res = a.claim(1, 1);
+    assert(res == HostDescriptionStore::CLAIMED_ELSEWHERE);
+
+    // After a release, a revision is neither available nor claimed anymore
+    a.release(1);
+    assert(!a.hasClaimed(1, 0));
+    fetched = b.fetch(1, 0);
+    assert(!fetched);
+    assert(!FileUtils::exists(getFile(1, 0, "claim")));
+    res = b.claim(1, 0);
+    assert(res == HostDescriptionStore::CLAIMED);
+    assert(b.hasClaimed(1, 1));
+}
+
+void testStaleClaim() {
+    // Claim a revision on behalf of a process which does not exist anymore
+    pid_t pid = fork();
+    if (pid == 0) _exit(0);
+    waitpid(pid, nullptr, 0);
+    {
+        std::ofstream ofs(getFile(2, 0, "claim"));
+        ofs << pid;
+    }
+    HostDescriptionStore store(runId);
+    auto res = store.claim(2, 0);
+    assert(res == HostDescriptionStore::CLAIMED);
+}
+
+void testCleanUpOnDestruction() {
+    {
+        HostDescriptionStore store(runId);
+        auto res = store.claim(3, 0);
+        assert(res == HostDescriptionStore::CLAIMED);
+        store.publish(3, 0, std::shared_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(100, 1)));
+    }
+    assert(!FileUtils::exists(getFile(3, 0, "claim")));
+    assert(!FileUtils::exists(getFile(3, 0, "ready")));
+    HostDescriptionStore store(runId);
+    auto fetched = store.fetch(3, 0);
+    assert(!fetched);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(1);
+
+    testPublishAndFetch();
+    testStaleClaim();
+    testCleanUpOnDestruction();
+}
@@ -0,0 +1,147 @@
+
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "comm/job_tree_pipelined_all_reduction.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/timer.hpp"
+
+typedef JobTreePipelinedAllReduction::AllReduceElement Elem;
+
+struct InFlightMessage {
+    int source;
+    int dest;
+    int mpiTag;
+    JobMessage msg;
+};
+
+// Binary job tree where the process with tree index i has rank i.
+JobTreeSnapshot getSnapshot(int index, int nbProcesses) {
+    JobTreeSnapshot tree;
+    tree.nodeRank = index;
+    tree.index = index;
+    tree.contextId = 1000 + index;
+    int left = 2*index+1, right = 2*index+2;
+    tree.nbChildren = (left < nbProcesses) + (right < nbProcesses);
+    tree.leftChildNodeRank = left < nbProcesses ? left : -1;
+    tree.leftChildIndex = left;
+    tree.leftChildContextId = 1000 + left;
+    tree.rightChildNodeRank = right < nbProcesses ? right : -1;
+    tree.rightChildIndex = right;
+    tree.rightChildContextId = 1000 + right;
+    tree.parentNodeRank = index == 0 ? -1 : (index-1) / 2;
+    tree.parentIndex = index == 0 ? -1 : (index-1) / 2;
+    tree.parentContextId = index == 0 ? 0 : 1000 + (index-1) / 2;
+    return tree;
+}
+
+// Element of process i: (i+1)*(j+1) at position j
+Elem getLocalElem(int index, size_t elemSize) {
+    Elem elem(elemSize);
+    for (size_t j = 0; j < elemSize; j++) elem[j] = (index+1) * (float) (j+1);
+    return elem;
+}
+
+// Simulates an all-reduction (summation) among the given number of processes.
+// Messages are delivered in a random order, and each process produces its
+// local element at a random point in time. Processes in "pruned" do not
+// participate and are pruned by their parents.
+void testAllReduction(int nbProcesses, size_t elemSize, size_t segmentSize, bool broadcast, std::set<int> pruned = {}) {
+    LOG(V2_INFO, "Test: %i processes, element size %lu, segment size %lu, broadcast %i, %lu pruned\n",
+        nbProcesses, elemSize, segmentSize, broadcast, pruned.size());
+
+    std::list<InFlightMessage> inFlight;
+    std::vector<std::unique_ptr<JobTreePipelinedAllReduction>> reductions(nbProcesses);
+    for (int i = 0; i < nbProcesses; i++) {
+        if (pruned.count(i)) continue;
+        reductions[i].reset(new JobTreePipelinedAllReduction(getSnapshot(i, nbProcesses),
+            JobMessage(1, 0, 0, 1, MSG_ALLREDUCE_CLAUSES), Elem(elemSize, 0), segmentSize,
+            [](float* acc, const float* other, size_t offset, size_t size) {
+                for (size_t j = 0; j < size; j++) acc[j] += other[j];
+            }));
+        reductions[i]->setMessageSender([&, source = i](int dest, int mpiTag, JobMessage& msg) {
+            assert(msg.contextIdOfDestination == 1000 + dest);
+            inFlight.push_back({source, dest, mpiTag, msg});
+        });
+        if (broadcast) reductions[i]->enableBroadcast();
+        else reductions[i]->disableBroadcast();
+        if (i == 0) reductions[i]->setTransformationOfElementAtRoot([](const Elem& elem) {
+            Elem result = elem;
+            result.push_back(-1); // also test a change of size
+            return result;
+        });
+        // Prune left children by their rank and right children by their index
+        if (pruned.count(2*i+1)) reductions[i]->pruneChild(2*i+1);
+        if (pruned.count(2*i+2)) reductions[i]->pruneChildByIndex(2*i+2);
+    }
+
+    // Participating processes, excluding the subtrees of pruned processes
+    std::vector<bool> participating(nbProcesses, false);
+    int nbParticipating = 0;
+    for (int i = 0; i < nbProcesses; i++) {
+        participating[i] = !pruned.count(i) && (i == 0 || participating[(i-1)/2]);
+        nbParticipating += participating[i];
+    }
+
+    std::vector<int> producers;
+    for (int i = 0; i < nbProcesses; i++) if (participating[i]) producers.push_back(i);
+    while (!producers.empty() || !inFlight.empty()) {
+        if (!producers.empty() && (inFlight.empty() || Random::rand() < 0.1)) {
+            int p = (int) (Random::rand() * producers.size());
+            int index = producers[p];
+            producers.erase(producers.begin() + p);
+            reductions[index]->produce([&]() {return getLocalElem(index, elemSize);});
+            continue;
+        }
+        auto it = inFlight.begin();
+        std::advance(it, (int) (Random::rand() * inFlight.size()));
+        auto m = std::move(*it);
+        inFlight.erase(it);
+        assert(participating[m.dest]);
+        bool accepted = reductions[m.dest]->receive(m.source, m.mpiTag, m.msg);
+        assert(accepted);
+    }
+
+    // Expected sum over all participating processes
+    Elem expected(elemSize, 0);
+    for (int i = 0; i < nbProcesses; i++) {
+        if (!participating[i]) continue;
+        auto elem = getLocalElem(i, elemSize);
+        for (size_t j = 0; j < elemSize; j++) expected[j] += elem[j];
+    }
+    expected.push_back(-1);
+
+    for (int i = 0; i < nbProcesses; i++) {
+        if (!participating[i]) continue;
+        assert(reductions[i]->hasResult() || log_return_false("[ERROR] process %i has no result\n", i));
+        auto result = reductions[i]->extractResult();
+        if (i != 0 && !broadcast) {
+            assert(result.empty());
+            continue;
+        }
+        assert(result == expected || log_return_false("[ERROR] process %i: wrong result\n", i));
+    }
+    LOG(V2_INFO, "%i processes participated\n", nbParticipating);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+
+    for (bool broadcast : {false, true}) {
+        testAllReduction(1, 100, 10, broadcast);
+        testAllReduction(7, 100, 10, broadcast);
+        testAllReduction(12, 1000, 64, broadcast);
+        testAllReduction(12, 1000, 7, broadcast);
+        testAllReduction(20, 999, 1000, broadcast);
+        testAllReduction(20, 5, 1, broadcast);
+        testAllReduction(20, 0, 16, broadcast);
+        testAllReduction(20, 300, 32, broadcast, {2, 9});
+    }
+}
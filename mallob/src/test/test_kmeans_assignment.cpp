@@ -0,0 +1,136 @@
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "app/kmeans/kmeans_assignment.hpp"
+#include "app/kmeans/kmeans_utils.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+
+std::vector<float> randomPoints(int nbPoints, int dim) {
+    std::vector<float> points(nbPoints * dim);
+    for (auto& x : points) x = 100 * Random::rand() - 50;
+    return points;
+}
+
+std::vector<std::vector<float>> pickCenters(const std::vector<float>& points, int nbCenters, int dim) {
+    std::vector<std::vector<float>> centers(nbCenters);
+    for (int k = 0; k < nbCenters; k++) {
+        int p = (int) (Random::rand() * (points.size() / dim));
+        centers[k].assign(points.data() + p*dim, points.data() + (p+1)*dim);
+    }
+    return centers;
+}
+
+// The previous per-pair assignment loop
+void assignReference(const std::vector<float>& points, const std::vector<std::vector<float>>& centers,
+        int dim, std::vector<int>& membership) {
+    for (size_t p = 0; p < membership.size(); p++) {
+        float best = std::numeric_limits<float>::infinity();
+        membership[p] = -1;
+        for (size_t k = 0; k < centers.size(); k++) {
+            float dist = KMeansUtils::eukild(points.data() + p*dim, centers[k].data(), dim);
+            if (dist < best) {
+                best = dist;
+                membership[p] = k;
+            }
+        }
+    }
+}
+
+void testCorrectness() {
+    for (int isaIdx : {KMeansAssignmentKernel::SCALAR, KMeansAssignmentKernel::AVX2, KMeansAssignmentKernel::AVX512}) {
+        auto isa = (KMeansAssignmentKernel::Isa) isaIdx;
+        if (!KMeansAssignmentKernel::isSupported(isa)) {
+            LOG(V2_INFO, "%s not supported - skipping\n", KMeansAssignmentKernel::getIsaName(isa));
+            continue;
+        }
+        for (int dim : {1, 3, 16, 37}) for (int nbCenters : {1, 5, 16, 17, 50}) {
+            const int nbPoints = 5003;
+            auto points = randomPoints(nbPoints, dim);
+            auto centers = pickCenters(points, nbCenters, dim);
+            // Duplicate centers: the smaller index must win
+            if (nbCenters > 2) centers[nbCenters-1] = centers[1];
+
+            std::vector<int> expected(nbPoints), actual(nbPoints, -1);
+            assignReference(points, centers, dim, expected);
+            KMeansAssignmentKernel kernel(isa);
+            kernel.setCenters(centers, dim);
+            bool ok = kernel.assignParallel(points.data(), 0, nbPoints, actual.data(), 4, [](int) {return false;});
+            assert(ok);
+
+            for (int p = 0; p < nbPoints; p++) {
+                if (actual[p] == expected[p]) continue;
+                // FMA rounding may only change the result between (nearly) equidistant centers
+                assert(actual[p] >= 0 && actual[p] < nbCenters);
+                float distActual = KMeansUtils::eukild(points.data() + p*dim, centers[actual[p]].data(), dim);
+                float distExpected = KMeansUtils::eukild(points.data() + p*dim, centers[expected[p]].data(), dim);
+                assert(std::abs(distActual - distExpected) <= 1e-5 * std::max(1.0f, distExpected)
+                    || log_return_false("[ERROR] %s, d=%i, k=%i: point %i assigned to %i (%.7f) instead of %i (%.7f)\n",
+                    KMeansAssignmentKernel::getIsaName(isa), dim, nbCenters, p, actual[p], distActual, expected[p], distExpected));
+            }
+        }
+        LOG(V2_INFO, "%s assignments OK\n", KMeansAssignmentKernel::getIsaName(isa));
+    }
+}
+
+void testInterrupt() {
+    const int dim = 8, nbPoints = 100000;
+    auto points = randomPoints(nbPoints, dim);
+    auto centers = pickCenters(points, 10, dim);
+    KMeansAssignmentKernel kernel;
+    kernel.setCenters(centers, dim);
+    std::vector<int> membership(nbPoints, -1);
+    bool ok = kernel.assignParallel(points.data(), 0, nbPoints, membership.data(), 4, [&](int pointID) {
+        return pointID >= nbPoints/2;
+    });
+    assert(!ok);
+    assert(membership[0] != -1);
+    assert(membership[nbPoints-1] == -1);
+}
+
+void benchmark() {
+    const int nbThreads = std::max(1U, std::thread::hardware_concurrency());
+    for (int dim : {2, 16, 128}) for (int nbCenters : {4, 16, 64, 256}) {
+        const int nbPoints = std::max(10000, 100000000 / (dim * nbCenters));
+        auto points = randomPoints(nbPoints, dim);
+        auto centers = pickCenters(points, nbCenters, dim);
+        std::vector<int> membership(nbPoints);
+
+        float time = Timer::elapsedSeconds();
+        assignReference(points, centers, dim, membership);
+        const float timeReference = Timer::elapsedSeconds() - time;
+
+        KMeansAssignmentKernel kernel;
+        kernel.setCenters(centers, dim);
+        time = Timer::elapsedSeconds();
+        kernel.assign(points.data(), 0, nbPoints, membership.data());
+        const float timeKernel = Timer::elapsedSeconds() - time;
+
+        time = Timer::elapsedSeconds();
+        kernel.assignParallel(points.data(), 0, nbPoints, membership.data(), nbThreads, [](int) {return false;});
+        const float timeParallel = Timer::elapsedSeconds() - time;
+
+        LOG(V2_INFO, "d=%i k=%i n=%i: reference %.3e points/s, %s %.3e points/s, %s x%i %.3e points/s\n",
+            dim, nbCenters, nbPoints, nbPoints / timeReference,
+            KMeansAssignmentKernel::getIsaName(kernel.getIsa()), nbPoints / timeKernel,
+            KMeansAssignmentKernel::getIsaName(kernel.getIsa()), nbThreads, nbPoints / timeParallel);
+    }
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(4);
+
+    testCorrectness();
+    testInterrupt();
+    benchmark();
+}
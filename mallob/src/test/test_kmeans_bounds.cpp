@@ -0,0 +1,130 @@
+
+#include <memory>
+#include <vector>
+
+#include "app/kmeans/kmeans_assignment.hpp"
+#include "app/kmeans/kmeans_bounds.hpp"
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
+#include "util/sys/timer.hpp"
+
+typedef std::vector<std::vector<float>> Centers;
+
+// Points scattered around some random blobs
+std::vector<float> clusteredPoints(int nbPoints, int dim, int nbBlobs) {
+    std::vector<float> blobs(nbBlobs * dim);
+    for (auto& x : blobs) x = 100 * Random::rand();
+    std::vector<float> points(nbPoints * dim);
+    for (int p = 0; p < nbPoints; p++) {
+        int b = (int) (Random::rand() * nbBlobs);
+        for (int d = 0; d < dim; d++) points[p*dim + d] = blobs[b*dim + d] + 10 * Random::rand() - 5;
+    }
+    return points;
+}
+
+Centers computeCenters(const std::vector<float>& points, const std::vector<int>& membership, int nbCenters, int dim) {
+    std::vector<std::vector<double>> sums(nbCenters, std::vector<double>(dim, 0));
+    std::vector<int> counts(nbCenters, 0);
+    for (size_t p = 0; p < membership.size(); p++) {
+        counts[membership[p]]++;
+        for (int d = 0; d < dim; d++) sums[membership[p]][d] += points[p*dim + d];
+    }
+    Centers centers(nbCenters, std::vector<float>(dim, 0));
+    for (int k = 0; k < nbCenters; k++) for (int d = 0; d < dim; d++)
+        if (counts[k] > 0) centers[k][d] = sums[k][d] / counts[k];
+    return centers;
+}
+
+// Runs Lloyd's algorithm with exact assignments and, in lockstep, with bounds on
+// a number of simulated workers which changes between iterations. Each worker
+// assigns its interval of the points, as in KMeansJob.
+void testSameClustering(int nbPoints, int dim, int nbCenters) {
+    auto points = clusteredPoints(nbPoints, dim, nbCenters);
+    Centers centers(nbCenters);
+    for (int k = 0; k < nbCenters; k++) {
+        int p = (int) (Random::rand() * nbPoints);
+        centers[k].assign(points.data() + p*dim, points.data() + (p+1)*dim);
+    }
+
+    const int maxNbWorkers = 8;
+    std::vector<std::unique_ptr<KMeansBounds>> workers;
+    for (int i = 0; i < maxNbWorkers; i++) workers.emplace_back(new KMeansBounds(nbPoints));
+    auto noInterrupt = [](int) {return false;};
+
+    std::vector<int> expected(nbPoints), actual(nbPoints);
+    for (int iteration = 0; iteration < 30; iteration++) {
+        KMeansAssignmentKernel kernel;
+        kernel.setCenters(centers, dim);
+        kernel.assignParallel(points.data(), 0, nbPoints, expected.data(), 4, noInterrupt);
+
+        const int nbWorkers = 1 + (iteration / 3) % maxNbWorkers;
+        uint64_t nbComputed = 0, nbSkipped = 0;
+        std::fill(actual.begin(), actual.end(), -1);
+        for (int i = 0; i < nbWorkers; i++) {
+            int begin = (int) (nbPoints * (i / (float) nbWorkers));
+            int end = (int) (nbPoints * ((i+1) / (float) nbWorkers));
+            workers[i]->setCenters(centers, dim);
+            bool ok = workers[i]->assignParallel(kernel, points.data(), begin, end, actual.data(), 4, noInterrupt);
+            assert(ok);
+            auto [computed, skipped] = workers[i]->extractDistanceCounts();
+            nbComputed += computed;
+            nbSkipped += skipped;
+        }
+        for (int p = 0; p < nbPoints; p++) {
+            assert(actual[p] == expected[p] || log_return_false("[ERROR] iteration %i: point %i assigned to %i instead of %i\n",
+                iteration, p, actual[p], expected[p]));
+        }
+        LOG(V2_INFO, "n=%i d=%i k=%i iteration %i, %i workers: skipped %.3f of %lu distances\n", nbPoints, dim, nbCenters,
+            iteration, nbWorkers, nbSkipped / (double) (nbComputed + nbSkipped), nbComputed + nbSkipped);
+        assert(nbComputed + nbSkipped >= (uint64_t) nbPoints * nbCenters);
+
+        auto newCenters = computeCenters(points, expected, nbCenters, dim);
+        if (newCenters == centers) break;
+        centers = newCenters;
+    }
+}
+
+void benchmark(int nbPoints, int dim, int nbCenters) {
+    auto points = clusteredPoints(nbPoints, dim, nbCenters);
+    Centers centers(nbCenters);
+    for (int k = 0; k < nbCenters; k++) {
+        int p = (int) (Random::rand() * nbPoints);
+        centers[k].assign(points.data() + p*dim, points.data() + (p+1)*dim);
+    }
+    auto noInterrupt = [](int) {return false;};
+    KMeansBounds bounds(nbPoints);
+    std::vector<int> membership(nbPoints);
+    float timeExact = 0, timeBounds = 0;
+    int iteration = 0;
+    for (; iteration < 20; iteration++) {
+        KMeansAssignmentKernel kernel;
+        kernel.setCenters(centers, dim);
+        float time = Timer::elapsedSeconds();
+        kernel.assignParallel(points.data(), 0, nbPoints, membership.data(), 1, noInterrupt);
+        timeExact += Timer::elapsedSeconds() - time;
+        time = Timer::elapsedSeconds();
+        bounds.setCenters(centers, dim);
+        bounds.assignParallel(kernel, points.data(), 0, nbPoints, membership.data(), 1, noInterrupt);
+        timeBounds += Timer::elapsedSeconds() - time;
+        centers = computeCenters(points, membership, nbCenters, dim);
+    }
+    LOG(V2_INFO, "n=%i d=%i k=%i, %i iterations: exact %.3fs, bounds %.3fs\n",
+        nbPoints, dim, nbCenters, iteration, timeExact, timeBounds);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(4);
+
+    testSameClustering(20000, 2, 5);
+    testSameClustering(20000, 16, 40);
+    testSameClustering(10000, 128, 20);
+    testSameClustering(5000, 3, 1);
+    benchmark(200000, 32, 64);
+}
@@ -0,0 +1,97 @@
+
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "app/kmeans/kmeans_point_file.hpp"
+#include "app/kmeans/kmeans_reader.hpp"
+#include "data/job_description.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/timer.hpp"
+
+// Writes random points in the text format, with surplus columns which are to be ignored
+void writeRandomPoints(const std::string& filename, int k, int dim, int surplusCols, int nbPoints) {
+    std::ofstream ofs(filename);
+    ofs << k << " " << dim << " " << dim + surplusCols << " " << nbPoints << "\n";
+    for (int p = 0; p < nbPoints; p++) {
+        for (int c = 0; c < dim + surplusCols; c++) {
+            ofs << (c > 0 ? " " : "") << 200 * Random::rand() - 100;
+        }
+        ofs << "\n";
+    }
+}
+
+void testConversion(int k, int dim, int surplusCols, int nbPoints) {
+    const std::string textFile = "/tmp/mallob_test_kmeans_reader.txt";
+    const std::string pointFile = "/tmp/mallob_test_kmeans_reader.mkm";
+    writeRandomPoints(textFile, k, dim, surplusCols, nbPoints);
+
+    float time = Timer::elapsedSeconds();
+    JobDescription dText(1, 1, 0);
+    bool ok = KMeansReader::read(textFile, dText);
+    assert(ok);
+    const float timeText = Timer::elapsedSeconds() - time;
+
+    int nbConverted, dimConverted;
+    ok = KMeansReader::convertToPointFile(textFile, pointFile, nbConverted, dimConverted);
+    assert(ok);
+    assert(nbConverted == nbPoints);
+    assert(dimConverted == dim);
+
+    time = Timer::elapsedSeconds();
+    JobDescription dBin(1, 1, 0);
+    ok = KMeansReader::read(pointFile, dBin);
+    assert(ok);
+    const float timeBin = Timer::elapsedSeconds() - time;
+
+    // Metadata (k, dim, count) and all points must be identical
+    assert(dBin.getFormulaPayloadSize(0) == 3 + nbPoints * dim);
+    assert(dBin.getFormulaPayloadSize(0) == dText.getFormulaPayloadSize(0));
+    assert(memcmp(dBin.getFormulaPayload(0), dText.getFormulaPayload(0),
+        dText.getFormulaPayloadSize(0)*sizeof(int)) == 0);
+    assert(dBin.getFormulaPayload(0)[0] == k);
+    assert(dBin.getFormulaPayload(0)[1] == dim);
+    assert(dBin.getFormulaPayload(0)[2] == nbPoints);
+
+    LOG(V2_INFO, "k=%i dim=%i cols=%i n=%i: text %.3fs, binary %.3fs\n",
+        k, dim, dim + surplusCols, nbPoints, timeText, timeBin);
+}
+
+void testMalformed() {
+    // A truncated point file is rejected (and not parsed as text)
+    const std::string pointFile = "/tmp/mallob_test_kmeans_reader.mkm";
+    int retval = truncate(pointFile.c_str(), 100);
+    assert(retval == 0);
+    JobDescription d(1, 1, 0);
+    bool ok = KMeansReader::read(pointFile, d);
+    assert(!ok);
+
+    // A number of points for which the expected data size overflows is rejected
+    std::vector<uint8_t> data(sizeof(KMeansPointFile::Header) + 4*sizeof(float));
+    KMeansPointFile::Header header {KMeansPointFile::MAGIC, 2, 1, (1ULL << 62) + 4};
+    memcpy(data.data(), &header, sizeof(header));
+    ok = KMeansPointFile::isPointFile(data.data(), data.size());
+    assert(!ok);
+    header.nbPoints = 4;
+    memcpy(data.data(), &header, sizeof(header));
+    ok = KMeansPointFile::isPointFile(data.data(), data.size());
+    assert(ok);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+
+    testConversion(3, 2, 0, 10);
+    testConversion(5, 7, 3, 1000);
+    testConversion(10, 64, 2, 100000);
+    testMalformed();
+}
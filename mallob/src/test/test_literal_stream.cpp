@@ -0,0 +1,218 @@
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/timer.hpp"
+#include "data/job_description.hpp"
+#include "data/literal_stream.hpp"
+#include "interface/socket/connection.hpp"
+
+// Client side of the protocol: [size][payload] frames written to / read from a raw socket.
+
+void sendFrame(int fd, const void* data, int size) {
+    std::vector<char> msg(sizeof(int) + size);
+    memcpy(msg.data(), &size, sizeof(int));
+    if (size > 0) memcpy(msg.data()+sizeof(int), data, size);
+    size_t sent = 0;
+    while (sent < msg.size()) {
+        auto n = ::send(fd, msg.data()+sent, msg.size()-sent, 0);
+        assert(n > 0);
+        sent += n;
+    }
+}
+
+void readFully(int fd, char* out, size_t size) {
+    size_t received = 0;
+    while (received < size) {
+        auto n = ::recv(fd, out+received, size-received, 0);
+        assert(n > 0);
+        received += n;
+    }
+}
+
+nlohmann::json receiveJson(int fd) {
+    int size;
+    readFully(fd, (char*) &size, sizeof(int));
+    std::string str(size, ' ');
+    readFully(fd, str.data(), size);
+    return nlohmann::json::parse(str);
+}
+
+std::vector<int> generateFormula(int nbClauses) {
+    std::vector<int> lits;
+    for (int c = 0; c < nbClauses; c++) {
+        int len = 1 + (int) (5 * Random::rand());
+        for (int i = 0; i < len; i++) lits.push_back((Random::rand() < 0.5 ? -1 : 1) * (1 + (int) (1000 * Random::rand())));
+        lits.push_back(0);
+    }
+    return lits;
+}
+
+// Server side: like the SocketConnector, but the consumer digests the literals into a description.
+struct Server {
+    Connection conn;
+    std::shared_ptr<LiteralStream> stream;
+    std::thread receiver;
+    std::thread consumer;
+    JobDescription desc {1, 1, 0};
+    float timeOfHeader {0};
+    float timeOfParsed {0};
+    std::atomic_bool parsed {false};
+
+    Server(int fd, size_t window) : conn(1, fd, 65536) {
+        receiver = std::thread([&, window]() {
+            while (conn.valid()) {
+                auto optJson = conn.receive();
+                if (!optJson) continue;
+                assert(optJson.value()["stream"].get<bool>());
+                timeOfHeader = Timer::elapsedSeconds();
+                stream.reset(new LiteralStream(window, [&](size_t credit) {
+                    conn.send(nlohmann::json {{"credit", credit}});
+                }));
+                conn.beginBinaryStream([&](std::vector<int>&& frame) {
+                    return stream->push(std::move(frame));
+                }, [&](bool success) {
+                    stream->conclude(success);
+                });
+                conn.send(nlohmann::json {{"credit", stream->getWindow()}});
+                consumer = std::thread([&]() {
+                    desc.beginInitialization(0);
+                    std::vector<int> chunk;
+                    while (stream->pop(chunk, 100) != LiteralStream::END) {
+                        desc.addPermanentData(chunk.data(), chunk.size());
+                    }
+                    desc.endInitialization();
+                    timeOfParsed = Timer::elapsedSeconds();
+                    stream->setParsed(stream->getState() == LiteralStream::COMPLETE);
+                    parsed.store(true, std::memory_order_release);
+                });
+            }
+        });
+    }
+    ~Server() {
+        receiver.join();
+        if (consumer.joinable()) consumer.join();
+    }
+};
+
+void testCredit() {
+    std::vector<size_t> grants;
+    LiteralStream stream(1024, [&](size_t credit) {grants.push_back(credit);});
+    bool pushed = stream.push(std::vector<int>(200, 1));
+    assert(pushed);
+    pushed = stream.push(std::vector<int>(100, 1)); // 1200 bytes > window
+    assert(!pushed);
+    pushed = stream.push(std::vector<int>(56, 1));
+    assert(pushed);
+    pushed = stream.push(std::vector<int>(1, 1));
+    assert(!pushed);
+    std::vector<int> chunk;
+    auto res = stream.pop(chunk, 10);
+    assert(res == LiteralStream::CHUNK && chunk.size() == 200);
+    assert(grants.size() == 1 && grants[0] == 800);
+    pushed = stream.push(std::vector<int>(200, 1));
+    assert(pushed);
+    res = stream.pop(chunk, 10);
+    assert(res == LiteralStream::CHUNK && chunk.size() == 56);
+    assert(grants.size() == 1); // 224 bytes < window/4
+    res = stream.pop(chunk, 10);
+    assert(res == LiteralStream::CHUNK && chunk.size() == 200);
+    assert(grants.size() == 2 && grants[1] == 1024);
+    res = stream.pop(chunk, 10);
+    assert(res == LiteralStream::TIMEOUT);
+    stream.conclude(true);
+    pushed = stream.push(std::vector<int>(1, 1));
+    assert(!pushed);
+    res = stream.pop(chunk, 10);
+    assert(res == LiteralStream::END);
+    assert(stream.getState() == LiteralStream::COMPLETE);
+    assert(stream.getNbLiterals() == 456);
+    LOG(V2_INFO, "Credit accounting OK\n");
+}
+
+// Streams a formula in frames of the given size while respecting the granted credit.
+void testStreamedUpload(int nbClauses, size_t window, int frameSize) {
+    int fds[2];
+    int res = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(res == 0);
+    auto formula = generateFormula(nbClauses);
+    float timeOfEnd;
+    size_t maxOutstanding = 0;
+    {
+        Server server(fds[0], window);
+
+        float timeOfStart = Timer::elapsedSeconds();
+        std::string header = nlohmann::json {{"user", "test"}, {"name", "job"}, {"stream", true}}.dump();
+        sendFrame(fds[1], header.c_str(), header.size());
+        size_t credit = receiveJson(fds[1])["credit"].get<size_t>();
+        assert(credit == window);
+        size_t sentBytes = 0, grantedBytes = credit;
+        size_t pos = 0;
+        while (pos < formula.size()) {
+            size_t nbInts = std::min((size_t) frameSize, formula.size() - pos);
+            // Wait for more credit if necessary
+            while (grantedBytes - sentBytes < nbInts * sizeof(int)) {
+                grantedBytes += receiveJson(fds[1])["credit"].get<size_t>();
+            }
+            sendFrame(fds[1], formula.data()+pos, nbInts * sizeof(int));
+            sentBytes += nbInts * sizeof(int);
+            maxOutstanding = std::max(maxOutstanding, sentBytes - (grantedBytes - window));
+            pos += nbInts;
+        }
+        sendFrame(fds[1], nullptr, 0);
+        timeOfEnd = Timer::elapsedSeconds();
+        while (!server.parsed.load(std::memory_order_acquire)) usleep(1000);
+        assert(server.stream->isValid());
+        assert(server.desc.getNumFormulaLiterals() == formula.size());
+        const int* payload = server.desc.getFormulaPayload(0);
+        for (size_t i = 0; i < formula.size(); i++) assert(payload[i] == formula[i]);
+        LOG(V2_INFO, "Streamed %lu lits (window %lu B, frames of %i lits): upload %.4fs, parsed %.4fs after header, %.5fs after upload\n",
+            formula.size(), window, frameSize, timeOfEnd - timeOfStart, server.timeOfParsed - server.timeOfHeader,
+            server.timeOfParsed - timeOfEnd);
+        ::close(fds[1]);
+    }
+    // The client never had more bytes in flight than a single window
+    assert(maxOutstanding <= window);
+}
+
+// A client which ignores its credit is cut off.
+void testCreditViolation() {
+    int fds[2];
+    int res = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(res == 0);
+    {
+        Server server(fds[0], 1024);
+        std::string header = nlohmann::json {{"user", "test"}, {"name", "job"}, {"stream", true}}.dump();
+        sendFrame(fds[1], header.c_str(), header.size());
+        size_t credit = receiveJson(fds[1])["credit"].get<size_t>();
+        assert(credit == 1024);
+        std::vector<int> frame(512, 1);
+        sendFrame(fds[1], frame.data(), frame.size() * sizeof(int));
+        while (!server.parsed.load(std::memory_order_acquire)) usleep(1000);
+        assert(server.stream->getState() == LiteralStream::FAILED);
+        assert(!server.stream->isValid());
+        ::close(fds[1]);
+    }
+    LOG(V2_INFO, "Credit violation detected\n");
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+
+    testCredit();
+    testCreditViolation();
+    testStreamedUpload(10, 1024, 16);
+    testStreamedUpload(100000, 4096, 256);
+    testStreamedUpload(100000, 1<<20, 4096);
+}
@@ -1,14 +1,18 @@
 
 #include <assert.h>
+#include <algorithm>
 #include <cstdio>
 #include <stdlib.h>
 #include <cstdint>
+#include <string>
 #include <vector>
 
+#include "app/sat/proof/trusted/lrat_check_pipeline.hpp"
 #include "app/sat/proof/trusted/lrat_checker.hpp"
 #include "util/logger.hpp"
 #include "util/params.hpp"
 #include "util/random.hpp"
+#include "util/sys/proc.hpp"
 #include "util/sys/timer.hpp"
 
 bool addCls(LratChecker& chk, uint64_t id, const std::vector<int>& lits, const std::vector<uint64_t>& hints) {
@@ -18,6 +22,205 @@ bool delCls(LratChecker& chk, const std::vector<uint64_t>& ids) {
     return chk.deleteClause(ids.data(), ids.size());
 }
 
+// Synthetic proof: Each derived clause weakens a live clause by one literal
+// (with the live clause as its only hint), and each derivation is followed by
+// a deletion once the maximum number of live clauses is reached. All clauses
+// are taken from a fixed pool of chains of weakened clauses, so the memory
+// outside of the checker remains constant.
+void benchmark(int nbVars, int nbOrigClauses, int nbDerivations, int maxLiveClauses) {
+    LOG(V2_INFO, "Benchmark: %i vars, %i original clauses, %i derivations, <= %i live clauses\n",
+        nbVars, nbOrigClauses, nbDerivations, maxLiveClauses);
+    auto randomLit = [&]() {return (Random::rand() < 0.5 ? -1 : 1) * (1 + (int) (Random::rand() * nbVars));};
+    const int nbBases = 10'000, chainLength = 12;
+    std::vector<std::vector<int>> pool;
+    for (int base = 0; base < nbBases; base++) {
+        std::vector<int> cls;
+        auto addRandomLit = [&]() {
+            int lit;
+            do lit = randomLit();
+            while (std::find_if(cls.begin(), cls.end(), [&](int l) {return abs(l) == abs(lit);}) != cls.end());
+            cls.push_back(lit);
+        };
+        int size = 2 + (int) (Random::rand() * 6);
+        for (int l = 0; l < size; l++) addRandomLit();
+        for (int d = 0; d < chainLength; d++) {
+            pool.push_back(cls);
+            addRandomLit();
+        }
+    }
+    std::vector<int> orig;
+    std::vector<uint64_t> liveIds(maxLiveClauses, 0);
+    std::vector<int> liveClauses(maxLiveClauses, 0); // indices into the pool
+    for (int i = 0; i < nbOrigClauses; i++) {
+        int idx = chainLength * (int) (Random::rand() * nbBases);
+        for (int lit : pool[idx]) orig.push_back(lit);
+        orig.push_back(0);
+        liveIds[i] = i+1;
+        liveClauses[i] = idx;
+    }
+    size_t nbLive = nbOrigClauses;
+
+    const double rssBefore = Proc::getRecursiveProportionalSetSizeKbs(Proc::getPid());
+    float time = Timer::elapsedSeconds();
+    LratChecker chk(nbVars);
+    bool ok = chk.loadOriginalClauses(orig.data(), orig.size()); assert(ok);
+    uint64_t nextId = nbOrigClauses + 1;
+    for (int i = 0; i < nbDerivations; i++) {
+        size_t parent = (size_t) (Random::rand() * nbLive);
+        int idx = liveClauses[parent];
+        if ((idx+1) % chainLength != 0) idx++;
+        ok = chk.addClause(nextId, pool[idx].data(), pool[idx].size(), &liveIds[parent], 1); assert(ok);
+        size_t slot = nbLive;
+        if (nbLive == maxLiveClauses) {
+            slot = (size_t) (Random::rand() * nbLive);
+            ok = chk.deleteClause(&liveIds[slot], 1); assert(ok);
+        } else nbLive++;
+        liveIds[slot] = nextId++;
+        liveClauses[slot] = idx;
+    }
+    time = Timer::elapsedSeconds() - time;
+    const double rssAfter = Proc::getRecursiveProportionalSetSizeKbs(Proc::getPid());
+    LOG(V2_INFO, "%.1f checks/s, %lu live clauses, %.1f bytes/clause (RSS), %.1f bytes/clause (checker)\n",
+        nbDerivations / time, nbLive, 1024 * (rssAfter - rssBefore) / nbLive,
+        chk.getMemoryFootprint() / (double) chk.getNbClauses());
+}
+
+// Delete most clauses to trigger a compaction of the clause arena
+// and check that the remaining clauses are still found.
+void testCompaction() {
+    LOG(V2_INFO, "Testing compaction ...\n");
+    const int nbClauses = 300'000;
+    std::vector<int> orig;
+    for (int i = 0; i < nbClauses; i++) {
+        for (int l = 1; l <= 5; l++) orig.push_back((i % 2 == 0 ? 1 : -1) * (5*(i % 1000) + l));
+        orig.push_back(0);
+    }
+    LratChecker chk(5'001);
+    bool ok = chk.loadOriginalClauses(orig.data(), orig.size()); assert(ok);
+    for (uint64_t id = 1; id <= nbClauses; id++) {
+        if (id % 3 == 0) continue;
+        ok = delCls(chk, {id}); assert(ok);
+    }
+    assert(chk.getNbCompactions() > 0);
+    assert(chk.getNbClauses() == nbClauses / 3);
+    uint64_t nextId = nbClauses + 1;
+    for (uint64_t id = 1; id <= nbClauses; id++) {
+        const int* lits = orig.data() + 6*(id-1);
+        std::vector<int> weakened(lits, lits+5);
+        weakened.push_back(5'001);
+        ok = addCls(chk, nextId, weakened, {id});
+        assert(ok == (id % 3 == 0) || log_return_false("[ERROR] clause %lu\n", id));
+        if (ok) nextId++;
+    }
+    ok = delCls(chk, {3, 6, nbClauses}); assert(ok);
+    ok = delCls(chk, {1}); assert(!ok);
+}
+
+// A synthetic proof of derivations (weakening a live clause, which is the only hint)
+// and deletions, recorded for replay. Optionally, one derivation is incorrect.
+struct SyntheticProof {
+    int nbVars;
+    std::vector<int> orig;
+    std::vector<std::vector<int>> clauses;
+    struct Op {uint64_t id; int clause; uint64_t hint;}; // hint = 0: deletion of id
+    std::vector<Op> ops;
+    SyntheticProof(int nbVars, int nbOrigClauses, int nbDerivations, int maxLiveClauses, int errorAt = -1) : nbVars(nbVars) {
+        auto randomVar = [&]() {return 1 + (int) (Random::rand() * nbVars);};
+        std::vector<uint64_t> liveIds;
+        std::vector<int> liveClauses;
+        for (int i = 0; i < nbOrigClauses; i++) {
+            std::vector<int> cls;
+            int var = randomVar();
+            for (int l = 0; l < 3; l++) cls.push_back((Random::rand() < 0.5 ? -1 : 1) * (1 + (var+l) % nbVars));
+            for (int lit : cls) orig.push_back(lit);
+            orig.push_back(0);
+            clauses.push_back(cls);
+            liveIds.push_back(i+1);
+            liveClauses.push_back(i);
+        }
+        uint64_t nextId = nbOrigClauses+1;
+        for (int i = 0; i < nbDerivations; i++) {
+            size_t parent = (size_t) (Random::rand() * liveIds.size());
+            auto cls = clauses[liveClauses[parent]];
+            int lit;
+            do lit = randomVar();
+            while (std::find_if(cls.begin(), cls.end(), [&](int l) {return abs(l) == lit;}) != cls.end());
+            cls.push_back(lit);
+            // Incorrect derivation: drop a literal of the hint clause
+            if (i == errorAt) cls.erase(cls.begin());
+            clauses.push_back(cls);
+            ops.push_back({nextId, (int) clauses.size()-1, liveIds[parent]});
+            if (liveIds.size() < maxLiveClauses) {
+                liveIds.push_back(nextId);
+                liveClauses.push_back(clauses.size()-1);
+            } else {
+                size_t victim = (size_t) (Random::rand() * liveIds.size());
+                ops.push_back({liveIds[victim], 0, 0});
+                liveIds[victim] = nextId;
+                liveClauses[victim] = clauses.size()-1;
+            }
+            nextId++;
+        }
+    }
+};
+
+// Returns the index of the first rejected operation (or -1).
+int checkSequentially(const SyntheticProof& proof, std::string& errmsg) {
+    LratChecker chk(proof.nbVars);
+    bool ok = chk.loadOriginalClauses(proof.orig.data(), proof.orig.size()); assert(ok);
+    for (int i = 0; i < proof.ops.size(); i++) {
+        auto& op = proof.ops[i];
+        auto& cls = proof.clauses[op.clause];
+        ok = op.hint == 0 ? delCls(chk, {op.id}) : addCls(chk, op.id, cls, {op.hint});
+        if (!ok) {
+            errmsg = chk.getErrorMessage();
+            return i;
+        }
+    }
+    return -1;
+}
+int checkPipelined(const SyntheticProof& proof, int nbWorkers, std::string& errmsg) {
+    LratChecker chk(proof.nbVars);
+    bool ok = chk.loadOriginalClauses(proof.orig.data(), proof.orig.size()); assert(ok);
+    int firstError = -1;
+    int nbCommitted = 0;
+    {
+        LratCheckPipeline pipeline(chk, nbWorkers, [&](bool ok, const u8* sig) {
+            if (!ok && firstError == -1) firstError = nbCommitted;
+            nbCommitted++;
+        });
+        for (auto& op : proof.ops) {
+            auto& cls = proof.clauses[op.clause];
+            if (op.hint == 0) pipeline.submitDeletion(&op.id, 1);
+            else pipeline.submitDerivation(op.id, cls.data(), cls.size(), &op.hint, 1, nullptr);
+        }
+        pipeline.drain();
+        if (!pipeline.valid()) errmsg = pipeline.getErrorMessage();
+    }
+    assert(nbCommitted == proof.ops.size());
+    return firstError;
+}
+
+void testPipeline() {
+    LOG(V2_INFO, "Testing pipelined checking ...\n");
+    for (int errorAt : {-1, 0, 12'345, 199'999}) {
+        SyntheticProof proof(10'000, 20'000, 200'000, 50'000, errorAt);
+        std::string msgSeq, msgPipe;
+        int resSeq = checkSequentially(proof, msgSeq);
+        assert((errorAt == -1) == (resSeq == -1));
+        for (int nbWorkers : {0, 1, 3}) {
+            msgPipe.clear();
+            float time = Timer::elapsedSeconds();
+            int resPipe = checkPipelined(proof, nbWorkers, msgPipe);
+            time = Timer::elapsedSeconds() - time;
+            LOG(V2_INFO, "error at %i, %i workers: first rejected op %i (%s) - %.1f ops/s\n",
+                errorAt, nbWorkers, resPipe, msgPipe.c_str(), proof.ops.size() / time);
+            assert(resPipe == resSeq || log_return_false("[ERROR] %i != %i\n", resPipe, resSeq));
+            assert(msgPipe == msgSeq || log_return_false("[ERROR] \"%s\" != \"%s\"\n", msgPipe.c_str(), msgSeq.c_str()));
+        }
+    }
+}
+
 int main(int argc, char** argv) {
     Timer::init();
     Random::init(rand(), rand());
@@ -57,4 +260,8 @@ int main(int argc, char** argv) {
     ok = chk.validateUnsat(); assert(ok);
 
     printf("All ok.\n");
+
+    testCompaction();
+    testPipeline();
+    benchmark(1'000'000, 1'000'000, 5'000'000, 2'000'000);
 }
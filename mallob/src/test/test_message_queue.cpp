@@ -4,6 +4,8 @@
 #include <vector>
 #include <cstdint>
 #include <utility>
+#include <unistd.h>
+#include <atomic>
 
 #include "mpi.h"
 #include "util/random.hpp"
@@ -24,6 +26,8 @@ const int TAG_INT_VEC = 111;
 const int TAG_ACK = 112;
 const int TAG_EXIT = 113;
 const int TAG_PINGPONG = 114;
+const int TAG_BIG = 115;
+const int TAG_RELAY = 116;
 
 void testSelfMessages() {
 
@@ -180,9 +184,160 @@ void testBigP2P() {
     LOG(V2_INFO, "Max delay: %.4f s\n", maxDelay);
 }
 
+void testCoalescing() {
+
+    int rank = MyMpi::rank(MPI_COMM_WORLD);
+    auto& q = MyMpi::getMessageQueue();
+    q.setCoalescing(100, 4096, 0.001);
+    auto statsBefore = q.getCoalescingStats();
+
+    // Small messages with interspersed large ones, which are not coalesced
+    const int numMessages = 20000;
+    int numReceived = 0;
+    MessageSubscription sub(TAG_INT_VEC, [&](MessageHandle& h) {
+        auto vec = Serializable::get<IntVec>(h.getRecvData()).data;
+        assert(h.source == 1-rank);
+        // Order of messages must be preserved
+        assert(vec[0] == numReceived || LOG_RETURN_FALSE("Received #%i instead of #%i\n", vec[0], numReceived));
+        assert(vec.size() == (vec[0] % 1000 == 999 ? 1000 : 2));
+        numReceived++;
+    });
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    float time = Timer::elapsedSeconds();
+    for (int i = 0; i < numMessages; i++) {
+        IntVec vec({i, rank});
+        if (i % 1000 == 999) vec.data.resize(1000);
+        MyMpi::isend(1-rank, TAG_INT_VEC, vec);
+        if (i % 10 == 0) q.advance();
+    }
+    while (numReceived < numMessages || q.hasOpenSends()) q.advance();
+    time = Timer::elapsedSeconds() - time;
+
+    auto stats = q.getCoalescingStats();
+    stats.numMessages -= statsBefore.numMessages;
+    stats.numEnvelopes -= statsBefore.numEnvelopes;
+    stats.sumAddedLatency -= statsBefore.sumAddedLatency;
+    LOG(V2_INFO, "%i msgs exchanged in %.4fs: %lu coalesced into %lu MPI sends (%.2f msgs/send), added latency avg %.6fs max %.6fs\n",
+        numMessages, time, stats.numMessages, stats.numEnvelopes, stats.numMessages / (double) stats.numEnvelopes,
+        stats.sumAddedLatency / stats.numMessages, stats.maxAddedLatency);
+    assert(stats.numMessages == numMessages - numMessages/1000);
+    assert(stats.numEnvelopes < stats.numMessages);
+    MPI_Barrier(MPI_COMM_WORLD);
+    q.setCoalescing(0, 0, 0);
+}
+
+// A large (fragmented) message arrives while the main thread is busy:
+// the progress thread must receive and assemble it in the meantime.
+void testBusyMainThread() {
+
+    int rank = MyMpi::rank(MPI_COMM_WORLD);
+    auto& q = MyMpi::getMessageQueue();
+    assert(q.hasProgressThread());
+    q.extractHandoffStats();
+
+    const int numInts = 10000000;
+    const float busySeconds = 1;
+    bool received = false;
+    float timeOfReceipt = 0;
+    int numSentCallbacks = 0;
+    MessageSubscription sub(TAG_BIG, [&](MessageHandle& h) {
+        timeOfReceipt = Timer::elapsedSeconds();
+        auto vec = Serializable::get<IntVec>(h.getRecvData()).data;
+        assert(vec.size() == numInts);
+        for (int i = 0; i < numInts; i++) assert(vec[i] == i);
+        received = true;
+    });
+    q.registerSentCallback(TAG_BIG, [&](int id) {numSentCallbacks++;});
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank == 0) {
+        IntVec vec;
+        for (int i = 0; i < numInts; i++) vec.data.push_back(i);
+        MyMpi::isend(1, TAG_BIG, vec);
+        while (q.hasOpenSends()) q.advance();
+        assert(numSentCallbacks == 1);
+    } else {
+        // Busy main thread which does not advance the message queue
+        usleep(1000 * 1000 * busySeconds);
+        auto stats = q.extractHandoffStats();
+        LOG(V2_INFO, "After busy period: %lu pending msgs\n", stats.numPending);
+        assert(stats.numPending == 1);
+        float time = Timer::elapsedSeconds();
+        while (!received) q.advance();
+        time = timeOfReceipt - time;
+        stats = q.extractHandoffStats();
+        LOG(V2_INFO, "Received %.4fs after busy period, handoff latency max %.4fs\n", time, stats.maxLatency);
+        assert(stats.numMessages == 1 && stats.numPending == 0);
+        assert(time < 0.1 * busySeconds);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+// Rank 0 sends a large message to rank 1, which passes it back to rank 0:
+// first after receiving it completely, then by relaying each fragment on arrival.
+void testRelay() {
+
+    int rank = MyMpi::rank(MPI_COMM_WORLD);
+    auto& q = MyMpi::getMessageQueue();
+
+    const int numInts = 10000000;
+    std::atomic_bool relay {false}; // the relay callback may be called by the progress thread
+    std::atomic_int numRelayCallbacks {0};
+    bool receivedAtRelay = false;
+    bool receivedBack = false;
+    auto verify = [&](MessageHandle& h) {
+        auto vec = Serializable::get<IntVec>(h.getRecvData()).data;
+        assert(vec.size() == numInts);
+        for (int i = 0; i < numInts; i++) assert(vec[i] == i);
+    };
+    MessageSubscription sub(TAG_RELAY, [&](MessageHandle& h) {
+        verify(h);
+        if (rank == 0) {
+            receivedBack = true;
+            return;
+        }
+        receivedAtRelay = true;
+        // Store and forward
+        if (!relay) MyMpi::isend(0, TAG_RELAY, h.moveRecvData());
+    });
+    if (rank == 1) q.registerRelayCallback(TAG_RELAY, [&](int source, const uint8_t* data, size_t size) {
+        assert(source == 0);
+        // Payload begins with the serialized vector
+        assert(size >= 2*sizeof(int) && ((int*) data)[0] == 0 && ((int*) data)[1] == 1);
+        numRelayCallbacks++;
+        return relay ? std::vector<int>(1, 0) : std::vector<int>();
+    });
+
+    IntVec vec;
+    for (int i = 0; i < numInts; i++) vec.data.push_back(i);
+    float times[2];
+    for (int round = 0; round < 2; round++) {
+        relay = round == 1;
+        receivedAtRelay = false;
+        receivedBack = false;
+        MPI_Barrier(MPI_COMM_WORLD);
+        float time = Timer::elapsedSeconds();
+        if (rank == 0) {
+            MyMpi::isend(1, TAG_RELAY, vec);
+            while (!receivedBack || q.hasOpenSends()) q.advance();
+        } else {
+            while (!receivedAtRelay || q.hasOpenSends()) q.advance();
+        }
+        times[round] = Timer::elapsedSeconds() - time;
+    }
+    if (rank == 0) LOG(V2_INFO, "Round trip of %i ints: %.4fs with store and forward, %.4fs with relaying\n",
+        numInts, times[0], times[1]);
+    if (rank == 1) {
+        assert(numRelayCallbacks == 2);
+        q.clearRelayCallback(TAG_RELAY);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
 int main(int argc, char *argv[]) {
 
-    MyMpi::init();
+    MyMpi::init(/*multiThreaded=*/true);
     Timer::init();
     int rank = MyMpi::rank(MPI_COMM_WORLD);
     assert(MyMpi::size(MPI_COMM_WORLD) == 2);
@@ -199,6 +354,19 @@ int main(int argc, char *argv[]) {
     //testSelfMessages();
     //testSimpleP2P();
     testBigP2P();
+    testCoalescing();
+    testRelay();
+
+    if (MyMpi::isThreadMultiple()) {
+        MyMpi::getMessageQueue().startProgressThread(10);
+        testBigP2P();
+        testCoalescing();
+        testBusyMainThread();
+        testRelay();
+    } else {
+        LOG(V1_WARN, "[WARN] No MPI_THREAD_MULTIPLE - skipping progress thread tests\n");
+    }
+    MyMpi::getMessageQueue().close();
 
     MPI_Finalize();
 }
\ No newline at end of file
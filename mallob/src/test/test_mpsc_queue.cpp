@@ -0,0 +1,63 @@
+
+#include <thread>
+#include <vector>
+
+#include "util/assert.hpp"
+#include "util/logger.hpp"
+#include "util/mpsc_queue.hpp"
+#include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/timer.hpp"
+
+// Several producers push increasing numbers concurrently to a single consumer,
+// which must receive each producer's numbers exactly once and in order.
+void testConcurrentProducers(int nbProducers, int nbElemsPerProducer) {
+    MPSCQueue<std::pair<int, int>> queue;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < nbProducers; p++) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < nbElemsPerProducer; i++) queue.push({p, i});
+        });
+    }
+
+    std::vector<int> nextExpected(nbProducers, 0);
+    long nbPopped = 0;
+    std::pair<int, int> elem;
+    float time = Timer::elapsedSeconds();
+    while (nbPopped < (long) nbProducers * nbElemsPerProducer) {
+        if (!queue.pop(elem)) continue;
+        auto [p, i] = elem;
+        assert(i == nextExpected[p] || log_return_false("[ERROR] producer %i: got %i, expected %i\n", p, i, nextExpected[p]));
+        nextExpected[p]++;
+        nbPopped++;
+    }
+    time = Timer::elapsedSeconds() - time;
+    for (auto& thread : producers) thread.join();
+    assert(queue.empty());
+    LOG(V2_INFO, "%i producers: %ld elements in %.4fs\n", nbProducers, nbPopped, time);
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+
+    MPSCQueue<int> queue;
+    int x;
+    assert(queue.empty());
+    bool popped = queue.pop(x);
+    assert(!popped);
+    queue.push(1);
+    queue.push(2);
+    popped = queue.pop(x);
+    assert(popped && x == 1);
+    popped = queue.pop(x);
+    assert(popped && x == 2);
+    popped = queue.pop(x);
+    assert(!popped);
+
+    testConcurrentProducers(1, 100000);
+    testConcurrentProducers(2, 100000);
+    testConcurrentProducers(8, 100000);
+}
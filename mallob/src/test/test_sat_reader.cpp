@@ -2,24 +2,140 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string>
+#include <fstream>
 #include <initializer_list>
+#include <sys/stat.h>
 
 #include "util/random.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/thread_pool.hpp"
 #include "app/sat/parse/sat_reader.hpp"
 #include "util/logger.hpp"
 #include "util/sys/timer.hpp"
 #include "util/params.hpp"
 #include "data/job_description.hpp"
 
+// Writes a random CNF with comments, clauses spanning several lines, and assumptions
+void writeRandomCnf(const std::string& filename, int nbVars, int nbClauses) {
+    std::ofstream ofs(filename);
+    ofs << "c random test formula\np cnf " << nbVars << " " << nbClauses << "\n";
+    for (int i = 0; i < nbClauses; i++) {
+        int len = 1 + (int) (Random::rand() * 12);
+        for (int j = 0; j < len; j++) {
+            ofs << (Random::rand() < 0.5 ? "-" : "") << 1 + (int) (Random::rand() * nbVars)
+                << (Random::rand() < 0.05 ? " \n" : " ");
+        }
+        ofs << "0\n";
+        if (Random::rand() < 0.001) ofs << "c some comment 1 2 3\n";
+    }
+    ofs << "a 1 -2 3 0";
+}
+
+void compareWithParallelParsing(const Parameters& baseParams, const std::string& file) {
+    struct stat st;
+    stat(file.c_str(), &st);
+
+    float time = Timer::elapsedSeconds();
+    SatReader rSeq(baseParams, file);
+    JobDescription dSeq(1, 1, 0);
+    bool success = rSeq.read(dSeq);
+    assert(success);
+    time = Timer::elapsedSeconds() - time;
+    LOG(V2_INFO, " - sequential: %.3fs (%.3f GB/s)\n", time, st.st_size / 1e9 / time);
+
+    for (int nbTasks : {1, 4, 16}) {
+        Parameters params(baseParams);
+        params.parallelParsingTasks.set(nbTasks);
+        time = Timer::elapsedSeconds();
+        SatReader rPar(params, file);
+        JobDescription dPar(1, 1, 0);
+        success = rPar.read(dPar);
+        assert(success);
+        time = Timer::elapsedSeconds() - time;
+        LOG(V2_INFO, " - %i tasks: %.3fs (%.3f GB/s)\n", nbTasks, time, st.st_size / 1e9 / time);
+
+        assert(rPar.getNbVars() == rSeq.getNbVars());
+        assert(rPar.getNbClauses() == rSeq.getNbClauses());
+        assert(dPar.getFormulaPayloadSize(0) == dSeq.getFormulaPayloadSize(0));
+        assert(memcmp(dPar.getFormulaPayload(0), dSeq.getFormulaPayload(0),
+            dSeq.getFormulaPayloadSize(0)*sizeof(int)) == 0);
+        assert(dPar.getAssumptionsSize(0) == dSeq.getAssumptionsSize(0));
+        assert(memcmp(dPar.getAssumptionsPayload(0), dSeq.getAssumptionsPayload(0),
+            dSeq.getAssumptionsSize(0)*sizeof(int)) == 0);
+    }
+}
+
+void testCnfCache(const Parameters& baseParams, const std::string& file) {
+    std::string cacheDir = "/tmp/mallob_test_cnf_cache";
+    int retval = system(("rm -rf " + cacheDir + " && mkdir -p " + cacheDir).c_str());
+    assert(retval == 0);
+    Parameters params(baseParams);
+    params.cnfCacheDirectory.set(cacheDir);
+
+    SatReader rRef(baseParams, file);
+    JobDescription dRef(1, 1, 0);
+    bool success = rRef.read(dRef);
+    assert(success);
+
+    // First read: parse and write binary conversion into the cache;
+    // second read: ingest binary conversion
+    for (int rep = 0; rep < 2; rep++) {
+        float time = Timer::elapsedSeconds();
+        SatReader r(params, file);
+        JobDescription d(1, 1, 0);
+        success = r.read(d);
+        assert(success);
+        time = Timer::elapsedSeconds() - time;
+        LOG(V2_INFO, " - %s: %.3fs\n", rep == 0 ? "parse + cache" : "from cache", time);
+        assert(r.getNbVars() == rRef.getNbVars());
+        assert(r.getNbClauses() == rRef.getNbClauses());
+        assert(d.getFormulaPayloadSize(0) == dRef.getFormulaPayloadSize(0));
+        assert(memcmp(d.getFormulaPayload(0), dRef.getFormulaPayload(0),
+            dRef.getFormulaPayloadSize(0)*sizeof(int)) == 0);
+        assert(d.getAssumptionsSize(0) == dRef.getAssumptionsSize(0));
+        assert(memcmp(d.getAssumptionsPayload(0), dRef.getAssumptionsPayload(0),
+            dRef.getAssumptionsSize(0)*sizeof(int)) == 0);
+    }
+    // The cache now contains the binary CNF which can be submitted as a file by itself
+    retval = system(("cp " + cacheDir + "/*.mcnf " + cacheDir + "/formula.mcnf").c_str());
+    assert(retval == 0);
+    SatReader rBin(baseParams, cacheDir + "/formula.mcnf");
+    JobDescription dBin(1, 1, 0);
+    success = rBin.read(dBin);
+    assert(success);
+    assert(rBin.getNbClauses() == rRef.getNbClauses());
+    assert(dBin.getFormulaPayloadSize(0) == dRef.getFormulaPayloadSize(0));
+
+    // A corrupted cache entry is detected and the original file is parsed instead
+    retval = system(("rm " + cacheDir + "/formula.mcnf && printf '\\007' | dd of=$(ls " + cacheDir
+        + "/*.mcnf) bs=1 seek=100 conv=notrunc status=none").c_str());
+    assert(retval == 0);
+    SatReader rCorrupt(params, file);
+    JobDescription dCorrupt(1, 1, 0);
+    success = rCorrupt.read(dCorrupt);
+    assert(success);
+    assert(dCorrupt.getFormulaPayloadSize(0) == dRef.getFormulaPayloadSize(0));
+    assert(memcmp(dCorrupt.getFormulaPayload(0), dRef.getFormulaPayload(0),
+        dRef.getFormulaPayloadSize(0)*sizeof(int)) == 0);
+}
+
 int main(int argc, char *argv[]) {
 
     Timer::init();
     Random::init(rand(), rand());
     Logger::init(0, V5_DEBG);
+    Process::init(0);
+    ProcessWideThreadPool::init(4);
 
     Parameters params;
     params.init(argc, argv);
 
+    LOG(V2_INFO, "Comparing sequential and parallel parsing of a random CNF ...\n");
+    writeRandomCnf("/tmp/mallob_test_sat_reader_random.cnf", 1'000'000, 1'000'000);
+    compareWithParallelParsing(params, "/tmp/mallob_test_sat_reader_random.cnf");
+    LOG(V2_INFO, "Testing the cache of binary CNF conversions ...\n");
+    testCnfCache(params, "/tmp/mallob_test_sat_reader_random.cnf");
+
     auto files = {"Steiner-9-5-bce.cnf.xz", "uum12.smt2.cnf.xz", 
         "LED_round_29-32_faultAt_29_fault_injections_5_seed_1579630418.cnf.xz", "SAT_dat.k80.cnf.xz", "Timetable_C_497_E_62_Cl_33_S_30.cnf.xz", 
         "course0.2_2018_3-sc2018.cnf.xz", "sv-comp19_prop-reachsafety.queue_longer_false-unreach-call.i-witness.cnf.xz"};
@@ -29,7 +145,7 @@ int main(int argc, char *argv[]) {
         LOG(V2_INFO, "Reading test CNF %s ...\n", f.c_str());
         float time = Timer::elapsedSeconds();
         SatReader r(params, f);
-        JobDescription d;
+        JobDescription d(1, 1, 0);
         bool success = r.read(d);
         assert(success);
         time = Timer::elapsedSeconds() - time;
@@ -45,5 +161,8 @@ int main(int argc, char *argv[]) {
         assert(retval == 0);
 
         LOG(V2_INFO, " -- difference: %.3fs\n", time - time2);
+
+        LOG(V2_INFO, "Comparing sequential and parallel parsing of the decompressed CNF ...\n");
+        compareWithParallelParsing(params, "/tmp/tmpfile");
     }
 }
\ No newline at end of file
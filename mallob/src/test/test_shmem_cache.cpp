@@ -0,0 +1,184 @@
+
+#include <assert.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "util/logger.hpp"
+#include "util/random.hpp"
+#include "util/sys/fileutils.hpp"
+#include "util/sys/process.hpp"
+#include "util/sys/shmem_cache.hpp"
+#include "util/sys/timer.hpp"
+#include "util/sys/tmpdir.hpp"
+
+std::vector<int> randomFormula(size_t size) {
+    std::vector<int> lits(size);
+    for (auto& lit : lits) lit = 1 + (int) (Random::rand() * 1'000'000);
+    return lits;
+}
+
+std::string label(const std::string& suffix) {
+    return "/edu.kit.iti.mallob.test-shmem-cache." + std::to_string(getpid()) + "." + suffix;
+}
+
+bool segmentExists(SharedMemoryCache::Key key) {
+    return FileUtils::exists(TmpDir::getMachineLocalTmpDir() + SharedMemoryCache::getShmemId(key).substr(1));
+}
+
+void testContentAddressing() {
+    LOG(V2_INFO, "Testing content addressing ...\n");
+    SharedMemoryCache::setRetentionCap(0);
+    auto& cache = StaticSharedMemoryCache::get();
+
+    auto f = randomFormula(100'000);
+    auto g = f;
+    const size_t size = f.size() * sizeof(int);
+    SharedMemoryCache::Fingerprint fp, fpOther;
+    auto key = SharedMemoryCache::computeKey(f.data(), size, &fp);
+    auto keyOther = SharedMemoryCache::computeKey(g.data(), size, &fpOther);
+    assert(key == keyOther && fp == fpOther);
+    g.back()++;
+    keyOther = SharedMemoryCache::computeKey(g.data(), size, &fpOther);
+    assert(key != keyOther && fp != fpOther);
+    keyOther = SharedMemoryCache::computeKey(f.data(), size - sizeof(int), &fpOther);
+    assert(key != keyOther && fp != fpOther);
+
+    // Two jobs with different description IDs share the same segment
+    std::string id1, id2, id3;
+    void* shmem1 = cache.createOrAccess(key, fp, 1001, label("a"), size, f.data(), id1);
+    void* shmem2 = cache.createOrAccess(key, fp, 1002, label("b"), size, f.data(), id2);
+    assert(id1 == id2);
+    assert(memcmp(shmem1, f.data(), size) == 0);
+    assert(memcmp(shmem2, f.data(), size) == 0);
+
+    // Access by description ID without providing any data
+    SharedMemoryCache::Key accessedKey;
+    void* shmem3 = cache.tryAccess(1002, label("c"), size, id3, accessedKey);
+    assert(shmem3);
+    assert(accessedKey == key);
+    assert(id3 == id1);
+    std::string idNone;
+    void* shmemNone = cache.tryAccess(999'999'999, label("d"), size, idNone, accessedKey);
+    assert(!shmemNone);
+    // A description of a different size is not given this segment
+    shmemNone = cache.tryAccess(1002, label("d"), size - sizeof(int), idNone, accessedKey);
+    assert(!shmemNone);
+
+    // A different formula with the same key (i.e., a key collision) is rejected
+    shmemNone = cache.createOrAccess(key, fpOther, 1003, label("e"), size - sizeof(int), f.data(), idNone);
+    assert(!shmemNone);
+    shmemNone = cache.createOrAccess(key, SharedMemoryCache::Fingerprint{fp.size, fp.hash+1}, 1003, label("e"),
+        size, f.data(), idNone);
+    assert(!shmemNone);
+    shmemNone = cache.tryAccess(1003, label("e"), size, idNone, accessedKey);
+    assert(!shmemNone);
+
+    // The segment is deleted with the last reference
+    cache.drop(key, label("a"), size, shmem1);
+    cache.drop(key, label("b"), size, shmem2);
+    assert(segmentExists(key));
+    cache.drop(key, label("c"), size, shmem3);
+    assert(!segmentExists(key));
+}
+
+void testLruEviction() {
+    LOG(V2_INFO, "Testing LRU eviction ...\n");
+    auto& cache = StaticSharedMemoryCache::get();
+    const size_t size = 1'000'000 * sizeof(int);
+    // Room for two unreferenced segments
+    SharedMemoryCache::setRetentionCap(2*size + size/2);
+
+    std::vector<SharedMemoryCache::Key> keys;
+    std::vector<SharedMemoryCache::Fingerprint> fingerprints;
+    for (int i = 0; i < 4; i++) {
+        auto f = randomFormula(size / sizeof(int));
+        SharedMemoryCache::Fingerprint fp;
+        auto key = SharedMemoryCache::computeKey(f.data(), size, &fp);
+        std::string id;
+        void* shmem = cache.createOrAccess(key, fp, 0, label("lru"), size, f.data(), id);
+        cache.drop(key, label("lru"), size, shmem);
+        assert(segmentExists(key));
+        keys.push_back(key);
+        fingerprints.push_back(fp);
+        usleep(10'000);
+    }
+    // Use the first segment again: it becomes the most recently used one
+    std::string id;
+    void* shmem = cache.createOrAccess(keys[0], fingerprints[0], 0, label("lru"), size, nullptr, id);
+    assert(shmem);
+    cache.drop(keys[0], label("lru"), size, shmem);
+    SharedMemoryCache::collectGarbage();
+    assert(segmentExists(keys[0]));
+    assert(!segmentExists(keys[1]));
+    assert(!segmentExists(keys[2]));
+    assert(segmentExists(keys[3]));
+
+    SharedMemoryCache::setRetentionCap(0);
+    SharedMemoryCache::collectGarbage();
+    for (auto key : keys) assert(!segmentExists(key));
+}
+
+void testStaleReferences() {
+    LOG(V2_INFO, "Testing references of terminated processes ...\n");
+    SharedMemoryCache::setRetentionCap(0);
+    auto f = randomFormula(10'000);
+    const size_t size = f.size() * sizeof(int);
+    SharedMemoryCache::Fingerprint fp;
+    auto key = SharedMemoryCache::computeKey(f.data(), size, &fp);
+
+    // A process which references the segment and exits without dropping it
+    pid_t child = fork();
+    if (child == 0) {
+        std::string id;
+        StaticSharedMemoryCache::get().createOrAccess(key, fp, 0, label("child"), size, f.data(), id);
+        _exit(0);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    assert(segmentExists(key));
+
+    // A restarted process finds the segment and references it
+    std::string id;
+    void* shmem = StaticSharedMemoryCache::get().createOrAccess(key, fp, 0, label("restarted"), size, f.data(), id);
+    assert(memcmp(shmem, f.data(), size) == 0);
+    SharedMemoryCache::collectGarbage();
+    assert(segmentExists(key));
+
+    // The dead process' reference is cleaned up
+    StaticSharedMemoryCache::get().drop(key, label("restarted"), size, shmem);
+    SharedMemoryCache::collectGarbage();
+    assert(!segmentExists(key));
+}
+
+void testStrayFiles() {
+    LOG(V2_INFO, "Testing stray files next to the cache segments ...\n");
+    SharedMemoryCache::setRetentionCap(0);
+    const std::string segment = TmpDir::getMachineLocalTmpDir() + SharedMemoryCache::getShmemId(0).substr(1);
+    const std::string prefix = segment.substr(0, segment.size() - 16);
+    std::vector<std::string> strayFiles {prefix + "not-a-key", prefix + "0123456789abcdef.bak", prefix + "xyz"};
+    for (auto& file : strayFiles) {
+        std::ofstream ofs(file);
+        ofs << "stray";
+    }
+    // Non-conforming names are skipped, not parsed
+    SharedMemoryCache::collectGarbage();
+    for (auto& file : strayFiles) {
+        assert(FileUtils::exists(file));
+        FileUtils::rm(file);
+    }
+}
+
+int main() {
+    Timer::init();
+    Random::init(rand(), rand());
+    Logger::init(0, V5_DEBG);
+    Process::init(0);
+
+    testContentAddressing();
+    testLruEviction();
+    testStaleReferences();
+    testStrayFiles();
+}
@@ -3,11 +3,13 @@
 #include <stddef.h>
 #include <cmath>
 #include <map>
+#include <functional>
 #include <vector>
 
 #include "util/sys/timer.hpp"
 #include "util/random.hpp"
 #include "balancing/volume_calculator.hpp"
+#include "balancing/incremental_volume_calculator.hpp"
 #include "balancing/balancing_entry.hpp"
 #include "balancing/event_map.hpp"
 #include "util/logger.hpp"
@@ -224,6 +226,125 @@ void testTinyModifier(Parameters& params) {
     auto result = testEventMap(params, map, /*numWorkers=*/100, /*expectedUtilization=*/100);
 }
 
+// Compares the incremental calculator with a VolumeCalculator computed from scratch.
+void checkEquivalence(Parameters& params, const EventMap& map, IncrementalVolumeCalculator& incCalc, int numWorkers) {
+    VolumeCalculator calc(map, params, numWorkers, false);
+    calc.calculateResult();
+    incCalc.calculateResult(false);
+    assert(calc.getEntries().size() == incCalc.getNbEntries());
+    for (const auto& entry : calc.getEntries()) {
+        assert(incCalc.hasVolume(entry.jobId));
+        assert(entry.volume == incCalc.getVolume(entry.jobId)
+            || LOG_RETURN_FALSE("#%i : volume %i != %i\n", entry.jobId, entry.volume, incCalc.getVolume(entry.jobId)));
+    }
+    assert(calc.getZeroEntries().size() == incCalc.getZeroEntries().size());
+    for (const auto& entry : calc.getZeroEntries()) {
+        assert(incCalc.getZeroEntries().count(entry.jobId));
+        assert(!incCalc.hasVolume(entry.jobId));
+    }
+}
+
+void testIncrementalEquivalence(Parameters& params) {
+    LOG(V2_INFO, "#### Test incremental equivalence ####\n");
+
+    // Different distributions of priorities and demands
+    std::vector<std::pair<std::string, std::function<Event(int, int)>>> generators {
+        {"uniform", [](int id, int epoch) {
+            return Event {id, epoch, 1 + (int) (Random::rand() * 64), 1};
+        }},
+        {"few classes", [](int id, int epoch) {
+            return Event {id, epoch, 1 << (int) (Random::rand() * 8), 0.25f * (1 + (int) (Random::rand() * 4))};
+        }},
+        {"distinct", [](int id, int epoch) {
+            return Event {id, epoch, 1 + (int) (Random::rand() * 1000), 0.001f + 0.999f * (float) Random::rand()};
+        }},
+        {"wide priority range", [](int id, int epoch) {
+            // exceeds exact summation of priorities
+            return Event {id, epoch, 1 + (int) (Random::rand() * 100), (float) std::pow(2.0, -40 * Random::rand()) + (float) Random::rand()};
+        }},
+        {"with zeros", [](int id, int epoch) {
+            return Event {id, epoch, Random::rand() < 0.2 ? 0 : 1 + (int) (Random::rand() * 32), 
+                0.01f * (1 + (int) (Random::rand() * 100))};
+        }}
+    };
+
+    for (auto& [name, generate] : generators) {
+        for (int numWorkers : {10, 100, 1000, 10000}) {
+            EventMap map;
+            IncrementalVolumeCalculator incCalc(params, numWorkers);
+            int epoch = 1;
+            int nextJobId = 1;
+            int numComputations = 0;
+            for (int round = 0; round < 200; round++) {
+                // Apply a few random changes: new jobs, changed jobs, removed jobs
+                int numChanges = 1 + (int) (Random::rand() * 5);
+                for (int c = 0; c < numChanges; c++) {
+                    double r = Random::rand();
+                    Event ev;
+                    if (map.isEmpty() || r < 0.4) {
+                        ev = generate(nextJobId++, epoch++);
+                    } else {
+                        auto it = std::next(map.getEntries().begin(), (int) (Random::rand() * map.getEntries().size()));
+                        ev = generate(it->first, epoch++);
+                        if (r < 0.6) {
+                            map.remove(it->first);
+                            incCalc.remove(it->first);
+                            continue;
+                        }
+                        if (r < 0.8) ev.priority = it->second.priority;
+                    }
+                    map.insertIfNovel(ev);
+                    incCalc.update(ev);
+                }
+                if (map.isEmpty()) continue;
+                checkEquivalence(params, map, incCalc, numWorkers);
+                numComputations++;
+            }
+            LOG(V3_VERB, "%s, %i workers: %i equivalent computations, %lu jobs in %lu classes\n",
+                name.c_str(), numWorkers, numComputations, incCalc.getNbEntries(), incCalc.getNbJobClasses());
+        }
+    }
+}
+
+void testIncrementalPerformance(Parameters& params, int numJobs, int numWorkers, bool fewClasses) {
+
+    EventMap map;
+    IncrementalVolumeCalculator incCalc(params, numWorkers);
+    int epoch = 1;
+    auto generate = [&](int id) {
+        if (fewClasses) return Event {id, epoch++, 1 << (int) (Random::rand() * 10), 0.5f * (1 + (int) (Random::rand() * 4))};
+        return Event {id, epoch++, 1 + (int) (Random::rand() * 1000), 0.001f + 0.999f * (float) Random::rand()};
+    };
+    for (int id = 1; id <= numJobs; id++) {
+        auto ev = generate(id);
+        map.insertIfNovel(ev);
+        incCalc.update(ev);
+    }
+
+    // Each balancing round digests a single changed job
+    const int numRounds = 100;
+    float timeFull = 0, timeIncremental = 0;
+    for (int round = 0; round < numRounds; round++) {
+        auto ev = generate(1 + (int) (Random::rand() * numJobs));
+        map.insertIfNovel(ev);
+
+        float time = Timer::elapsedSeconds();
+        VolumeCalculator calc(map, params, numWorkers, false);
+        calc.calculateResult();
+        timeFull += Timer::elapsedSeconds() - time;
+
+        time = Timer::elapsedSeconds();
+        incCalc.update(ev);
+        incCalc.calculateResult(false);
+        timeIncremental += Timer::elapsedSeconds() - time;
+
+        for (const auto& entry : calc.getEntries()) assert(entry.volume == incCalc.getVolume(entry.jobId));
+    }
+    LOG(V2_INFO, "nJobs=%i nWorkers=%i classes=%lu : full %.6fs, incremental %.6fs per round (speedup %.1f)\n",
+        numJobs, numWorkers, incCalc.getNbJobClasses(), timeFull/numRounds, timeIncremental/numRounds,
+        timeFull / timeIncremental);
+}
+
 int main(int argc, char *argv[]) {
     Timer::init();
     Parameters params;
@@ -241,6 +362,9 @@ int main(int argc, char *argv[]) {
     testDivergentDemandPriorityRatio(params);
     testTinyModifier(params);
     testHugeModifier(params);
+    testIncrementalEquivalence(params);
+    for (int numWorkers : {4096, 65536}) for (bool fewClasses : {false, true})
+        testIncrementalPerformance(params, 10000, numWorkers, fewClasses);
     testPerformance(params);
 }
 
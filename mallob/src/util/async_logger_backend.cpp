@@ -0,0 +1,505 @@
+
+#include "async_logger_backend.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+#include "util/logger.hpp"
+
+// Provided by the linker: end of the program's text and of its initialized data.
+// String literals of the executable reside in between (see "man 3 end").
+extern "C" char etext, edata;
+
+namespace {
+
+const uint32_t PADDING_RECORD = 0xFFFFFFFF;
+
+struct RecordHeader {
+    uint32_t size;       // in bytes, including this header; multiple of 8
+    uint32_t options;    // PADDING_RECORD: skip to the beginning of the ring
+    float time;
+    int32_t otherRank;
+    const char* format;  // nullptr: the format string follows as [length][chars]
+};
+
+enum ArgType {ARG_PERCENT, ARG_INT, ARG_UINT, ARG_CHAR, ARG_DOUBLE, ARG_LONG_DOUBLE, ARG_STRING, ARG_PTR};
+enum LengthModifier {LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T, LEN_BIGL};
+
+struct FormatSpec {
+    int length; // number of characters, including the '%'
+    int nbStars;
+    bool plain; // no flags, width, or precision
+    ArgType type;
+    LengthModifier lengthModifier;
+};
+
+const int MAX_SPEC_LENGTH = 31;
+
+bool isDigit(char c) {return c >= '0' && c <= '9';}
+
+// Parses the conversion specification which begins at p (pointing to a '%').
+// Returns false for specifications which are not supported for deferred formatting.
+bool parseSpec(const char* p, FormatSpec& spec) {
+    const char* q = p+1;
+    spec.nbStars = 0;
+    spec.lengthModifier = LEN_NONE;
+    if (*q == '%') {
+        spec.type = ARG_PERCENT;
+        spec.length = 2;
+        return true;
+    }
+    // Positional arguments ("%1$i")
+    const char* r = q;
+    while (isDigit(*r)) r++;
+    if (*r == '$') return false;
+
+    while (*q != '\0' && strchr("-+ #0'", *q)) q++;
+    if (*q == '*') {spec.nbStars++; q++;}
+    else while (isDigit(*q)) q++;
+    if (*q == '.') {
+        q++;
+        if (*q == '*') {spec.nbStars++; q++;}
+        else while (isDigit(*q)) q++;
+    }
+    spec.plain = q == p+1;
+    switch (*q) {
+    case 'h': if (q[1] == 'h') {spec.lengthModifier = LEN_HH; q += 2;} else {spec.lengthModifier = LEN_H; q++;} break;
+    case 'l': if (q[1] == 'l') {spec.lengthModifier = LEN_LL; q += 2;} else {spec.lengthModifier = LEN_L; q++;} break;
+    case 'q': spec.lengthModifier = LEN_LL; q++; break;
+    case 'j': spec.lengthModifier = LEN_J; q++; break;
+    case 'z': spec.lengthModifier = LEN_Z; q++; break;
+    case 't': spec.lengthModifier = LEN_T; q++; break;
+    case 'L': spec.lengthModifier = LEN_BIGL; q++; break;
+    }
+    const bool bigL = spec.lengthModifier == LEN_BIGL;
+    switch (*q) {
+    case 'd': case 'i':
+        if (bigL) return false;
+        spec.type = ARG_INT; break;
+    case 'u': case 'o': case 'x': case 'X':
+        if (bigL) return false;
+        spec.type = ARG_UINT; break;
+    case 'c':
+        if (spec.lengthModifier != LEN_NONE) return false; // no wide characters
+        spec.type = ARG_CHAR; break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec.type = bigL ? ARG_LONG_DOUBLE : ARG_DOUBLE; break;
+    case 's':
+        if (spec.lengthModifier != LEN_NONE) return false; // no wide strings
+        spec.type = ARG_STRING; break;
+    case 'p':
+        spec.type = ARG_PTR; break;
+    default:
+        return false; // includes "%n" and a premature end of the string
+    }
+    spec.length = q+1 - p;
+    return spec.length <= MAX_SPEC_LENGTH;
+}
+
+// Calls onLiteral(begin, length) and onSpec(spec, begin) in the order of the format string.
+template <typename L, typename S>
+bool forEachSpec(const char* format, L onLiteral, S onSpec) {
+    const char* p = format;
+    const char* literalBegin = p;
+    while (*p != '\0') {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        if (p > literalBegin) onLiteral(literalBegin, p - literalBegin);
+        FormatSpec spec;
+        if (!parseSpec(p, spec)) return false;
+        if (!onSpec(spec, p)) return false;
+        p += spec.length;
+        literalBegin = p;
+    }
+    if (p > literalBegin) onLiteral(literalBegin, p - literalBegin);
+    return true;
+}
+
+template <typename T>
+void writeValue(std::vector<uint8_t>& out, const T& value) {
+    size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T readValue(const uint8_t*& in) {
+    T value;
+    memcpy(&value, in, sizeof(T));
+    in += sizeof(T);
+    return value;
+}
+
+void putString(std::vector<uint8_t>& out, const char* str) {
+    uint32_t length = strlen(str);
+    writeValue(out, length);
+    size_t offset = out.size();
+    out.resize(offset + length);
+    memcpy(out.data() + offset, str, length);
+}
+
+// Reads the argument of the given specification from args and appends it to out.
+void encodeArg(const FormatSpec& spec, va_list& args, std::vector<uint8_t>& out) {
+    for (int i = 0; i < spec.nbStars; i++) writeValue(out, va_arg(args, int));
+    switch (spec.type) {
+    case ARG_INT:
+        switch (spec.lengthModifier) {
+        case LEN_L: writeValue(out, va_arg(args, long)); break;
+        case LEN_LL: writeValue(out, va_arg(args, long long)); break;
+        case LEN_J: writeValue(out, va_arg(args, intmax_t)); break;
+        case LEN_Z: writeValue(out, va_arg(args, ssize_t)); break;
+        case LEN_T: writeValue(out, va_arg(args, ptrdiff_t)); break;
+        default: writeValue(out, va_arg(args, int)); break;
+        }
+        break;
+    case ARG_UINT:
+        switch (spec.lengthModifier) {
+        case LEN_L: writeValue(out, va_arg(args, unsigned long)); break;
+        case LEN_LL: writeValue(out, va_arg(args, unsigned long long)); break;
+        case LEN_J: writeValue(out, va_arg(args, uintmax_t)); break;
+        case LEN_Z: writeValue(out, va_arg(args, size_t)); break;
+        case LEN_T: writeValue(out, va_arg(args, ptrdiff_t)); break;
+        default: writeValue(out, va_arg(args, unsigned int)); break;
+        }
+        break;
+    case ARG_CHAR: writeValue(out, va_arg(args, int)); break;
+    case ARG_DOUBLE: writeValue(out, va_arg(args, double)); break;
+    case ARG_LONG_DOUBLE: writeValue(out, va_arg(args, long double)); break;
+    case ARG_STRING: {
+        const char* str = va_arg(args, const char*);
+        putString(out, str ? str : "(null)");
+        break;
+    }
+    case ARG_PTR: writeValue(out, va_arg(args, void*)); break;
+    case ARG_PERCENT: break;
+    }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+template <typename T>
+int formatOne(char* buf, size_t size, const char* spec, int nbStars, const int* stars, T value) {
+    if (nbStars == 0) return snprintf(buf, size, spec, value);
+    if (nbStars == 1) return snprintf(buf, size, spec, stars[0], value);
+    return snprintf(buf, size, spec, stars[0], stars[1], value);
+}
+#pragma GCC diagnostic pop
+
+template <typename T>
+void appendFormatted(std::string& out, const char* spec, int nbStars, const int* stars, T value) {
+    char buf[256];
+    int n = formatOne(buf, sizeof(buf), spec, nbStars, stars, value);
+    if (n < 0) return;
+    if (n < (int) sizeof(buf)) {
+        out.append(buf, n);
+        return;
+    }
+    size_t offset = out.size();
+    out.resize(offset + n + 1);
+    formatOne(&out[offset], n + 1, spec, nbStars, stars, value);
+    out.resize(offset + n);
+}
+
+template <typename T>
+void appendInteger(std::string& out, T value) {
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, result.ptr - buf);
+}
+
+// Reads the argument of the given specification from in and appends its formatting to out.
+void decodeArg(const FormatSpec& spec, const char* specBegin, const uint8_t*& in, std::string& out) {
+    if (spec.type == ARG_PERCENT) {
+        out += '%';
+        return;
+    }
+    // Fast paths for the most common conversions
+    if (spec.plain) {
+        const char conversion = specBegin[spec.length-1];
+        if (spec.type == ARG_STRING) {
+            uint32_t length = readValue<uint32_t>(in);
+            out.append((const char*) in, length);
+            in += length;
+            return;
+        }
+        if (spec.type == ARG_INT && spec.lengthModifier == LEN_NONE) {
+            appendInteger(out, readValue<int>(in));
+            return;
+        }
+        if (spec.type == ARG_INT && spec.lengthModifier == LEN_L) {
+            appendInteger(out, readValue<long>(in));
+            return;
+        }
+        if (spec.type == ARG_UINT && conversion == 'u' && spec.lengthModifier == LEN_NONE) {
+            appendInteger(out, readValue<unsigned int>(in));
+            return;
+        }
+        if (spec.type == ARG_UINT && conversion == 'u' && spec.lengthModifier == LEN_L) {
+            appendInteger(out, readValue<unsigned long>(in));
+            return;
+        }
+    }
+    char specStr[MAX_SPEC_LENGTH+1];
+    memcpy(specStr, specBegin, spec.length);
+    specStr[spec.length] = '\0';
+    int stars[2];
+    for (int i = 0; i < spec.nbStars; i++) stars[i] = readValue<int>(in);
+    const int n = spec.nbStars;
+    switch (spec.type) {
+    case ARG_INT:
+        switch (spec.lengthModifier) {
+        case LEN_L: appendFormatted(out, specStr, n, stars, readValue<long>(in)); break;
+        case LEN_LL: appendFormatted(out, specStr, n, stars, readValue<long long>(in)); break;
+        case LEN_J: appendFormatted(out, specStr, n, stars, readValue<intmax_t>(in)); break;
+        case LEN_Z: appendFormatted(out, specStr, n, stars, readValue<ssize_t>(in)); break;
+        case LEN_T: appendFormatted(out, specStr, n, stars, readValue<ptrdiff_t>(in)); break;
+        default: appendFormatted(out, specStr, n, stars, readValue<int>(in)); break;
+        }
+        break;
+    case ARG_UINT:
+        switch (spec.lengthModifier) {
+        case LEN_L: appendFormatted(out, specStr, n, stars, readValue<unsigned long>(in)); break;
+        case LEN_LL: appendFormatted(out, specStr, n, stars, readValue<unsigned long long>(in)); break;
+        case LEN_J: appendFormatted(out, specStr, n, stars, readValue<uintmax_t>(in)); break;
+        case LEN_Z: appendFormatted(out, specStr, n, stars, readValue<size_t>(in)); break;
+        case LEN_T: appendFormatted(out, specStr, n, stars, readValue<ptrdiff_t>(in)); break;
+        default: appendFormatted(out, specStr, n, stars, readValue<unsigned int>(in)); break;
+        }
+        break;
+    case ARG_CHAR: appendFormatted(out, specStr, n, stars, readValue<int>(in)); break;
+    case ARG_DOUBLE: appendFormatted(out, specStr, n, stars, readValue<double>(in)); break;
+    case ARG_LONG_DOUBLE: appendFormatted(out, specStr, n, stars, readValue<long double>(in)); break;
+    case ARG_STRING: {
+        uint32_t length = readValue<uint32_t>(in);
+        std::string str((const char*) in, length);
+        in += length;
+        appendFormatted(out, specStr, n, stars, str.c_str());
+        break;
+    }
+    case ARG_PTR: appendFormatted(out, specStr, n, stars, readValue<void*>(in)); break;
+    case ARG_PERCENT: break;
+    }
+}
+
+bool isLiteral(const char* str) {
+    return str >= &etext && str < &edata;
+}
+
+}  // namespace
+
+void AsyncLoggerBackend::disableInForkedChild() {
+    // The drain thread does not exist in a forked child, and the pending
+    // records are written by the parent: log synchronously from here on.
+    auto& backend = get();
+    if (!backend._enabled.exchange(false)) return;
+    backend._drain_thread.release();
+    backend._drain_lock.clear(std::memory_order_release);
+}
+
+AsyncLoggerBackend& AsyncLoggerBackend::get() {
+    // Never destructed: threads may still log while static objects are destructed
+    static AsyncLoggerBackend* backend = new AsyncLoggerBackend();
+    return *backend;
+}
+
+bool AsyncLoggerBackend::start(const Logger* logger, size_t ringCapacity) {
+    if (_enabled.load(std::memory_order_relaxed)) return false;
+    _logger = logger;
+    // Ring capacity must stay fixed once rings exist
+    if (_ring_capacity == 0) _ring_capacity = std::max((size_t) 4096, ringCapacity & ~(size_t)7);
+    static bool registeredForkHandler = false;
+    if (!registeredForkHandler) {
+        pthread_atfork(nullptr, nullptr, disableInForkedChild);
+        registeredForkHandler = true;
+    }
+    _terminate.store(false, std::memory_order_relaxed);
+    _enabled.store(true, std::memory_order_release);
+    _drain_thread.reset(new std::thread([&]() {
+        pthread_setname_np(pthread_self(), "LogDrain");
+        runDrainThread();
+    }));
+    return true;
+}
+
+void AsyncLoggerBackend::stop() {
+    if (!_enabled.exchange(false)) return;
+    _terminate.store(true, std::memory_order_relaxed);
+    if (_drain_thread && _drain_thread->joinable()) {
+        if (_drain_thread->get_id() == std::this_thread::get_id()) _drain_thread->detach();
+        else _drain_thread->join();
+    }
+    _drain_thread.reset();
+    drain();
+}
+
+AsyncLoggerBackend::Ring& AsyncLoggerBackend::getLocalRing() {
+    thread_local std::shared_ptr<Ring> ring;
+    if (!ring) {
+        ring.reset(new Ring(_ring_capacity));
+        auto lock = _rings_mutex.getLock();
+        _rings.push_back(ring);
+    }
+    return *ring;
+}
+
+bool AsyncLoggerBackend::push(unsigned int options, float time, int otherRank, const char* format, va_list& args) {
+
+    // Encode the record
+    thread_local std::vector<uint8_t> record;
+    record.resize(sizeof(RecordHeader));
+    const bool literal = isLiteral(format);
+    if (!literal) putString(record, format);
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    bool supported = forEachSpec(format, [](const char*, size_t) {}, [&](const FormatSpec& spec, const char*) {
+        encodeArg(spec, argsCopy, record);
+        return true;
+    });
+    va_end(argsCopy);
+    if (!supported) return false;
+    record.resize((record.size() + 7) & ~(size_t)7);
+    if (record.size() > _ring_capacity / 4) return false;
+
+    RecordHeader header {(uint32_t) record.size(), options, time, otherRank, literal ? format : nullptr};
+    memcpy(record.data(), &header, sizeof(RecordHeader));
+
+    // Reserve space in the ring, wrapping around with a padding record if necessary
+    Ring& ring = getLocalRing();
+    const uint64_t writePos = ring.writePos.load(std::memory_order_relaxed);
+    const size_t offset = writePos % _ring_capacity;
+    const size_t padding = _ring_capacity - offset < record.size() ? _ring_capacity - offset : 0;
+    const uint64_t needed = padding + record.size();
+    if (writePos + needed - ring.readPos.load(std::memory_order_acquire) > _ring_capacity) {
+        // Ring is full: wait for the drain thread, but do not wait forever
+        // (e.g., if the drain thread crashed)
+        _nb_waits.fetch_add(1, std::memory_order_relaxed);
+        int nbYields = 0;
+        while (writePos + needed - ring.readPos.load(std::memory_order_acquire) > _ring_capacity) {
+            if (!isEnabled() || ++nbYields > 1000000) return false;
+            sched_yield();
+        }
+    }
+    if (padding > 0) {
+        uint32_t pad[2] = {(uint32_t) padding, PADDING_RECORD};
+        memcpy(ring.data.data() + offset, pad, sizeof(pad));
+    }
+    memcpy(ring.data.data() + (offset + padding) % _ring_capacity, record.data(), record.size());
+    ring.writePos.store(writePos + needed, std::memory_order_release);
+    return true;
+}
+
+bool AsyncLoggerBackend::drain(int timeoutMillis, bool keepLocked) {
+    if (!tryLockDrain(timeoutMillis)) return false;
+    drainLocked();
+    if (!keepLocked) unlockDrain();
+    return true;
+}
+
+bool AsyncLoggerBackend::tryLockDrain(int timeoutMillis) {
+    int nbTries = 0;
+    while (_drain_lock.test_and_set(std::memory_order_acquire)) {
+        if (++nbTries > 10 * timeoutMillis) return false;
+        usleep(100);
+    }
+    return true;
+}
+
+void AsyncLoggerBackend::runDrainThread() {
+    while (!_terminate.load(std::memory_order_relaxed)) {
+        size_t nbLines = 0;
+        if (tryLockDrain(0)) {
+            drainLocked();
+            nbLines = _lines.size();
+            unlockDrain();
+        }
+        // Poll again immediately if there was a lot to do
+        if (nbLines < 64) usleep(1000);
+    }
+}
+
+void AsyncLoggerBackend::drainLocked() {
+    if (_ring_capacity == 0) return;
+
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        auto lock = _rings_mutex.getLock();
+        rings = _rings;
+    }
+
+    _lines.clear();
+    _text.clear();
+    for (auto& ring : rings) {
+        uint64_t readPos = ring->readPos.load(std::memory_order_relaxed);
+        const uint64_t writePos = ring->writePos.load(std::memory_order_acquire);
+        while (readPos < writePos) {
+            const uint8_t* record = ring->data.data() + readPos % _ring_capacity;
+            uint32_t pad[2];
+            memcpy(pad, record, sizeof(pad));
+            if (pad[1] == PADDING_RECORD) {
+                readPos += pad[0];
+                continue;
+            }
+            _lines.emplace_back();
+            readPos += decodeRecord(record, _lines.back());
+        }
+        ring->readPos.store(readPos, std::memory_order_release);
+    }
+    rings.clear();
+
+    // Forget the rings of exited threads
+    {
+        auto lock = _rings_mutex.getLock();
+        for (auto it = _rings.begin(); it != _rings.end();) {
+            auto& ring = *it;
+            if (ring.use_count() == 1 && ring->readPos.load(std::memory_order_relaxed)
+                    == ring->writePos.load(std::memory_order_acquire)) {
+                it = _rings.erase(it);
+            } else ++it;
+        }
+    }
+
+    if (_lines.empty()) return;
+    std::stable_sort(_lines.begin(), _lines.end(), [](const Line& left, const Line& right) {
+        return left.time < right.time;
+    });
+    _logger->writeLines(_lines, _text);
+    _nb_records.fetch_add(_lines.size(), std::memory_order_relaxed);
+}
+
+size_t AsyncLoggerBackend::decodeRecord(const uint8_t* record, Line& line) {
+    RecordHeader header;
+    memcpy(&header, record, sizeof(RecordHeader));
+    line.time = header.time;
+    line.options = header.options;
+    line.otherRank = header.otherRank;
+    line.textBegin = _text.size();
+
+    const uint8_t* in = record + sizeof(RecordHeader);
+    std::string inlineFormat;
+    const char* format = header.format;
+    if (!format) {
+        uint32_t length = readValue<uint32_t>(in);
+        inlineFormat.assign((const char*) in, length);
+        in += length;
+        format = inlineFormat.c_str();
+    }
+    forEachSpec(format, [&](const char* begin, size_t length) {
+        _text.append(begin, length);
+    }, [&](const FormatSpec& spec, const char* begin) {
+        decodeArg(spec, begin, in, _text);
+        return true;
+    });
+    line.textLength = _text.size() - line.textBegin;
+    return header.size;
+}
@@ -0,0 +1,95 @@
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/sys/threading.hpp"
+
+class Logger;
+
+/*
+Process-wide backend for asynchronous logging of the main Logger instance.
+Each producing thread writes compact binary records into its own lock-free
+single-producer ring buffer: the options, a timestamp, the rank of the other
+process (if any), a format ID and the raw arguments as they were passed.
+The format ID is the address of the format string if it is a literal in the
+executable's read-only data; other format strings are copied into the record.
+A background thread drains all buffers periodically, formats the records
+ordered by their timestamps and writes them in large batches via the Logger.
+*/
+class AsyncLoggerBackend {
+
+public:
+    struct Line {
+        float time;
+        unsigned int options;
+        int otherRank;
+        size_t textBegin;  // position of the formatted message in the drained text
+        size_t textLength;
+    };
+
+private:
+    struct Ring {
+        std::vector<uint8_t> data;
+        alignas(64) std::atomic<uint64_t> writePos {0}; // only written by the producer
+        alignas(64) std::atomic<uint64_t> readPos {0};  // only written by the drainer
+        Ring(size_t capacity) : data(capacity) {}
+    };
+
+    const Logger* _logger {nullptr};
+    size_t _ring_capacity {0};
+    std::atomic_bool _enabled {false};
+    std::atomic_bool _terminate {false};
+    std::unique_ptr<std::thread> _drain_thread;
+
+    Mutex _rings_mutex;
+    std::vector<std::shared_ptr<Ring>> _rings;
+
+    // Held while draining the rings and writing their records
+    std::atomic_flag _drain_lock = ATOMIC_FLAG_INIT;
+    std::vector<Line> _lines;
+    std::string _text;
+
+    std::atomic_ulong _nb_records {0};
+    std::atomic_ulong _nb_waits {0};
+
+public:
+    static AsyncLoggerBackend& get();
+
+    // Start draining records into the given logger. ringCapacity is the size in bytes
+    // of each thread's buffer. Returns false if the backend is running already.
+    bool start(const Logger* logger, size_t ringCapacity = 1<<18);
+    // Drain all remaining records and stop the background thread.
+    void stop();
+    bool isEnabled() const {return _enabled.load(std::memory_order_relaxed);}
+
+    // Returns false if the record could not be enqueued (unsupported format string
+    // or a record which does not fit into a ring buffer). The caller then needs to
+    // drain() and write the line synchronously.
+    bool push(unsigned int options, float time, int otherRank, const char* format, va_list& args);
+
+    // Synchronously write all records pushed so far. Waits at most timeoutMillis for a
+    // concurrent drain to finish (e.g., when called while crashing); returns false on timeout.
+    // If keepLocked is true, the drain lock remains held on success and must be released
+    // with unlockDrain().
+    bool drain(int timeoutMillis = 1000, bool keepLocked = false);
+    void unlockDrain() {_drain_lock.clear(std::memory_order_release);}
+
+    unsigned long getNbRecords() const {return _nb_records.load(std::memory_order_relaxed);}
+    unsigned long getNbWaits() const {return _nb_waits.load(std::memory_order_relaxed);}
+
+private:
+    AsyncLoggerBackend() {}
+    static void disableInForkedChild();
+    Ring& getLocalRing();
+    void runDrainThread();
+    bool tryLockDrain(int timeoutMillis);
+    void drainLocked();
+    size_t decodeRecord(const uint8_t* record, Line& line);
+};
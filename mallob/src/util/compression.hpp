@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdint>
 #include <type_traits>
+#include <vector>
 
 #include "util/assert.hpp"
 
@@ -12,12 +13,13 @@ int toVariableBytelength(T val, uint8_t* out) {
     constexpr int maxLength = (sizeof(T)*8) / 7 + 1;
 
     T remainder = val;
-    if (std::is_signed_v<T>) {
+    if constexpr (std::is_signed_v<T>) {
         remainder = 2*std::abs(remainder) + (remainder<0);
     }
     int offset = 0;
 
-    while (remainder != 0) {
+    // At least one byte is written (also for zero) since decoding always reads one
+    do {
 
         uint8_t nextByte = remainder & 0b01111111;
         remainder = remainder >> 7;
@@ -25,7 +27,7 @@ int toVariableBytelength(T val, uint8_t* out) {
 
         assert(offset < maxLength);
         out[offset++] = nextByte;
-    }
+    } while (remainder != 0);
     return offset;
 }
 
@@ -47,9 +49,67 @@ T fromVariableBytelength(const uint8_t* in, int& outLength) {
     }
     outLength = offset;
 
-    if (std::is_signed_v<T>) {
+    if constexpr (std::is_signed_v<T>) {
         bool negative = out % 2 == 1;
         out = (negative ? -1 : 1) * (out/2);
     }
     return out;
 }
+
+// Delta coding of a stream of 32-bit numbers (e.g., the literals of a formula, or a clause buffer
+// via ClauseBufferCodec): each number is mapped to an unsigned one (zigzag: 2|x| or 2|x|-1), and
+// its difference to the preceding non-zero number is written as a zigzag-encoded variable-length
+// integer (see above). A zero (clause separator) is written as a single byte, so literals of
+// nearby variables take few bytes.
+// Any stream of 32-bit data (also floats) is encoded losslessly.
+inline uint32_t toZigzag(uint32_t x) {return (x << 1) ^ (uint32_t) (((int32_t) x) >> 31);}
+inline uint32_t fromZigzag(uint32_t z) {return (z >> 1) ^ (0 - (z & 1));}
+
+// Writes the encoding of the numbers to out, which must provide space for 5 bytes per number
+// (the worst case). Returns the number of written bytes.
+inline size_t compressIntStream(const int* data, size_t size, uint8_t* out) {
+    uint8_t* o = out;
+    uint32_t prev = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] == 0) {
+            *o++ = 0;
+            continue;
+        }
+        const uint32_t val = toZigzag((uint32_t) data[i]);
+        const uint64_t code = ((uint64_t) toZigzag(val - prev)) + 1; // zero is reserved
+        o += toVariableBytelength<uint64_t>(code, o);
+        prev = val;
+    }
+    return o - out;
+}
+
+// Appends the encoding of the numbers to out.
+inline void compressIntStream(const int* data, size_t size, std::vector<uint8_t>& out) {
+    size_t offset = out.size();
+    out.resize(offset + 5*size); // worst case
+    out.resize(offset + compressIntStream(data, size, out.data() + offset));
+}
+
+// Decodes exactly outSize numbers from the provided bytes. Returns false if the bytes
+// are malformed or do not contain exactly outSize numbers.
+inline bool decompressIntStream(const uint8_t* in, size_t inSize, int* out, size_t outSize) {
+    const uint8_t* end = in + inSize;
+    uint32_t prev = 0;
+    for (size_t i = 0; i < outSize; i++) {
+        // The number must end within the input and within five bytes
+        const uint8_t* last = in;
+        while (last != end && last - in < 4 && (*last & 0b10000000)) last++;
+        if (last == end || (*last & 0b10000000)) return false;
+        int length;
+        const uint64_t code = fromVariableBytelength<uint64_t>(in, length);
+        in += length;
+        if (code == 0) {
+            out[i] = 0;
+            continue;
+        }
+        if (code > (1ULL << 32)) return false;
+        prev += fromZigzag((uint32_t) (code-1));
+        out[i] = (int) fromZigzag(prev);
+    }
+    return in == end;
+}
@@ -106,14 +106,23 @@ void Logger::init(const LoggerConfig& config) {
             abort();
         }
     }
+
+    // Asynchronous writing of log lines
+    if (config.async && !_main_instance._async) {
+        _main_instance._async = AsyncLoggerBackend::get().start(&_main_instance);
+    } else if (!config.async && _main_instance._async) {
+        AsyncLoggerBackend::get().stop();
+        _main_instance._async = false;
+    }
 }
 Logger::Logger(Logger&& other) :
     _log_directory(std::move(other._log_directory)), _log_filename(std::move(other._log_filename)), 
     _line_prefix(std::move(other._line_prefix)), _log_cfile(other._log_cfile), _rank(other._rank), 
     _verbosity(other._verbosity), _colored_output(other._colored_output), _quiet(other._quiet), 
-    _c_prefix(other._c_prefix), _flush_file_immediately(other._flush_file_immediately) {
+    _c_prefix(other._c_prefix), _flush_file_immediately(other._flush_file_immediately), _async(other._async) {
     
     other._log_cfile = nullptr;
+    other._async = false;
 }
 Logger& Logger::operator=(Logger&& other) {
     _log_directory = std::move(other._log_directory);
@@ -126,11 +135,14 @@ Logger& Logger::operator=(Logger&& other) {
     _quiet = other._quiet;
     _c_prefix = other._c_prefix;
     _flush_file_immediately = other._flush_file_immediately;
+    _async = other._async;
 
     other._log_cfile = nullptr;
+    other._async = false;
     return *this;
 }
 Logger::~Logger() {
+    if (_async) AsyncLoggerBackend::get().stop();
     flush();
     if (_log_cfile != nullptr) fclose(_log_cfile);
 }
@@ -171,7 +183,10 @@ void Logger::setQuiet() {
 }
 
 void Logger::setLinePrefix(const std::string& linePrefix) {
+    // The drain thread of the asynchronous backend reads the prefix
+    bool holdingDrainLock = _async && AsyncLoggerBackend::get().drain(1000, /*keepLocked=*/true);
     _line_prefix = linePrefix;
+    if (holdingDrainLock) AsyncLoggerBackend::get().unlockDrain();
 }
 
 void Logger::log(unsigned int options, const char* str, ...) const {
@@ -190,6 +205,7 @@ bool Logger::fail(unsigned int options, const char* str, ...) const {
 }
 
 void Logger::flush() const {
+    if (_async && AsyncLoggerBackend::get().isEnabled()) AsyncLoggerBackend::get().drain();
     if (!_quiet) fflush(stdout);
     if (_log_cfile != nullptr) fflush(_log_cfile);
 }
@@ -239,6 +255,14 @@ void Logger::log(va_list& args, unsigned int options, const char* str) const {
         otherRank = va_arg(args, int);
     }
 
+    bool holdingDrainLock = false;
+    if (_async && AsyncLoggerBackend::get().isEnabled()) {
+        auto& backend = AsyncLoggerBackend::get();
+        if (backend.push(options, Timer::elapsedSeconds(), otherRank, str, args)) return;
+        // Not possible to defer this line: write it synchronously after all deferred lines
+        holdingDrainLock = backend.drain(1000, /*keepLocked=*/true);
+    }
+
     // Colored output, if applicable
     if (!_quiet && _colored_output) {
         if (verbosity <= V0_CRIT) {
@@ -290,6 +314,48 @@ void Logger::log(va_list& args, unsigned int options, const char* str) const {
     if (!_quiet && _colored_output) {
         std::cout << Modifier(Code::FG_DEFAULT);
     }
+
+    if (holdingDrainLock) AsyncLoggerBackend::get().unlockDrain();
+}
+
+void Logger::writeLines(const std::vector<AsyncLoggerBackend::Line>& lines, const std::string& text) const {
+
+    static const Code colors[] = {FG_LIGHT_CYAN, FG_CYAN, FG_LIGHT_BLUE, FG_BLUE, FG_MAGENTA, FG_DARK_GRAY};
+    std::string out;
+    char prefixBuf[64];
+    float prefixTime = -1;
+    int prefixLength = 0;
+    for (bool toFile : {false, true}) {
+        if (toFile ? _log_cfile == nullptr : _quiet) continue;
+        const bool colored = !toFile && _colored_output;
+        out.clear();
+        for (auto& line : lines) {
+            int verbosity = line.options & 7;
+            if (colored) out += "\033[" + std::to_string(colors[std::min(verbosity, 5)]) + "m";
+            if ((line.options & LOG_NO_PREFIX) == 0) {
+                if (_c_prefix) out += "c ";
+                // Consecutive lines often share their timestamp
+                if (line.time != prefixTime) {
+                    prefixLength = snprintf(prefixBuf, sizeof(prefixBuf), "%.3f %i", line.time, _rank);
+                    prefixTime = line.time;
+                }
+                out.append(prefixBuf, prefixLength);
+                out += _line_prefix;
+                out += ' ';
+            }
+            out.append(text, line.textBegin, line.textLength);
+            if (line.otherRank >= 0) {
+                auto arrowStr = (line.options & LOG_ADD_DESTRANK) ? "=>" : "<=";
+                out += ' ';
+                out += arrowStr;
+                out += " [" + std::to_string(line.otherRank) + "]\n";
+            }
+            if (colored) out += "\033[" + std::to_string(FG_DEFAULT) + "m";
+        }
+        FILE* file = toFile ? _log_cfile : stdout;
+        fwrite(out.data(), 1, out.size(), file);
+        if (!toFile || _flush_file_immediately) fflush(file);
+    }
 }
 
 int Logger::getVerbosity() const {
@@ -7,6 +7,9 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <string>
+#include <vector>
+
+#include "util/async_logger_backend.hpp"
 
 #define V0_CRIT 0
 #define V1_WARN 1
@@ -37,6 +40,7 @@ public:
         bool quiet = false;
         bool cPrefix = false;
         bool flushFileImmediately = false;
+        bool async = false;
         const std::string* logDirOrNull = nullptr;
         const std::string* logFilenameOrNull = nullptr;
     };
@@ -62,6 +66,7 @@ private:
     bool _quiet = false;
     bool _c_prefix = false;
     bool _flush_file_immediately = false;
+    bool _async = false;
     mutable pid_t _associated_tid = 0;
 
 public:
@@ -95,6 +100,10 @@ public:
 private:
 
     void log(va_list& args, unsigned int options, const char* str) const;
+
+    // Writes formatted lines of the asynchronous backend in a single batch.
+    friend class AsyncLoggerBackend;
+    void writeLines(const std::vector<AsyncLoggerBackend::Line>& lines, const std::string& text) const;
 };
 
 void log(int options, const char* str, ...);
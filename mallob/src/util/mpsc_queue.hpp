@@ -0,0 +1,66 @@
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+/*
+Unbounded lock-free queue for multiple producers and a single consumer
+(intrusive node-based queue after D. Vyukov). push() is wait-free except for
+the allocation of a node, and pop() never blocks. An element whose push()
+has not fully completed yet may be invisible to pop() for a short moment,
+which also holds back the elements pushed after it.
+T must be default-constructible and move-assignable.
+*/
+template <typename T>
+class MPSCQueue {
+
+private:
+    struct Node {
+        std::atomic<Node*> next {nullptr};
+        T value;
+    };
+
+    // Producers append behind _head; the consumer reads from _tail->next.
+    alignas(64) std::atomic<Node*> _head;
+    alignas(64) Node* _tail;
+
+public:
+    MPSCQueue() {
+        _tail = new Node();
+        _head.store(_tail, std::memory_order_relaxed);
+    }
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+    ~MPSCQueue() {
+        while (_tail) {
+            Node* next = _tail->next.load(std::memory_order_relaxed);
+            delete _tail;
+            _tail = next;
+        }
+    }
+
+    // May be called concurrently from any number of threads.
+    void push(T&& value) {
+        Node* node = new Node();
+        node->value = std::move(value);
+        Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // Must only be called by the consumer thread.
+    bool pop(T& out) {
+        Node* next = _tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        // The popped node becomes the new stub node.
+        delete _tail;
+        _tail = next;
+        return true;
+    }
+
+    // Must only be called by the consumer thread.
+    bool empty() const {
+        return _tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+};
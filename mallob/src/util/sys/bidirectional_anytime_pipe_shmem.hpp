@@ -41,6 +41,7 @@ private:
     struct InPlaceData {
         volatile bool available;
         volatile size_t size;
+        volatile size_t totalSize; // size of the entire message in bytes
         volatile bool toBeContinued;
         volatile char tag;
         static InPlaceData* getMetadata(volatile char* buffer) {return (InPlaceData*) buffer;}
@@ -51,9 +52,17 @@ private:
         }
     };
 
+    // The data of a message is the concatenation of userData and suffix.
+    // The suffix (e.g., some trailing metadata) is kept separately in order to avoid
+    // copying the (possibly large) userData into a new, concatenated vector.
     struct Message {
         char tag {0};
         std::vector<int> userData;
+        std::vector<int> suffix;
+        size_t size() const {return userData.size() + suffix.size();}
+        const int* at(size_t pos) const {
+            return pos < userData.size() ? userData.data()+pos : suffix.data()+(pos-userData.size());
+        }
     };
 
     // Internal method to read a single message, possibly buffered across multiple chunks.
@@ -74,6 +83,8 @@ private:
             assert(shmemMeta->size <= shmemSize ||
                 log_return_false("[ERROR] prompted to read %lu bytes into buffer of length %lu!\n", shmemMeta->size, shmemSize));
             size_t oldMsgNbInts = outMsg.userData.size();
+            // allocate the entire message at once to avoid reallocations while appending chunks
+            if (oldMsgNbInts == 0) outMsg.userData.reserve(shmemMeta->totalSize / sizeof(int));
             outMsg.userData.resize(outMsg.userData.size() + shmemMeta->size / sizeof(int));
             memcpy(outMsg.userData.data() + oldMsgNbInts, (char*)shmemBuf, shmemMeta->size);
             bool tbc = shmemMeta->toBeContinued;
@@ -105,12 +116,20 @@ private:
 
         if (!blocking && shmemMeta->available) return false;
         while (shmemMeta->available && !_terminate) usleep(1000);
+        const size_t msgSize = inMsg.size();
         while (!_terminate) {
             shmemMeta->tag = inMsg.tag;
-            size_t endInMsg = std::min(posInMsg + shmemSize/sizeof(int), inMsg.userData.size());
+            shmemMeta->totalSize = msgSize * sizeof(int);
+            size_t endInMsg = std::min(posInMsg + shmemSize/sizeof(int), msgSize);
             shmemMeta->size = (endInMsg-posInMsg) * sizeof(int);
-            memcpy((char*)shmemBuf, inMsg.userData.data() + posInMsg, shmemMeta->size);
-            bool tbc = (posInMsg < inMsg.userData.size());
+            // copy the chunk, which may span both parts of the message
+            size_t pos = posInMsg;
+            while (pos < endInMsg) {
+                size_t end = pos < inMsg.userData.size() ? std::min(endInMsg, inMsg.userData.size()) : endInMsg;
+                memcpy((char*)shmemBuf + (pos-posInMsg)*sizeof(int), inMsg.at(pos), (end-pos)*sizeof(int));
+                pos = end;
+            }
+            bool tbc = (posInMsg < msgSize);
             shmemMeta->toBeContinued = tbc;
             posInMsg += shmemMeta->size / sizeof(int);
             shmemMeta->available = true;
@@ -248,11 +267,11 @@ public:
         return success;
     }
     // Send a piece of data built from concatenating the two provided arrays (for convenience),
-    // can be blocking and moves/copies the data.
+    // can be blocking and moves data1 / copies data2. The arrays are only concatenated
+    // in the shared-memory buffer, so data2 should be the smaller one.
     bool writeData(std::vector<int>&& data1, const std::vector<int>& data2, char contentTag) {
         LOG(V5_DEBG, "PIPE write %c\n", contentTag);
-        data1.insert(data1.end(), data2.begin(), data2.end());
-        Message msg {contentTag, std::move(data1)};
+        Message msg {contentTag, std::move(data1), data2};
         if (!_out_concurrent) {
             bool success = writeData(_data_out_left, _data_out_right, _cap_out,
                 true, msg);
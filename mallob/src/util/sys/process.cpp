@@ -39,7 +39,9 @@ void handleSignal(int signum) {
     Process::_exit_signal = signum;
     Process::_signal_tid = Proc::getTid();
 
-    // If crash, try to write a trace of the concerned thread with gdb
+    // If crash, try to write a trace of the concerned thread with gdb.
+    // Pending log lines are not flushed here (not async-signal-safe with asynchronous
+    // logging); they are written when the main thread reports the signal or exits.
     if (Process::isCrash(signum)) Process::writeTrace(Proc::getTid());
 
     // Impose a hard timeout for this process' lifetime from this point,
@@ -50,7 +52,7 @@ void handleSignal(int signum) {
     // Special case where we are in the main thread and a crash was noticed:
     // normal execution cannot continue here, so we exit directly.
     if (Process::isCrash(signum) && Process::_main_tid == Proc::getTid()) {
-        Process::reportTerminationSignal(Process::getCaughtSignal().value());
+        Process::reportTerminationSignal(Process::getCaughtSignal().value(), true);
         Process::forwardTerminateToChildren();
         Process::doExit(signum);
     }
@@ -60,9 +62,36 @@ bool Process::isCrash(int signum) {
     return signum == SIGABRT || signum == SIGFPE || signum == SIGSEGV || signum == SIGBUS || signum == SIGILL;
 }
 
-void Process::reportTerminationSignal(const SignalInfo& info) {
+void Process::reportTerminationSignal(const SignalInfo& info, bool inSignalHandler) {
     assert(Proc::getTid() == Process::_main_tid);
 
+    if (inSignalHandler) {
+        // The logger is not async-signal-safe: assemble the line by hand and write it directly
+        char buf[128];
+        size_t len = 0;
+        auto append = [&](const char* str) {
+            while (*str && len < sizeof(buf)) buf[len++] = *str++;
+        };
+        auto appendNumber = [&](long x) {
+            char digits[24];
+            int nbDigits = 0;
+            unsigned long u = x < 0 ? -(unsigned long) x : x;
+            do {digits[nbDigits++] = '0' + u % 10; u /= 10;} while (u > 0);
+            if (x < 0) digits[nbDigits++] = '-';
+            while (nbDigits > 0 && len < sizeof(buf)) buf[len++] = digits[--nbDigits];
+        };
+        append(isCrash(info.signum) ? "[ERROR] pid=" : "pid=");
+        appendNumber(Proc::getPid());
+        append(" tid=");
+        appendNumber(info.tid);
+        append(" signal=");
+        appendNumber(info.signum);
+        append("\n");
+        auto nbWritten = write(STDERR_FILENO, buf, len);
+        (void) nbWritten;
+        return;
+    }
+
     if (isCrash(info.signum)) {
         LOG(V0_CRIT, "[ERROR] pid=%ld tid=%ld signal=%d\n", 
                 Proc::getPid(), info.tid, info.signum);
@@ -58,7 +58,7 @@ public:
     };
     static std::optional<SignalInfo> getCaughtSignal();
     static bool isCrash(int signum);
-    static void reportTerminationSignal(const SignalInfo& info);
+    static void reportTerminationSignal(const SignalInfo& info, bool inSignalHandler = false);
 
     static void writeTrace(long tid);
 
@@ -1,5 +1,4 @@
-
 #include "shmem_cache.hpp"
 
-SharedMemoryCache::ProcessWideOwnedShmemTable SharedMemoryCache::procWideOwnedShmemTable {};
+std::atomic<size_t> SharedMemoryCache::retentionCapBytes {0};
 SharedMemoryCache StaticSharedMemoryCache::singleton {};
@@ -1,165 +1,316 @@
 
 #pragma once
 
-#include "robin_map.h"
 #include "util/logger.hpp"
 #include "util/sys/fileutils.hpp"
 #include "util/sys/shared_memory.hpp"
-#include "util/sys/threading.hpp"
 #include "util/sys/tmpdir.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <signal.h>
 #include <string>
+#include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
+#include <vector>
 
+// Host-wide, content-addressed cache of formulae in shared memory.
+// A segment is identified by a key which is computed from its content, so jobs
+// with the same formula (regardless of job ID, description ID, or revision)
+// share a single segment. All state is kept in the file system of the machine:
+// Each user of a segment holds a reference file which includes the user's PID,
+// so reference counts survive restarts of individual processes and references
+// of processes which died are cleaned up during garbage collection.
+// Segments without references are retained up to a configurable memory cap
+// (0 by default: delete at last reference) and evicted in LRU order.
+// The modification time of a segment's file represents its last use.
+// Each segment ends with a fingerprint of its content which is verified on every access,
+// so that a key collision cannot lead to a job being given a different formula.
 class SharedMemoryCache {
 
-private:
-    struct ProcessWideOwnedShmemTable {
-        Mutex mtx;
-        tsl::robin_map<int, std::pair<void*, size_t>> table;
-        ~ProcessWideOwnedShmemTable() {
-            auto lock = mtx.getLock();
-            for (auto it : table) {
-                SharedMemory::free(getShmemId(it.first), (char*)it.second.first, it.second.second);
-            }
+public:
+    typedef uint64_t Key;
+    struct Fingerprint {
+        uint64_t size {0};
+        uint64_t hash {0}; // a second hash of the content, independent of the key
+        bool operator==(const Fingerprint& other) const {
+            return size == other.size && hash == other.hash;
+        }
+        bool operator!=(const Fingerprint& other) const {
+            return !(*this == other);
         }
     };
-    static ProcessWideOwnedShmemTable procWideOwnedShmemTable;
+
+private:
+    static std::atomic<size_t> retentionCapBytes;
 
 public:
-    void* createOrAccess(int descriptionId, const std::string& userLabel, size_t size, const void* data, std::string& outShmemId) {
-        LOG(V5_DEBG, "CACHE create or access %i via %s\n", descriptionId, userLabel.c_str());
+    // Compute the key of a segment with the provided content and,
+    // in the same pass, the fingerprint which is stored with the segment.
+    static Key computeKey(const void* data, size_t size, Fingerprint* outFingerprint = nullptr) {
+        // Four independent lanes of 64-bit multiply-xorshift hashing
+        const uint8_t* bytes = (const uint8_t*) data;
+        uint64_t lanes[4] = {0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL, 0x94d049bb133111ebULL, size};
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32) {
+            for (int l = 0; l < 4; l++) {
+                uint64_t word;
+                memcpy(&word, bytes + i + 8*l, sizeof(uint64_t));
+                lanes[l] = (lanes[l] ^ mix(word)) * 0x9fb21c651e98df25ULL;
+            }
+        }
+        for (; i < size; i++) lanes[i % 4] = (lanes[i % 4] ^ bytes[i]) * 0x9fb21c651e98df25ULL;
+        if (outFingerprint) {
+            outFingerprint->size = size;
+            outFingerprint->hash = mix(lanes[3] + mix(lanes[2] + mix(lanes[1] + mix(lanes[0] ^ 0x2545f4914f6cdd1dULL))));
+        }
+        return mix(lanes[0] ^ mix(lanes[1] ^ mix(lanes[2] ^ mix(lanes[3]))));
+    }
 
-        // Acquire RAII lock to manipulate this job description's shared memory exclusively
-        FileBasedLock lock("jobdesc", descriptionId);
+    // Set how many bytes of unreferenced segments may be retained on this machine.
+    static void setRetentionCap(size_t capBytes) {
+        retentionCapBytes.store(capBytes, std::memory_order_relaxed);
+    }
+
+    // Returns nullptr if a segment with this key but a different fingerprint exists.
+    void* createOrAccess(Key key, const Fingerprint& fingerprint, int descriptionId, const std::string& userLabel,
+            size_t size, const void* data, std::string& outShmemId) {
+        LOG(V5_DEBG, "CACHE create or access %s via %s\n", toStr(key).c_str(), userLabel.c_str());
+
+        // Acquire RAII lock to manipulate this segment exclusively
+        FileBasedLock lock("shmcache", toStr(key));
 
         // Add a reference to the shared memory segment
-        bool ok = FileUtils::createExclusively(getRefFilename(descriptionId, userLabel));
+        bool ok = FileUtils::createExclusively(getRefFilename(key, userLabel));
         assert(ok);
 
         // Try to create the shared memory segment
-        const std::string shmemId = getShmemId(descriptionId);
-        void* shmem = SharedMemory::create(shmemId, size);
+        const std::string shmemId = getShmemId(key);
+        void* shmem = SharedMemory::create(shmemId, size + sizeof(Fingerprint));
         if (shmem) {
+            // Remember which segment holds this job description
+            if (descriptionId > 0) writeAlias(descriptionId, key, fingerprint);
             // successfully created - initialize while releasing the general lock.
-            {
-                auto lock = procWideOwnedShmemTable.mtx.getLock();
-                procWideOwnedShmemTable.table[descriptionId] = {shmem, size};
-            }
             // acquire a file specifically representing the initialization process.
-            FileBasedLock createLock("jobdesccreate", descriptionId);
+            FileBasedLock createLock("shmcachecreate", toStr(key));
             lock.unlock();
             assert(data);
             memcpy(shmem, data, size);
-            LOG(V5_DEBG, "CACHE created %i (size %lu)\n", descriptionId, size);
+            memcpy((uint8_t*) shmem + size, &fingerprint, sizeof(Fingerprint));
+            LOG(V4_VVER, "CACHE created %s (size %lu)\n", toStr(key).c_str(), size);
             outShmemId = shmemId;
             return shmem;
         }
-        // shmem file already exists - access it
 
-        // Release manipulation lock
-        lock.unlock();
-
-        // Wait until the shmem segment has been fully initialized
-        while (FileUtils::exists(FileBasedLock::opLockFile("jobdesccreate", descriptionId)))
-            usleep(3000);
-
-        // Now you can *safely* access the shared memory outside the lock (since you wrote a reference to it)
-        shmem = SharedMemory::access(shmemId, size, SharedMemory::READONLY);
-        LOG(V5_DEBG, "CACHE accessed %i (size %lu)\n", descriptionId, size);
+        // shmem file already exists - access it
+        shmem = accessVerified(key, fingerprint, userLabel, size, lock);
+        if (!shmem) return nullptr;
+        if (descriptionId > 0) writeAlias(descriptionId, key, fingerprint);
+        LOG(V4_VVER, "CACHE accessed %s (size %lu)\n", toStr(key).c_str(), size);
         outShmemId = shmemId;
         return shmem;
     }
 
-    void* tryAccess(int descriptionId, const std::string& userLabel, size_t size, std::string& outShmemId) {
-        LOG(V5_DEBG, "CACHE try preregister %i via %s\n", descriptionId, userLabel.c_str());
+    // Access the segment which was created earlier for the provided job description (if any).
+    void* tryAccess(int descriptionId, const std::string& userLabel, size_t size, std::string& outShmemId, Key& outKey) {
+        LOG(V5_DEBG, "CACHE try preregister desc. %i via %s\n", descriptionId, userLabel.c_str());
+
+        Key key {0};
+        Fingerprint fingerprint;
+        if (!readAlias(descriptionId, key, fingerprint)) return nullptr;
+        if (fingerprint.size != size) return nullptr;
 
-        // Acquire RAII lock to manipulate this job description's shared memory exclusively
-        FileBasedLock lock("jobdesc", descriptionId);
+        // Acquire RAII lock to manipulate this segment exclusively
+        FileBasedLock lock("shmcache", toStr(key));
 
         // Try to access the shared memory segment
-        void* shmem;
-        const std::string shmemId = getShmemId(descriptionId);
-        if (!FileUtils::exists("/dev/shm" + shmemId)) return nullptr;
+        const std::string shmemId = getShmemId(key);
+        if (!FileUtils::exists(getShmemFilename(key))) return nullptr;
 
         // Shared memory segment seems to be present.
-        
+
         // Add a reference to the shared memory segment
-        bool ok = FileUtils::createExclusively(getRefFilename(descriptionId, userLabel));
+        bool ok = FileUtils::createExclusively(getRefFilename(key, userLabel));
         assert(ok);
-
-        // Release manipulation lock
-        lock.unlock();
-        
-        // Wait until the shmem segment has been fully initialized
-        while (FileUtils::exists(FileBasedLock::opLockFile("jobdesccreate", descriptionId)))
-            usleep(3000);
-
-        // Now you can *safely* access the shared memory outside the lock (since you wrote a reference to it)
-        shmem = SharedMemory::access(shmemId, size, SharedMemory::READONLY);
-        LOG(V5_DEBG, "CACHE accessed %i (size %lu)\n", descriptionId, size);
+        void* shmem = accessVerified(key, fingerprint, userLabel, size, lock);
+        if (!shmem) return nullptr;
+        LOG(V4_VVER, "CACHE accessed %s (size %lu) for desc. %i\n", toStr(key).c_str(), size, descriptionId);
         outShmemId = shmemId;
+        outKey = key;
         return shmem;
     }
 
-    void drop(int descriptionId, const std::string& userLabel, size_t size, void* data) {
-        LOG(V5_DEBG, "CACHE drop %i via %s\n", descriptionId, userLabel.c_str());
+    void drop(Key key, const std::string& userLabel, size_t size, void* data) {
+        LOG(V5_DEBG, "CACHE drop %s via %s\n", toStr(key).c_str(), userLabel.c_str());
 
-        // Acquire RAII lock to manipulate this job description's shared memory
-        FileBasedLock lock("jobdesc", descriptionId);
+        // Acquire RAII lock to manipulate this segment
+        FileBasedLock lock("shmcache", toStr(key));
 
-        // Remove your own lock file
-        int res = FileUtils::rm(getRefFilename(descriptionId, userLabel));
+        // Remove your own reference and your own mapping
+        int res = FileUtils::rm(getRefFilename(key, userLabel));
         assert(res == 0);
-        LOG(V5_DEBG, "CACHE dropped %i via %s\n", descriptionId, userLabel.c_str());
+        SharedMemory::close((char*) data, size + sizeof(Fingerprint));
+        touch(key);
+        LOG(V5_DEBG, "CACHE dropped %s via %s\n", toStr(key).c_str(), userLabel.c_str());
 
-        tryDelete(descriptionId);
+        if (retentionCapBytes.load(std::memory_order_relaxed) == 0) tryDelete(key);
     }
 
+    // Clean up references of dead processes, delete unreferenced segments
+    // and evict unreferenced segments beyond the retention cap (LRU first).
     static void collectGarbage() {
         LOG(V5_DEBG, "CACHE gc\n");
 
-        auto shmemTable = [&]() {
-            auto lock = procWideOwnedShmemTable.mtx.getLock();
-            return procWideOwnedShmemTable.table;
-        }();
-        for (auto [descriptionId, val] : shmemTable) {
+        // Only one process at a time on this machine
+        FileBasedLock gcLock("shmcachegc", "all", false);
+        if (!gcLock.tryLock()) return;
+
+        struct Entry {
+            Key key;
+            size_t size;
+            long lastUse; // nanoseconds
+        };
+        std::vector<Entry> retained;
+        size_t totalSize = 0;
+        const size_t cap = retentionCapBytes.load(std::memory_order_relaxed);
+        const std::string prefix = getShmemFilename(0).substr(0, getShmemFilename(0).size() - toStr(0).size());
+        for (const auto& file : FileUtils::glob(prefix + "*")) {
+            Key key;
+            if (!fromStr(file.substr(prefix.size()), key)) continue; // not a cache segment
+            struct stat st;
+            if (stat(file.c_str(), &st) != 0) continue;
 
-            // Acquire RAII lock to manipulate this job description's shared memory exclusively
-            FileBasedLock lock("jobdesc", descriptionId);
-            tryDelete(descriptionId);
+            FileBasedLock lock("shmcache", toStr(key), false);
+            if (!lock.tryLock()) continue; // busy: skip this time
+            pruneDeadReferences(key);
+            if (hasReferences(key)) {
+                totalSize += st.st_size;
+                continue;
+            }
+            if (cap == 0) {
+                tryDelete(key);
+                continue;
+            }
+            totalSize += st.st_size;
+            retained.push_back({key, (size_t) st.st_size,
+                1'000'000'000L * st.st_mtim.tv_sec + st.st_mtim.tv_nsec});
+        }
+
+        // Evict least recently used unreferenced segments while above the cap
+        std::sort(retained.begin(), retained.end(), [](const Entry& a, const Entry& b) {
+            return a.lastUse < b.lastUse;
+        });
+        for (auto& entry : retained) {
+            if (totalSize <= cap) break;
+            FileBasedLock lock("shmcache", toStr(entry.key), false);
+            if (!lock.tryLock()) continue;
+            if (tryDelete(entry.key)) {
+                LOG(V4_VVER, "CACHE evicted %s (size %lu)\n", toStr(entry.key).c_str(), entry.size);
+                totalSize -= entry.size;
+            }
+        }
+
+        // Forget description IDs whose segments are gone
+        const std::string aliasPrefix = getAliasFilename(0).substr(0, getAliasFilename(0).size()-1);
+        for (const auto& file : FileUtils::glob(aliasPrefix + "*")) {
+            Key key {0};
+            Fingerprint fingerprint;
+            int descriptionId = atoi(file.substr(aliasPrefix.size()).c_str());
+            if (!readAlias(descriptionId, key, fingerprint)) continue;
+            FileBasedLock lock("shmcache", toStr(key), false);
+            if (!lock.tryLock()) continue;
+            if (!FileUtils::exists(getShmemFilename(key))) FileUtils::rm(file);
         }
     }
 
-    static std::string getShmemId(int descriptionId) {
-        return "/edu.kit.iti.mallob.jobdesc." + std::to_string(descriptionId);
+    static std::string getShmemId(Key key) {
+        return "/edu.kit.iti.mallob.jobdesc." + toStr(key);
     }
 
 private:
-    static bool tryDelete(int descriptionId) {
-        auto lockFiles = FileUtils::glob(getRefFilename(descriptionId, "*"));
-        if (!lockFiles.empty()) return false;
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    static std::string toStr(Key key) {
+        char str[17];
+        snprintf(str, sizeof(str), "%016lx", (unsigned long) key);
+        return std::string(str);
+    }
+    // Inverse of toStr. Returns false for anything which is not a key written by toStr.
+    static bool fromStr(const std::string& str, Key& key) {
+        if (str.size() != 16 || !std::all_of(str.begin(), str.end(), ::isxdigit)) return false;
+        char* end;
+        errno = 0;
+        unsigned long long val = strtoull(str.c_str(), &end, 16);
+        if (errno != 0 || *end != '\0') return false;
+        key = (Key) val;
+        return true;
+    }
+
+    static std::string getShmemFilename(Key key) {
+        return TmpDir::getMachineLocalTmpDir() + getShmemId(key).substr(1);
+    }
+
+    // Must be called while holding the lock of the key.
+    static bool tryDelete(Key key) {
+        if (hasReferences(key)) return false;
         // reference count became zero: delete
-        LOG(V5_DEBG, "CACHE delete %i\n", descriptionId);
-        void* data;
-        size_t size;
-        {
-            auto lock = procWideOwnedShmemTable.mtx.getLock();
-            auto it = procWideOwnedShmemTable.table.find(descriptionId);
-            if (it == procWideOwnedShmemTable.table.end()) return false;
-            data = it.value().first;
-            size = it.value().second;
-            procWideOwnedShmemTable.table.erase(it);
+        LOG(V5_DEBG, "CACHE delete %s\n", toStr(key).c_str());
+        return shm_unlink(getShmemId(key).c_str()) == 0;
+    }
+
+    static bool hasReferences(Key key) {
+        return !FileUtils::glob(getRefFilename(key, "*", "*")).empty();
+    }
+
+    static void pruneDeadReferences(Key key) {
+        for (const auto& file : FileUtils::glob(getRefFilename(key, "*", "*"))) {
+            pid_t pid = atoi(file.substr(file.rfind('.')+1).c_str());
+            if (pid > 0 && kill(pid, 0) != 0 && errno == ESRCH) {
+                LOG(V4_VVER, "CACHE remove stale reference %s\n", file.c_str());
+                FileUtils::rm(file);
+            }
         }
-        SharedMemory::free(getShmemId(descriptionId), (char*) data, size);
-        return true;
+    }
+
+    // Mark the segment as recently used.
+    static void touch(Key key) {
+        utimes(getShmemFilename(key).c_str(), nullptr);
+    }
+
+    static std::string getAliasFilename(int descriptionId) {
+        return TmpDir::getMachineLocalTmpDir() + "/edu.kit.iti.mallob.jobdesc-alias." + std::to_string(descriptionId);
+    }
+    // The alias of a description also records the segment's fingerprint, which is
+    // verified when the segment is accessed via the alias.
+    static void writeAlias(int descriptionId, Key key, const Fingerprint& fingerprint) {
+        std::ofstream ofs(getAliasFilename(descriptionId));
+        ofs << toStr(key) << " " << fingerprint.size << " " << fingerprint.hash;
+    }
+    static bool readAlias(int descriptionId, Key& key, Fingerprint& fingerprint) {
+        std::ifstream ifs(getAliasFilename(descriptionId));
+        std::string str;
+        if (!(ifs >> str >> fingerprint.size >> fingerprint.hash)) return false;
+        return fromStr(str, key);
     }
 
     struct FileBasedLock {
         std::string label;
-        int id;
+        std::string id;
         bool locked {false};
-        FileBasedLock(const std::string& label, int id, bool lockImmediately = true) : label(label), id(id) {
+        FileBasedLock(const std::string& label, const std::string& id, bool lockImmediately = true) : label(label), id(id) {
             if (lockImmediately) lock();
         }
         void lock() {
@@ -186,13 +337,45 @@ private:
         ~FileBasedLock() {
             unlock();
         }
-        static std::string opLockFile(const std::string& label, int id) {
-            return TmpDir::getMachineLocalTmpDir() + "/edu.kit.iti.mallob." + label + "-lock." + std::to_string(id);
+        static std::string opLockFile(const std::string& label, const std::string& id) {
+            return TmpDir::getMachineLocalTmpDir() + "/edu.kit.iti.mallob." + label + "-lock." + id;
         }
     };
 
-    static std::string getRefFilename(int descriptionId, const std::string& userLabel) {
-        return TmpDir::getMachineLocalTmpDir() + "/" + userLabel + ".jobdesc-ref." + std::to_string(descriptionId);
+    // Maps an existing segment for which the caller has just added a reference
+    // while holding the provided lock. Returns nullptr (and removes the reference again)
+    // if the segment's content does not match the expected fingerprint.
+    void* accessVerified(Key key, const Fingerprint& fingerprint, const std::string& userLabel,
+            size_t size, FileBasedLock& lock) {
+        touch(key);
+
+        // Release manipulation lock
+        lock.unlock();
+
+        // Wait until the shmem segment has been fully initialized
+        while (FileUtils::exists(FileBasedLock::opLockFile("shmcachecreate", toStr(key))))
+            usleep(3000);
+
+        // Now you can *safely* access the shared memory outside the lock (since you wrote a reference to it)
+        struct stat st;
+        void* shmem = nullptr;
+        if (stat(getShmemFilename(key).c_str(), &st) == 0 && (size_t) st.st_size == size + sizeof(Fingerprint))
+            shmem = SharedMemory::access(getShmemId(key), size + sizeof(Fingerprint), SharedMemory::READONLY);
+        if (shmem && memcmp((uint8_t*) shmem + size, &fingerprint, sizeof(Fingerprint)) == 0)
+            return shmem;
+
+        LOG(V1_WARN, "[WARN] CACHE %s holds different content (size %lu)\n", toStr(key).c_str(), size);
+        if (shmem) SharedMemory::close((char*) shmem, size + sizeof(Fingerprint));
+        lock.lock();
+        FileUtils::rm(getRefFilename(key, userLabel));
+        return nullptr;
+    }
+
+    static std::string getRefFilename(Key key, const std::string& userLabel) {
+        return getRefFilename(key, userLabel, std::to_string(getpid()));
+    }
+    static std::string getRefFilename(Key key, const std::string& userLabel, const std::string& pid) {
+        return TmpDir::getMachineLocalTmpDir() + "/" + userLabel + ".jobdesc-ref." + toStr(key) + "." + pid;
     }
 };
 
@@ -31,6 +31,9 @@ void ConditionVariable::waitWithTimeout(Mutex& mutex, int millisecs, std::functi
 void ConditionVariable::waitWithLockedMutex(std::unique_lock<std::mutex>& lock, std::function<bool()> condition) {
     while (!condition()) condvar.wait(lock);
 }
+bool ConditionVariable::waitWithLockedMutexFor(std::unique_lock<std::mutex>& lock, int millisecs, std::function<bool()> condition) {
+    return condvar.wait_for(lock, std::chrono::milliseconds(millisecs), condition);
+}
 void ConditionVariable::notifySingle() {
     condvar.notify_one();
 }
@@ -27,6 +27,8 @@ public:
     void wait(Mutex& mutex, std::function<bool()> condition);
 	void waitWithTimeout(Mutex& mutex, int millisecs, std::function<bool()> condition);
 	void waitWithLockedMutex(std::unique_lock<std::mutex>& lock, std::function<bool()> condition);
+	// Returns whether the condition holds, i.e., false if the timeout was hit.
+	bool waitWithLockedMutexFor(std::unique_lock<std::mutex>& lock, int millisecs, std::function<bool()> condition);
 	void notifySingle();
 	void notify();
 };
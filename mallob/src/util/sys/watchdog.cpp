@@ -1,6 +1,7 @@
 
 #include "watchdog.hpp"
 
+#include <algorithm>
 #include <cerrno>
 #include <unistd.h>
 #include <signal.h>
@@ -28,6 +29,7 @@ Watchdog::Watchdog(bool enabled, int checkIntervalMillis, bool useThreadPool, st
         while (_worker.continueRunning()) {
             int timeMillis = (int) (1000*Timer::elapsedSeconds());
             auto elapsed = timeMillis - _last_reset_millis;
+            unsigned long numPendingMsgs = checkMessageLatency(0.001f * timeMillis);
             if (_globally_enabled.load(std::memory_order_relaxed) && _active) {
                 bool doAbort = false;
                 if (_abort_period_millis > 0 && elapsed > _abort_period_millis) {
@@ -44,8 +46,8 @@ Watchdog::Watchdog(bool enabled, int checkIntervalMillis, bool useThreadPool, st
                     abort();
                 }
                 if (_warning_period_millis > 0 && elapsed > _warning_period_millis) {
-                    LOG(V1_WARN, "[WARN] Watchdog: No reset for %i ms (activity=%i recvtag=%i sendtag=%i)\n", 
-                        elapsed, _activity, _activity_recv_tag, _activity_send_tag);
+                    LOG(V1_WARN, "[WARN] Watchdog: No reset for %i ms (activity=%i recvtag=%i sendtag=%i pendingmsgs=%lu)\n", 
+                        elapsed, _activity, _activity_recv_tag, _activity_send_tag, numPendingMsgs);
                 }
             }
             int res = usleep(1000 * checkIntervalMillis);
@@ -82,6 +84,37 @@ void Watchdog::setAbortTicks(int nbTicks) {
     _abort_ticks = nbTicks;
 }
 
+void Watchdog::setMessageLatencyProbe(const MessageLatencyProbe& probe) {
+    auto lock = _probe_mutex.getLock();
+    _latency_probe = probe;
+}
+
+unsigned long Watchdog::checkMessageLatency(float time) {
+    MessageLatency latency;
+    {
+        auto lock = _probe_mutex.getLock();
+        if (!_latency_probe) return 0;
+        latency = _latency_probe();
+    }
+    if (latency.numHandled > 0 && _warning_period_millis > 0
+            && 1000 * latency.maxSeconds > _warning_period_millis) {
+        LOG(V1_WARN, "[WARN] Watchdog: message latency max=%.4fs avg=%.4fs (%lu handled, %lu pending)\n",
+            latency.maxSeconds, latency.avgSeconds, latency.numHandled, latency.numPending);
+    }
+    _latency_num_handled += latency.numHandled;
+    _latency_sum_seconds += latency.numHandled * (double) latency.avgSeconds;
+    _latency_max_seconds = std::max(_latency_max_seconds, latency.maxSeconds);
+    if (time - _last_latency_report >= 10) {
+        LOG(V4_VVER, "Watchdog: message latency max=%.6fs avg=%.6fs (%lu handled)\n", _latency_max_seconds,
+            _latency_sum_seconds / std::max(1UL, _latency_num_handled), _latency_num_handled);
+        _latency_num_handled = 0;
+        _latency_sum_seconds = 0;
+        _latency_max_seconds = 0;
+        _last_latency_report = time;
+    }
+    return latency.numPending;
+}
+
 void Watchdog::reset(float time) {
     _last_reset_millis = (int) (1000*time);
     _ticks = 0;
@@ -3,6 +3,7 @@
 #define DOMPASCH_MALLOB_WATCHDOG_HPP
 
 #include <atomic>
+#include <functional>
 #include <future>
 
 #include "timer.hpp"
@@ -23,6 +24,15 @@ public:
         /*7*/ SYSSTATE
     };
 
+    // Time between the arrival of messages and their handling by the main loop
+    struct MessageLatency {
+        unsigned long numHandled {0};
+        unsigned long numPending {0};
+        float avgSeconds {0};
+        float maxSeconds {0};
+    };
+    typedef std::function<MessageLatency()> MessageLatencyProbe;
+
 private:
     Activity _activity = Activity::IDLE_OR_HANDLING_MSG;
     int _activity_recv_tag = 0;
@@ -45,6 +55,13 @@ private:
 
     std::function<void()> _abort_function;
 
+    Mutex _probe_mutex;
+    MessageLatencyProbe _latency_probe;
+    unsigned long _latency_num_handled {0};
+    double _latency_sum_seconds {0};
+    float _latency_max_seconds {0};
+    float _last_latency_report {0};
+
 public:
     Watchdog(bool enabled, int checkIntervalMillis, bool useThreadPool = false,
         std::function<void()> customAbortFunction = std::function<void()>());
@@ -59,10 +76,17 @@ public:
     }
     int* activityRecvTag() {return &_activity_recv_tag;}
     int* activitySendTag() {return &_activity_send_tag;}
+    // The probe is queried in each check from the watchdog's thread and should
+    // return the latencies since its last call. Latencies exceeding the warning
+    // period are reported immediately, all others periodically.
+    void setMessageLatencyProbe(const MessageLatencyProbe& probe);
     void stop();
     void stopWithoutWaiting();
 
     static void disableGlobally();
+
+private:
+    unsigned long checkMessageLatency(float time);
 };
 
 #endif
\ No newline at end of file